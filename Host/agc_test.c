@@ -0,0 +1,67 @@
+/*
+ * agc_test.c - host test of audio AGC (agc.c) - 40 dB step of a tone after the gain has settled on the quiet one
+ *
+ * FM blocks (BB_BLOCK samples at FS_BB_Hz, gain is only reduced) and SSB blocks (4 samples at AUDIO_FS_Hz, up to 80 dB
+ * of gain) with attack 0.1, 1 and 4.8 ms. The look-ahead has to keep every output sample below the limiter knee -
+ * the gain is reduced before the step leaves the delay line - and the level has to settle at AGC_LEVEL_DEFAULT.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc agc_test.c ../stm32f407_mxl5007t/Core/Src/agc.c -lm
+ *     -o agc_test && ./agc_test
+ */
+#include <stdio.h>
+#include <math.h>
+#include "main.h"
+#include "agc.h"
+#include "audio_i2s.h"
+
+#define BLOCKS     20000 //3 s - SSB gain has to rise to its 80 dB limit on the quiet tone first
+#define STEP_BLOCK 14000
+
+void UART_printf(const char *format, ...)
+{
+	(void) format;
+}
+
+static int run(Output_demod_type_enum demod, uint16_t n, double fs, float amp, float attack_ms)
+{
+	float L[BB_BLOCK], peak_max = 0, peak_end = 0, full_scale = 1.0f, knee = AGC_KNEE*full_scale;
+	double ph = 0;
+	uint32_t b, k, over = 0;
+	int fail;
+
+	agc_set(true, AGC_LEVEL_DEFAULT, attack_ms, AGC_DECAY_DEFAULT);
+	agc_process(L, NULL, 0, full_scale, OUT_IQ); //other audio - delay line and gain start again
+	for (b = 0; b < BLOCKS; b++)
+	{
+		for (k = 0; k < n; k++, ph += 2.0*M_PI*1.0e3/fs)
+			L[k] = amp*(b < STEP_BLOCK ? 0.01f : 1.0f)*sin(ph);
+		agc_process(L, NULL, n, full_scale, demod);
+		for (k = 0; k < n; k++)
+		{
+			if (fabsf(L[k]) > knee) over++;
+			if (fabsf(L[k]) > peak_max) peak_max = fabsf(L[k]);
+			if ( (b >= BLOCKS - 200) && (fabsf(L[k]) > peak_end) ) peak_end = fabsf(L[k]);
+		}
+	}
+
+	fail = (over != 0) || (fabsf(20*log10f(peak_end) - AGC_LEVEL_DEFAULT) > 1.0f);
+	printf("%-4s attack %3.1f ms: peak %6.2f dBFS (knee %.2f) ; samples above knee %lu ; settled %6.2f dBFS - %s\n",
+			demod == DEMOD_FM ? "FM" : "SSB", AGC_Config.attack_ms, 20*log10f(peak_max), 20*log10f(knee),
+			(unsigned long) over, 20*log10f(peak_end), fail ? "FAIL" : "ok");
+	return fail;
+}
+
+int main(void)
+{
+	static const float attack_ms[] = {0.1f, 1.0f, 4.8f};
+	int k, fail = 0;
+
+	for (k = 0; k < 3; k++)
+	{
+		fail |= run(DEMOD_FM, BB_BLOCK, FS_BB_Hz, 2.0f, attack_ms[k]); //FM deviation above full scale
+		fail |= run(DEMOD_USB, BB_BLOCK/AUDIO_DECIM, AUDIO_FS_Hz, 1.0e-3f, attack_ms[k]); //raw Weaver output of a weak signal
+	}
+	printf("%s\n", fail ? "FAIL" : "PASS");
+
+	return fail;
+}
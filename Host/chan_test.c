@@ -0,0 +1,150 @@
+/*
+ * chan_test.c - host test of the channelizer (chan.c) - channel selectivity and demodulated tone
+ *
+ * Channels at the default offsets (0, +12.5, -12.5, +25 kHz) get synthetic I/Q at FS_BB_Hz. A carrier in one channel
+ * has to be CHAN_TEST_REJ_dB below in the others, like a carrier at -81 kHz, which is folded to +25 kHz when the shared
+ * half band filter doesn't stop it. Then FM 1 kHz tone (2.5 kHz deviation) in -12.5 kHz channel next to 20 dB stronger
+ * carrier at +12.5 kHz - routed audio has to give CHAN_TEST_SINAD_dB. Channel powers come from chan_print() lines.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc chan_test.c ../stm32f407_mxl5007t/Core/Src/chan.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_fir.c ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm -o chan_test && ./chan_test
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "cmd.h"
+#include "nfloor.h"
+#include "chan.h"
+
+#define BLOCKS             3000 //0.45 s
+#define F_TONE             1.0e3
+#define CHAN_TEST_REJ_dB   50.0
+#define CHAN_TEST_SINAD_dB 30.0
+
+DWT_Type Host_DWT;
+uint32_t SystemCoreClock = 168000000;
+volatile uint32_t ADC_overruns;
+NF_Result_TypeDef NF_Result = {.density_dB = -150.0f, .count = 1};
+IQ_Filter_enum IQ_Filter = IQ_FILTER_105kHz;
+const float IQ_Filter_bw_Hz[IQ_FILTERS] = {105000.0, 15000.0, 3000.0, 6000.0, 10000.0, 30000.0, 60000.0};
+
+static char Out[4096]; //chan_print() output
+static size_t Out_len;
+static double Audio[BLOCKS*AUDIO_BLOCK];
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	if (Out_len < sizeof(Out)) Out_len += vsnprintf(&Out[Out_len], sizeof(Out) - Out_len, format, args);
+	va_end(args);
+}
+
+//least squares fit of the tone and DC - the rest is noise and distortion
+static double sinad(const double* x, int n, double fs)
+{
+	double a[3][3] = {{0}}, b[3] = {0}, c[3], p = 0, r = 0, f, t, e;
+	int i, j, k, l;
+
+	for (k = 0; k < n; k++)
+	{
+		double v[3] = {cos(2.0*M_PI*F_TONE*k/fs), sin(2.0*M_PI*F_TONE*k/fs), 1.0};
+		for (i = 0; i < 3; i++)
+		{
+			b[i] += v[i]*x[k];
+			for (j = 0; j < 3; j++) a[i][j] += v[i]*v[j];
+		}
+	}
+	for (i = 0; i < 3; i++)
+		for (j = i + 1; j < 3; j++)
+		{
+			f = a[j][i]/a[i][i];
+			for (l = 0; l < 3; l++) a[j][l] -= f*a[i][l];
+			b[j] -= f*b[i];
+		}
+	for (i = 2; i >= 0; i--)
+	{
+		c[i] = b[i];
+		for (j = i + 1; j < 3; j++) c[i] -= a[i][j]*c[j];
+		c[i] /= a[i][i];
+	}
+	for (k = 0; k < n; k++)
+	{
+		t = c[0]*cos(2.0*M_PI*F_TONE*k/fs) + c[1]*sin(2.0*M_PI*F_TONE*k/fs);
+		e = x[k] - t - c[2];
+		p += t*t;
+		r += e*e;
+	}
+	return 10.0*log10(p/r);
+}
+
+//carrier a at f_Hz and FM tone b at fm_Hz, routed channel audio to Audio[], channel powers [dB] from chan_print()
+static void run(double f_Hz, double a, double fm_Hz, double b, uint8_t route, float* power_dB)
+{
+	float I[BB_BLOCK], Q[BB_BLOCK], out[AUDIO_BLOCK];
+	double ph_a = 0, ph_b = 0, t;
+	uint32_t blk, k, n = 0;
+	uint16_t m;
+	char* line;
+	int ch;
+	float off, p;
+
+	chan_set_on(true);
+	chan_set_route(route);
+	chan_set_squelch(CHAN_SQ_DEFAULT_dB);
+	for (blk = 0; blk < BLOCKS; blk++)
+	{
+		for (k = 0; k < BB_BLOCK; k++, n++)
+		{
+			t = n/FS_BB_Hz;
+			ph_a = 2.0*M_PI*f_Hz*t;
+			ph_b = 2.0*M_PI*fm_Hz*t + 2500.0/F_TONE*sin(2.0*M_PI*F_TONE*t);
+			I[k] = a*cos(ph_a) + b*cos(ph_b);
+			Q[k] = a*sin(ph_a) + b*sin(ph_b);
+		}
+		m = chan_process(I, Q, BB_BLOCK, out);
+		for (k = 0; k < m; k++) Audio[blk*AUDIO_BLOCK + k] = out[k];
+	}
+
+	Out_len = 0;
+	Out[0] = 0;
+	chan_print();
+	for (line = strchr(Out, '\n'); line != NULL; line = strchr(line + 1, '\n'))
+		if (sscanf(line + 1, "%d: %f kHz ; power %f dB", &ch, &off, &p) == 3) power_dB[ch] = p;
+}
+
+int main(void)
+{
+	static const double carrier_Hz[] = {0, 12500.0, -12500.0, 25000.0, -81000.0};
+	float power_dB[CHAN_MAX], ref_dB;
+	double s;
+	int k, j, pass = 1, ok;
+
+	chan_init();
+	for (k = 0; k < 5; k++)
+	{
+		run(carrier_Hz[k], 0.5, 0, 0, 0, power_dB);
+		ref_dB = (k < CHAN_MAX) ? power_dB[k] : 20*log10f(0.5f); //the last one is outside of all channels
+		printf("carrier %+6.1f kHz:", carrier_Hz[k]/1.0e3);
+		ok = 1;
+		for (j = 0; j < CHAN_MAX; j++)
+		{
+			printf(" %7.1f", power_dB[j]);
+			if ( (j != k) && (power_dB[j] > ref_dB - CHAN_TEST_REJ_dB) ) ok = 0;
+		}
+		printf(" dB - %s\n", ok ? "ok" : "FAIL");
+		pass &= ok;
+	}
+
+	run(12500.0, 0.5, -12500.0, 0.05, 2, power_dB);
+	s = sinad(&Audio[BLOCKS*AUDIO_BLOCK/2], BLOCKS*AUDIO_BLOCK/2, AUDIO_FS_Hz);
+	ok = s > CHAN_TEST_SINAD_dB;
+	printf("FM tone at -12.5 kHz, 20 dB stronger carrier at +12.5 kHz: SINAD %.1f dB - %s\n", s, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
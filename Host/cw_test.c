@@ -0,0 +1,176 @@
+/*
+ * cw_test.c - host test of CW receiver (cw.c) - Morse decoder copy of keyed carrier in white noise
+ *
+ * The text is keyed twice with 4 ms rise and fall time, 50 Hz from zero beat. The decoder learns the speed on the
+ * first copy, the second one may have at most CW_TEST_ERRORS character errors (edit distance to the best matching
+ * part of the output). SNR is in 500 Hz bandwidth. Noise alone (carrier never keyed) may print at most
+ * CW_TEST_NOISE_CHARS characters while the levels settle.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc cw_test.c ../stm32f407_mxl5007t/Core/Src/cw.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_mag.c ../stm32f407_mxl5007t/Core/Src/dsp_fir.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm -o cw_test && ./cw_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "cw.h"
+
+#define CW_TEST_TEXT        "CQ CQ DE SP5ABC SP5ABC K TEST 1234567890 THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 73"
+#define CW_TEST_COPY        "TEST 1234567890 THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 73 CQ CQ DE SP5ABC SP5ABC K TEST"
+#define CW_TEST_ERRORS      2
+#define CW_TEST_NOISE_CHARS 2
+#define CW_TEST_AMP         0.01
+#define CW_TEST_OFFSET_Hz   50.0
+
+DWT_Type Host_DWT;
+uint32_t SystemCoreClock = 168000000;
+
+static char Out[4096]; //decoder output
+static size_t Out_len;
+static char Key[32768]; //key state per dot
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	if (Out_len < sizeof(Out)) Out_len += vsnprintf(&Out[Out_len], sizeof(Out) - Out_len, format, args);
+	va_end(args);
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+static const char* morse(char c)
+{
+	static const char* letter[] = {".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-", ".-..",
+			"--", "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--.."};
+	static const char* digit[] = {"-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----."};
+
+	if ( (c >= 'A') && (c <= 'Z') ) return letter[c - 'A'];
+	if ( (c >= '0') && (c <= '9') ) return digit[c - '0'];
+	return "";
+}
+
+//key state per dot - dot, dash 3 dots, 1 dot between elements, 3 between characters, 7 between words
+static uint32_t keying(const char* text, int copies)
+{
+	uint32_t n = 0;
+	const char* p;
+	const char* m;
+	int r, i;
+
+	for (r = 0; r < copies; r++)
+		for (p = text; ; p++)
+		{
+			if ( (*p == ' ') || (*p == 0) )
+			{
+				for (i = 0; i < 4; i++) Key[n++] = 0; //3 already after the character
+				if (*p == 0) break;
+				continue;
+			}
+			for (m = morse(*p); *m; m++)
+			{
+				for (i = 0; i < ((*m == '.') ? 1 : 3); i++) Key[n++] = 1;
+				Key[n++] = 0;
+			}
+			Key[n++] = 0;
+			Key[n++] = 0;
+		}
+	return n;
+}
+
+//edit distance of s to the best matching part of Out (start and end of Out are free)
+static uint32_t errors(const char* s)
+{
+	static uint32_t d[2][sizeof(Out) + 1];
+	uint32_t m = strlen(s), i, j, best, c;
+
+	for (j = 0; j <= Out_len; j++) d[0][j] = 0;
+	for (i = 1; i <= m; i++)
+	{
+		d[i & 1][0] = i;
+		for (j = 1; j <= Out_len; j++)
+		{
+			c = d[(i - 1) & 1][j - 1] + (s[i - 1] != Out[j - 1]);
+			if (d[(i - 1) & 1][j] + 1 < c) c = d[(i - 1) & 1][j] + 1;
+			if (d[i & 1][j - 1] + 1 < c) c = d[i & 1][j - 1] + 1;
+			d[i & 1][j] = c;
+		}
+	}
+	best = m;
+	for (j = 0; j <= Out_len; j++) if (d[m & 1][j] < best) best = d[m & 1][j];
+	return best;
+}
+
+static int run(CW_Filter_enum filter, double snr_dB, int wpm, bool keyed)
+{
+	float I[BB_BLOCK], Q[BB_BLOCK], out[BB_BLOCK];
+	double dot = 1.2/wpm*FS_BB_Hz, tau = 0.004*FS_BB_Hz, env = 0, ph = 0;
+	double sigma = CW_TEST_AMP/sqrt(pow(10.0, snr_dB/10.0))*sqrt(FS_BB_Hz/500.0)/sqrt(2.0);
+	uint32_t keys = keying(CW_TEST_TEXT, 2), n = 0, u, k, blk = 0;
+	uint32_t total = keys*dot + FS_BB_Hz;
+	uint32_t err, chars = 0;
+	int pass;
+
+	srand(1);
+	Out_len = 0;
+	Out[0] = 0;
+	CW_Config.filter = filter;
+	CW_Config.decode = true;
+	cw_init();
+	while (n < total)
+	{
+		for (k = 0; k < BB_BLOCK; k++, n++)
+		{
+			u = n/dot;
+			env += ((((u < keys) && keyed) ? Key[u] : 0) - env)/tau;
+			ph += 2.0*M_PI*CW_TEST_OFFSET_Hz/FS_BB_Hz;
+			I[k] = CW_TEST_AMP*env*cos(ph) + sigma*gauss();
+			Q[k] = CW_TEST_AMP*env*sin(ph) + sigma*gauss();
+		}
+		cw_process(I, Q, BB_BLOCK, out);
+		if ((++blk & 63) == 0) cw_task(); //main loop
+	}
+	cw_task();
+
+	if (keyed)
+	{
+		err = errors(CW_TEST_COPY);
+		pass = err <= CW_TEST_ERRORS;
+		printf("%s Hz filter, %4.1f dB SNR, %d WPM: %u errors in %u characters - %s\n", cw_filter_name[filter], snr_dB, wpm,
+				(unsigned) err, (unsigned) strlen(CW_TEST_COPY), pass ? "ok" : "FAIL");
+	}
+	else
+	{
+		for (k = 0; k < Out_len; k++) if (Out[k] != ' ') chars++;
+		pass = chars <= CW_TEST_NOISE_CHARS;
+		printf("%s Hz filter, noise only: %u characters - %s\n", cw_filter_name[filter], (unsigned) chars, pass ? "ok" : "FAIL");
+	}
+	if (!pass) printf("output: %s\n", Out);
+	return pass;
+}
+
+int main(void)
+{
+	int pass = 1;
+
+	pass &= run(CW_FILTER_500, 10.0, 20, true);
+	pass &= run(CW_FILTER_200, 6.0, 20, true);
+	pass &= run(CW_FILTER_500, 10.0, 12, true);
+	pass &= run(CW_FILTER_500, 20.0, 35, true);
+	pass &= run(CW_FILTER_500, 0, 20, false);
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+/*
+ * data_gen.c - generates data_baseband.iq for data_test.c
+ *
+ * NBFM I/Q at FS_BB_Hz (after IQ filters) - an AX.25 frame in AFSK 1200 (3 kHz deviation) and a POCSAG 2400 batch
+ * with one alphanumeric message (4.5 kHz deviation), carrier 300 Hz off the channel and white noise 20 dB below it
+ * in the whole FS_BB_Hz band (32 dB in 12.5 kHz channel). Samples are interleaved int8 I/Q, full scale carrier is
+ * DATA_GEN_SCALE.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc data_gen.c -lm -o data_gen && ./data_gen
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+
+#define DATA_GEN_SCALE   100.0
+#define DATA_GEN_SNR_dB  20.0
+#define DATA_GEN_OFFSET  300.0
+
+static uint8_t Bits[4096];
+static int Bits_n;
+
+static void put(int b)
+{
+	Bits[Bits_n++] = b;
+}
+
+static void callsign(uint8_t* p, const char* c, int ssid, int last)
+{
+	int i;
+
+	for (i = 0; i < 6; i++) p[i] = ((*c) ? *c++ : ' ') << 1;
+	p[6] = 0x60 | (ssid << 1) | last;
+}
+
+//HDLC frame with bit stuffing in NRZI - 1 is no change of tone
+static int ax25_gen(void)
+{
+	const char* info = "!4903.50N/07201.75W-host test";
+	uint8_t f[128];
+	uint16_t crc = 0xFFFF;
+	int i, j, n, level = 0, ones = 0, start = Bits_n;
+
+	callsign(f, "APRS", 0, 0);
+	callsign(f + 7, "N0CALL", 9, 0);
+	callsign(f + 14, "WIDE1", 1, 1);
+	n = 21;
+	f[n++] = 0x03;
+	f[n++] = 0xF0;
+	memcpy(f + n, info, strlen(info));
+	n += strlen(info);
+	for (i = 0; i < n; i++)
+	{
+		crc ^= f[i];
+		for (j = 0; j < 8; j++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+	}
+	crc = ~crc;
+	f[n++] = crc & 0xFF;
+	f[n++] = crc >> 8;
+
+#define NRZI(b) do { if (!(b)) level ^= 1; put(level); } while (0)
+	for (i = 0; i < 16; i++)
+		for (j = 0; j < 8; j++) NRZI((0x7E >> j) & 1);
+	for (i = 0; i < n; i++)
+		for (j = 0; j < 8; j++)
+		{
+			int b = (f[i] >> j) & 1;
+
+			NRZI(b);
+			if (b && (++ones == 5))
+			{
+				NRZI(0);
+				ones = 0;
+			}
+			else if (!b) ones = 0;
+		}
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 8; j++) NRZI((0x7E >> j) & 1);
+	return Bits_n - start;
+}
+
+//BCH(31,21) and even parity
+static uint32_t pocsag_cw(uint32_t d21)
+{
+	uint32_t r = d21 << 10, cw;
+	int j;
+
+	for (j = 30; j >= 10; j--)
+		if (r & (1UL << j)) r ^= 0x769UL << (j - 10);
+	cw = (d21 << 11) | (r << 1);
+	return cw | __builtin_parity(cw);
+}
+
+static int pocsag_gen(uint32_t addr, int func, const char* msg)
+{
+	uint32_t cws[16], chunk = 0;
+	int i, j, nc = 0, cb = 0, start = Bits_n;
+
+	for (i = 0; i < 16; i++) cws[i] = 0x7A89C197; //idle
+	nc = 2*(addr & 7);
+	cws[nc++] = pocsag_cw(((addr >> 3) << 2) | func);
+	for (; *msg; msg++)
+		for (j = 0; j < 7; j++)
+		{
+			chunk = (chunk << 1) | ((*msg >> j) & 1);
+			if (++cb == 20)
+			{
+				cws[nc++] = pocsag_cw((1UL << 20) | chunk);
+				chunk = cb = 0;
+			}
+		}
+	if (cb) cws[nc++] = pocsag_cw((1UL << 20) | (chunk << (20 - cb)));
+
+	for (i = 0; i < 576; i++) put(i & 1);
+	for (j = 31; j >= 0; j--) put((0x7CD215D8 >> j) & 1);
+	for (i = 0; i < 16; i++)
+		for (j = 31; j >= 0; j--) put((cws[i] >> j) & 1);
+	for (i = 0; i < 64; i++) put(i & 1);
+	return Bits_n - start;
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+	return sqrt(-2*log(u))*cos(2*M_PI*v);
+}
+
+//FM modulation of bits from..from+n at baud, AFSK tones or direct FSK
+static void modulate(FILE* f, int from, int n, double baud, int afsk, double* phase)
+{
+	double fs = FS_BB_Hz, noise = pow(10, -DATA_GEN_SNR_dB/20)/sqrt(2), tone = 0, freq;
+	long k, len = (long) (n*fs/baud);
+	int8_t iq[2];
+
+	for (k = 0; k < len; k++)
+	{
+		int b = Bits[from + (int) (k*baud/fs)];
+
+		if (afsk)
+		{
+			tone += 2*M_PI*(b ? 1200.0 : 2200.0)/fs;
+			freq = 3000.0*cos(tone);
+		}
+		else freq = b ? 4500.0 : -4500.0; //POCSAG - 1 is the lower frequency, the decoder takes both polarities
+		*phase += 2*M_PI*(freq + DATA_GEN_OFFSET)/fs;
+		iq[0] = (int8_t) lrint(DATA_GEN_SCALE*(cos(*phase) + noise*gauss()));
+		iq[1] = (int8_t) lrint(DATA_GEN_SCALE*(sin(*phase) + noise*gauss()));
+		fwrite(iq, 1, 2, f);
+	}
+}
+
+int main(void)
+{
+	FILE* f = fopen("data_baseband.iq", "wb");
+	double phase = 0;
+	int n;
+
+	if (f == NULL) return 1;
+	srand(1);
+	n = ax25_gen();
+	modulate(f, 0, n, 1200.0, 1, &phase);
+	n = pocsag_gen(1234568, 3, "Host test 2400");
+	modulate(f, Bits_n - n, n, 2400.0, 0, &phase);
+	fclose(f);
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * data_test.c - host test of data demodulators (data_demod.c, ax25.c, pocsag.c) on data_baseband.iq
+ *
+ * The baseband file (data_gen.c) goes through both sources of data_process() like in the ADC callback:
+ * FM audio - polar discriminator at FS_BB_Hz (DATA_SRC_BB) ; NBFM - nbfm_process() and its discriminator output at
+ * AUDIO_FS_Hz (DATA_SRC_AUDIO). Every mode/source pair has to print the expected frame. stub/ has the HAL header
+ * included by main.h, the rest comes from Core.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc data_test.c ../stm32f407_mxl5007t/Core/Src/data_demod.c
+ *     ../stm32f407_mxl5007t/Core/Src/ax25.c ../stm32f407_mxl5007t/Core/Src/pocsag.c ../stm32f407_mxl5007t/Core/Src/nbfm.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_fir.c ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm -o data_test && ./data_test
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "printf.h"
+#include "usart.h"
+#include "nbfm.h"
+#include "data_demod.h"
+
+Output_demod_type_enum Demod_Type;
+volatile uint32_t ADC_overruns;
+
+static char Out[4096]; //console output of the decoders
+static size_t Out_len;
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	if (Out_len < sizeof(Out)) Out_len += vsnprintf(&Out[Out_len], sizeof(Out) - Out_len, format, args);
+	va_end(args);
+}
+
+void usart_putc(void* p, char c)
+{
+	(void) p;
+	if (Out_len < sizeof(Out) - 1) Out[Out_len++] = c;
+}
+
+void audio_i2s_write(const float* L, const float* R, uint16_t n, float scale)
+{
+	(void) L; (void) R; (void) n; (void) scale;
+}
+
+static int run(FILE* f, Data_Mode_enum mode, Output_demod_type_enum demod, NBFM_Channel_enum channel, const char* expected)
+{
+	int8_t iq[2*BB_BLOCK];
+	float I[BB_BLOCK], Q[BB_BLOCK], audio[BB_BLOCK], prev_i = 1, prev_q = 0;
+	uint16_t k, m;
+	int pass;
+
+	rewind(f);
+	Out_len = 0;
+	Out[0] = 0;
+	Demod_Type = demod;
+	NBFM_Config.channel = channel;
+	nbfm_init();
+	data_init();
+	data_set_mode(mode);
+	Data_Config.output = DATA_OUT_TEXT;
+
+	while (fread(iq, 2, BB_BLOCK, f) == BB_BLOCK)
+	{
+		for (k = 0; k < BB_BLOCK; k++)
+		{
+			I[k] = iq[2*k]/100.0f;
+			Q[k] = iq[2*k + 1]/100.0f;
+		}
+		if (demod == DEMOD_NBFM)
+		{
+			m = nbfm_process(I, Q, BB_BLOCK, audio);
+			data_process(NBFM_Discr, m, DATA_SRC_AUDIO);
+		}
+		else
+		{
+			for (k = 0; k < BB_BLOCK; k++)
+			{
+				audio[k] = atan2f(prev_i*Q[k] - I[k]*prev_q, I[k]*prev_i + Q[k]*prev_q);
+				prev_i = I[k];
+				prev_q = Q[k];
+			}
+			data_process(audio, BB_BLOCK, DATA_SRC_BB);
+		}
+		data_task();
+	}
+	data_task();
+
+	pass = strstr(Out, expected) != NULL;
+	printf("%-4s %-10s %s\n", pass ? "ok" : "FAIL", data_mode_name[mode], (demod == DEMOD_NBFM) ? "NBFM I/Q" : "FM audio");
+	if (!pass) printf("expected: %s\noutput:\n%s\n", expected, Out);
+	return pass;
+}
+
+int main(void)
+{
+	const char* ax25 = "N0CALL-9>APRS,WIDE1-1:!4903.50N/07201.75W-host test";
+	const char* pocsag = "1234568/3: Host test 2400";
+	FILE* f = fopen("data_baseband.iq", "rb");
+	int pass = 1;
+
+	if (f == NULL)
+	{
+		printf("data_baseband.iq not found - run data_gen first\n");
+		return 1;
+	}
+	pass &= run(f, DATA_AFSK1200, DEMOD_FM, NBFM_CHANNEL_12k5, ax25);
+	pass &= run(f, DATA_AFSK1200, DEMOD_NBFM, NBFM_CHANNEL_12k5, ax25);
+	pass &= run(f, DATA_POCSAG2400, DEMOD_FM, NBFM_CHANNEL_25k, pocsag);
+	pass &= run(f, DATA_POCSAG2400, DEMOD_NBFM, NBFM_CHANNEL_25k, pocsag); //pagers use 25 kHz channels
+	fclose(f);
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+ * enob_test.c - host test of ENOB/SINAD measurement and integer CIC decimation paths (enob.c)
+ *
+ * Simulated 12-bit ADC codes (tone at the mixer table frequency + TONE_OFFSET_Hz, Gaussian noise of ADC_NOISE_LSB and
+ * quantization) and I/Q of the DSP chain are captured while enob_measure() waits for them (HAL_GetTick() stands in
+ * for the ADC callback). The table from enob_measure() is parsed: raw ADC ENOB has to be within ENOB_TEST_BITS from
+ * the value of the simulated noise and both CIC paths have to keep the processing gain within ENOB_TEST_GAIN_BITS
+ * from the ideal one (white noise, +/-fs/16 of FS_ADC_Hz/2).
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc enob_test.c ../stm32f407_mxl5007t/Core/Src/enob.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_fft.c -lm -o enob_test && ./enob_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "cmd.h"
+#include "freq_plan.h"
+#include "enob.h"
+
+#define NCO_LEN             33
+#define NCO_STEP            10     //mixer at 10/33 of FS_ADC_Hz
+#define TONE_OFFSET_Hz      10300.0
+#define TONE_AMP            0.9    //of full scale
+#define ADC_NOISE_LSB       0.3    //rms, quantization comes on top
+#define ENOB_TEST_BITS      0.2
+#define ENOB_TEST_GAIN_BITS 0.4
+
+IQ_Filter_enum IQ_Filter = IQ_FILTER_105kHz;
+const float IQ_Filter_bw_Hz[IQ_FILTERS] = {105000.0, 15000.0, 3000.0, 6000.0, 10000.0, 30000.0, 60000.0};
+
+static float Nco_sin[NCO_LEN], Nco_cos[NCO_LEN];
+const float *NCO_sin = Nco_sin, *NCO_cos = Nco_cos;
+uint8_t NCO_len = NCO_LEN;
+
+static int16_t Adc[ENOB_WARMUP + ENOB_LEN];
+static float I[ENOB_LEN], Q[ENOB_LEN];
+static char Out[2048]; //enob_measure() table
+static size_t Out_len;
+
+//enob_measure() waits for the captures here - everything is delivered in ADC_BLOCK and BB_BLOCK pieces at once
+uint32_t HAL_GetTick(void)
+{
+	uint16_t k;
+
+	for (k = 0; k < ENOB_WARMUP + ENOB_LEN; k += ADC_BLOCK)
+		enob_capture_adc(&Adc[k], (ENOB_WARMUP + ENOB_LEN - k < ADC_BLOCK) ? ENOB_WARMUP + ENOB_LEN - k : ADC_BLOCK);
+	for (k = 0; k < ENOB_LEN; k += BB_BLOCK)
+		enob_capture_bb(&I[k], &Q[k], BB_BLOCK);
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	if (Out_len < sizeof(Out)) Out_len += vsnprintf(&Out[Out_len], sizeof(Out) - Out_len, format, args);
+	va_end(args);
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+//the last three numbers of the path row - ENOB, gain and (ideal gain)
+static int row(const char* path, double* enob, double* gain, double* ideal)
+{
+	char line[256], *tok[16], *p;
+	const char* s;
+	int n = 0;
+
+	for (s = Out; (s = strstr(s, path)) != NULL; s++)
+		if ( (s == Out) || (s[-1] == '\n') ) break;
+	if (s == NULL) return 0;
+	strncpy(line, s, sizeof(line) - 1);
+	line[sizeof(line) - 1] = 0;
+	line[strcspn(line, "\r\n")] = 0;
+	for (p = strtok(line, " ()\r\n"); (p != NULL) && (n < 16); p = strtok(NULL, " ()\r\n")) tok[n++] = p;
+	if (n < 3) return 0;
+	*enob = atof(tok[n - 3]);
+	*gain = atof(tok[n - 2]);
+	*ideal = atof(tok[n - 1]);
+	return 1;
+}
+
+int main(void)
+{
+	static const char* Cic[] = {"cic2", "cic4"};
+	double f = (double) NCO_STEP/NCO_LEN*FS_ADC_Hz + TONE_OFFSET_Hz, x, lsb = 1.0/2047.5, sinad, tone_dBFS, expect;
+	double enob, gain, ideal;
+	uint16_t k;
+	int pass = 1, ok;
+
+	for (k = 0; k < NCO_LEN; k++)
+	{
+		Nco_sin[k] = sin(2.0*M_PI*NCO_STEP*k/NCO_LEN);
+		Nco_cos[k] = cos(2.0*M_PI*NCO_STEP*k/NCO_LEN);
+	}
+	srand(1);
+	for (k = 0; k < ENOB_WARMUP + ENOB_LEN; k++)
+	{
+		x = TONE_AMP*cos(2.0*M_PI*f*k/FS_ADC_Hz) + ADC_NOISE_LSB*lsb*gauss();
+		Adc[k] = (int16_t) lrint(2047.5 + 2047.5*x);
+	}
+	for (k = 0; k < ENOB_LEN; k++)
+	{
+		x = 2.0*M_PI*TONE_OFFSET_Hz*k/FS_BB_Hz;
+		I[k] = 0.45*cos(x);
+		Q[k] = 0.45*sin(x);
+	}
+
+	fft_init();
+	enob_measure();
+	printf("%s", Out);
+
+	//the same formula like enob.c - noise of the simulation and quantization
+	tone_dBFS = 20.0*log10(TONE_AMP);
+	sinad = 10.0*log10(TONE_AMP*TONE_AMP/2.0/((ADC_NOISE_LSB*ADC_NOISE_LSB + 1.0/12.0)*lsb*lsb));
+	expect = (sinad - tone_dBFS - 1.76)/6.02;
+	ok = row("adc", &enob, &gain, &ideal) && (fabs(enob - expect) < ENOB_TEST_BITS);
+	printf("adc: ENOB %.2f, %.2f from the simulated noise - %s\n", enob, expect, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	for (k = 0; k < 2; k++)
+	{
+		ok = row(Cic[k], &enob, &gain, &ideal) && (fabs(gain - ideal) < ENOB_TEST_GAIN_BITS);
+		printf("%s: processing gain %.2f bits, ideal %.2f - %s\n", Cic[k], gain, ideal, ok ? "ok" : "FAIL");
+		pass &= ok;
+	}
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/*
+ * fm_discr_test.c - host test of FM discriminators (FM_Discr) of the ADC callback - SINAD of demodulated 1 kHz tone
+ *
+ * The discriminator lines of DEMOD_FM case in stm32f4xx_it.c are repeated here (they live in the ADC callback), the
+ * asin table and fast_atan2f() come from Core. Synthetic I/Q at FS_BB_Hz like Matlab/fm_discr_compare.m: FM with 1 kHz
+ * tone and white noise, raw discriminator output without audio filter. Prints SINAD table of the script header and
+ * fails if polar discriminator isn't better than Noga's one.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc fm_discr_test.c ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm
+ *     -o fm_discr_test && ./fm_discr_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "main.h"
+#include "dsp_math.h"
+#include "dsp_tables.h"
+
+#define SAMPLES 65536
+#define F_TONE  1.0e3
+
+static float I[SAMPLES], Q[SAMPLES];
+static double Y[FM_DISCR_NUM][SAMPLES];
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+//least squares fit of the tone and DC - the rest is noise and distortion
+static double sinad(const double* x, int n, double fs)
+{
+	double a[3][3] = {{0}}, b[3] = {0}, c[3], p = 0, r = 0, f, t, e;
+	int i, j, k, l;
+
+	for (k = 0; k < n; k++)
+	{
+		double v[3] = {cos(2.0*M_PI*F_TONE*k/fs), sin(2.0*M_PI*F_TONE*k/fs), 1.0};
+		for (i = 0; i < 3; i++)
+		{
+			b[i] += v[i]*x[k];
+			for (j = 0; j < 3; j++) a[i][j] += v[i]*v[j];
+		}
+	}
+	for (i = 0; i < 3; i++)
+		for (j = i + 1; j < 3; j++)
+		{
+			f = a[j][i]/a[i][i];
+			for (l = 0; l < 3; l++) a[j][l] -= f*a[i][l];
+			b[j] -= f*b[i];
+		}
+	for (i = 2; i >= 0; i--)
+	{
+		c[i] = b[i];
+		for (j = i + 1; j < 3; j++) c[i] -= a[i][j]*c[j];
+		c[i] /= a[i][i];
+	}
+	for (k = 0; k < n; k++)
+	{
+		t = c[0]*cos(2.0*M_PI*F_TONE*k/fs) + c[1]*sin(2.0*M_PI*F_TONE*k/fs);
+		e = x[k] - t - c[2];
+		p += t*t;
+		r += e*e;
+	}
+	return 10.0*log10(p/r);
+}
+
+static void run(double f_dev, double snr_dB, double* sinad_dB)
+{
+	const float K = 0.5;
+	const float A_asin_arr_scale = (N_asin - 1.0)/2.0;
+	const float B_asin_arr_scale = (N_asin - 1.0)/2.0;
+	float i0, i1, i2, q0, q1, q2, phase;
+	double ph, noise = pow(10.0, -snr_dB/20.0)/sqrt(2.0);
+	int k, n, d;
+
+	srand(1);
+	for (k = 0; k < SAMPLES; k++)
+	{
+		ph = f_dev/F_TONE*sin(2.0*M_PI*F_TONE*k/FS_BB_Hz); //frequency f_dev*cos()
+		I[k] = cos(ph) + noise*gauss();
+		Q[k] = sin(ph) + noise*gauss();
+	}
+
+	for (k = 2, n = 0; k < SAMPLES; k++, n++)
+	{
+		i0 = I[k]; i1 = I[k-1]; i2 = I[k-2];
+		q0 = Q[k]; q1 = Q[k-1]; q2 = Q[k-2];
+
+		phase = K*(i1*(q0 - q2) - (i0 - i2)*q1) / (i1*i1 + q1*q1);
+		if (phase > 1.0f) phase = 1.0f;
+		if (phase < -1.0f) phase = -1.0f;
+		Y[FM_DISCR_NOGA][n] = asin_arr[(uint16_t) (A_asin_arr_scale*phase + B_asin_arr_scale)];
+
+		Y[FM_DISCR_ATAN2][n] = fast_atan2f(i1*q0 - i0*q1, i0*i1 + q0*q1);
+	}
+
+	for (d = 0; d < FM_DISCR_NUM; d++) sinad_dB[d] = sinad(Y[d], n, FS_BB_Hz);
+}
+
+int main(void)
+{
+	static const double f_dev[] = {50e3, 50e3, 75e3};
+	static const double snr_dB[] = {30.0, 60.0, 30.0};
+	double s[FM_DISCR_NUM];
+	int k, fail = 0;
+
+	printf("f_dev     SNR      noga    atan2   [SINAD dB]\n");
+	for (k = 0; k < 3; k++)
+	{
+		run(f_dev[k], snr_dB[k], s);
+		printf("%2.0f kHz   %2.0f dB   %5.1f   %5.1f\n", f_dev[k]/1e3, snr_dB[k], s[FM_DISCR_NOGA], s[FM_DISCR_ATAN2]);
+		if (s[FM_DISCR_ATAN2] < s[FM_DISCR_NOGA]) fail = 1;
+	}
+	printf("%s\n", fail ? "FAIL" : "PASS");
+
+	return fail;
+}
@@ -0,0 +1,127 @@
+/*
+ * iq_corr_test.c - host test of ADC DC offset removal and I/Q imbalance estimation and correction (iq_corr.c)
+ *
+ * Noise ADC blocks with DC offset go through iqc_dc_update() the way the scaling loop does it (IQC_DC_applied is
+ * subtracted), circular Gaussian I/Q with known gain and phase error goes through iqc_process(). The estimates are
+ * read from iqc_print(): DC has to be within IQC_TEST_DC from the offset, gain and phase within IQC_TEST_GAIN_dB and
+ * IQC_TEST_PHASE_deg, and with correction on the remaining I/Q correlation has to be below IQC_TEST_CORR and the
+ * gain error below IQC_TEST_GAIN_dB.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc iq_corr_test.c ../stm32f407_mxl5007t/Core/Src/iq_corr.c -lm
+ *     -o iq_corr_test && ./iq_corr_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "iq_corr.h"
+
+#define BLOCKS             50000 //7.5 s of baseband blocks - averages are 0.62 s
+#define CHECK_BLOCKS       2000
+#define DC_OFFSET          0.013
+#define GAIN               1.05  //0.42 dB
+#define PHASE_rad          0.03  //1.72 deg
+#define ADC_NOISE          0.1
+#define IQC_TEST_DC        0.003 //4 sigma of the estimate - block mean is averaged over ~2/IQC_DC_COEFF blocks
+#define IQC_TEST_GAIN_dB   0.05
+#define IQC_TEST_PHASE_deg 0.15
+#define IQC_TEST_CORR      0.01
+
+static char Out[512]; //iqc_print() output
+static size_t Out_len;
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	if (Out_len < sizeof(Out)) Out_len += vsnprintf(&Out[Out_len], sizeof(Out) - Out_len, format, args);
+	va_end(args);
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+//one ADC block with DC offset and one I/Q block with imbalance
+static void block(float* I, float* Q)
+{
+	float x, sum = 0, a, b;
+	uint16_t k;
+
+	for (k = 0; k < ADC_BLOCK; k++)
+	{
+		x = DC_OFFSET + ADC_NOISE*gauss() - IQC_DC_applied;
+		sum += x;
+	}
+	iqc_dc_update(sum, ADC_BLOCK);
+
+	for (k = 0; k < BB_BLOCK; k++)
+	{
+		a = gauss();
+		b = gauss();
+		I[k] = a;
+		Q[k] = GAIN*(b*cos(PHASE_rad) + a*sin(PHASE_rad));
+	}
+	iqc_process(I, Q, BB_BLOCK);
+}
+
+int main(void)
+{
+	float I[BB_BLOCK], Q[BB_BLOCK], dc = 0, gain_dB = 0, phase_deg = 0;
+	double sii = 0, sqq = 0, siq = 0, corr, res_dB;
+	const char* p;
+	uint32_t b, k;
+	int pass = 1, ok;
+
+	srand(1);
+	iqc_reset();
+	iqc_set_dc_block(true);
+	for (b = 0; b < BLOCKS; b++) block(I, Q);
+
+	Out_len = 0;
+	iqc_print();
+	p = strstr(Out, "LSB (");
+	if (p) sscanf(p, "LSB (%e)", &dc);
+	p = strstr(Out, "gain ");
+	if (p) sscanf(p, "gain %f dB ; phase %f deg", &gain_dB, &phase_deg);
+
+	ok = fabs(dc - DC_OFFSET) < IQC_TEST_DC;
+	printf("DC offset %.4f: estimate %.4f - %s\n", DC_OFFSET, dc, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	ok = (fabs(gain_dB - 20.0*log10(GAIN)) < IQC_TEST_GAIN_dB) && (fabs(phase_deg - PHASE_rad*180.0/M_PI) < IQC_TEST_PHASE_deg);
+	printf("imbalance %.2f dB / %.2f deg: estimate %.2f dB / %.2f deg - %s\n", 20.0*log10(GAIN), PHASE_rad*180.0/M_PI, gain_dB,
+			phase_deg, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	iqc_set_corr(true);
+	for (b = 0; b < CHECK_BLOCKS; b++)
+	{
+		block(I, Q);
+		for (k = 0; k < BB_BLOCK; k++)
+		{
+			sii += I[k]*I[k];
+			sqq += Q[k]*Q[k];
+			siq += I[k]*Q[k];
+		}
+	}
+	corr = siq/sqrt(sii*sqq);
+	res_dB = 10.0*log10(sqq/sii);
+	ok = (fabs(corr) < IQC_TEST_CORR) && (fabs(res_dB) < IQC_TEST_GAIN_dB);
+	printf("correction on: I/Q correlation %.4f, gain %.3f dB - %s\n", corr, res_dB, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
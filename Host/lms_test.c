@@ -0,0 +1,136 @@
+/*
+ * lms_test.c - host test of LMS auto-notch and noise reduction (lms.c) on audio at AUDIO_FS_Hz
+ *
+ * Auto-notch: steady 1 kHz heterodyne 15 dB above a slowly modulated 440 Hz tone - the heterodyne has to be reduced
+ * by LMS_TEST_NOTCH_dB and the tone may lose at most LMS_TEST_KEEP_dB. Noise reduction: synthetic voice (pitch
+ * harmonics with syllable envelope) in white noise - SNR (voice against everything else, after the best voice gain)
+ * has to improve by LMS_TEST_NR_dB. Both are measured on the second half of the run. Cycles aren't measured here -
+ * x86 says nothing about Cortex-M4, "lms bench" does it on the target.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc lms_test.c ../stm32f407_mxl5007t/Core/Src/lms.c -lm -o lms_test && ./lms_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "main.h"
+#include "audio_i2s.h"
+#include "lms.h"
+
+#define SAMPLES           264000 //10 s
+#define HET_Hz            1000.3
+#define HET_AMP           0.3
+#define TONE_AMP          0.053  //15 dB below the heterodyne
+#define VOICE_AMP         0.3
+#define NOISE_SIGMA       0.1
+#define LMS_TEST_NOTCH_dB 30.0
+#define LMS_TEST_KEEP_dB  6.0    //the modulated tone is quite steady too
+#define LMS_TEST_NR_dB    1.5
+
+DWT_Type Host_DWT;
+uint32_t SystemCoreClock = 168000000;
+
+static float In[SAMPLES], Out[SAMPLES], Voice[SAMPLES];
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	(void) format;
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+//Out = In through the filter, AUDIO_BLOCK samples per call like after demodulators
+static void run(LMS_Filter_enum filter)
+{
+	uint32_t n;
+
+	lms_init();
+	lms_set_on(filter, true);
+	for (n = 0; n < SAMPLES; n++) Out[n] = In[n];
+	for (n = 0; n + AUDIO_BLOCK <= SAMPLES; n += AUDIO_BLOCK)
+		lms_process(&Out[n], AUDIO_BLOCK);
+}
+
+//amplitude of f_Hz in the second half
+static double tone(const float* x, double f_Hz)
+{
+	double re = 0, im = 0;
+	uint32_t n;
+
+	for (n = SAMPLES/2; n < SAMPLES; n++)
+	{
+		re += x[n]*cos(2.0*M_PI*f_Hz*n/AUDIO_FS_Hz);
+		im += x[n]*sin(2.0*M_PI*f_Hz*n/AUDIO_FS_Hz);
+	}
+	return 2.0*sqrt(re*re + im*im)/(SAMPLES/2);
+}
+
+//voice to the rest after the best voice gain in the second half
+static double snr_dB(const float* x)
+{
+	double vv = 0, xv = 0, err = 0, g, d;
+	uint32_t n;
+
+	for (n = SAMPLES/2; n < SAMPLES; n++)
+	{
+		vv += Voice[n]*Voice[n];
+		xv += x[n]*Voice[n];
+	}
+	g = xv/vv;
+	for (n = SAMPLES/2; n < SAMPLES; n++)
+	{
+		d = x[n] - g*Voice[n];
+		err += d*d;
+	}
+	return 10.0*log10(g*g*vv/err);
+}
+
+int main(void)
+{
+	double t, ph = 0, f0, s, het, tone_in, tone_out, snr_in, snr_out;
+	uint32_t n, h;
+	int pass = 1, ok;
+
+	for (n = 0; n < SAMPLES; n++)
+	{
+		t = n/AUDIO_FS_Hz;
+		In[n] = HET_AMP*sin(2.0*M_PI*HET_Hz*t) + TONE_AMP*sin(2.0*M_PI*440.0*t)*(0.5 + 0.5*sin(2.0*M_PI*3.0*t));
+	}
+	tone_in = tone(In, 440.0);
+	run(LMS_NOTCH);
+	het = 20.0*log10(tone(Out, HET_Hz)/HET_AMP);
+	tone_out = 20.0*log10(tone(Out, 440.0)/tone_in);
+	ok = (het < -LMS_TEST_NOTCH_dB) && (tone_out > -LMS_TEST_KEEP_dB);
+	printf("notch %d taps: heterodyne %.1f dB, 440 Hz tone %+.1f dB - %s\n", LMS_NOTCH_TAPS, het, tone_out, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	srand(1);
+	for (n = 0; n < SAMPLES; n++)
+	{
+		t = n/AUDIO_FS_Hz;
+		f0 = 140.0 + 40.0*sin(2.0*M_PI*1.3*t);
+		ph += 2.0*M_PI*f0/AUDIO_FS_Hz;
+		for (h = 2, s = 0; h*f0 < 2800.0; h++) s += sin(h*ph + h*h)/h;
+		Voice[n] = VOICE_AMP*0.5*(1.0 + sin(2.0*M_PI*4.0*t))*s;
+		In[n] = Voice[n] + NOISE_SIGMA*gauss();
+	}
+	snr_in = snr_dB(In);
+	run(LMS_NR);
+	snr_out = snr_dB(Out);
+	ok = snr_out - snr_in > LMS_TEST_NR_dB;
+	printf("noise reduction %d taps: SNR %.1f dB -> %.1f dB (%+.1f dB) - %s\n", LMS_NR_TAPS, snr_in, snr_out, snr_out - snr_in,
+			ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
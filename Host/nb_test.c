@@ -0,0 +1,98 @@
+/*
+ * nb_test.c - host test of noise blanker and impulse limiter (nb.c) on ADC blocks
+ *
+ * IF tone with white noise (like scaled ADC samples) gets a 4 sample pulse every PULSE_PERIOD samples at random
+ * position in the block. After the average has settled, every pulse sample has to be zeroed (blank) or clipped below
+ * NB_TEST_CLIP of the pulse (limit), and nothing outside of the pulse, NB_PRE samples before it and the hang time
+ * after it may be touched (false triggers).
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc nb_test.c ../stm32f407_mxl5007t/Core/Src/nb.c -lm -o nb_test && ./nb_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include "main.h"
+#include "nb.h"
+
+#define BLOCKS        20000  //2.56 M samples
+#define SETTLE        8192   //samples - average decays from NB_AVG_INIT
+#define PULSE_PERIOD  20000
+#define PULSE_LEN     4
+#define PULSE_AMP     0.8
+#define TONE_AMP      0.1
+#define NOISE_SIGMA   0.02
+#define NB_TEST_CLIP  0.5    //limited pulse sample / pulse amplitude
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	(void) format;
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+static int run(NB_Mode_enum mode)
+{
+	static float x[BLOCKS*ADC_BLOCK], clean[BLOCKS*ADC_BLOCK];
+	static uint32_t pulse[BLOCKS*ADC_BLOCK/PULSE_PERIOD + 1]; //start positions
+	uint32_t n, p, j, pulses = 0, tested = 0, caught = 0, false_cnt = 0;
+	uint32_t pre = (mode == NB_BLANK) ? NB_PRE : 0, post = PULSE_LEN + ((mode == NB_BLANK) ? NB_Config.hang : 0);
+	int pass;
+
+	srand(1);
+	for (n = 0; n < BLOCKS*ADC_BLOCK; n++)
+		x[n] = clean[n] = TONE_AMP*cos(2.0*M_PI*0.27*n) + NOISE_SIGMA*gauss();
+	for (p = 1000; p + post < BLOCKS*ADC_BLOCK; p += PULSE_PERIOD + rand() % ADC_BLOCK)
+	{
+		pulse[pulses++] = p;
+		for (n = p; n < p + PULSE_LEN; n++)
+			x[n] += PULSE_AMP*((n & 1) ? 1 : -1);
+	}
+
+	nb_set_mode(mode);
+	for (n = 0; n < BLOCKS; n++)
+		nb_process(&x[n*ADC_BLOCK], ADC_BLOCK);
+
+	for (j = 0; j < pulses; j++)
+	{
+		if (pulse[j] < SETTLE) continue;
+		tested++;
+		for (n = pulse[j]; n < pulse[j] + PULSE_LEN; n++)
+			if (fabsf(x[n]) > NB_TEST_CLIP*PULSE_AMP) break;
+		if (n == pulse[j] + PULSE_LEN) caught++;
+	}
+
+	//samples changed outside of pulse, pre and hang time
+	for (n = SETTLE, j = 0; n < BLOCKS*ADC_BLOCK; n++)
+	{
+		while ( (j < pulses) && (n >= pulse[j] + post) ) j++;
+		if ( (j < pulses) && (n + pre >= pulse[j]) ) continue;
+		if (x[n] != clean[n]) false_cnt++;
+	}
+
+	pass = (caught == tested) && (false_cnt == 0);
+	printf("%s: %u of %u pulses caught, %u samples changed away from pulses - %s\n", nb_mode_name[mode], (unsigned) caught,
+			(unsigned) tested, (unsigned) false_cnt, pass ? "ok" : "FAIL");
+	return pass;
+}
+
+int main(void)
+{
+	int pass = 1;
+
+	pass &= run(NB_BLANK);
+	pass &= run(NB_LIMIT);
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/*
+ * nbfm_test.c - host test of NBFM receiver (nbfm.c) - audio level, SINAD, noise squelch and CTCSS/DCS detection
+ *
+ * FM carrier with 1 kHz tone at nominal deviation (plus sub-audio tone or DCS code) and white noise at FS_BB_Hz goes
+ * through nbfm_process(). CNR is in the noise bandwidth of the channel filter. The audio level has to be within
+ * NBFM_TEST_LEVEL_dB from NBFM_AUDIO_LEVEL, SINAD at 10 dB CNR has to be above NBFM_TEST_SINAD_dB, the default
+ * squelch has to open within NBFM_TEST_SQ_dB from NBFM_TEST_SQ_CNR_dB and stay closed on noise. CTCSS tones and DCS
+ * codes are read from nbfm_print(), the closest CTCSS tones must not open the tone squelch and noise alone must not
+ * show any DCS code. DCS words are made here by polynomial division, not by the LFSR of nbfm.c, so the two
+ * encoders check each other (the polynomial itself isn't verified against a radio).
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc nbfm_test.c ../stm32f407_mxl5007t/Core/Src/nbfm.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_fir.c ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm -o nbfm_test && ./nbfm_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "nbfm.h"
+
+#define NBFM_TEST_LEVEL_dB   0.5
+#define NBFM_TEST_SINAD_dB   12.0
+#define NBFM_TEST_SQ_CNR_dB  6.0
+#define NBFM_TEST_SQ_dB      3.0
+#define NBFM_TEST_TONE_Hz    300.0 //CTCSS and DCS deviation
+#define NBFM_TEST_NOISE_s    20.0  //noise only for DCS false detection
+#define PRINT_BLOCKS         1024  //nbfm_print() every 0.15 s - shorter than DCS detection hold
+
+static const double Noise_BW_Hz[NBFM_CHANNELS] = {11000.0, 16000.0}; //channel filter noise bandwidth
+static const double Dev_Hz[NBFM_CHANNELS] = {2500.0, 5000.0};
+
+typedef enum
+{
+	TONE_NONE = 0,
+	TONE_CTCSS,
+	TONE_DCS
+}Tone_enum;
+
+typedef struct
+{
+	double level;   //1 kHz audio amplitude
+	double sinad_dB;
+	double open;    //time fraction of open squelch (second half of the run)
+}NBFM_Result_TypeDef;
+
+static char Out[65536]; //nbfm_print() outputs of the run
+static size_t Out_len;
+static const char* Last; //the last one
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	if (Out_len < sizeof(Out)) Out_len += vsnprintf(&Out[Out_len], sizeof(Out) - Out_len, format, args);
+	va_end(args);
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+//23 bit DCS word: 12 data bits (code and "100") from x^22 down, remainder mod x^11 + x^10 + x^6 + x^5 + x^4 + x^2 + 1
+//from x^10 down - bit 0 is sent first
+static uint32_t dcs_word(uint16_t code)
+{
+	uint32_t data = (code & 0x1FF) | 0x800, p = 0, word = data;
+	int k;
+
+	for (k = 0; k < 12; k++)
+		if ((data >> k) & 1) p |= 1UL << (22 - k);
+	for (k = 22; k >= 11; k--)
+		if ((p >> k) & 1) p ^= 0xC75UL << (k - 11);
+	for (k = 0; k < 11; k++)
+		word |= ((p >> (10 - k)) & 1) << (12 + k);
+	return word;
+}
+
+//any DCS code received during the run
+static bool dcs_seen(void)
+{
+	const char* p;
+
+	for (p = strstr(Out, "received:"); p != NULL; p = strstr(p + 1, "received:"))
+		if (strncmp(strchr(p, '\r') - 4, "none", 4) != 0) return true;
+	return false;
+}
+
+//voice (1 kHz at nominal deviation, if voice), sub-audio tone [Hz] or DCS code, noise at cnr_dB (no carrier if < -90)
+static NBFM_Result_TypeDef run(NBFM_Channel_enum channel, double cnr_dB, bool voice, Tone_enum tone, double param, double secs)
+{
+	NBFM_Result_TypeDef r;
+	float I[BB_BLOCK], Q[BB_BLOCK], out[BB_BLOCK];
+	double ph = 0, t, f, amp = (cnr_dB < -90.0) ? 0 : 1.0, sigma, re = 0, im = 0, p = 0, a;
+	uint32_t word = (tone == TONE_DCS) ? dcs_word((uint16_t) param) : 0;
+	uint32_t b, k, n = 0, cnt = 0, open = 0, blocks = secs*FS_BB_Hz/BB_BLOCK, samples = 0;
+	uint16_t m;
+
+	sigma = (cnr_dB < -90.0) ? 0.1 : sqrt(FS_BB_Hz/(2.0*Noise_BW_Hz[channel])*pow(10.0, -cnr_dB/10.0));
+	if (cnr_dB > 90.0) sigma = 0;
+	srand(1);
+	Out_len = 0;
+	Out[0] = 0;
+	NBFM_Config.channel = channel;
+	NBFM_Config.squelch_dB = NBFM_SQ_DEFAULT_dB;
+	nbfm_init();
+
+	for (b = 0; b < blocks; b++)
+	{
+		for (k = 0; k < BB_BLOCK; k++, n++)
+		{
+			t = n/FS_BB_Hz;
+			f = voice ? Dev_Hz[channel]*sin(2.0*M_PI*1000.0*t) : 0;
+			if (tone == TONE_CTCSS) f += NBFM_TEST_TONE_Hz*sin(2.0*M_PI*param*t);
+			if (tone == TONE_DCS) f += ((word >> ((uint32_t) (t*NBFM_DCS_BAUD) % NBFM_DCS_BITS)) & 1) ? NBFM_TEST_TONE_Hz : -NBFM_TEST_TONE_Hz;
+			ph += 2.0*M_PI*f/FS_BB_Hz;
+			I[k] = amp*cos(ph) + sigma*gauss();
+			Q[k] = amp*sin(ph) + sigma*gauss();
+		}
+		m = nbfm_process(I, Q, BB_BLOCK, out);
+		if (b % PRINT_BLOCKS == PRINT_BLOCKS - 1) nbfm_print();
+		for (k = 0; k < m; k++, samples++)
+			if (b >= blocks/2)
+			{
+				re += out[k]*cos(2.0*M_PI*1000.0*samples/AUDIO_FS_Hz);
+				im += out[k]*sin(2.0*M_PI*1000.0*samples/AUDIO_FS_Hz);
+				p += out[k]*out[k];
+				open += out[k] != 0;
+				cnt++;
+			}
+	}
+
+	a = 2.0*sqrt(re*re + im*im)/cnt;
+	p /= cnt;
+	r.level = a;
+	r.sinad_dB = 10.0*log10(p/(p - a*a/2.0 + 1.0e-30));
+	r.open = (double) open/cnt;
+	Last = &Out[Out_len];
+	nbfm_print();
+	return r;
+}
+
+int main(void)
+{
+	static const double Ctcss_Hz[] = {67.0, 69.3, 97.4, 100.0, 151.4, 203.5, 254.1};
+	static const uint16_t Dcs[] = {0023, 0125, 0754}; //octal like on radios
+	NBFM_Result_TypeDef r;
+	NBFM_Channel_enum ch;
+	double cnr, level_dB;
+	char s[32];
+	uint32_t k;
+	int pass = 1, ok;
+
+	for (ch = NBFM_CHANNEL_12k5; ch < NBFM_CHANNELS; ch++)
+	{
+		r = run(ch, 100.0, true, TONE_NONE, 0, 1.0);
+		level_dB = 20.0*log10(r.level/NBFM_AUDIO_LEVEL);
+		ok = fabs(level_dB) < NBFM_TEST_LEVEL_dB;
+		printf("%s kHz channel: 1 kHz audio level %.3f (%+.2f dB) - %s\n", nbfm_channel_name[ch], r.level, level_dB, ok ? "ok" : "FAIL");
+		pass &= ok;
+
+		r = run(ch, 10.0, true, TONE_NONE, 0, 1.0);
+		ok = (r.sinad_dB > NBFM_TEST_SINAD_dB) && (r.open > 0.99);
+		printf("%s kHz channel: SINAD %.1f dB at 10 dB CNR, squelch open %.0f%% - %s\n", nbfm_channel_name[ch], r.sinad_dB,
+				100.0*r.open, ok ? "ok" : "FAIL");
+		pass &= ok;
+	}
+
+	//the lowest CNR with squelch open all the time
+	for (cnr = 0; cnr <= 15.0; cnr += 1.0)
+	{
+		r = run(NBFM_CHANNEL_12k5, cnr, true, TONE_NONE, 0, 1.0);
+		if (r.open > 0.99) break;
+	}
+	ok = fabs(cnr - NBFM_TEST_SQ_CNR_dB) <= NBFM_TEST_SQ_dB;
+	printf("squelch %d dB: open from %.0f dB CNR (SINAD %.1f dB) - %s\n", NBFM_SQ_DEFAULT_dB, cnr, r.sinad_dB, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	r = run(NBFM_CHANNEL_12k5, -100.0, false, TONE_NONE, 0, 2.0);
+	ok = r.open == 0;
+	printf("squelch %d dB: noise only, open %.1f%% - %s\n", NBFM_SQ_DEFAULT_dB, 100.0*r.open, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	for (k = 0; k < sizeof(Ctcss_Hz)/sizeof(Ctcss_Hz[0]); k++)
+	{
+		run(NBFM_CHANNEL_12k5, 20.0, true, TONE_CTCSS, Ctcss_Hz[k], 1.5);
+		snprintf(s, sizeof(s), "received: CTCSS %.1f Hz", Ctcss_Hz[k]);
+		ok = strstr(Last, s) != NULL;
+		printf("CTCSS %.1f Hz detected - %s\n", Ctcss_Hz[k], ok ? "ok" : "FAIL");
+		if (!ok) printf("%s", Last);
+		pass &= ok;
+	}
+
+	//tone squelch set to the neighbour of the received tone
+	nbfm_set_ctcss(69.3);
+	r = run(NBFM_CHANNEL_12k5, 20.0, true, TONE_CTCSS, 67.0, 1.5);
+	ok = r.open == 0;
+	nbfm_set_ctcss(97.4);
+	r = run(NBFM_CHANNEL_12k5, 20.0, true, TONE_CTCSS, 100.0, 1.5);
+	ok &= r.open == 0;
+	nbfm_set_ctcss(100.0);
+	r = run(NBFM_CHANNEL_12k5, 20.0, true, TONE_CTCSS, 100.0, 1.5);
+	ok &= r.open > 0.99;
+	nbfm_tone_off();
+	printf("CTCSS squelch: 67.0 Hz closed at 69.3, 100.0 Hz closed at 97.4 and open at 100.0 - %s\n", ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	for (k = 0; k < sizeof(Dcs)/sizeof(Dcs[0]); k++)
+	{
+		nbfm_set_dcs(Dcs[k]);
+		r = run(NBFM_CHANNEL_12k5, 20.0, true, TONE_DCS, Dcs[k], 1.5);
+		snprintf(s, sizeof(s), "; DCS %03o", Dcs[k]);
+		ok = (strstr(strstr(Last, "received:"), s) != NULL) && (r.open > 0.99);
+		printf("DCS %03o detected, squelch open %.0f%% - %s\n", Dcs[k], 100.0*r.open, ok ? "ok" : "FAIL");
+		if (!ok) printf("%s", Last);
+		pass &= ok;
+	}
+	nbfm_tone_off();
+
+	r = run(NBFM_CHANNEL_12k5, -100.0, false, TONE_NONE, 0, NBFM_TEST_NOISE_s);
+	ok = !dcs_seen();
+	printf("noise only %.0f s: no DCS code - %s\n", NBFM_TEST_NOISE_s, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/*
+ * nfloor_test.c - host test of FFT median noise floor estimator and channel SNR (nfloor.c)
+ *
+ * Mixer output (complex white noise and a carrier in the channel at FS_ADC_Hz) goes through nf_capture() and nf_task()
+ * like in the ADC callback and the main loop. Mean of NF_TEST_ESTIMATES estimates has to be within NF_TEST_SNR_dB
+ * from the true SNR (0 - 30 dB) and the noise in the channel within NF_TEST_NOISE_dB, for narrow and wide IQ filter.
+ * Then 40 dB stronger carrier outside of the channel must not move the noise estimate - that's why it's a median.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc nfloor_test.c ../stm32f407_mxl5007t/Core/Src/nfloor.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_fft.c -lm -o nfloor_test && ./nfloor_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "main.h"
+#include "cmd.h"
+#include "dsp_fft.h"
+#include "nfloor.h"
+
+#define NOISE_POW          1.0e-4 //complex noise power at FS_ADC_Hz
+#define CARRIER_Hz         2000.0
+#define OFF_CHANNEL_Hz     300000.0
+#define NF_TEST_ESTIMATES  200
+#define NF_TEST_SNR_dB     0.3
+#define NF_TEST_NOISE_dB   0.3
+
+IQ_Filter_enum IQ_Filter = IQ_FILTER_105kHz;
+const float IQ_Filter_bw_Hz[IQ_FILTERS] = {105000.0, 15000.0, 3000.0, 6000.0, 10000.0, 30000.0, 60000.0};
+const char *iq_filter_name[IQ_FILTERS] = {"105", "15", "3", "6", "10", "30", "60"};
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	(void) format;
+}
+
+static double gauss(void)
+{
+	double u = (rand() + 1.0)/(RAND_MAX + 2.0), v = (rand() + 1.0)/(RAND_MAX + 2.0);
+
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*v);
+}
+
+//noise power in the bins summed as channel
+static double channel_noise(void)
+{
+	uint16_t ch = (uint16_t) (IQ_Filter_bw_Hz[IQ_Filter]/(FS_ADC_Hz/NF_FFT_LEN) + 0.5);
+
+	if (ch > NF_FFT_LEN/4) ch = NF_FFT_LEN/4;
+	return NOISE_POW*(2*ch + 1)/NF_FFT_LEN;
+}
+
+//carrier at snr_dB in the channel and optional one off_dB above channel noise outside - means of the estimates
+static void run(double snr_dB, double off_dB, double* snr_est, double* noise_est)
+{
+	float I[ADC_BLOCK], Q[ADC_BLOCK];
+	double a = sqrt(channel_noise()*pow(10.0, snr_dB/10.0)), b = (off_dB > 0) ? sqrt(channel_noise()*pow(10.0, off_dB/10.0)) : 0;
+	double sigma = sqrt(NOISE_POW/2.0), ph, ph2;
+	uint32_t t = 0, cnt = 0, c0;
+	uint16_t k;
+
+	*snr_est = *noise_est = 0;
+	nf_reset();
+	while (cnt < NF_TEST_ESTIMATES)
+	{
+		for (k = 0; k < ADC_BLOCK; k++, t++)
+		{
+			ph = 2.0*M_PI*CARRIER_Hz*t/FS_ADC_Hz;
+			ph2 = 2.0*M_PI*OFF_CHANNEL_Hz*t/FS_ADC_Hz;
+			I[k] = a*cos(ph) + b*cos(ph2) + sigma*gauss();
+			Q[k] = a*sin(ph) + b*sin(ph2) + sigma*gauss();
+		}
+		nf_capture(I, Q, ADC_BLOCK);
+		c0 = NF_Result.count;
+		nf_task();
+		if (NF_Result.count != c0)
+		{
+			*snr_est += NF_Result.snr_dB;
+			*noise_est += NF_Result.noise_dB;
+			cnt++;
+		}
+	}
+	*snr_est /= cnt;
+	*noise_est /= cnt;
+}
+
+int main(void)
+{
+	static const IQ_Filter_enum Filters[] = {IQ_FILTER_15kHz, IQ_FILTER_105kHz};
+	double snr, est, noise, noise_true;
+	uint32_t f;
+	int pass = 1, ok;
+
+	fft_init();
+	nf_init();
+	srand(1);
+	for (f = 0; f < sizeof(Filters)/sizeof(Filters[0]); f++)
+	{
+		IQ_Filter = Filters[f];
+		noise_true = 10.0*log10(channel_noise());
+		for (snr = 0; snr <= 30.0; snr += 10.0)
+		{
+			run(snr, 0, &est, &noise);
+			ok = (fabs(est - snr) < NF_TEST_SNR_dB) && (fabs(noise - noise_true) < NF_TEST_NOISE_dB);
+			printf("IQ filter %s kHz, SNR %2.0f dB: estimate %5.2f dB, noise %+.2f dB - %s\n", iq_filter_name[IQ_Filter], snr, est,
+					noise - noise_true, ok ? "ok" : "FAIL");
+			pass &= ok;
+		}
+	}
+
+	IQ_Filter = IQ_FILTER_15kHz;
+	noise_true = 10.0*log10(channel_noise());
+	run(10.0, 40.0, &est, &noise);
+	ok = (fabs(est - 10.0) < NF_TEST_SNR_dB) && (fabs(noise - noise_true) < NF_TEST_NOISE_dB);
+	printf("IQ filter %s kHz, SNR 10 dB, carrier 40 dB at %.0f kHz: estimate %5.2f dB, noise %+.2f dB - %s\n",
+			iq_filter_name[IQ_Filter], OFF_CHANNEL_Hz/1.0e3, est, noise - noise_true, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
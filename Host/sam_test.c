@@ -0,0 +1,136 @@
+/*
+ * sam_test.c - host test of synchronous AM detector (sam.c) - carrier lock, distortion and sideband selection
+ *
+ * AM carrier with 80% modulated 1 kHz tone at FS_BB_Hz goes through sam_process() (the level is set by agc.c later,
+ * so the output is linear). The PLL has to lock from -SAM_TEST_LOCK_Hz to +SAM_TEST_LOCK_Hz carrier offset (read
+ * from sam_print()), DSB 2nd harmonic has to be SAM_TEST_H2_dB down, USB/LSB have to reject a tone only in the
+ * opposite sideband by SAM_TEST_REJ_dB and carrier fading (20 dB deep) must not break the lock nor raise 2nd harmonic
+ * above -SAM_TEST_FADE_dB.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc sam_test.c ../stm32f407_mxl5007t/Core/Src/sam.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_mag.c ../stm32f407_mxl5007t/Core/Src/dsp_fir.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm -o sam_test && ./sam_test
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "audio_i2s.h"
+#include "sam.h"
+
+#define BLOCKS           20000 //3 s - the first half is for the lock
+#define SAM_TEST_LOCK_Hz 900.0
+#define SAM_TEST_H2_dB   40.0
+#define SAM_TEST_REJ_dB  35.0
+#define SAM_TEST_FADE_dB 20.0  //2nd harmonic with carrier fading
+#define SAM_TEST_FADE_Hz 2.0   //carrier level 0.1 - 1.0 (|cos|, so the fade is 4 Hz)
+
+#define USB_TONE_Hz      2200.0 //single sideband test tones
+#define LSB_TONE_Hz      1500.0
+
+DWT_Type Host_DWT;
+uint32_t SystemCoreClock = 168000000;
+
+static char Out[256]; //sam_print() output
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void UART_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(Out, sizeof(Out), format, args);
+	va_end(args);
+}
+
+typedef struct
+{
+	double a[4]; //audio amplitude at Test_Hz
+	bool locked;
+}SAM_Result_TypeDef;
+
+static const double Test_Hz[4] = {1000.0, 2000.0, USB_TONE_Hz, LSB_TONE_Hz};
+
+//carrier at offset_Hz with DSB tone (dsb is modulation depth) and single sideband tones (usb, lsb amplitudes)
+static SAM_Result_TypeDef run(SAM_Sideband_enum sb, double offset_Hz, double dsb, double usb, double lsb, bool fade)
+{
+	SAM_Result_TypeDef r;
+	float I[BB_BLOCK], Q[BB_BLOCK], out[BB_BLOCK];
+	double re[4] = {0}, im[4] = {0}, t, ph, cr, x;
+	uint32_t b, k, j, n = 0, cnt = 0;
+	uint16_t m;
+
+	SAM_Config.sideband = sb;
+	sam_init();
+	for (b = 0; b < BLOCKS; b++)
+	{
+		for (k = 0; k < BB_BLOCK; k++, n++)
+		{
+			t = n/FS_BB_Hz;
+			ph = 2.0*M_PI*offset_Hz*t;
+			cr = fade ? 0.1 + 0.9*fabs(cos(2.0*M_PI*SAM_TEST_FADE_Hz*t)) : 1.0;
+			x = cr + dsb*cos(2.0*M_PI*1000.0*t);
+			I[k] = 0.01*(x*cos(ph) + usb*cos(ph + 2.0*M_PI*USB_TONE_Hz*t) + lsb*cos(ph - 2.0*M_PI*LSB_TONE_Hz*t));
+			Q[k] = 0.01*(x*sin(ph) + usb*sin(ph + 2.0*M_PI*USB_TONE_Hz*t) + lsb*sin(ph - 2.0*M_PI*LSB_TONE_Hz*t));
+		}
+		m = sam_process(I, Q, BB_BLOCK, out);
+		if (b >= BLOCKS/2)
+			for (k = 0; k < m; k++, cnt++)
+				for (j = 0; j < 4; j++)
+				{
+					re[j] += out[k]*cos(2.0*M_PI*Test_Hz[j]*cnt/AUDIO_FS_Hz);
+					im[j] += out[k]*sin(2.0*M_PI*Test_Hz[j]*cnt/AUDIO_FS_Hz);
+				}
+	}
+	for (j = 0; j < 4; j++) r.a[j] = 2.0*sqrt(re[j]*re[j] + im[j]*im[j])/cnt;
+	sam_print();
+	r.locked = strstr(Out, "not locked") == NULL;
+	return r;
+}
+
+static double db(double a, double ref)
+{
+	return 20.0*log10(a/ref + 1.0e-30);
+}
+
+int main(void)
+{
+	static const double Lock_Hz[] = {-SAM_TEST_LOCK_Hz, -500.0, 0.0, 300.0, SAM_TEST_LOCK_Hz};
+	SAM_Result_TypeDef r;
+	double h2, rej_u, rej_l;
+	uint32_t k;
+	int pass = 1, ok;
+
+	for (k = 0; k < sizeof(Lock_Hz)/sizeof(Lock_Hz[0]); k++)
+	{
+		r = run(SAM_DSB, Lock_Hz[k], 0.8, 0, 0, false);
+		h2 = db(r.a[1], r.a[0]);
+		ok = r.locked && (h2 < -SAM_TEST_H2_dB);
+		printf("DSB, carrier %+4.0f Hz: %s, 2nd harmonic %.1f dB - %s\n", Lock_Hz[k], r.locked ? "locked" : "not locked", h2,
+				ok ? "ok" : "FAIL");
+		pass &= ok;
+	}
+
+	//the DSB tone is the reference - one sideband carries half of it
+	r = run(SAM_USB, 300.0, 0.4, 0.2, 0.2, false);
+	rej_u = db(r.a[3], r.a[2]);
+	r = run(SAM_LSB, 300.0, 0.4, 0.2, 0.2, false);
+	rej_l = db(r.a[2], r.a[3]);
+	ok = (rej_u < -SAM_TEST_REJ_dB) && (rej_l < -SAM_TEST_REJ_dB);
+	printf("opposite sideband tone: USB %.1f dB, LSB %.1f dB - %s\n", rej_u, rej_l, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	r = run(SAM_DSB, 300.0, 0.8, 0, 0, true); //overmodulated in the fades - envelope detector would clip
+	h2 = db(r.a[1], r.a[0]);
+	ok = r.locked && (h2 < -SAM_TEST_FADE_dB);
+	printf("DSB, 20 dB carrier fade: %s, 2nd harmonic %.1f dB - %s\n", r.locked ? "locked" : "not locked", h2, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * ssb_test.c - host test of SSB demodulator (ssb.c) - audio response of USB/LSB, filters and BFO offset
+ *
+ * Complex tone at FS_BB_Hz goes through ssb_process() (the level is set by agc.c later, so the output is linear) and
+ * its audio power is compared with 1 kHz USB tone. Pass band 300 - 3000 Hz of 2.7 kHz filter has to be flat within
+ * SSB_TEST_RIPPLE_dB, the opposite sideband has to be SSB_TEST_REJ_dB down from 500 Hz (SSB_TEST_REJ_250_dB at
+ * 250 Hz, close to the carrier), and 2.4/3.0 kHz filters and BFO offset have to move the upper edge.
+ *
+ * gcc -O2 -Istub -I../stm32f407_mxl5007t/Core/Inc ssb_test.c ../stm32f407_mxl5007t/Core/Src/ssb.c
+ *     ../stm32f407_mxl5007t/Core/Src/dsp_fir.c ../stm32f407_mxl5007t/Core/Src/dsp_tables.c -lm -o ssb_test && ./ssb_test
+ */
+#include <stdio.h>
+#include <math.h>
+#include "main.h"
+#include "ssb.h"
+
+#define BLOCKS              4000 //0.6 s
+#define SSB_TEST_RIPPLE_dB  1.0
+#define SSB_TEST_REJ_dB     55.0
+#define SSB_TEST_REJ_250_dB 40.0
+#define SSB_TEST_EDGE_Hz    150.0 //-6 dB point from the nominal upper edge
+
+typedef struct
+{
+	SSB_Filter_enum filter;
+	int16_t bfo_Hz;
+	double edge_Hz; //nominal upper edge of audio pass band
+}Edge_Test_TypeDef;
+
+static const Edge_Test_TypeDef Edge_Test[] =
+{
+	{SSB_FILTER_2k4, 0, 2700.0}, {SSB_FILTER_2k7, 0, 3000.0}, {SSB_FILTER_3k0, 0, 3300.0}, {SSB_FILTER_2k7, 200, 3200.0}
+};
+
+void UART_printf(const char *format, ...)
+{
+	(void) format;
+}
+
+//audio power of complex tone at f_Hz (negative is below the carrier)
+static double run(double f_Hz, bool lsb, SSB_Filter_enum filter, int16_t bfo_Hz)
+{
+	float I[BB_BLOCK], Q[BB_BLOCK], out[BB_BLOCK];
+	double ph = 0, p = 0;
+	uint32_t b, k, cnt = 0;
+	uint16_t m;
+
+	SSB_Config.filter = filter;
+	SSB_Config.bfo_Hz = bfo_Hz;
+	ssb_init();
+	for (b = 0; b < BLOCKS; b++)
+	{
+		for (k = 0; k < BB_BLOCK; k++, ph += 2.0*M_PI*f_Hz/FS_BB_Hz)
+		{
+			I[k] = 0.01*cos(ph);
+			Q[k] = 0.01*sin(ph);
+		}
+		m = ssb_process(I, Q, BB_BLOCK, lsb, out);
+		if (b >= BLOCKS/2)
+			for (k = 0; k < m; k++, cnt++) p += out[k]*out[k];
+	}
+	return p/cnt;
+}
+
+static double db(double p, double ref)
+{
+	return 10.0*log10(p/ref + 1.0e-30);
+}
+
+int main(void)
+{
+	double ref = run(1000.0, false, SSB_FILTER_2k7, 0), r, pmin = 0, pmax = -200, rej = -200, rej250;
+	double f;
+	uint32_t k;
+	int pass = 1, ok;
+
+	for (f = 300.0; f <= 3000.0; f += 100.0)
+	{
+		r = db(run(f, false, SSB_FILTER_2k7, 0), ref);
+		if ( (f == 300.0) || (r < pmin) ) pmin = r;
+		if (r > pmax) pmax = r;
+		r = db(run(-f, true, SSB_FILTER_2k7, 0), ref); //LSB mirror
+		if (r < pmin) pmin = r;
+		if (r > pmax) pmax = r;
+	}
+	ok = pmax - pmin < SSB_TEST_RIPPLE_dB;
+	printf("USB/LSB 2.7 kHz pass band 300 - 3000 Hz: %.2f ... %.2f dB - %s\n", pmin, pmax, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	rej250 = fmax(db(run(-250.0, false, SSB_FILTER_2k7, 0), ref), db(run(250.0, true, SSB_FILTER_2k7, 0), ref));
+	for (f = 500.0; f <= 4000.0; f += 250.0)
+	{
+		rej = fmax(rej, db(run(-f, false, SSB_FILTER_2k7, 0), ref));
+		rej = fmax(rej, db(run(f, true, SSB_FILTER_2k7, 0), ref));
+	}
+	ok = (rej250 < -SSB_TEST_REJ_250_dB) && (rej < -SSB_TEST_REJ_dB);
+	printf("opposite sideband: %.1f dB at 250 Hz, %.1f dB from 500 Hz - %s\n", rej250, rej, ok ? "ok" : "FAIL");
+	pass &= ok;
+
+	//upper edge of the pass band - the first frequency 6 dB down
+	for (k = 0; k < sizeof(Edge_Test)/sizeof(Edge_Test[0]); k++)
+	{
+		const Edge_Test_TypeDef* e = &Edge_Test[k];
+
+		for (f = 2000.0; f < 5000.0; f += 25.0)
+			if (db(run(f, false, e->filter, e->bfo_Hz), ref) < -6.0) break;
+		ok = fabs(f - e->edge_Hz) <= SSB_TEST_EDGE_Hz;
+		printf("filter %s kHz, BFO %+d Hz: -6 dB at %.0f Hz (nominal edge %.0f Hz) - %s\n", ssb_filter_name[e->filter], e->bfo_Hz,
+				f, e->edge_Hz, ok ? "ok" : "FAIL");
+		pass &= ok;
+	}
+
+	printf("%s\n", pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
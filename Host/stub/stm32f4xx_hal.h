@@ -0,0 +1,22 @@
+/*
+ * stm32f4xx_hal.h - host build of DSP modules (data_test.c, chan_test.c): HAL types and functions used by Core/Inc headers
+ */
+
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#include <stdint.h>
+
+typedef struct { int dummy; } UART_HandleTypeDef;
+typedef struct { int dummy; } TIM_HandleTypeDef;
+
+typedef struct { uint32_t CYCCNT; } DWT_Type; //perf.h probes read the cycle counter
+
+extern DWT_Type Host_DWT;
+#define DWT (&Host_DWT)
+
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+
+#endif
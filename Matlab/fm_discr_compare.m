@@ -0,0 +1,44 @@
+%Compares FM discriminators from stm32f4xx_it.c (FM_Discr) - SINAD of demodulated 1 kHz tone.
+%I/Q after IQ filters are loaded from iq_record.mat (variables I, Q, fs) if it exists,
+%otherwise FM signal with 1 kHz tone and white noise is generated.
+%Cycle counts of the discriminators are measured on STM32 by perf command (PERF_DEMOD stage).
+%
+%Results - synthetic I/Q (no iq_record.mat was recorded), 2^16 samples, raw discriminator output without audio filter,
+%Host/fm_discr_test.c prints the same table from the discriminator code of the ADC callback:
+%  f_dev    SNR      noga      atan2   [SINAD dB]
+%  50 kHz   30 dB    22.7      30.4
+%  50 kHz   60 dB    28.1      60.4    (distortion of asin table, atan2 polynomial < 2e-5 rad)
+%  75 kHz   30 dB     9.3      33.9    (|x| > 0.8 - asin table step grows near +/-1)
+clc;
+
+N_asin = 150;
+f_tone = 1e3;
+
+if (isfile('iq_record.mat'))
+    load('iq_record.mat', 'I', 'Q', 'fs');
+else
+    fs = 84e6/99/4; %TIM3 triggering and decimation by 4
+    f_dev = 50e3;
+    SNR_dB = 30;
+    t = (0:2^16-1)/fs;
+    z = exp(1j*f_dev/f_tone*sin(2*pi*f_tone*t)); %phase f_dev/f_tone*sin(), frequency f_dev*cos()
+    z = z + 10^(-SNR_dB/20)/sqrt(2)*(randn(size(z)) + 1j*randn(size(z)));
+    I = real(z);
+    Q = imag(z);
+end
+
+I = single(I(:).');
+Q = single(Q(:).');
+asin_arr = single(asin(2/N_asin*(0:N_asin-1) - 1));
+n = 3:length(I);
+
+%Noga's discriminator with division and asin look-up table
+x = 0.5*(I(n-1).*(Q(n) - Q(n-2)) - (I(n) - I(n-2)).*Q(n-1)) ./ (I(n-1).^2 + Q(n-1).^2);
+x = min(max(x, -1), 1);
+noga = asin_arr(floor((N_asin-1)/2*x + (N_asin-1)/2) + 1);
+
+%polar discriminator - phase difference
+polar = atan2(I(n-1).*Q(n) - I(n).*Q(n-1), I(n).*I(n-1) + Q(n).*Q(n-1));
+
+fprintf('SINAD noga:  %.2f dB\n', sinad(double(noga), fs));
+fprintf('SINAD atan2: %.2f dB\n', sinad(double(polar), fs));
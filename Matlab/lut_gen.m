@@ -0,0 +1,179 @@
+%Generates arcsine look-up table and FIR filters coefficients for STM32 (dsp_tables.c).
+%N_asin has to be the same like in main.h, FIR filters lengths like in dsp_tables.h
+%Mixer sine/cosine table depends on frequency plan, so it's computed by freq_plan.c
+clc;
+
+N_asin = 150;
+
+asin_arr = single(asin(2/N_asin*(0:N_asin-1) - 1));
+
+%IQ decimation 848.5 kHz -> 424.2 kHz -> 212.1 kHz by two half band filters (every other tap is zero, so 5 multiplications
+%per output) and channel filters at 212.1 kHz - cut-off is half of the channel bandwidth, biquads are needed because direct
+%form of narrow filters isn't stable with single precision coefficients. 105 kHz channel is the half band filters only
+fs_adc = 84e6/99;
+IQ_HB1 = single(fir1(14, 0.5, kaiser(15, kaiserbeta(60))));
+IQ_HB2 = single(fir1(14, 0.5, kaiser(15, kaiserbeta(50))));
+IQ_BW = [3, 6, 10, 15, 30, 60];
+IQ_IIR = zeros(length(IQ_BW), 15, 'single');
+for k=1:length(IQ_BW)
+    IQ_IIR(k, :) = single(cheby_biquads(6, 0.5, IQ_BW(k)*1000, fs_adc/4));
+end
+
+%WFM audio decimation 212.1 kHz -> 53.0 kHz -> 26.5 kHz, Kaiser window for 50 dB attenuation
+fs_bb = 84e6/99/4;
+beta = kaiserbeta(50);
+WFM_FIR1 = single(fir1(27, 22000/(fs_bb/2), kaiser(28, beta)));
+WFM_FIR2 = single(fir1(47, 13250/(fs_bb/8), kaiser(48, beta)));
+
+%RDS 57 kHz band pass decimation 212.1 kHz -> 26.5 kHz (low pass shifted to 57 kHz, so mixing is done only at 26.5 kHz)
+%and low pass decimation 26.5 kHz -> 13.3 kHz, matched filter is one period of sine per bit at 13.3 kHz
+h = fir1(31, 12000/(fs_bb/2), kaiser(32, beta));
+RDS_FIR1_I = single(h.*cos(2*pi*57000/fs_bb*(0:31)));
+RDS_FIR1_Q = single(h.*sin(2*pi*57000/fs_bb*(0:31)));
+RDS_FIR2 = single(fir1(31, 3700/(fs_bb/16), kaiser(32, beta)));
+N_mf = 11;
+RDS_MF = single(2/N_mf*sin(2*pi*(N_mf-1-(0:N_mf-1)+0.5)/N_mf));
+
+%SSB I/Q decimation 212.1 kHz -> 26.5 kHz and Weaver low pass filters (half of audio bandwidth) at 26.5 kHz
+SSB_FIR1 = single(fir1(31, 12000/(fs_bb/2), kaiser(32, beta)));
+SSB_IIR_2k4 = single(cheby_biquads(8, 0.5, 1200, fs_bb/8));
+SSB_IIR_2k7 = single(cheby_biquads(8, 0.5, 1350, fs_bb/8));
+SSB_IIR_3k0 = single(cheby_biquads(8, 0.5, 1500, fs_bb/8));
+
+%CW I/Q decimation 26.5 kHz -> 3.3 kHz and narrow low pass filters (half of bandwidth) at 3.3 kHz
+CW_FIR2 = single(fir1(31, 1000/(fs_bb/16), kaiser(32, beta)));
+CW_IIR_200 = single(cheby_biquads(4, 0.5, 100, fs_bb/64));
+CW_IIR_300 = single(cheby_biquads(4, 0.5, 150, fs_bb/64));
+CW_IIR_500 = single(cheby_biquads(4, 0.5, 250, fs_bb/64));
+
+%synchronous AM sideband selection - Weaver low pass filter (half of audio bandwidth) at 26.5 kHz
+SAM_IIR = single(cheby_biquads(8, 0.5, 2500, fs_bb/8));
+
+%NBFM I/Q decimation 212.1 kHz -> 53.0 kHz -> 26.5 kHz (the 2nd stage is the channel filter) and audio filters at 26.5 kHz:
+%voice band pass (high pass removes CTCSS/DCS), noise squelch high pass and sub-audio low pass for tone detection
+NBFM_FIR1 = single(fir1(23, 26000/(fs_bb/2), kaiser(24, beta)));
+NBFM_FIR2_12k5 = single(fir1(63, 6500/(fs_bb/8), kaiser(64, beta)));
+NBFM_FIR2_25k = single(fir1(63, 10500/(fs_bb/8), kaiser(64, beta)));
+NBFM_AUDIO_IIR = single([cheby_biquads(6, 0.5, 300, fs_bb/8, 'high'), cheby_biquads(4, 0.5, 3000, fs_bb/8)]);
+NBFM_NOISE_IIR = single(cheby_biquads(4, 0.5, 4500, fs_bb/8, 'high'));
+NBFM_TONE_IIR = single(cheby_biquads(4, 0.5, 270, fs_bb/8));
+
+%data demodulators decimation 26.5 kHz -> 13.3 kHz (212.1 kHz -> 26.5 kHz is done by SSB_FIR1)
+DATA_FIR2 = single(fir1(23, 6500/(fs_bb/16), kaiser(24, beta)));
+
+%channelizer 212.1 kHz -> 106.1 kHz (shared by all channels, offsets up to 25 kHz) -> 53.0 kHz -> 26.5 kHz by half band filters
+%and 12.5 kHz channel filter at 26.5 kHz
+CHAN_HB = single(fir1(18, 0.5, kaiser(19, kaiserbeta(60))));
+CHAN_HB_SHORT = single(fir1(10, 0.5, kaiser(11, kaiserbeta(60))));
+CHAN_FIR = single(fir1(35, 6500/(fs_bb/16), kaiser(36, beta)));
+
+fid = fopen('../stm32f407_mxl5007t/Core/Src/dsp_tables.c', 'w');
+fprintf(fid, '/*\n * dsp_tables.c - arcsine look-up table and FIR filters coefficients\n *\n');
+fprintf(fid, ' * Generated by Matlab/lut_gen.m - don''t edit. Tables are const so they''re placed in flash\n');
+fprintf(fid, ' * and there''s no asinf computing at startup (mixer table is set by frequency plan - freq_plan.c).\n */\n');
+fprintf(fid, '#include "main.h"\n#include "dsp_tables.h"\n\n');
+write_table(fid, 'asin_arr', 'N_asin', asin_arr, 'arcsine for x = 2*i/N_asin - 1 (needed for FM)');
+fprintf(fid, '\n');
+write_table(fid, 'IQ_HB1', 'IQ_HB1_TAPS', IQ_HB1, 'IQ decimation 1st stage 848.5 -> 424.2 kHz - half band, Kaiser window 60 dB (pass 105 kHz, every other tap is zero)');
+fprintf(fid, '\n');
+write_table(fid, 'IQ_HB2', 'IQ_HB2_TAPS', IQ_HB2, 'IQ decimation 2nd stage 424.2 -> 212.1 kHz - half band, Kaiser window 50 dB (pass 75 kHz, every other tap is zero)');
+for k=1:length(IQ_BW)
+    fprintf(fid, '\n');
+    write_table(fid, sprintf('IQ_IIR_%dk', IQ_BW(k)), 'IQ_IIR_COEFFS', IQ_IIR(k, :), sprintf('IQ channel filter low pass %d kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (%d kHz channel)', IQ_BW(k), 2*IQ_BW(k)));
+end
+fprintf(fid, '\n');
+write_table(fid, 'WFM_FIR1', 'WFM_FIR1_TAPS', WFM_FIR1, 'WFM audio decimation 1st stage 212.1 -> 53.0 kHz - Kaiser window, fc=22 kHz');
+fprintf(fid, '\n');
+write_table(fid, 'WFM_FIR2', 'WFM_FIR2_TAPS', WFM_FIR2, 'WFM audio decimation 2nd stage 53.0 -> 26.5 kHz - Kaiser window, fc=13.25 kHz (pass 11.5 kHz, stop 15 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'RDS_FIR1_I', 'RDS_FIR1_TAPS', RDS_FIR1_I, 'RDS 57 kHz band pass decimation 212.1 -> 26.5 kHz (real part) - Kaiser window low pass fc=12 kHz shifted to 57 kHz');
+fprintf(fid, '\n');
+write_table(fid, 'RDS_FIR1_Q', 'RDS_FIR1_TAPS', RDS_FIR1_Q, 'RDS 57 kHz band pass decimation 212.1 -> 26.5 kHz (imaginary part)');
+fprintf(fid, '\n');
+write_table(fid, 'RDS_FIR2', 'RDS_FIR2_TAPS', RDS_FIR2, 'RDS decimation 2nd stage 26.5 -> 13.3 kHz - Kaiser window, fc=3.7 kHz (pass 2.4 kHz, stop 5 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'RDS_MF', 'RDS_MF_TAPS', RDS_MF, 'RDS biphase symbol matched filter at 13.3 kHz - one period of sine per bit (11.16 samples)');
+fprintf(fid, '\n');
+write_table(fid, 'SSB_FIR1', 'SSB_FIR1_TAPS', SSB_FIR1, 'SSB I/Q decimation 212.1 -> 26.5 kHz - Kaiser window, fc=12 kHz (pass 3.5 kHz, stop 22.5 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'SSB_IIR_2k4', 'SSB_IIR_COEFFS', SSB_IIR_2k4, 'SSB Weaver low pass 1.20 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (2.4 kHz audio bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'SSB_IIR_2k7', 'SSB_IIR_COEFFS', SSB_IIR_2k7, 'SSB Weaver low pass 1.35 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (2.7 kHz audio bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'SSB_IIR_3k0', 'SSB_IIR_COEFFS', SSB_IIR_3k0, 'SSB Weaver low pass 1.50 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (3.0 kHz audio bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'CW_FIR2', 'CW_FIR2_TAPS', CW_FIR2, 'CW I/Q decimation 26.5 -> 3.3 kHz - Kaiser window, fc=1 kHz (pass 250 Hz, stop 2.5 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'CW_IIR_200', 'CW_IIR_COEFFS', CW_IIR_200, 'CW low pass 100 Hz at 3.3 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (200 Hz bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'CW_IIR_300', 'CW_IIR_COEFFS', CW_IIR_300, 'CW low pass 150 Hz at 3.3 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (300 Hz bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'CW_IIR_500', 'CW_IIR_COEFFS', CW_IIR_500, 'CW low pass 250 Hz at 3.3 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (500 Hz bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'SAM_IIR', 'SAM_IIR_COEFFS', SAM_IIR, 'synchronous AM sideband low pass 2.5 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (5 kHz audio bandwidth)');
+fprintf(fid, '\n');
+write_table(fid, 'NBFM_FIR1', 'NBFM_FIR1_TAPS', NBFM_FIR1, 'NBFM I/Q decimation 212.1 -> 53.0 kHz - Kaiser window, fc=26 kHz (pass 12.5 kHz, stop 39.5 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'NBFM_FIR2_12k5', 'NBFM_FIR2_TAPS', NBFM_FIR2_12k5, 'NBFM channel filter and decimation 53.0 -> 26.5 kHz - Kaiser window, fc=6.5 kHz (pass 5.3 kHz, stop 7.7 kHz) for 12.5 kHz channels');
+fprintf(fid, '\n');
+write_table(fid, 'NBFM_FIR2_25k', 'NBFM_FIR2_TAPS', NBFM_FIR2_25k, 'NBFM channel filter and decimation 53.0 -> 26.5 kHz - Kaiser window, fc=10.5 kHz (pass 9.3 kHz, stop 11.7 kHz) for 25 kHz channels');
+fprintf(fid, '\n');
+write_table(fid, 'NBFM_AUDIO_IIR', 'NBFM_AUDIO_COEFFS', NBFM_AUDIO_IIR, 'NBFM voice band pass 300 - 3000 Hz at 26.5 kHz - 6th order Chebyshev 0.5 dB high pass (CTCSS/DCS removal) and 4th order low pass, biquads {b0, b1, b2, a1, a2}');
+fprintf(fid, '\n');
+write_table(fid, 'NBFM_NOISE_IIR', 'NBFM_NOISE_COEFFS', NBFM_NOISE_IIR, 'NBFM noise squelch high pass 4.5 kHz at 26.5 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (discriminator noise above voice band)');
+fprintf(fid, '\n');
+write_table(fid, 'NBFM_TONE_IIR', 'NBFM_TONE_COEFFS', NBFM_TONE_IIR, 'NBFM sub-audio low pass 270 Hz at 26.5 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (CTCSS/DCS before decimation to 1.66 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'DATA_FIR2', 'DATA_FIR2_TAPS', DATA_FIR2, 'data demodulators decimation 26.5 -> 13.3 kHz - Kaiser window, fc=6.5 kHz (pass 4.8 kHz, stop 8.2 kHz)');
+fprintf(fid, '\n');
+write_table(fid, 'CHAN_HB', 'CHAN_HB_TAPS', CHAN_HB, 'channelizer decimation 212.1 -> 106.1 kHz (all channels) and 53.0 -> 26.5 kHz - half band, Kaiser window 60 dB (pass 31.25 and 7.7 kHz, every other tap is zero)');
+fprintf(fid, '\n');
+write_table(fid, 'CHAN_HB_SHORT', 'CHAN_HB_SHORT_TAPS', CHAN_HB_SHORT, 'channelizer decimation 106.1 -> 53.0 kHz - half band, Kaiser window 60 dB (pass 7.7 kHz, stop 45.3 kHz, every other tap is zero)');
+fprintf(fid, '\n');
+write_table(fid, 'CHAN_FIR', 'CHAN_FIR_TAPS', CHAN_FIR, 'channelizer channel filter at 26.5 kHz - Kaiser window, fc=6.5 kHz (pass 5.3 kHz, stop 7.7 kHz) for 12.5 kHz channels');
+fclose(fid);
+
+function beta = kaiserbeta(A)
+    beta = 0.5842*(A-21)^0.4 + 0.07886*(A-21);
+end
+
+%biquads {b0, b1, b2, a1, a2} ordered from the lowest Q, unity pass band gain of every section (DC or Nyquist for high pass)
+%and passband ripple in the 1st one
+function coeff = cheby_biquads(N, Rp, fc, fs, type)
+    if (nargin < 5)
+        type = 'low';
+    end
+    [z, p, k] = cheby1(N, Rp, fc/(fs/2), type);
+    sos = zp2sos(z, p, k);
+    if (strcmp(type, 'high'))
+        s = [1, -1, 1]; %response at Nyquist
+    else
+        s = [1, 1, 1];
+    end
+    coeff = [];
+    for i=1:size(sos, 1)
+        b = sos(i, 1:3)*sum(s.*sos(i, 4:6))/sum(s.*sos(i, 1:3));
+        if (i == 1)
+            b = b*10^(-Rp/20);
+        end
+        coeff = [coeff, b, sos(i, 5:6)];
+    end
+end
+
+function write_table(fid, name, size_name, table, comment)
+    fprintf(fid, '//%s\nconst float %s[%s] =\n{\n', comment, name, size_name);
+    for k=1:length(table)
+        if (mod(k-1, 4) == 0)
+            fprintf(fid, '\t');
+        end
+        fprintf(fid, '%.9e', table(k));
+        if (k ~= length(table))
+            if (mod(k, 4) == 0)
+                fprintf(fid, ',\n');
+            else
+                fprintf(fid, ', ');
+            end
+        end
+    end
+    fprintf(fid, '\n};\n');
+end
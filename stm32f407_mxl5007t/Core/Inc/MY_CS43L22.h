@@ -74,5 +74,6 @@ void CS43_Start(void);
 void CS43_Stop(void);
 void CS43_Mute(void);
 void CS43_Unmute(void);
+void CS43_SetMode(CS43_MODE outputMode);
 
 #endif
@@ -86,6 +86,40 @@ MxL_ERR_MSG MxL_Tuner_Init(MxL5007_TunerConfigS* );
 ******************************************************************************/
 MxL_ERR_MSG MxL_Tuner_RFTune(MxL5007_TunerConfigS*, uint32_t RF_Freq_Hz, MxL5007_BW_MHz BWMHz);
 
+/******************************************************************************
+**
+**  Name: MxL_Tuner_RFTune_Calc
+**
+**  Description:    Channel change calculation without I2C write (register payload can be cached)
+**
+**  Parameters:    	pArray				- Pointer to payload array (MAX_ARRAY_SIZE)
+**					Array_Size			- Pointer to payload size
+**					RF_Freq_Hz			- RF Frequency in Hz
+**					BWMHz				- Bandwidth 6, 7 or 8 MHz
+**
+**  Returns:        nothing
+**
+******************************************************************************/
+void MxL_Tuner_RFTune_Calc(uint8_t* pArray, uint32_t* Array_Size, uint32_t RF_Freq_Hz, MxL5007_BW_MHz BWMHz);
+
+/******************************************************************************
+**
+**  Name: MxL_Tuner_RFTune_Cached
+**
+**  Description:    Frequency tunning for channel with payload precomputed by MxL_Tuner_RFTune_Calc
+**
+**  Parameters:    	myTuner				- Pointer to MxL5007_TunerConfigS
+**					RF_Freq_Hz			- RF Frequency in Hz (stored in myTuner only)
+**					BWMHz				- Bandwidth 6, 7 or 8 MHz (stored in myTuner only)
+**					pArray				- Pointer to precomputed payload
+**					Array_Size			- payload size
+**
+**  Returns:        MxL_ERR_MSG			- MxL_OK if success
+**										- MxL_ERR_RFTUNE if fail
+**
+******************************************************************************/
+MxL_ERR_MSG MxL_Tuner_RFTune_Cached(MxL5007_TunerConfigS*, uint32_t RF_Freq_Hz, MxL5007_BW_MHz BWMHz, uint8_t* pArray, uint32_t Array_Size);
+
 /******************************************************************************
 **
 **  Name: MxL_Soft_Reset
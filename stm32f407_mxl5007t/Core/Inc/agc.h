@@ -0,0 +1,32 @@
+/*
+ * agc.h - block based audio AGC with look-ahead as long as attack time and soft limiter for all demodulators
+ */
+
+#ifndef __agc__
+#define __agc__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define AGC_LEVEL_DEFAULT   -6.0f    //target peak level [dBFS of the output]
+#define AGC_ATTACK_DEFAULT  1.0f     //[ms] - up to AGC_LOOKAHEAD_MAX blocks
+#define AGC_DECAY_DEFAULT   500.0f   //[ms]
+#define AGC_KNEE            0.8f     //soft limiter starts at this part of full scale
+#define AGC_BLOCK_ms        (1000.0*ADC_BLOCK/FS_ADC_Hz) //gain is updated once per ADC block (0.15 ms) at every audio rate
+#define AGC_LOOKAHEAD_MAX   32       //blocks (4.8 ms) - audio delay line is AGC_LOOKAHEAD_MAX*BB_BLOCK samples of L and R
+
+typedef struct
+{
+	volatile bool on;  //off - unity gain, limiter still works
+	float level_dB;
+	float attack_ms;
+	float decay_ms;
+}AGC_Config_TypeDef;
+
+extern AGC_Config_TypeDef AGC_Config;
+
+void agc_set(bool on, float level_dB, float attack_ms, float decay_ms);
+void agc_process(float* L, float* R, uint16_t n, float full_scale, Output_demod_type_enum demod);
+void agc_print(void);
+
+#endif
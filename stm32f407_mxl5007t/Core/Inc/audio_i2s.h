@@ -0,0 +1,32 @@
+/*
+ * audio_i2s.h - digital stereo audio to CS43L22 over I2S3
+ */
+
+#ifndef __audio_i2s__
+#define __audio_i2s__
+
+#include <stdbool.h>
+#include "main.h"
+
+//I2S frame rate is exactly FS_BB_Hz/AUDIO_DECIM, so there's no sample rate conversion and the ring never drifts:
+//HSE/PLLM=2 MHz ; PLLI2SN=112 ; PLLI2SR=3 -> I2SCLK=74.667 MHz ; MCLK=256*Fs ; I2SDIV=5 ; ODD=1 -> Fs=74.667 MHz/(256*11)=26515.15 Hz
+#define AUDIO_DECIM       8
+#define AUDIO_FS_Hz       (FS_BB_Hz/AUDIO_DECIM)
+#define AUDIO_BLOCK       (BB_BLOCK/AUDIO_DECIM) //audio frames per DSP block
+#define AUDIO_I2S_DIV     5
+#define AUDIO_I2S_ODD     1
+#define AUDIO_I2S_FRAMES  64 //stereo frames in DMA ring - power of 2
+
+extern uint32_t Audio_I2S_slips;
+
+void audio_i2s_start(void);
+void audio_i2s_write(const float* L, const float* R, uint16_t n, float scale);
+void audio_route(Output_demod_type_enum demod);
+
+//demodulators which write audio at AUDIO_FS_Hz by audio_i2s_write()
+static inline bool audio_i2s_demod(Output_demod_type_enum demod)
+{
+	return (demod == DEMOD_WFM) || (demod == DEMOD_USB) || (demod == DEMOD_LSB) || (demod == DEMOD_CW) || (demod == DEMOD_SAM) || (demod == DEMOD_NBFM);
+}
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * ax25.h - HDLC deframer and AX.25 frame output (text or KISS)
+ */
+
+#ifndef __ax25__
+#define __ax25__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define AX25_FRAME_MAX  332 //7 addresses, control, PID, 256 bytes of info and FCS
+#define AX25_FRAME_MIN  17  //2 addresses, control and FCS
+#define AX25_ADDR_MAX   10  //destination, source and 8 digipeaters
+
+typedef struct
+{
+	uint32_t frames;     //valid FCS
+	uint32_t fcs_errors;
+	uint32_t aborts;     //seven ones or too long frames
+}AX25_Stat_TypeDef;
+
+extern AX25_Stat_TypeDef AX25_Stat;
+
+void ax25_reset(void);
+void ax25_bit(uint8_t level, bool kiss);
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * bringup.h - non-blocking MxL5007T and CS43L22 initialization
+ */
+
+#ifndef __bringup__
+#define __bringup__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define MxL_POWERUP_DELAY_ms 300 //without delay after power up MxL5007 doesn't give ACK
+
+bool bringup_task(void);
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * chan.h - channelizer: several 12.5 kHz NBFM channels within IQ filter band demodulated at once
+ */
+
+#ifndef __chan__
+#define __chan__
+
+#include <stdbool.h>
+#include "main.h"
+#include "nbfm.h"
+#include "audio_i2s.h"
+
+#define CHAN_MAX            4
+#define CHAN_DEFAULT        4        //channels demodulated after switching on - cost is in chan.c
+#define CHAN_HALF_BW_Hz     6250.0   //12.5 kHz channels - channel filter
+#define CHAN_OFFSET_MAX_Hz  25000.0f //pass band of the shared half band filter is +/-31.25 kHz
+#define CHAN_POWER_AVG      0.01f    //channel power average per audio sample (3.8 ms)
+#define CHAN_SQ_DEFAULT_dB  10       //SNR for opening
+#define CHAN_SQ_HYST_dB     3.0      //squelch closes CHAN_SQ_HYST_dB below opening SNR
+#define CHAN_ROUTE_AUTO     0xFF     //audio from the first open channel
+
+typedef struct
+{
+	volatile bool on;           //channelizer replaces NBFM demodulator
+	uint8_t channels;           //1...CHAN_MAX
+	float offset_Hz[CHAN_MAX];  //from tuned frequency
+	int8_t squelch_dB;          //SNR over noise floor (nfloor.c) in channel noise bandwidth
+	volatile uint8_t route;     //channel to audio or CHAN_ROUTE_AUTO
+}Chan_Config_TypeDef;
+
+extern Chan_Config_TypeDef Chan_Config;
+extern float Chan_Discr[AUDIO_BLOCK];
+
+void chan_init(void);
+void chan_set_on(bool on);
+void chan_set_offsets(const float* offset_Hz, uint8_t channels);
+void chan_set_squelch(int8_t squelch_dB);
+void chan_set_route(uint8_t route);
+uint16_t chan_process(const float* I, const float* Q, uint16_t n, float* out);
+void chan_task(void);
+void chan_print(void);
+
+#endif
@@ -10,6 +10,10 @@
 
 extern void init_cmd(void);
 extern void cmd_parse(char ch);
-void set_IQ_filters_coeff(float* b, float* a, Output_demod_type_enum Demod_Type);
+extern const char *iq_filter_name[IQ_FILTERS];
+extern const float IQ_Filter_bw_Hz[IQ_FILTERS];
+void set_IQ_filters_coeff(Output_demod_type_enum Demod_Type);
+void set_IQ_filter(IQ_Filter_enum filter);
+float set_total_gain(float Total_Gain);
 
 #endif
@@ -0,0 +1,56 @@
+/*
+ * cw.h - CW receiver with BFO product detector and Morse decoder
+ */
+
+#ifndef __cw__
+#define __cw__
+
+#include <stdbool.h>
+#include "main.h"
+#include "audio_i2s.h"
+
+#define CW_DECIM1         8      //FS_BB_Hz -> AUDIO_FS_Hz
+#define CW_DECIM2         8      //AUDIO_FS_Hz -> CW_FS_Hz
+#define CW_FS_Hz          (AUDIO_FS_Hz/CW_DECIM2) //3.3 kHz - narrow filters, envelope and keying
+#define CW_PITCH_MIN_Hz   300
+#define CW_PITCH_MAX_Hz   1200
+#define CW_DEFAULT_PITCH  700    //Hz - beat note of zero beat signal
+#define CW_ENV_SMOOTH     0.02f    //envelope low pass before keying (15 ms)
+#define CW_LEVEL_ATTACK   0.05f    //signal peak level - fast attack (6 ms)
+#define CW_LEVEL_DECAY    0.0005f  //and slow decay (0.6 s)
+#define CW_NOISE_AVG      0.002f   //noise level - envelope average while key is up (0.15 s)
+#define CW_MARK_MAX_ms    1000     //the longest mark - dash at CW_WPM_MIN is 720 ms
+#define CW_KEY_ON         0.5f     //key down above noise + CW_KEY_ON*(signal - noise)
+#define CW_KEY_OFF        0.35f    //key up below noise + CW_KEY_OFF*(signal - noise)
+#define CW_SNR_MIN        2.0f     //signal/noise envelope ratio needed for keying (6 dB)
+#define CW_WPM_MIN        5
+#define CW_WPM_MAX        50
+#define CW_EVENTS_RING    64       //mark/space lengths from ADC callback to cw_task() - power of 2
+
+//filter index and pitch are stored in settings
+typedef enum
+{
+	CW_FILTER_200 = 0,
+	CW_FILTER_300,
+	CW_FILTER_500,
+	CW_FILTERS
+}CW_Filter_enum;
+
+typedef struct
+{
+	CW_Filter_enum filter; //bandwidth
+	uint16_t pitch_Hz;     //BFO - beat note frequency
+	bool decode;           //Morse decoder prints text to console
+}CW_Config_TypeDef;
+
+extern CW_Config_TypeDef CW_Config;
+extern const char *cw_filter_name[CW_FILTERS];
+
+void cw_init(void);
+void cw_set_filter(CW_Filter_enum filter);
+void cw_set_pitch(uint16_t pitch_Hz);
+uint16_t cw_process(const float* I, const float* Q, uint16_t n, float* out);
+void cw_task(void);
+void cw_print(void);
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * data_demod.h - data demodulators (AFSK 1200 for AX.25, FSK for POCSAG) on FM/AM/NBFM demodulator output
+ */
+
+#ifndef __data_demod__
+#define __data_demod__
+
+#include <stdbool.h>
+#include "main.h"
+#include "audio_i2s.h"
+
+#define DATA_DECIM1         8      //FS_BB_Hz -> AUDIO_FS_Hz (FM/AM audio)
+#define DATA_DECIM2         2      //AUDIO_FS_Hz -> DATA_FS_Hz
+#define DATA_FS_Hz          (AUDIO_FS_Hz/DATA_DECIM2) //13.3 kHz - 11 samples per AFSK bit
+#define DATA_AFSK_MARK_Hz   1200.0
+#define DATA_AFSK_SPACE_Hz  2200.0
+#define DATA_AFSK_BAUD      1200.0
+#define DATA_AFSK_CORR      11     //mark/space correlation length - one bit
+#define DATA_FSK_MA_MAX     26     //FSK moving average (one bit) - 512 baud is the slowest
+#define DATA_FSK_DC_AVG     0.0005f //FSK DC (frequency offset) average per sample (0.15 s)
+#define DATA_CLOCK_GAIN     2      //bit clock phase correction at transition - 1/2^DATA_CLOCK_GAIN of the error
+#define DATA_BITS_RING      1024   //bits from ADC callback to data_task() - power of 2
+
+typedef enum
+{
+	DATA_OFF = 0,
+	DATA_AFSK1200,   //Bell 202 AFSK, NRZI and HDLC - AX.25 packet radio
+	DATA_POCSAG512,  //direct FSK - POCSAG pagers
+	DATA_POCSAG1200,
+	DATA_POCSAG2400,
+	DATA_MODES
+}Data_Mode_enum;
+
+typedef enum
+{
+	DATA_OUT_TEXT = 0, //decoded frames printed on console
+	DATA_OUT_KISS      //AX.25 frames in KISS framing on console UART (binary) - for APRS/packet software
+}Data_Output_enum;
+
+typedef enum
+{
+	DATA_SRC_BB = 0,   //FM/AM audio at FS_BB_Hz
+	DATA_SRC_AUDIO     //NBFM discriminator at AUDIO_FS_Hz
+}Data_Source_enum;
+
+typedef struct
+{
+	volatile Data_Mode_enum mode;
+	Data_Output_enum output;
+}Data_Config_TypeDef;
+
+extern Data_Config_TypeDef Data_Config;
+extern const char *data_mode_name[DATA_MODES];
+
+void data_init(void);
+void data_set_mode(Data_Mode_enum mode);
+void data_process(const float* x, uint16_t n, Data_Source_enum src);
+void data_task(void);
+void data_print(void);
+
+#endif
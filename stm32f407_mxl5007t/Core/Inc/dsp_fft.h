@@ -0,0 +1,15 @@
+/*
+ * dsp_fft.h - radix-2 complex FFT for measurements in the main loop
+ */
+
+#ifndef __dsp_fft__
+#define __dsp_fft__
+
+#include <stdint.h>
+
+#define FFT_LEN_MAX  1024 //power of 2 - twiddle table size
+
+void fft_init(void);
+void fft_cplx(float* re, float* im, uint16_t len);
+
+#endif
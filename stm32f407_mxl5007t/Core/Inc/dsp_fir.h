@@ -0,0 +1,25 @@
+/*
+ * dsp_fir.h - decimating FIR filters for block processing
+ */
+
+#ifndef __dsp_fir__
+#define __dsp_fir__
+
+#include <stdint.h>
+
+typedef struct
+{
+	const float* coeff; //coefficients in flash
+	uint16_t taps;
+	uint8_t decim;      //output every decim-th input sample
+	uint8_t phase;      //input samples since the last output
+	uint16_t idx;       //delay line write position
+	float* delay;       //2*taps - every sample is written twice so the taps are always contiguous
+}FIR_Decim_TypeDef;
+
+void fir_reset(FIR_Decim_TypeDef* f);
+uint16_t fir_decim(FIR_Decim_TypeDef* f, const float* in, float* out, uint16_t n);
+uint16_t fir_decim_sym(FIR_Decim_TypeDef* f, const float* in, float* out, uint16_t n);
+uint16_t fir_decim_hb(FIR_Decim_TypeDef* f, const float* in, float* out, uint16_t n);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * dsp_mag.h - magnitude |I + jQ| for envelope detectors and level measurement
+ */
+
+#ifndef __dsp_mag__
+#define __dsp_mag__
+
+#include <stdint.h>
+#include "dsp_math.h"
+
+#define MAG_BENCH_LEN  64 //test vector length for mag bench
+
+//accuracy levels - cycles per sample and errors are printed by mag bench
+typedef enum
+{
+	MAG_AMBM = 0, //alpha max plus beta min (error < 4%)
+	MAG_RSQRT,    //p*rsqrt(p) with one Newton-Raphson step (error < 0.18%)
+	MAG_EXACT,    //VSQRT
+	MAG_MODES
+}Mag_Mode_enum;
+
+//every envelope user has its own speed/precision point
+typedef enum
+{
+	MAG_USER_AM = 0, //AM envelope detector - per baseband sample
+	MAG_USER_SAM,    //SAM carrier level and unlocked envelope - per audio sample
+	MAG_USER_CW,     //CW keying envelope - per narrow band sample
+	MAG_USER_LEVEL,  //tune/scan level in main loop
+	MAG_USERS
+}Mag_User_enum;
+
+extern volatile Mag_Mode_enum Mag_Mode[MAG_USERS];
+extern const char *mag_mode_name[MAG_MODES];
+extern const char *mag_user_name[MAG_USERS];
+
+//one sample - mode is usually a constant or read once per block, so the switch is hoisted by the compiler
+static inline float mag_calc(float x, float y, Mag_Mode_enum mode)
+{
+	float p;
+
+	switch (mode)
+	{
+	case MAG_AMBM:
+		return fast_magf(x, y);
+
+	case MAG_RSQRT:
+		p = x*x + y*y;
+		return p*fast_rsqrtf(p + 1.0e-30f); //offset keeps 0*rsqrt(0) finite
+
+	default:
+		return fast_sqrtf(x*x + y*y);
+	}
+}
+
+void mag_block(const float* I, const float* Q, float* out, uint16_t n, Mag_Mode_enum mode);
+void mag_set(Mag_User_enum user, Mag_Mode_enum mode);
+void mag_bench(void);
+void mag_print(void);
+
+#endif
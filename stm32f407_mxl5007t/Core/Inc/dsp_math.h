@@ -0,0 +1,98 @@
+/*
+ * dsp_math.h - fast math kernels for ADC callbacks
+ *
+ * Cortex-M4 FPU needs 14 cycles for VDIV and VSQRT, multiplication and addition take 1 cycle,
+ * so these functions are built only from multiplications and additions.
+ */
+
+#ifndef __dsp_math__
+#define __dsp_math__
+
+#include <stdint.h>
+#include <math.h>
+
+//1/x - initial estimate from float exponent bits and two Newton-Raphson iterations (relative error < 1e-5)
+static inline float fast_recipf(float x)
+{
+	union { float f; uint32_t u; } v = { .f = x };
+	float y;
+
+	v.u = 0x7EF311C3 - v.u;
+	y = v.f;
+	y = y*(2.0f - x*y);
+	y = y*(2.0f - x*y);
+	return y;
+}
+
+//atan2(y, x) - octant reduction and 9th order polynomial from Abramowitz & Stegun 4.4.49 (error < 2e-5 rad), returns 0 for (0, 0)
+static inline float fast_atan2f(float y, float x)
+{
+	float ax = fabsf(x), ay = fabsf(y);
+	float mn, mx, t, s, r;
+
+	if (ax > ay) { mx = ax; mn = ay; }
+	else { mx = ay; mn = ax; }
+	if (mx == 0.0f) return 0.0f;
+
+	t = mn*fast_recipf(mx);
+	s = t*t;
+	r = t*(0.9998660f + s*(-0.3302995f + s*(0.1801410f + s*(-0.0851330f + s*0.0208351f))));
+
+	if (ay > ax) r = (float) M_PI_2 - r;
+	if (x < 0.0f) r = (float) M_PI - r;
+	if (y < 0.0f) r = -r;
+	return r;
+}
+
+//1/sqrt(x) - initial estimate from float exponent bits and one Newton-Raphson iteration (relative error < 0.18%)
+static inline float fast_rsqrtf(float x)
+{
+	union { float f; uint32_t u; } v = { .f = x };
+	float y;
+
+	v.u = 0x5F375A86 - (v.u >> 1);
+	y = v.f;
+	return y*(1.5f - 0.5f*x*y*y);
+}
+
+//sqrt(x) by VSQRT instruction - sqrtf() without -fno-math-errno adds a check and library call for negative x
+static inline float fast_sqrtf(float x)
+{
+#if defined(__ARM_FP)
+	float r;
+	__asm ("vsqrt.f32 %0, %1" : "=t" (r) : "t" (x));
+	return r;
+#else
+	return sqrtf(x);
+#endif
+}
+
+//|x + jy| - alpha max plus beta min with minimal peak error (error < 4%)
+static inline float fast_magf(float x, float y)
+{
+	float ax = fabsf(x), ay = fabsf(y);
+
+	if (ax > ay) return 0.960433870f*ax + 0.397824735f*ay;
+	else return 0.960433870f*ay + 0.397824735f*ax;
+}
+
+//sine of phase accumulator (0 ... 2^32 -> 0 ... 2*pi) - folding to +/-pi/2 and 7th order Taylor polynomial (error < 2e-4)
+static inline float fast_sin_phase(uint32_t phase)
+{
+	float x = (int32_t) phase * (float) (M_PI/2147483648.0);
+	float s;
+
+	if (x > (float) M_PI_2) x = (float) M_PI - x;
+	else if (x < (float) -M_PI_2) x = (float) -M_PI - x;
+
+	s = x*x;
+	return x*(1.0f - s*(1.666666667e-1f - s*(8.333333333e-3f - s*1.984126984e-4f)));
+}
+
+static inline void fast_sincos_phase(uint32_t phase, float* s, float* c)
+{
+	*s = fast_sin_phase(phase);
+	*c = fast_sin_phase(phase + 0x40000000);
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * dsp_tables.h - look-up tables and FIR filters coefficients (generated by Matlab/lut_gen.m)
+ */
+
+#ifndef __dsp_tables__
+#define __dsp_tables__
+
+#include "main.h"
+
+#define IQ_HB1_TAPS 15
+#define IQ_HB2_TAPS 15
+#define IQ_IIR_SECTIONS 3
+#define IQ_IIR_COEFFS (5*IQ_IIR_SECTIONS)
+#define WFM_FIR1_TAPS 28
+#define WFM_FIR2_TAPS 48
+#define RDS_FIR1_TAPS 32
+#define RDS_FIR2_TAPS 32
+#define RDS_MF_TAPS   11
+#define SSB_FIR1_TAPS 32
+#define SSB_IIR_SECTIONS 4
+#define SSB_IIR_COEFFS (5*SSB_IIR_SECTIONS)
+#define CW_FIR2_TAPS  32
+#define CW_IIR_SECTIONS 2
+#define CW_IIR_COEFFS (5*CW_IIR_SECTIONS)
+#define SAM_IIR_SECTIONS 4
+#define SAM_IIR_COEFFS (5*SAM_IIR_SECTIONS)
+#define NBFM_FIR1_TAPS 24
+#define NBFM_FIR2_TAPS 64
+#define NBFM_AUDIO_SECTIONS 5
+#define NBFM_AUDIO_COEFFS (5*NBFM_AUDIO_SECTIONS)
+#define NBFM_NOISE_SECTIONS 2
+#define NBFM_NOISE_COEFFS (5*NBFM_NOISE_SECTIONS)
+#define NBFM_TONE_SECTIONS 2
+#define NBFM_TONE_COEFFS (5*NBFM_TONE_SECTIONS)
+#define DATA_FIR2_TAPS 24
+#define CHAN_HB_TAPS  19
+#define CHAN_HB_SHORT_TAPS 11
+#define CHAN_FIR_TAPS 36
+
+extern const float asin_arr[N_asin];
+extern const float IQ_HB1[IQ_HB1_TAPS];
+extern const float IQ_HB2[IQ_HB2_TAPS];
+extern const float IQ_IIR_3k[IQ_IIR_COEFFS];
+extern const float IQ_IIR_6k[IQ_IIR_COEFFS];
+extern const float IQ_IIR_10k[IQ_IIR_COEFFS];
+extern const float IQ_IIR_15k[IQ_IIR_COEFFS];
+extern const float IQ_IIR_30k[IQ_IIR_COEFFS];
+extern const float IQ_IIR_60k[IQ_IIR_COEFFS];
+extern const float WFM_FIR1[WFM_FIR1_TAPS];
+extern const float WFM_FIR2[WFM_FIR2_TAPS];
+extern const float RDS_FIR1_I[RDS_FIR1_TAPS];
+extern const float RDS_FIR1_Q[RDS_FIR1_TAPS];
+extern const float RDS_FIR2[RDS_FIR2_TAPS];
+extern const float RDS_MF[RDS_MF_TAPS];
+extern const float SSB_FIR1[SSB_FIR1_TAPS];
+extern const float SSB_IIR_2k4[SSB_IIR_COEFFS];
+extern const float SSB_IIR_2k7[SSB_IIR_COEFFS];
+extern const float SSB_IIR_3k0[SSB_IIR_COEFFS];
+extern const float CW_FIR2[CW_FIR2_TAPS];
+extern const float CW_IIR_200[CW_IIR_COEFFS];
+extern const float CW_IIR_300[CW_IIR_COEFFS];
+extern const float CW_IIR_500[CW_IIR_COEFFS];
+extern const float SAM_IIR[SAM_IIR_COEFFS];
+extern const float NBFM_FIR1[NBFM_FIR1_TAPS];
+extern const float NBFM_FIR2_12k5[NBFM_FIR2_TAPS];
+extern const float NBFM_FIR2_25k[NBFM_FIR2_TAPS];
+extern const float NBFM_AUDIO_IIR[NBFM_AUDIO_COEFFS];
+extern const float NBFM_NOISE_IIR[NBFM_NOISE_COEFFS];
+extern const float NBFM_TONE_IIR[NBFM_TONE_COEFFS];
+extern const float DATA_FIR2[DATA_FIR2_TAPS];
+extern const float CHAN_HB[CHAN_HB_TAPS];
+extern const float CHAN_HB_SHORT[CHAN_HB_SHORT_TAPS];
+extern const float CHAN_FIR[CHAN_FIR_TAPS];
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * enob.h - effective number of bits, SINAD and SFDR of a captured tone at ADC, CIC decimator and IQ filter outputs
+ */
+
+#ifndef __enob__
+#define __enob__
+
+#include <stdint.h>
+#include "main.h"
+#include "dsp_fft.h"
+
+#define ENOB_LEN        FFT_LEN_MAX //samples analysed per path
+#define ENOB_WARMUP     32          //extra ADC samples for CIC decimator settling
+#define ENOB_LOBE_BINS  5           //Blackman-Harris main lobe half width - tone and DC
+#define ENOB_CIC_N      3           //CIC stages
+#define ENOB_CIC_BITS   30          //accumulator magnitude bits (int32 with sign and one bit of margin)
+#define ENOB_TIMEOUT_ms 100
+
+typedef enum
+{
+	ENOB_ADC = 0,  //raw ADC samples - real, 0...fs/2
+	ENOB_CIC2,     //integer mixer and CIC decimator R=2 in 32-bit accumulators - +/-fs/16
+	ENOB_CIC4,     //the same with R=4 - +/-fs/16
+	ENOB_IIR,      //I/Q after IQ filters and decimation (DSP chain) - +/-IQ filter cut-off
+	ENOB_PATHS
+}ENOB_Path_enum;
+
+typedef struct
+{
+	float fs_Hz;     //sample rate of the path
+	float band_Hz;   //noise is summed up to this frequency (both signs for I/Q)
+	float tone_Hz;
+	float tone_dBFS; //full scale ADC sine is 0 dBFS at every path
+	float sinad_dB;
+	float sfdr_dB;   //[dBc]
+	float enob;      //referred to full scale
+}ENOB_Result_TypeDef;
+
+void enob_capture_adc(const int16_t* samples, uint16_t n);
+void enob_capture_bb(const float* I, const float* Q, uint16_t n);
+void enob_measure(void);
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * flash_if.h - internal flash erase/program routines for data stored in reserved sectors
+ */
+
+#ifndef __flash_if__
+#define __flash_if__
+
+#include <stdbool.h>
+#include "main.h"
+
+extern uint32_t Flash_erase_ms; //duration of the last sector erase - ADC processing is stalled for that time
+
+bool flash_erase_sector(uint32_t sector);
+bool flash_program(uint32_t addr, const void* data, uint32_t len);
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * freq_plan.h - IF plan: tuner IF selection, IF after band pass sampling, mixer NCO table and validation
+ */
+
+#ifndef __freq_plan__
+#define __freq_plan__
+
+#include <stdbool.h>
+#include "main.h"
+#include "MxL5007_Common.h"
+
+#define FP_IF_MAX_Hz    10000000.0 //ADC input bandwidth and aperture jitter - higher IFs aren't sampled usefully
+#define FP_NCO_MAX      64         //the longest mixer table
+#define FP_NCO_ERR_Hz   500.0      //the shortest table within this frequency error is taken
+#define FP_GUARD_Hz     10000.0    //IQ filter transition band - channel edge to 0 Hz or fs/2
+#define FP_NARROW_Hz    15000.0    //IQ filter bandwidths (see set_IQ_filters_coeff)
+#define FP_WIDE_Hz      105000.0
+#define FP_IF_BW_Hz     6000000.0  //tuner IF filter (MxL_BW_6MHz) - noise of all Nyquist zones in it is folded
+
+typedef enum
+{
+	FP_OK = 0,
+	FP_ERR_IF,     //IF is above ADC input bandwidth
+	FP_ERR_ALIAS,  //even the narrow IQ filter band crosses 0 Hz or fs/2 after band pass sampling
+	FP_ERR_NCO,    //no table up to FP_NCO_MAX is within FP_NCO_ERR_Hz
+	FP_ERRORS
+}FP_Error_enum;
+
+//precomputed plans - tuner IF, the sample rate is always FS_ADC_Hz
+typedef struct
+{
+	const char *name;
+	MxL5007_IF_Freq if_Hz;
+}FP_Spec_TypeDef;
+
+//what the plan gives
+typedef struct
+{
+	double fs_Hz;        //FS_ADC_Hz
+	double alias_Hz;     //IF after band pass sampling
+	bool inverted;       //odd Nyquist zone - tuner IF spectrum is inverted to compensate
+	uint8_t nco_len;     //mixer table - nco_step periods of alias_Hz in nco_len samples
+	uint8_t nco_step;
+	double nco_err_Hz;   //mixer frequency - alias_Hz
+	double margin_Hz;    //channel center to the nearer of 0 Hz and fs/2
+	double fs_bb_Hz;     //after IQ filters and ADC_DECIM
+	uint8_t zones;       //Nyquist zones in tuner IF filter - noise folding
+	bool wide;           //105 kHz IQ filter (FM, WFM) fits, otherwise only 15 kHz modes
+	FP_Error_enum error;
+}FP_Plan_TypeDef;
+
+#define FP_PLANS 6
+
+extern const FP_Spec_TypeDef fp_specs[FP_PLANS];
+extern FP_Plan_TypeDef FP_Plan; //active plan
+
+//mixer table - switched by fp_select() with interrupts disabled, read once per block by ADC callback
+extern const float *NCO_sin, *NCO_cos;
+extern uint8_t NCO_len;
+
+void fp_compute(const FP_Spec_TypeDef* spec, FP_Plan_TypeDef* p);
+void fp_init(uint8_t plan);
+bool fp_select(uint8_t plan);
+uint8_t fp_active(void);
+bool fp_fits(float bw_Hz);
+void fp_print(void);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * iq_corr.h - ADC DC offset removal and I/Q gain/phase imbalance estimation and correction
+ */
+
+#ifndef __iq_corr__
+#define __iq_corr__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define IQC_DC_COEFF     (1.0f/64)   //DC offset average per block (9.7 ms)
+#define IQC_AVG_COEFF    (1.0f/4096) //I/Q powers and correlation averages per block (0.62 s) - imbalance is static
+#define IQC_POWER_MIN    1.0e-12f    //no estimation below this I power (mute, no signal)
+
+typedef struct
+{
+	volatile bool dc_block;  //DC offset estimate is removed from ADC samples
+	volatile bool corr;      //I/Q imbalance correction after IQ filters (estimation runs always)
+}IQC_Config_TypeDef;
+
+extern IQC_Config_TypeDef IQC_Config;
+extern float IQC_DC_applied; //subtracted from scaled ADC samples - 0 if dc_block is off
+
+void iqc_set_dc_block(bool on);
+void iqc_set_corr(bool on);
+void iqc_reset(void);
+void iqc_dc_update(float sum, uint16_t n);
+void iqc_process(float* I, float* Q, uint16_t n);
+void iqc_print(void);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * lms.h - LMS adaptive auto-notch and noise reduction on mono audio at AUDIO_FS_Hz
+ */
+
+#ifndef __lms__
+#define __lms__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define LMS_TAPS_MIN     8
+#define LMS_TAPS_MAX     128
+#define LMS_DELAY_MAX    64
+#define LMS_POWER_AVG    (1.0f/256)  //input power average per sample (9.7 ms) - step normalization
+#define LMS_BENCH_LEN    256         //samples per benchmark run
+
+//auto-notch - long decorrelation delay, so only steady tones are predicted and removed
+#define LMS_NOTCH_TAPS   64
+#define LMS_NOTCH_DELAY  64          //2.4 ms
+#define LMS_NOTCH_MU     0.002f
+#define LMS_NOTCH_LEAK   1.0e-5f
+
+//noise reduction - one sample delay, voice is predicted and uncorrelated noise isn't
+#define LMS_NR_TAPS      32
+#define LMS_NR_DELAY     1
+#define LMS_NR_MU        0.05f
+#define LMS_NR_LEAK      1.0e-4f
+
+typedef enum
+{
+	LMS_NOTCH = 0,  //output is prediction error
+	LMS_NR,         //output is prediction
+	LMS_FILTERS
+}LMS_Filter_enum;
+
+typedef struct
+{
+	volatile bool on;
+	uint8_t taps;
+	uint8_t delay;    //reference is input delayed by this
+	float mu;         //normalized step
+	float leak;       //coefficients leakage per sample
+	float w[LMS_TAPS_MAX];
+	float buf[2*(LMS_TAPS_MAX + LMS_DELAY_MAX)]; //every sample is written twice so the taps are always contiguous
+	uint16_t idx;
+	float power;
+}LMS_TypeDef;
+
+extern LMS_TypeDef LMS[LMS_FILTERS];
+extern const char *lms_filter_name[LMS_FILTERS];
+
+void lms_init(void);
+void lms_set_on(LMS_Filter_enum filter, bool on);
+void lms_set_taps(LMS_Filter_enum filter, uint8_t taps);
+bool lms_active(Output_demod_type_enum demod);
+void lms_process(float* x, uint16_t n);
+void lms_bench(void);
+void lms_print(void);
+
+#endif
@@ -47,38 +47,16 @@ extern "C" {
 #define Total_Gain_max  MxL_max_Gain + IF_Gain + Attenuation
 
 
-#define N_cos_sin    33 //see comments in main.c
-#define Step_cos_sin 10
-
 #define N_asin 150
 
-//IQ filters coefficients for FM
-#define b0__105kHz 5.59802632778882980346679687500000e-04
-#define b1__105kHz 2.79901339672505855560302734375000e-03
-#define b2__105kHz 5.59802679345011711120605468750000e-03
-#define b3__105kHz 5.59802679345011711120605468750000e-03
-#define b4__105kHz 2.79901339672505855560302734375000e-03
-#define b5__105kHz 5.59802632778882980346679687500000e-04
-
-#define a0__105kHz -3.78060984611511230468750000000000e+00
-#define a1__105kHz 6.29705619812011718750000000000000e+00
-#define a2__105kHz -5.68249320983886718750000000000000e+00
-#define a3__105kHz 2.76533651351928710937500000000000e+00
-#define a4__105kHz -5.81376254558563232421875000000000e-01
-
-//IQ filters coefficients for AM and CW
-#define b0__15kHz 3.95331483105110237374901771545410e-08
-#define b1__15kHz 1.97665755763409833889454603195190e-07
-#define b2__15kHz 3.95331511526819667778909206390381e-07
-#define b3__15kHz 3.95331511526819667778909206390381e-07
-#define b4__15kHz 1.97665755763409833889454603195190e-07
-#define b5__15kHz 3.95331483105110237374901771545410e-08
-
-#define a0__15kHz -4.90738058090209960937500000000000e+00
-#define a1__15kHz 9.64835929870605468750000000000000e+00
-#define a2__15kHz -9.49977493286132812500000000000000e+00
-#define a3__15kHz 4.68406248092651367187500000000000e+00
-#define a4__15kHz -9.25264954566955566406250000000000e-01
+//DSP processes ADC samples in blocks - one block per half of circular DMA buffer (half/full transfer interrupt)
+#define FS_ADC_Hz  (84000000.0/99.0) //TIM3_clk/(ARR+1)
+#define ADC_DECIM  4                 //decimation after IQ filters
+#define ADC_BLOCK  128               //ADC samples per block
+#define BB_BLOCK   (ADC_BLOCK/ADC_DECIM) //I/Q samples per block
+#define FS_BB_Hz   (FS_ADC_Hz/ADC_DECIM)
+
+extern volatile uint32_t ADC_overruns; //halves of ADC buffer overwritten by DMA before their processing was finished
 
 /* USER CODE END EC */
 
@@ -89,8 +67,32 @@ typedef enum
 	DEMOD_FM = 0,
 	DEMOD_AM,
 	OUT_IQ,
-	DEMOD_CW
+	DEMOD_CW,
+	DEMOD_WFM, //broadcast FM with stereo decoder and de-emphasis
+	DEMOD_USB, //SSB - Weaver demodulator
+	DEMOD_LSB,
+	DEMOD_SAM, //synchronous AM with carrier PLL
+	DEMOD_NBFM //narrowband FM voice with noise and tone squelch
 }Output_demod_type_enum;
+
+typedef enum
+{
+	IQ_FILTER_105kHz = 0, //the first two keep their values - memory bank channels store the index
+	IQ_FILTER_15kHz,
+	IQ_FILTER_3kHz,
+	IQ_FILTER_6kHz,
+	IQ_FILTER_10kHz,
+	IQ_FILTER_30kHz,
+	IQ_FILTER_60kHz,
+	IQ_FILTERS
+}IQ_Filter_enum;
+
+typedef enum
+{
+	FM_DISCR_NOGA = 0, //Noga's discriminator with division and asin look-up table
+	FM_DISCR_ATAN2,    //polar discriminator - phase difference by polynomial atan2
+	FM_DISCR_NUM
+}FM_Discr_enum;
 /* USER CODE END EM */
 
 void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
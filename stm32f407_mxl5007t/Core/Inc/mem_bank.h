@@ -0,0 +1,59 @@
+/*
+ * mem_bank.h - memory channels bank stored in internal flash
+ */
+
+#ifndef __mem_bank__
+#define __mem_bank__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define MEM_FLASH_SECTOR    FLASH_SECTOR_11
+#define MEM_FLASH_ADDR      0x080E0000 //sector 11 - reserved in STM32F407VGTX_FLASH.ld
+#define MEM_FLASH_SIZE      (128*1024)
+#define MEM_MAGIC_IMAGE     0x4D454D31 //"MEM1" - whole bank image written by older firmware, loaded and compacted
+#define MEM_MAGIC           0x4D454D32 //"MEM2" - change it when Mem_Record_TypeDef changes
+#define MEM_RECORD_SIZE     64
+#define MEM_CHANNELS        64
+#define MEM_TUNE_PAYLOAD    24 //MxL5007T RFTune payload is 10 address/data pairs
+#define MEM_VALID           0xA5
+
+typedef struct
+{
+	uint32_t freq_Hz;
+	uint8_t valid;                          //MEM_VALID if channel is stored
+	uint8_t demod;                          //Output_demod_type_enum
+	uint8_t filter;                         //IQ_Filter_enum
+	uint8_t tune_len;                       //precomputed MxL5007T payload length
+	float gain;                             //total gain [dB]
+	float squelch;                          //squelch open threshold [dB] for memory scan
+	uint8_t tune_regs[MEM_TUNE_PAYLOAD];    //precomputed MxL5007T RFTune payload - address/data pairs
+}Mem_Channel_TypeDef;
+
+typedef struct
+{
+	uint32_t magic;
+	Mem_Channel_TypeDef ch[MEM_CHANNELS];
+}Mem_Bank_TypeDef;
+
+//append-only record of one channel - the last record of a channel in the sector is the valid one
+typedef struct
+{
+	uint32_t magic;     //written as the last word so partially written record is never valid
+	uint8_t n;          //channel number
+	uint8_t reserved0[3];
+	Mem_Channel_TypeDef ch;
+	uint8_t reserved[MEM_RECORD_SIZE - 12 - sizeof(Mem_Channel_TypeDef)];
+	uint32_t checksum;
+}Mem_Record_TypeDef;
+
+void mem_init(void);
+bool mem_store(uint8_t n, float squelch);
+bool mem_clear(uint8_t n);
+bool mem_recall(uint8_t n);
+bool mem_valid(uint8_t n);
+int16_t mem_next(uint8_t n);
+const Mem_Channel_TypeDef* mem_get(uint8_t n);
+void mem_list(void);
+
+#endif
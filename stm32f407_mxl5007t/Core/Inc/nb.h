@@ -0,0 +1,44 @@
+/*
+ * nb.h - noise blanker and impulse limiter on scaled ADC block (before mixer and IQ filters)
+ */
+
+#ifndef __nb__
+#define __nb__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define NB_THRESHOLD_DEFAULT 6.0f    //pulse is above threshold x average magnitude (15.6 dB)
+#define NB_THRESHOLD_MIN     2.0f
+#define NB_THRESHOLD_MAX     100.0f
+#define NB_HANG_DEFAULT      8       //samples blanked after the last pulse sample (9.4 us) - tuner IF filter rings too
+#define NB_HANG_MAX          64
+#define NB_PRE               2       //samples blanked before pulse - only in the same block (previous one is filtered)
+#define NB_AVG_COEFF         (1.0f/1024) //average magnitude per FS_ADC_Hz sample (1.2 ms)
+#define NB_AVG_INIT          1.0f    //full scale - average decays to signal level, nothing is blanked before
+
+typedef enum
+{
+	NB_OFF = 0,
+	NB_BLANK,  //samples of pulse and around it are zeroed
+	NB_LIMIT,  //samples are clipped at threshold
+	NB_MODES
+}NB_Mode_enum;
+
+typedef struct
+{
+	volatile NB_Mode_enum mode;
+	float threshold;  //relative to average magnitude
+	uint8_t hang;     //samples
+}NB_Config_TypeDef;
+
+extern NB_Config_TypeDef NB_Config;
+extern const char *nb_mode_name[NB_MODES];
+
+void nb_set_mode(NB_Mode_enum mode);
+void nb_set_threshold(float threshold);
+void nb_set_hang(uint8_t hang);
+void nb_process(float* x, uint16_t n);
+void nb_print(void);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * nbfm.h - narrowband FM voice receiver with noise squelch and CTCSS/DCS tone squelch
+ */
+
+#ifndef __nbfm__
+#define __nbfm__
+
+#include <stdbool.h>
+#include "main.h"
+#include "audio_i2s.h"
+
+#define NBFM_DECIM1         4      //FS_BB_Hz -> 53 kHz
+#define NBFM_DECIM2         2      //53 kHz -> AUDIO_FS_Hz (channel filter)
+#define NBFM_DEEMPH_us      750.0  //6 dB/octave de-emphasis of land mobile radios
+#define NBFM_AUDIO_LEVEL    0.5    //audio amplitude of 1 kHz tone at nominal deviation
+#define NBFM_NOISE_AVG      0.002f //noise power average per audio sample (19 ms)
+#define NBFM_SQ_HYST_dB     3.0    //squelch closes NBFM_SQ_HYST_dB above opening level
+#define NBFM_SQ_DEFAULT_dB  (-6)   //noise level relative to no signal - 0 is squelch off
+#define NBFM_GATE_RAMP      0.005f //audio gate fade per audio sample (7.5 ms) - no clicks
+#define NBFM_TONE_DECIM     16     //AUDIO_FS_Hz -> NBFM_TONE_FS_Hz
+#define NBFM_TONE_FS_Hz     (AUDIO_FS_Hz/NBFM_TONE_DECIM) //1.66 kHz - CTCSS Goertzel bank and DCS bit slicer
+#define NBFM_TONE_DC_AVG    0.002f //sub-audio DC (carrier offset) average per tone sample (0.3 s)
+#define NBFM_CTCSS_TONES    50
+#define NBFM_CTCSS_N        512    //Goertzel window (0.31 s) - the closest tones 67.0/69.3 Hz are 0.7 bin apart
+#define NBFM_CTCSS_RATIO    0.3f   //tone power / sub-audio power for detection
+#define NBFM_CTCSS_NONE     0xFF
+#define NBFM_DCS_BAUD       134.4
+#define NBFM_DCS_BITS       23     //Golay (23,12) word - 9 bits of code, "100" and 11 parity bits, LSB first
+#define NBFM_DCS_HOLD       (3*NBFM_DCS_BITS) //bits - detection is held for one missed word
+#define NBFM_DCS_NONE       0xFFFF
+
+typedef enum
+{
+	NBFM_CHANNEL_12k5 = 0, //2.5 kHz deviation
+	NBFM_CHANNEL_25k,      //5 kHz deviation
+	NBFM_CHANNELS
+}NBFM_Channel_enum;
+
+typedef enum
+{
+	NBFM_TONE_OFF = 0, //noise squelch only
+	NBFM_TONE_CTCSS,
+	NBFM_TONE_DCS
+}NBFM_Tone_enum;
+
+//channel is stored in settings
+typedef struct
+{
+	NBFM_Channel_enum channel;
+	int8_t squelch_dB;    //noise above voice band relative to no signal for opening - 0 is off
+	NBFM_Tone_enum tone;  //audio is gated by CTCSS tone or DCS code too
+	uint8_t ctcss;        //index in nbfm_ctcss_dHz
+	uint16_t dcs;         //DCS code - 9 bits, printed in octal like on radios
+}NBFM_Config_TypeDef;
+
+extern NBFM_Config_TypeDef NBFM_Config;
+extern const char *nbfm_channel_name[NBFM_CHANNELS];
+extern const uint16_t nbfm_ctcss_dHz[NBFM_CTCSS_TONES];
+extern float NBFM_Discr[BB_BLOCK/(NBFM_DECIM1*NBFM_DECIM2)];
+
+void nbfm_init(void);
+void nbfm_set_channel(NBFM_Channel_enum channel);
+void nbfm_set_squelch(int8_t squelch_dB);
+bool nbfm_set_ctcss(float freq_Hz);
+void nbfm_set_dcs(uint16_t code);
+void nbfm_tone_off(void);
+uint16_t nbfm_process(const float* I, const float* Q, uint16_t n, float* out);
+void nbfm_print(void);
+
+#endif
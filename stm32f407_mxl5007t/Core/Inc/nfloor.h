@@ -0,0 +1,34 @@
+/*
+ * nfloor.h - noise floor estimator (median of averaged FFT bins of mixer output) and channel SNR
+ */
+
+#ifndef __nfloor__
+#define __nfloor__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define NF_FFT_LEN      256         //complex FFT of mixer output - 3.3 kHz bins, two ADC blocks
+#define NF_AVG          8           //power spectra averaged per estimate (2.4 ms of samples)
+#define NF_MEDIAN_BIAS  0.959f      //median/mean of chi-square with 2*NF_AVG degrees of freedom
+#define NF_SNR_MIN_dB   (-30.0f)
+
+typedef struct
+{
+	float noise_dB;    //noise power in the channel bandwidth [dB] - the same scale like scan levels
+	float channel_dB;  //signal + noise power in the channel bandwidth [dB]
+	float snr_dB;      //(channel - noise)/noise
+	float density_dB;  //noise density [dBFS/Hz]
+	uint32_t count;    //estimates since nf_reset()
+}NF_Result_TypeDef;
+
+extern NF_Result_TypeDef NF_Result;
+
+void nf_init(void);
+void nf_reset(void);
+void nf_capture(const float* I, const float* Q, uint16_t n);
+void nf_task(void);
+float nf_snr_dB(void);
+void nf_print(void);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * perf.h - DSP profiling with DWT cycle counter
+ */
+
+#ifndef __perf__
+#define __perf__
+
+#include "main.h"
+
+#define PERF_ENABLE 1 //0 - probes are compiled out
+
+typedef enum
+{
+	PERF_SCALE = 0, //ADC samples scaling
+	PERF_NB,        //noise blanker / impulse limiter
+	PERF_MIXER,     //multiplication by sine and cosine
+	PERF_IIR,       //IQ half band decimation and channel low pass filters
+	PERF_IQ,        //I/Q imbalance estimation and correction
+	PERF_DEMOD,     //demodulator and audio filters
+	PERF_LMS,       //audio auto-notch and noise reduction
+	PERF_AGC,       //audio AGC and limiter
+	PERF_OUTPUT,    //DAC scaling and output
+	PERF_WFM_MPX,   //WFM polar discriminator
+	PERF_WFM_PILOT, //WFM pilot PLL and L-R demodulation
+	PERF_WFM_AUDIO, //WFM decimation, matrix and de-emphasis
+	PERF_RDS,       //RDS demodulator
+	PERF_DATA,      //AFSK/FSK data demodulators
+	PERF_CALLBACK,  //whole ADC callback
+	PERF_ISR,       //DMA interrupt including HAL overhead
+	PERF_PROBES
+}Perf_Probe_enum;
+
+typedef struct
+{
+	uint32_t min;
+	uint32_t max;
+	uint32_t cnt;
+	uint64_t sum;
+}Perf_Stat_TypeDef;
+
+extern Perf_Stat_TypeDef Perf_Stat[PERF_PROBES];
+extern uint32_t Perf_deadline;
+extern uint32_t Perf_overruns;
+
+void perf_init(void);
+void perf_reset(void);
+void perf_print(void);
+
+static inline uint32_t perf_start(void)
+{
+	return DWT->CYCCNT;
+}
+
+//records cycles from start for the probe and returns current stamp, so stages can be chained
+static inline uint32_t perf_stamp(Perf_Probe_enum probe, uint32_t start)
+{
+#if PERF_ENABLE
+	uint32_t now = DWT->CYCCNT;
+	uint32_t cycles = now - start;
+	Perf_Stat_TypeDef* s = &Perf_Stat[probe];
+
+	if (cycles < s->min) s->min = cycles;
+	if (cycles > s->max) s->max = cycles;
+	s->sum += cycles;
+	s->cnt++;
+	return now;
+#else
+	return start;
+#endif
+}
+
+//end of DMA interrupt - deadline is ADC_BLOCK samples (half of DMA buffer)
+static inline void perf_isr_end(uint32_t start)
+{
+#if PERF_ENABLE
+	if (DWT->CYCCNT - start > Perf_deadline) Perf_overruns++;
+	perf_stamp(PERF_ISR, start);
+#endif
+}
+
+#endif
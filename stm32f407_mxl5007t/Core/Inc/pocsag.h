@@ -0,0 +1,30 @@
+/*
+ * pocsag.h - POCSAG pager batch synchronization, BCH(31,21) correction and message decoding
+ */
+
+#ifndef __pocsag__
+#define __pocsag__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define POCSAG_SYNC       0x7CD215D8
+#define POCSAG_IDLE       0x7A89C197
+#define POCSAG_BATCH      16  //codewords after sync word - 8 frames of 2
+#define POCSAG_SYNC_ERR   3   //bit errors accepted in sync word of the next batch
+#define POCSAG_MSG_MAX    80  //characters
+
+typedef struct
+{
+	uint32_t batches;
+	uint32_t messages;
+	uint32_t corrected;  //codewords with one bit corrected
+	uint32_t errors;     //uncorrectable codewords
+}POCSAG_Stat_TypeDef;
+
+extern POCSAG_Stat_TypeDef POCSAG_Stat;
+
+void pocsag_reset(uint16_t baud);
+void pocsag_bit(uint8_t bit);
+
+#endif
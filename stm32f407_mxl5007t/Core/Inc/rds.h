@@ -0,0 +1,37 @@
+/*
+ * rds.h - RDS/RBDS decoder from WFM multiplex signal
+ */
+
+#ifndef __rds__
+#define __rds__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define RDS_CARRIER_Hz      57000.0
+#define RDS_BITRATE_Hz      1187.5
+#define RDS_DECIM1          8      //57 kHz band pass decimation
+#define RDS_DECIM2          2      //low pass decimation
+#define RDS_FS_Hz           (FS_BB_Hz/(RDS_DECIM1*RDS_DECIM2)) //13.3 kHz - 11.16 samples per bit
+#define RDS_COSTAS_BW_Hz    10.0   //carrier loop natural frequency
+#define RDS_COSTAS_ZETA     0.707
+#define RDS_COSTAS_RANGE_Hz 20.0   //57 kHz is locked to the pilot, so only small offset is expected
+#define RDS_CLOCK_GAIN      0.01   //symbol clock correction [bit period] for normalized timing error
+#define RDS_BITS_RING       256    //bits from ADC callback to rds_task() - power of 2
+#define RDS_MAX_BURST       2      //longest corrected error burst [bits] - code corrects up to 5 but false corrections rise
+#define RDS_SYNC_LOSS       10     //consecutive uncorrectable blocks - bit slip or signal loss
+
+typedef struct
+{
+	bool enabled; //demodulator runs in WFM mode
+	bool print;   //PI/PS/RT are printed when they change
+}RDS_Config_TypeDef;
+
+extern RDS_Config_TypeDef RDS_Config;
+
+void rds_init(void);
+void rds_process(const float* mpx, uint16_t n);
+void rds_task(void);
+void rds_print(void);
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * sam.h - synchronous AM detector with carrier tracking PLL
+ */
+
+#ifndef __sam__
+#define __sam__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define SAM_DECIM         8      //FS_BB_Hz -> AUDIO_FS_Hz
+#define SAM_PLL_ACQ_Hz    100.0  //carrier PLL natural frequency during acquisition - pull-in from SAM_PLL_RANGE_Hz
+#define SAM_PLL_BW_Hz     20.0   //and after lock - low phase jitter from asymmetric sidebands
+#define SAM_PLL_ZETA      0.707
+#define SAM_PLL_RANGE_Hz  1000.0 //maximum carrier offset
+#define SAM_LOCK_RATIO    0.7f   //in-phase carrier level / envelope average for lock
+#define SAM_SB_SHIFT_Hz   2500.0 //Weaver shift for sideband selection - half of audio bandwidth
+#define SAM_AVG           0.0002f //carrier level and DC average per audio sample (0.19 s)
+
+typedef enum
+{
+	SAM_DSB = 0, //both sidebands - in-phase component
+	SAM_USB,
+	SAM_LSB,
+	SAM_SIDEBANDS
+}SAM_Sideband_enum;
+
+typedef struct
+{
+	SAM_Sideband_enum sideband;
+}SAM_Config_TypeDef;
+
+extern SAM_Config_TypeDef SAM_Config;
+extern const char *sam_sideband_name[SAM_SIDEBANDS];
+
+void sam_init(void);
+uint16_t sam_process(const float* I, const float* Q, uint16_t n, float* out);
+void sam_print(void);
+
+#endif
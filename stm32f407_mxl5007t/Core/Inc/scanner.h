@@ -0,0 +1,41 @@
+/*
+ * scanner.h - squelch controlled frequency scanner
+ */
+
+#ifndef __scanner__
+#define __scanner__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define SCAN_SQ_WINDOW_ms 20 //squelch level averaging window while the channel is open or in hang time
+#define SCAN_PRIO_SAMPLE_ms 2000 //priority channel check period while another memory channel is held open
+
+typedef enum
+{
+	SCAN_IDLE = 0,
+	SCAN_SETTLE, //waiting for tuner PLL and IQ filters to settle after retune
+	SCAN_DWELL,  //measuring channel level
+	SCAN_OPEN,   //squelch open - audio is on
+	SCAN_HANG,   //carrier dropped - waiting hang time before resuming
+	SCAN_PAUSED
+}Scan_State_enum;
+
+typedef struct
+{
+	uint32_t settle_ms; //time after retune before measurement
+	uint32_t dwell_ms;  //measurement time per channel
+	uint32_t hang_ms;   //time to stay on the channel after the carrier drops
+	uint32_t resume_ms; //maximum time on an active channel before moving on (0 - stay until carrier drops)
+	bool snr;           //squelch thresholds (scan and memory channels) are SNR over noise floor instead of absolute level [dB]
+}Scan_Config_TypeDef;
+
+extern Scan_Config_TypeDef Scan_Config;
+
+void scanner_start(double start_freq, double step, float sq_open, float sq_hyst);
+void scanner_start_mem(float sq_hyst, int16_t prio, uint8_t prio_every);
+bool scanner_task(int key);
+void scanner_stop(void);
+Scan_State_enum scanner_state(void);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * settings.h - persistent receiver settings and calibration stored in internal flash
+ */
+
+#ifndef __settings__
+#define __settings__
+
+#include <stdbool.h>
+#include "main.h"
+#include "cw.h"
+
+//two sectors used in turn - the other one is erased when the active one is full, so the latest record survives
+//power loss during erase (sector 10 is the first one, so records written before sector 9 was added are found)
+#define SET_FLASH_SECTORS    2
+#define SET_FLASH_SECTOR_0   FLASH_SECTOR_10
+#define SET_FLASH_ADDR_0     0x080C0000 //sector 10 - reserved in STM32F407VGTX_FLASH.ld
+#define SET_FLASH_SECTOR_1   FLASH_SECTOR_9
+#define SET_FLASH_ADDR_1     0x080A0000 //sector 9 - reserved in STM32F407VGTX_FLASH.ld
+#define SET_FLASH_SIZE       (128*1024)
+#define SET_MAGIC            0x53455431 //"SET1" - change it when Settings_Record_TypeDef changes
+#define SET_RECORD_SIZE      64
+#define SET_SAVE_DELAY_ms    5000 //settings have to be stable for this time before they are written (flash wear)
+#define SET_CHECK_PERIOD_ms  500
+
+//default receiver state - used if there are no valid records and by init command
+#define SET_DEFAULT_FREQ_Hz  (100*1000000)
+#define SET_DEFAULT_GAIN     75.0 //dB - total gain
+#define SET_DEFAULT_DEMOD    DEMOD_FM
+#define SET_DEFAULT_CW_PITCH CW_DEFAULT_PITCH
+#define SET_DEFAULT_CW_FILTER CW_FILTER_500
+#define SET_DEFAULT_FM_DISCR FM_DISCR_NOGA
+
+//WFM byte - zero is the default (50 us de-emphasis, stereo) so records written before it was added are still valid
+#define SET_WFM_DEEMPH_MASK  0x03 //0 - 50 us ; 1 - 75 us ; 2 - off
+#define SET_WFM_MONO         0x80
+
+typedef struct
+{
+	float IF_gain;      //dB - measured IF amplifier gain
+	float attenuation;  //dB - tuner's output loaded by IF amplifier input
+	float A_V_if_agc;   //V_if_agc [V] = A_V_if_agc*Gain [dB] + B_V_if_agc
+	float B_V_if_agc;
+	float K_corr;       //IF_AGC PWM low pass filter load correction
+}Calibration_TypeDef;
+
+typedef struct
+{
+	uint32_t freq_Hz;
+	float gain;         //total gain [dB]
+	uint16_t CW_pitch;  //Hz - out of range in records from the comparator CW times, so they fall back to default
+	uint8_t CW_filter;  //CW_Filter_enum
+	uint8_t demod;      //Output_demod_type_enum
+	uint8_t volume;
+	uint8_t fm_discr;   //FM_Discr_enum
+	uint8_t wfm;        //SET_WFM_DEEMPH_MASK | SET_WFM_MONO
+	uint8_t ssb;        //SSB_Filter_enum - zero is the default 2.7 kHz
+	Calibration_TypeDef cal;
+	uint8_t nbfm;       //NBFM_Channel_enum - after cal, so records written before it was added read zero (12.5 kHz)
+	uint8_t plan;       //frequency plan index - zero is 4.5 MHz IF
+}Settings_TypeDef;
+
+//append-only record - records are written one after another and the other sector is erased only when this one is full
+typedef struct
+{
+	uint32_t magic;     //written as the last word so partially written record is never valid
+	uint32_t seq;
+	Settings_TypeDef s;
+	uint8_t reserved[SET_RECORD_SIZE - 12 - sizeof(Settings_TypeDef)];
+	uint32_t checksum;
+}Settings_Record_TypeDef;
+
+extern Settings_TypeDef Settings;
+extern Calibration_TypeDef Calibration;
+
+void settings_init(void);
+void settings_defaults(Settings_TypeDef* s);
+void settings_capture(Settings_TypeDef* s);
+bool settings_save(void);
+void settings_task(void);
+void settings_print(void);
+uint8_t settings_wfm_encode(void);
+void settings_wfm_decode(uint8_t wfm);
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * ssb.h - SSB (USB/LSB) demodulator - Weaver method
+ */
+
+#ifndef __ssb__
+#define __ssb__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define SSB_DECIM         8      //FS_BB_Hz -> AUDIO_FS_Hz
+#define SSB_LOW_CUT_Hz    300.0  //lower edge of audio pass band
+#define SSB_BFO_MAX_Hz    3000   //maximum BFO offset from NCO frequency
+
+//filter index is stored in settings, so zero has to be the default
+typedef enum
+{
+	SSB_FILTER_2k7 = 0,
+	SSB_FILTER_2k4,
+	SSB_FILTER_3k0,
+	SSB_FILTERS
+}SSB_Filter_enum;
+
+typedef struct
+{
+	SSB_Filter_enum filter; //audio bandwidth
+	int16_t bfo_Hz;         //suppressed carrier offset from NCO frequency
+}SSB_Config_TypeDef;
+
+extern SSB_Config_TypeDef SSB_Config;
+extern const char *ssb_filter_name[SSB_FILTERS];
+
+void ssb_init(void);
+void ssb_set_filter(SSB_Filter_enum filter);
+void ssb_set_bfo(int16_t bfo_Hz);
+uint16_t ssb_process(const float* I, const float* Q, uint16_t n, bool lsb, float* out);
+void ssb_print(void);
+
+#endif
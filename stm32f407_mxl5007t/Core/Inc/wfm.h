@@ -0,0 +1,33 @@
+/*
+ * wfm.h - broadcast FM demodulator with stereo decoder
+ */
+
+#ifndef __wfm__
+#define __wfm__
+
+#include <stdbool.h>
+#include "main.h"
+
+#define WFM_PILOT_Hz      19000.0
+#define WFM_PLL_BW_Hz     20.0   //pilot PLL natural frequency
+#define WFM_PLL_ZETA      0.707
+#define WFM_PLL_RANGE_Hz  100.0  //maximum pilot frequency offset
+#define WFM_PILOT_NOM     0.1    //in-phase pilot level [rad] for 9% injection of 75 kHz deviation - phase detector gain
+#define WFM_PILOT_LOCK    0.025  //minimum in-phase pilot level [rad] for stereo
+#define WFM_DEFAULT_DEEMPH 50    //us - Europe ; 75 us - Americas
+
+typedef struct
+{
+	uint8_t deemph_us; //0 (off), 50 or 75
+	bool stereo;       //stereo decoding allowed
+}WFM_Config_TypeDef;
+
+extern WFM_Config_TypeDef WFM_Config;
+
+void wfm_init(void);
+void wfm_set_deemph(uint8_t deemph_us);
+uint16_t wfm_process(const float* I, const float* Q, uint16_t n, float* L, float* R);
+bool wfm_stereo(void);
+void wfm_print(void);
+
+#endif
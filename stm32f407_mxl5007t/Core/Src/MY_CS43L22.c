@@ -241,3 +241,22 @@ void CS43_Unmute(void)
 	iData[1] &= 0xCF; //PASSBMUTE=0 and PASSAMUTE=0
 	write_register(MISCELLANEOUS_CONTRLS,&iData[1]);
 }
+
+//switching between analog passthrough (DAC output) and I2S without full initialization
+void CS43_SetMode(CS43_MODE outputMode)
+{
+	read_register(MISCELLANEOUS_CONTRLS, &iData[1]);
+	if(outputMode == MODE_ANALOG_)
+	{
+		iData[1] |=  (1 << 7);   // Enable passthrough for AIN-A
+		iData[1] |=  (1 << 6);   // Enable passthrough for AIN-B
+		iData[1] &= ~(1 << 5);   // Unmute passthrough on AIN-A
+		iData[1] &= ~(1 << 4);   // Unmute passthrough on AIN-B
+		iData[1] &= ~(1 << 3);   // Changed settings take affect immediately
+	}
+	else if(outputMode == MODE_I2S)
+	{
+		iData[1] = 0x02;
+	}
+	write_register(MISCELLANEOUS_CONTRLS,&iData[1]);
+}
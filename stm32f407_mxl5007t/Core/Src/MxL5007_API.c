@@ -19,6 +19,7 @@
 #include "MxL_User_Define.h"
 #include "MxL5007.h"
 #include "printf.h"
+#include "settings.h"
 
 
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++//
@@ -149,6 +150,28 @@ MxL_ERR_MSG MxL_Tuner_RFTune(MxL5007_TunerConfigS* myTuner, uint32_t RF_Freq_Hz,
 	return MxL_OK;
 }
 
+//Channel change calculation only - payload can be stored and written later by MxL_Tuner_RFTune_Cached
+void MxL_Tuner_RFTune_Calc(uint8_t* pArray, uint32_t* Array_Size, uint32_t RF_Freq_Hz, MxL5007_BW_MHz BWMHz)
+{
+	MxL5007_RFTune(pArray, Array_Size, RF_Freq_Hz, BWMHz);
+}
+
+MxL_ERR_MSG MxL_Tuner_RFTune_Cached(MxL5007_TunerConfigS* myTuner, uint32_t RF_Freq_Hz, MxL5007_BW_MHz BWMHz, uint8_t* pArray, uint32_t Array_Size)
+{
+	//Store information into struc
+	myTuner->RF_Freq_Hz = RF_Freq_Hz;
+	myTuner->BW_MHz = BWMHz;
+
+	//perform I2C write of precomputed payload
+	if(MxL_I2C_Write((uint8_t)myTuner->I2C_Addr, pArray, Array_Size))
+		return MxL_ERR_RFTUNE;
+
+	//wait for 3ms
+	MxL_Delay(3);
+
+	return MxL_OK;
+}
+
 MxL5007_ChipVersion MxL_Check_ChipVersion(MxL5007_TunerConfigS* myTuner)
 {	
 	uint8_t Data;
@@ -251,7 +274,7 @@ MxL_ERR_MSG MxL_REFSynth_Lock_Status(MxL5007_TunerConfigS* myTuner, bool* isLock
 
 void MxL_SetGain(float gain)
 {
-	float V_if_agc = A_MxL_V_if_agc*gain + B_MxL_V_if_agc;
+	float V_if_agc = Calibration.A_V_if_agc*gain + Calibration.B_V_if_agc;
 	MxL_Set_IF_AGC_Volatge(V_if_agc);
 }
 
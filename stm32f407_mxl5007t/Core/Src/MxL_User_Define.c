@@ -12,6 +12,7 @@
 #include "main.h"
 #include "printf.h"
 #include "MxL_User_Define.h"
+#include "settings.h"
 
 #define I2C_time_out 50
 extern I2C_HandleTypeDef hi2c3; //handle to I2C3
@@ -136,7 +137,7 @@ void MxL_Delay(uint32_t mSec)
 ******************************************************************************/
 void MxL_Set_IF_AGC_Volatge(float V_if_agc)
 {
-	int32_t TIM4_CCR_val = V_if_agc * 8192.0/3.0 * K_corr_coeff; //calculating value for TIM4_CCR register
+	int32_t TIM4_CCR_val = V_if_agc * 8192.0/3.0 * Calibration.K_corr; //calculating value for TIM4_CCR register
 	if (TIM4_CCR_val < 0) TIM4_CCR_val = 0;
 	if (TIM4_CCR_val > 8191) TIM4_CCR_val = 8191;
 	TIM4->CCR2 =  TIM4_CCR_val; //duty cycle update
@@ -0,0 +1,169 @@
+/*
+ * agc.c - block based audio AGC with look-ahead as long as attack time and soft limiter for all demodulators
+ *
+ * Audio is delayed by look-ahead of ceil(attack/AGC_BLOCK_ms) blocks (1 ms default attack - 7 blocks, 1.06 ms), so
+ * peak of every block is known before the block is sent out. Peak of the newest block gives target gain (level/peak,
+ * up to the largest gain of the demodulator) once per block: lower gain is reached with attack time constant, higher
+ * gain by constant step (decay is time of 20 dB gain increase). Every block in the delay line bounds the gain too -
+ * gain goes linearly to knee/peak of the block in the blocks left before it is sent out, so peaks stay below the
+ * limiter knee and the gain is reduced over the attack time, not in the block of the peak. Gain is ramped linearly
+ * over the block, so there are no steps. Soft limiter above AGC_KNEE of full scale is left for AGC off, so DAC and I2S
+ * don't clip. Per sample cost is peak, gain ramp and limiter compare - divisions are only for samples above the knee.
+ */
+#include <string.h>
+#include <math.h>
+#include "agc.h"
+#include "dsp_math.h"
+#include "printf.h"
+
+AGC_Config_TypeDef AGC_Config =
+{
+	.on = true,
+	.level_dB = AGC_LEVEL_DEFAULT,
+	.attack_ms = AGC_ATTACK_DEFAULT,
+	.decay_ms = AGC_DECAY_DEFAULT
+};
+
+//the largest gain [dB] - FM audio level is given by deviation, so it's only reduced, AM envelope audio follows carrier
+//level, SSB, CW and SAM audio is raw detector output (noise isn't amplified above -80 dB like their old peak floors)
+static const float agc_max_gain_dB[DEMOD_NBFM + 1] =
+{
+	[DEMOD_FM] = 0,
+	[DEMOD_AM] = 60,
+	[OUT_IQ] = 0,
+	[DEMOD_CW] = 80,
+	[DEMOD_WFM] = 0,
+	[DEMOD_USB] = 80,
+	[DEMOD_LSB] = 80,
+	[DEMOD_SAM] = 80,
+	[DEMOD_NBFM] = 6
+};
+
+static float Level = 0.5f, Attack_coeff = 0.14f, Decay_step = 1.0f;
+static float Max_gain[DEMOD_NBFM + 1];
+static volatile uint8_t Lookahead = 1; //blocks - set by agc_set(), delay line starts again when it changes
+static float Gain = 1.0f, Peak;
+static float Delay_L[AGC_LOOKAHEAD_MAX][BB_BLOCK], Delay_R[AGC_LOOKAHEAD_MAX][BB_BLOCK];
+static float Delay_peak[AGC_LOOKAHEAD_MAX];
+static float Ramp_recip[AGC_LOOKAHEAD_MAX + 1]; //1/j - blocks left to reach knee/peak of the block j blocks from output
+static uint8_t Delay_len, Delay_pos; //Delay_pos - the oldest block
+static Output_demod_type_enum Last_demod = OUT_IQ;
+static uint16_t Last_n;
+static uint32_t Limited, Samples;
+
+void agc_set(bool on, float level_dB, float attack_ms, float decay_ms)
+{
+	uint8_t k;
+
+	if (level_dB > -1.0f) level_dB = -1.0f;
+	if (level_dB < -40.0f) level_dB = -40.0f;
+	if (attack_ms < 0.1f) attack_ms = 0.1f;
+	if (attack_ms > AGC_LOOKAHEAD_MAX*AGC_BLOCK_ms) attack_ms = AGC_LOOKAHEAD_MAX*AGC_BLOCK_ms; //covered by look-ahead
+	if (decay_ms < 10.0f) decay_ms = 10.0f;
+	if (decay_ms > 10000.0f) decay_ms = 10000.0f;
+
+	AGC_Config.level_dB = level_dB;
+	AGC_Config.attack_ms = attack_ms;
+	AGC_Config.decay_ms = decay_ms;
+	Level = powf(10.0f, level_dB/20.0f);
+	Attack_coeff = 1.0f - expf(-AGC_BLOCK_ms/attack_ms);
+	Decay_step = powf(10.0f, AGC_BLOCK_ms/decay_ms); //20 dB in decay_ms
+	for (k = 0; k <= DEMOD_NBFM; k++) Max_gain[k] = powf(10.0f, agc_max_gain_dB[k]/20.0f);
+	for (k = 1; k <= AGC_LOOKAHEAD_MAX; k++) Ramp_recip[k] = 1.0f/k;
+	Lookahead = (uint8_t) ceilf(attack_ms/AGC_BLOCK_ms - 0.001f);
+	AGC_Config.on = on;
+}
+
+static inline float agc_limit(float x, float knee, float span, float r_span)
+{
+	float a = fabsf(x), t;
+
+	if (a <= knee) return x;
+	Limited++;
+	t = (a - knee)*r_span;
+	return copysignf(knee + span*t*fast_recipf(1.0f + t), x); //asymptotically full scale
+}
+
+//L and R (R can be NULL) are replaced by the block from look-ahead ago with gain and limiter - full_scale is output
+//clipping level
+void agc_process(float* L, float* R, uint16_t n, float full_scale, Output_demod_type_enum demod)
+{
+	float peak = 0, target = 1.0f, g, dg, x, bound, p;
+	float knee = AGC_KNEE*full_scale, span = full_scale - knee, r_span = 1.0f/span;
+	float *dl, *dr;
+	uint8_t j, d = Lookahead, slot;
+	uint16_t k;
+
+	if ( (demod != Last_demod) || (n != Last_n) || (d != Delay_len) ) //other audio - look-ahead and gain start again
+	{
+		Last_demod = demod;
+		Last_n = n;
+		Delay_len = d;
+		Delay_pos = 0;
+		Gain = 1.0f;
+		memset(Delay_L, 0, sizeof(Delay_L));
+		memset(Delay_R, 0, sizeof(Delay_R));
+		memset(Delay_peak, 0, sizeof(Delay_peak));
+	}
+
+	//peak of the newest block
+	for (k = 0; k < n; k++) peak = fmaxf(peak, fabsf(L[k]));
+	if (R != NULL)
+		for (k = 0; k < n; k++) peak = fmaxf(peak, fabsf(R[k]));
+	Peak = peak;
+
+	if (AGC_Config.on)
+	{
+		target = Max_gain[demod];
+		if (peak*target > Level*full_scale) target = Level*full_scale/peak;
+	}
+	if (target < Gain) g = Gain + (target - Gain)*Attack_coeff;
+	else g = fminf(Gain*Decay_step, target);
+
+	//look-ahead - gain is at knee/peak of every block before its ramp starts (the newest block is j = d)
+	if (AGC_Config.on)
+	{
+		slot = Delay_pos;
+		for (j = 0; j <= d; j++)
+		{
+			p = (j < d) ? Delay_peak[slot] : peak;
+			if (p*g > knee)
+			{
+				bound = (j == 0) ? knee/p : Gain + (knee/p - Gain)*Ramp_recip[j];
+				if (bound < g) g = bound;
+			}
+			if (++slot >= d) slot = 0;
+		}
+	}
+
+	//the oldest block with gain ramp from the previous gain - the newest one takes its place
+	dl = Delay_L[Delay_pos];
+	dr = Delay_R[Delay_pos];
+	dg = (g - Gain)/n;
+	for (k = 0; k < n; k++)
+	{
+		x = L[k];
+		L[k] = agc_limit(dl[k]*(Gain + dg*(k + 1)), knee, span, r_span);
+		dl[k] = x;
+	}
+	if (R != NULL)
+		for (k = 0; k < n; k++)
+		{
+			x = R[k];
+			R[k] = agc_limit(dr[k]*(Gain + dg*(k + 1)), knee, span, r_span);
+			dr[k] = x;
+		}
+	Delay_peak[Delay_pos] = peak;
+	if (++Delay_pos >= d) Delay_pos = 0;
+	Gain = g;
+	Samples += n;
+}
+
+void agc_print(void)
+{
+	UART_printf("agc: %s ; level %.1f dBFS ; attack %.1f ms ; decay %.0f ms/20 dB ; look-ahead %.2f ms (%d blocks) ; limiter knee %.1f dBFS\r\n",
+			AGC_Config.on ? "on" : "off", AGC_Config.level_dB, AGC_Config.attack_ms, AGC_Config.decay_ms, Lookahead*AGC_BLOCK_ms, Lookahead,
+			20*log10f(AGC_KNEE));
+	UART_printf("gain %.1f dB (max %.0f dB) ; block peak %.2e ; limited %.3f %%\r\n", 20*log10f(Gain),
+			agc_max_gain_dB[Last_demod], Peak, Samples ? 100.0*Limited/Samples : 0.0);
+}
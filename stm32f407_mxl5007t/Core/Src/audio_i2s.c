@@ -0,0 +1,70 @@
+/*
+ * audio_i2s.c - digital stereo audio to CS43L22 over I2S3
+ *
+ * I2S DMA runs in circular mode over the ring without interrupts. DSP writes audio frames half of the ring ahead
+ * of DMA read position - I2S clock is synchronous with ADC sampling, so the distance stays constant.
+ * If it doesn't (DSP was stopped or overrun), the write position is set again and the slip is counted.
+ * CS43L22 plays I2S audio only in WFM mode, other modes use analog passthrough of DAC output.
+ */
+#include <string.h>
+#include "main.h"
+#include "audio_i2s.h"
+#include "MY_CS43L22.h"
+
+extern I2S_HandleTypeDef hi2s3;
+
+static int16_t Audio_I2S_buf[2*AUDIO_I2S_FRAMES]; //L, R
+static uint16_t Audio_wr;
+static volatile bool Audio_synced;
+static bool Audio_I2S_mode;
+uint32_t Audio_I2S_slips;
+
+void audio_i2s_start(void)
+{
+	memset(Audio_I2S_buf, 0, sizeof(Audio_I2S_buf));
+	Audio_synced = false;
+	HAL_I2S_Transmit_DMA(&hi2s3, (uint16_t*) Audio_I2S_buf, 2*AUDIO_I2S_FRAMES);
+	__HAL_DMA_DISABLE_IT(hi2s3.hdmatx, DMA_IT_HT | DMA_IT_TC); //ring is written by DSP - there's nothing to do in DMA interrupts
+}
+
+//called from ADC callback
+void audio_i2s_write(const float* L, const float* R, uint16_t n, float scale)
+{
+	uint16_t i, rd, dist;
+	int32_t l, r;
+
+	rd = (2*AUDIO_I2S_FRAMES - __HAL_DMA_GET_COUNTER(hi2s3.hdmatx)) / 2;
+	dist = (Audio_wr - rd) & (AUDIO_I2S_FRAMES - 1);
+	if ( !Audio_synced || (dist < AUDIO_I2S_FRAMES/4) || (dist > 3*AUDIO_I2S_FRAMES/4) )
+	{
+		if (Audio_synced) Audio_I2S_slips++;
+		Audio_wr = (rd + AUDIO_I2S_FRAMES/2) & (AUDIO_I2S_FRAMES - 1);
+		Audio_synced = true;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		l = L[i]*scale;
+		r = R[i]*scale;
+		if (l > 32767) l = 32767;
+		if (l < -32768) l = -32768;
+		if (r > 32767) r = 32767;
+		if (r < -32768) r = -32768;
+		Audio_I2S_buf[2*Audio_wr] = l;
+		Audio_I2S_buf[2*Audio_wr + 1] = r;
+		Audio_wr = (Audio_wr + 1) & (AUDIO_I2S_FRAMES - 1);
+	}
+}
+
+//CS43L22 source - I2S for WFM, SSB, CW and SAM, analog passthrough of DAC output for everything else
+void audio_route(Output_demod_type_enum demod)
+{
+	bool i2s = audio_i2s_demod(demod);
+
+	if (i2s == Audio_I2S_mode) return;
+	Audio_I2S_mode = i2s;
+
+	memset(Audio_I2S_buf, 0, sizeof(Audio_I2S_buf));
+	Audio_synced = false;
+	CS43_SetMode(i2s ? MODE_I2S : MODE_ANALOG_);
+}
@@ -0,0 +1,177 @@
+/*
+ * ax25.c - HDLC deframer and AX.25 frame output (text or KISS)
+ *
+ * Bits come as sampled levels (NRZI - no change is 1), flags 0x7E delimit frames, zero after five ones is removed
+ * and seven ones abort the frame. Frame with valid CRC-16/X.25 FCS is printed as "SRC>DST,DIGI*:info" or sent
+ * in KISS framing (FEND, port 0 data, escaped frame without FCS, FEND) for packet/APRS software on the console UART.
+ */
+#include <string.h>
+#include "ax25.h"
+#include "usart.h"
+#include "printf.h"
+
+#define AX25_FCS_RESIDUE  0xF0B8 //CRC over frame with its FCS
+#define KISS_FEND         0xC0
+#define KISS_FESC         0xDB
+#define KISS_TFEND        0xDC
+#define KISS_TFESC        0xDD
+
+AX25_Stat_TypeDef AX25_Stat;
+
+static uint8_t Frame[AX25_FRAME_MAX];
+static uint16_t Frame_len;
+static uint16_t Bit_buf;    //byte being received, 0x80 marker bit shifted out after 8 bits
+static uint8_t Bit_stream;  //last received bits, the newest in bit 0
+static uint8_t Prev_level;
+static bool In_frame;
+
+void ax25_reset(void)
+{
+	memset(&AX25_Stat, 0, sizeof(AX25_Stat));
+	Frame_len = 0;
+	Bit_buf = 0x80;
+	Bit_stream = 0;
+	Prev_level = 0;
+	In_frame = false;
+}
+
+static uint16_t ax25_crc(const uint8_t* p, uint16_t n)
+{
+	uint16_t crc = 0xFFFF;
+	uint8_t j;
+
+	while (n--)
+	{
+		crc ^= *p++;
+		for (j = 0; j < 8; j++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+	}
+	return crc;
+}
+
+static void ax25_print_call(const uint8_t* a)
+{
+	char call[10];
+	uint8_t j, k = 0, ssid;
+
+	for (j = 0; j < 6; j++)
+		if ((a[j] >> 1) != ' ') call[k++] = a[j] >> 1;
+	call[k] = 0;
+	ssid = (a[6] >> 1) & 0x0F;
+	if (ssid) UART_printf("%s-%u", call, ssid);
+	else UART_printf("%s", call);
+}
+
+static void ax25_print(uint16_t len)
+{
+	uint16_t j, k, addr = 0;
+	char text[64];
+
+	//addresses end with bit 0 set
+	while ((addr < AX25_ADDR_MAX) && (7*(addr + 1) <= len))
+		if (Frame[7*addr++ + 6] & 1) break;
+	if ( (addr < 2) || !(Frame[7*addr - 1] & 1) )
+	{
+		UART_printf("AX.25: bad address field (%u bytes)\r\n", len);
+		return;
+	}
+
+	UART_printf("AX.25: ");
+	ax25_print_call(&Frame[7]);
+	UART_printf(">");
+	ax25_print_call(&Frame[0]);
+	for (j = 2; j < addr; j++)
+	{
+		UART_printf(",");
+		ax25_print_call(&Frame[7*j]);
+		if (Frame[7*j + 6] & 0x80) UART_printf("*"); //has been repeated
+	}
+
+	j = 7*addr;
+	if ( (j + 2 <= len) && ((Frame[j] & 0xEF) == 0x03) ) //UI frame - control and PID, then info
+	{
+		UART_printf(":");
+		j += 2;
+		while (j < len)
+		{
+			for (k = 0; (k < sizeof(text) - 1) && (j < len); j++)
+				text[k++] = ((Frame[j] >= ' ') && (Frame[j] < 0x7F)) ? Frame[j] : '.';
+			text[k] = 0;
+			UART_printf("%s", text);
+		}
+		UART_printf("\r\n");
+	}
+	else if (j < len) UART_printf(" ctrl 0x%02X\r\n", Frame[j]);
+	else UART_printf("\r\n");
+}
+
+static void ax25_kiss(uint16_t len)
+{
+	uint16_t j;
+
+	usart_putc(0, KISS_FEND);
+	usart_putc(0, 0x00); //port 0, data frame
+	for (j = 0; j < len; j++)
+	{
+		if (Frame[j] == KISS_FEND)
+		{
+			usart_putc(0, KISS_FESC);
+			usart_putc(0, KISS_TFEND);
+		}
+		else if (Frame[j] == KISS_FESC)
+		{
+			usart_putc(0, KISS_FESC);
+			usart_putc(0, KISS_TFESC);
+		}
+		else usart_putc(0, Frame[j]);
+	}
+	usart_putc(0, KISS_FEND);
+}
+
+void ax25_bit(uint8_t level, bool kiss)
+{
+	uint8_t bit = (level == Prev_level);
+
+	Prev_level = level;
+	Bit_stream = (Bit_stream << 1) | bit;
+
+	if (Bit_stream == 0x7E) //flag - end of previous frame, start of next one
+	{
+		if (In_frame && (Frame_len >= AX25_FRAME_MIN))
+		{
+			if (ax25_crc(Frame, Frame_len) == AX25_FCS_RESIDUE)
+			{
+				AX25_Stat.frames++;
+				if (kiss) ax25_kiss(Frame_len - 2);
+				else ax25_print(Frame_len - 2);
+			}
+			else AX25_Stat.fcs_errors++;
+		}
+		In_frame = true;
+		Frame_len = 0;
+		Bit_buf = 0x80;
+		return;
+	}
+	if ((Bit_stream & 0x7F) == 0x7F) //abort (or idle ones)
+	{
+		if (In_frame && Frame_len) AX25_Stat.aborts++;
+		In_frame = false;
+		return;
+	}
+	if (!In_frame) return;
+	if ((Bit_stream & 0x3F) == 0x3E) return; //stuffed zero after five ones
+
+	if (bit) Bit_buf |= 0x100;
+	if (Bit_buf & 1)
+	{
+		if (Frame_len == AX25_FRAME_MAX)
+		{
+			AX25_Stat.aborts++;
+			In_frame = false;
+			return;
+		}
+		Frame[Frame_len++] = Bit_buf >> 1;
+		Bit_buf = 0x80;
+		return;
+	}
+	Bit_buf >>= 1;
+}
@@ -0,0 +1,149 @@
+/*
+ * bringup.c - non-blocking MxL5007T and CS43L22 initialization
+ *
+ * DSP chain is started as soon as the ADC is configured and tuner and codec are brought up by two state machines
+ * that are stepped alternately from the main loop. MxL5007T power up delay is just a time stamp check, so
+ * CS43L22 (on separate I2C1 bus) is initialized during that time. Audio is muted in DSP path until both are ready.
+ */
+#include <stdbool.h>
+#include "main.h"
+#include "bringup.h"
+#include "cmd.h"
+#include "printf.h"
+#include "settings.h"
+#include "MY_CS43L22.h"
+#include "audio_i2s.h"
+#include "MxL5007_Common.h"
+#include "MxL5007_API.h"
+#include "MxL_User_Define.h"
+
+extern I2C_HandleTypeDef hi2c1;
+extern TIM_HandleTypeDef htim4;
+extern Output_demod_type_enum Demod_Type;
+extern MxL5007_TunerConfigS myTuner;
+extern uint8_t Volume_curr;
+extern volatile bool DSP_Mute;
+
+typedef enum
+{
+	TUNER_POWERUP = 0,
+	TUNER_DETECT,
+	TUNER_INIT,
+	TUNER_TUNE,
+	TUNER_LOCK,
+	TUNER_GAIN,
+	TUNER_READY
+}Tuner_Bringup_enum;
+
+typedef enum
+{
+	CODEC_INIT = 0,
+	CODEC_VOLUME,
+	CODEC_START,
+	CODEC_READY
+}Codec_Bringup_enum;
+
+static Tuner_Bringup_enum Tuner_State = TUNER_POWERUP;
+static Codec_Bringup_enum Codec_State = CODEC_INIT;
+
+static void bringup_tuner(void)
+{
+	MxL_ERR_MSG MxL_Status;
+	bool RFSynthLock, REFSynthLock;
+
+	switch (Tuner_State)
+	{
+		case TUNER_POWERUP:
+			if (HAL_GetTick() >= MxL_POWERUP_DELAY_ms) Tuner_State = TUNER_DETECT;
+			break;
+
+		case TUNER_DETECT:
+		{
+			MxL5007_ChipVersion MxL_ChipVersion = MxL_Check_ChipVersion(&myTuner);
+			MxL_Print_ChipVersion(MxL_ChipVersion);
+			if (MxL_ChipVersion == MxL_UNKNOWN_ID) MxL_TIMEOUT_UserCallback();
+			Tuner_State = TUNER_INIT;
+			break;
+		}
+
+		case TUNER_INIT:
+			MxL_Status = MxL_Tuner_Init(&myTuner);
+			if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+			Tuner_State = TUNER_TUNE;
+			break;
+
+		case TUNER_TUNE:
+			MxL_Status = MxL_Tuner_RFTune(&myTuner, Settings.freq_Hz, MxL_BW_6MHz); //tuned where it was left off
+			if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+			Tuner_State = TUNER_LOCK;
+			break;
+
+		case TUNER_LOCK:
+			//Check Lock Status
+			MxL_Status = MxL_RFSynth_Lock_Status(&myTuner, &RFSynthLock);
+			if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+
+			MxL_Status = MxL_REFSynth_Lock_Status(&myTuner, &REFSynthLock);
+			if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+
+			UART_printf("rfLock=%d   refLock=%d\r\n", RFSynthLock, REFSynthLock);
+			UART_printf("MxL5007T initialized.\r\n");
+			Tuner_State = TUNER_GAIN;
+			break;
+
+		case TUNER_GAIN:
+			HAL_TIM_PWM_Start(&htim4, TIM_CHANNEL_2); //starting PWM for IF_AGC pin voltage settings
+			set_total_gain(Settings.gain);
+			Tuner_State = TUNER_READY;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void bringup_codec(void)
+{
+	switch (Codec_State)
+	{
+		case CODEC_INIT:
+			CS43_Init(hi2c1, MODE_ANALOG_);
+			Codec_State = CODEC_VOLUME;
+			break;
+
+		case CODEC_VOLUME:
+			Volume_curr = Settings.volume;
+			CS43_SetVolume(Volume_curr); //maximum value without distortion for 3.00 Vpp from DAC is CS43_default_vol=48 for DISCOVERY BOARD
+			CS43_Enable_RightLeft(CS43_RIGHT_LEFT);
+			Codec_State = CODEC_START;
+			break;
+
+		case CODEC_START:
+			CS43_Start();
+			audio_route(Demod_Type); //WFM needs I2S input of CS43L22
+			UART_printf("CS43L22 initialized.\r\n");
+			Codec_State = CODEC_READY;
+			break;
+
+		default:
+			break;
+	}
+}
+
+//returns true when tuner and codec are ready
+bool bringup_task(void)
+{
+	if ( (Tuner_State == TUNER_READY) && (Codec_State == CODEC_READY) ) return true;
+
+	bringup_tuner();
+	bringup_codec();
+
+	if ( (Tuner_State == TUNER_READY) && (Codec_State == CODEC_READY) )
+	{
+		DSP_Mute = false;
+		UART_printf("time to first audio: %ld ms\r\n", HAL_GetTick());
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,299 @@
+/*
+ * chan.c - channelizer: several 12.5 kHz NBFM channels within IQ filter band demodulated at once
+ *
+ * The same I/Q block at FS_BB_Hz (IQ filter 105 kHz, so the channels are inside it) is decimated once to 106.1 kHz by
+ * a half band filter which passes +/-CHAN_OFFSET_MAX_Hz channels. Then it goes to CHAN_MAX chains of NCO (rotating
+ * phasor, channel shifted to 0 Hz), two half band filters down to AUDIO_FS_Hz and the channel filter at AUDIO_FS_Hz.
+ * A bank of NCO + decimator chains was chosen over polyphase filter bank - channels are at any offset, not on a fixed
+ * grid, and for 2 - 4 channels FFT of polyphase bank wouldn't save anything. Every channel has polar discriminator,
+ * power and squelch - SNR over noise floor estimate (nfloor.c) in noise bandwidth of the channel filter, so the
+ * threshold doesn't depend on tuner gain. Only the routed channel has de-emphasis and voice filter.
+ *
+ * Cost per ADC block (I and Q) - shared half band 192 multiplications and 384 per channel (NCO at 106.1 kHz 128, half
+ * bands 64 and 48, channel filter 144), so 4 channels need 1728. Cycles of the whole channelizer are measured in every
+ * block - chan prints them as a part of ADC block period together with ADC overruns since it was switched on.
+ * Polar discriminator of the routed channel goes to data demodulators instead of nbfm.c one.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include "chan.h"
+#include "nfloor.h"
+#include "cmd.h"
+#include "dsp_math.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "perf.h"
+#include "printf.h"
+
+#define CHAN_DEV_Hz  2500.0 //12.5 kHz channel deviation
+
+extern IQ_Filter_enum IQ_Filter;
+
+Chan_Config_TypeDef Chan_Config =
+{
+	.on = false,
+	.channels = CHAN_DEFAULT,
+	.offset_Hz = {0, 12500.0, -12500.0, 25000.0},
+	.squelch_dB = CHAN_SQ_DEFAULT_dB,
+	.route = 0
+};
+
+typedef struct
+{
+	float rot_c, rot_s;   //phasor exp(j*phase) - channel is multiplied by its conjugate
+	float step_c, step_s; //exp(j*2*pi*offset/(FS_BB_Hz/2))
+	float hb2_i_delay[2*CHAN_HB_SHORT_TAPS], hb2_q_delay[2*CHAN_HB_SHORT_TAPS];
+	float hb3_i_delay[2*CHAN_HB_TAPS], hb3_q_delay[2*CHAN_HB_TAPS];
+	float fir_i_delay[2*CHAN_FIR_TAPS], fir_q_delay[2*CHAN_FIR_TAPS];
+	FIR_Decim_TypeDef hb2_i, hb2_q, hb3_i, hb3_q, fir_i, fir_q;
+	float prev_i, prev_q;
+	float power;
+	bool open;
+}Chan_TypeDef;
+
+static Chan_TypeDef Chan[CHAN_MAX];
+static float Hb_i_delay[2*CHAN_HB_TAPS], Hb_q_delay[2*CHAN_HB_TAPS];
+static FIR_Decim_TypeDef Hb_i, Hb_q; //shared by all channels
+static float Hb_I[BB_BLOCK/2], Hb_Q[BB_BLOCK/2];
+static float Rot_I[BB_BLOCK/2], Rot_Q[BB_BLOCK/2];
+static float Dec1_I[BB_BLOCK/4], Dec1_Q[BB_BLOCK/4];
+static float Dec2_I[AUDIO_BLOCK], Dec2_Q[AUDIO_BLOCK];
+static float Chan_I[AUDIO_BLOCK], Chan_Q[AUDIO_BLOCK];
+static uint8_t Route_now;
+static uint32_t Overruns_on; //ADC overruns when channelizer was switched on
+
+float Chan_Discr[AUDIO_BLOCK]; //routed channel discriminator for data demodulators
+
+//routed channel audio
+static float Deemph, Deemph_coeff, Audio_scale, Gate;
+static float Z_audio[NBFM_AUDIO_SECTIONS][2];
+
+//squelch - noise power in channel is updated from the main loop
+static float Enbw_Hz, Gain2; //noise bandwidth and squared DC gain of the channel filters
+static volatile float Noise_pow, Open_pow = 1.0e30f, Close_pow = 1.0e30f;
+static uint32_t Nf_count;
+
+static volatile uint32_t Cycles, Cycles_max;
+
+static void chan_reset(Chan_TypeDef* ch, float offset_Hz)
+{
+	ch->hb2_i = (FIR_Decim_TypeDef) {CHAN_HB_SHORT, CHAN_HB_SHORT_TAPS, 2, 0, 0, ch->hb2_i_delay};
+	ch->hb2_q = (FIR_Decim_TypeDef) {CHAN_HB_SHORT, CHAN_HB_SHORT_TAPS, 2, 0, 0, ch->hb2_q_delay};
+	ch->hb3_i = (FIR_Decim_TypeDef) {CHAN_HB, CHAN_HB_TAPS, 2, 0, 0, ch->hb3_i_delay};
+	ch->hb3_q = (FIR_Decim_TypeDef) {CHAN_HB, CHAN_HB_TAPS, 2, 0, 0, ch->hb3_q_delay};
+	ch->fir_i = (FIR_Decim_TypeDef) {CHAN_FIR, CHAN_FIR_TAPS, 1, 0, 0, ch->fir_i_delay};
+	ch->fir_q = (FIR_Decim_TypeDef) {CHAN_FIR, CHAN_FIR_TAPS, 1, 0, 0, ch->fir_q_delay};
+	fir_reset(&ch->hb2_i);
+	fir_reset(&ch->hb2_q);
+	fir_reset(&ch->hb3_i);
+	fir_reset(&ch->hb3_q);
+	fir_reset(&ch->fir_i);
+	fir_reset(&ch->fir_q);
+	ch->rot_c = 1.0;
+	ch->rot_s = 0;
+	ch->step_c = cos(2.0*M_PI*offset_Hz/(FS_BB_Hz/2));
+	ch->step_s = sin(2.0*M_PI*offset_Hz/(FS_BB_Hz/2));
+	ch->prev_i = ch->prev_q = 0;
+	ch->power = 0;
+	ch->open = false;
+}
+
+void chan_init(void)
+{
+	uint8_t k;
+	float s_hb = 0, s_short = 0, s = 0, s_sq = 0;
+	float wt = 2.0*M_PI*1000.0*NBFM_DEEMPH_us*1.0e-6;
+
+	//channel filter sets the noise bandwidth, half bands are much wider (only their DC gain counts - the long one is used twice)
+	for (k = 0; k < CHAN_HB_TAPS; k++) s_hb += CHAN_HB[k];
+	for (k = 0; k < CHAN_HB_SHORT_TAPS; k++) s_short += CHAN_HB_SHORT[k];
+	for (k = 0; k < CHAN_FIR_TAPS; k++)
+	{
+		s += CHAN_FIR[k];
+		s_sq += CHAN_FIR[k]*CHAN_FIR[k];
+	}
+	Gain2 = s_hb*s_hb*s_hb*s_hb*s_short*s_short*s*s;
+	Enbw_Hz = AUDIO_FS_Hz*s_sq/(s*s);
+
+	Deemph = 0;
+	Deemph_coeff = 1.0 - exp(-1.0/(AUDIO_FS_Hz*NBFM_DEEMPH_us*1.0e-6));
+	Audio_scale = NBFM_AUDIO_LEVEL*AUDIO_FS_Hz*sqrtf(1.0f + wt*wt)/(2.0*M_PI*CHAN_DEV_Hz);
+	for (k = 0; k < NBFM_AUDIO_SECTIONS; k++)
+		Z_audio[k][0] = Z_audio[k][1] = 0;
+	Gate = 0;
+
+	if ( (Chan_Config.channels == 0) || (Chan_Config.channels > CHAN_MAX) ) Chan_Config.channels = CHAN_MAX;
+	Hb_i = (FIR_Decim_TypeDef) {CHAN_HB, CHAN_HB_TAPS, 2, 0, 0, Hb_i_delay};
+	Hb_q = (FIR_Decim_TypeDef) {CHAN_HB, CHAN_HB_TAPS, 2, 0, 0, Hb_q_delay};
+	fir_reset(&Hb_i);
+	fir_reset(&Hb_q);
+	for (k = 0; k < CHAN_MAX; k++) chan_reset(&Chan[k], Chan_Config.offset_Hz[k]);
+	Route_now = (Chan_Config.route < Chan_Config.channels) ? Chan_Config.route : 0;
+	Cycles_max = 0;
+	Overruns_on = ADC_overruns;
+}
+
+//channelizer is stopped while its state is reset, so it can be called at any time
+void chan_set_on(bool on)
+{
+	Chan_Config.on = false;
+	chan_init();
+	Chan_Config.on = on;
+}
+
+void chan_set_offsets(const float* offset_Hz, uint8_t channels)
+{
+	uint8_t k;
+	bool on = Chan_Config.on;
+
+	if (channels == 0) return;
+	if (channels > CHAN_MAX) channels = CHAN_MAX;
+	Chan_Config.on = false;
+	for (k = 0; k < channels; k++)
+		Chan_Config.offset_Hz[k] = fmaxf(-CHAN_OFFSET_MAX_Hz, fminf(CHAN_OFFSET_MAX_Hz, offset_Hz[k]));
+	Chan_Config.channels = channels;
+	chan_init();
+	Chan_Config.on = on;
+}
+
+void chan_set_squelch(int8_t squelch_dB)
+{
+	Chan_Config.squelch_dB = squelch_dB;
+	Nf_count = 0; //thresholds again from the latest noise floor
+	chan_task();
+}
+
+void chan_set_route(uint8_t route)
+{
+	if ( (route != CHAN_ROUTE_AUTO) && (route >= Chan_Config.channels) ) return;
+	Chan_Config.route = route;
+	if (route != CHAN_ROUTE_AUTO) Route_now = route;
+}
+
+//returns number of audio samples in out (n/AUDIO_DECIM) of the routed channel
+uint16_t chan_process(const float* I, const float* Q, uint16_t n, float* out)
+{
+	uint32_t t = perf_start(), cycles;
+	float open_pow = Open_pow, close_pow = Close_pow;
+	float s, c, i, q, y, tmp;
+	uint16_t k, l1, l2, m = 0, n_hb;
+	uint8_t j, route = Chan_Config.route;
+
+	//automatic route stays on the channel until it closes
+	if (route == CHAN_ROUTE_AUTO)
+	{
+		if (!Chan[Route_now].open)
+			for (j = 0; j < Chan_Config.channels; j++)
+				if (Chan[j].open)
+				{
+					Route_now = j;
+					break;
+				}
+	}
+	else Route_now = route;
+
+	n_hb = fir_decim_hb(&Hb_i, I, Hb_I, n);
+	fir_decim_hb(&Hb_q, Q, Hb_Q, n);
+	for (j = 0; j < Chan_Config.channels; j++)
+	{
+		Chan_TypeDef* ch = &Chan[j];
+
+		//channel to 0 Hz - multiplication by exp(-j*phase), the phasor is rotated by the step in every sample
+		c = ch->rot_c;
+		s = ch->rot_s;
+		for (k = 0; k < n_hb; k++)
+		{
+			Rot_I[k] = Hb_I[k]*c + Hb_Q[k]*s;
+			Rot_Q[k] = Hb_Q[k]*c - Hb_I[k]*s;
+			tmp = c*ch->step_c - s*ch->step_s;
+			s = s*ch->step_c + c*ch->step_s;
+			c = tmp;
+		}
+		tmp = 1.5f - 0.5f*(c*c + s*s); //magnitude back to 1 (one Newton-Raphson step of 1/sqrt) - rounding errors grow otherwise
+		ch->rot_c = c*tmp;
+		ch->rot_s = s*tmp;
+
+		l1 = fir_decim_hb(&ch->hb2_i, Rot_I, Dec1_I, n_hb);
+		fir_decim_hb(&ch->hb2_q, Rot_Q, Dec1_Q, n_hb);
+		l2 = fir_decim_hb(&ch->hb3_i, Dec1_I, Dec2_I, l1);
+		fir_decim_hb(&ch->hb3_q, Dec1_Q, Dec2_Q, l1);
+		m = fir_decim_sym(&ch->fir_i, Dec2_I, Chan_I, l2);
+		fir_decim_sym(&ch->fir_q, Dec2_Q, Chan_Q, l2);
+
+		for (k = 0; k < m; k++)
+		{
+			i = Chan_I[k];
+			q = Chan_Q[k];
+			ch->power += (i*i + q*q - ch->power)*CHAN_POWER_AVG;
+			if (j == Route_now) Chan_Discr[k] = fast_atan2f(q*ch->prev_i - i*ch->prev_q, i*ch->prev_i + q*ch->prev_q);
+			ch->prev_i = i;
+			ch->prev_q = q;
+		}
+
+		//power squelch with hysteresis
+		if (ch->open) ch->open = ch->power > close_pow;
+		else ch->open = ch->power > open_pow;
+	}
+
+	//routed channel - de-emphasis, voice band pass and squelch gate
+	for (k = 0; k < m; k++)
+	{
+		Deemph += (Chan_Discr[k] - Deemph)*Deemph_coeff;
+		y = Deemph;
+		for (j = 0; j < NBFM_AUDIO_SECTIONS; j++)
+		{
+			const float* bq = &NBFM_AUDIO_IIR[5*j];
+			float w = y - (Z_audio[j][0]*bq[3] + Z_audio[j][1]*bq[4]);
+
+			y = w*bq[0] + Z_audio[j][0]*bq[1] + Z_audio[j][1]*bq[2];
+			Z_audio[j][1] = Z_audio[j][0];
+			Z_audio[j][0] = w;
+		}
+		Gate += ((Chan[Route_now].open ? 1.0f : 0.0f) - Gate)*NBFM_GATE_RAMP;
+		out[k] = y*Audio_scale*Gate;
+	}
+
+	cycles = perf_start() - t;
+	Cycles = cycles;
+	if (cycles > Cycles_max) Cycles_max = cycles;
+	return m;
+}
+
+//main loop - squelch thresholds from the latest noise floor estimate
+void chan_task(void)
+{
+	float noise, sq;
+
+	if ( (NF_Result.count == 0) || (NF_Result.count == Nf_count) ) return;
+	Nf_count = NF_Result.count;
+
+	noise = powf(10.0f, NF_Result.density_dB/10.0f)*Enbw_Hz*Gain2;
+	sq = Chan_Config.squelch_dB;
+	Noise_pow = noise;
+	Open_pow = noise*(1.0f + powf(10.0f, sq/10.0f));
+	Close_pow = noise*(1.0f + powf(10.0f, (sq - CHAN_SQ_HYST_dB)/10.0f));
+}
+
+void chan_print(void)
+{
+	float block_cycles = SystemCoreClock*(ADC_BLOCK/FS_ADC_Hz);
+	float noise = Noise_pow;
+	uint8_t k;
+
+	UART_printf("chan: %s ; squelch %d dB SNR ; route ", Chan_Config.on ? "on" : "off", Chan_Config.squelch_dB);
+	if (Chan_Config.route == CHAN_ROUTE_AUTO) UART_printf("auto (%d)", Route_now);
+	else UART_printf("%d", Chan_Config.route);
+	UART_printf(" ; noise bandwidth %.1f kHz ; CPU %lu cycles/block (max %lu) = %.1f %% (max %.1f %%) ; ADC overruns %lu\r\n",
+			Enbw_Hz/1.0e3, Cycles, Cycles_max, 100.0*Cycles/block_cycles, 100.0*Cycles_max/block_cycles, ADC_overruns - Overruns_on);
+
+	for (k = 0; k < Chan_Config.channels; k++)
+	{
+		float p = Chan[k].power/Gain2 + 1.0e-30f;
+
+		UART_printf("%d: %+8.2f kHz ; power %.1f dB ; SNR ", k, Chan_Config.offset_Hz[k]/1.0e3, 10*log10f(p));
+		if (noise > 0) UART_printf("%.1f dB", fmaxf(10*log10f(fmaxf(Chan[k].power - noise, 1.0e-30f)/noise), NF_SNR_MIN_dB));
+		else UART_printf("-");
+		UART_printf(" ; %s%s%s\r\n", Chan[k].open ? "open" : "closed", (k == Route_now) ? " ; audio" : "",
+				(fabsf(Chan_Config.offset_Hz[k]) + CHAN_HALF_BW_Hz > IQ_Filter_bw_Hz[IQ_Filter]) ? " ; outside IQ filter" : "");
+	}
+}
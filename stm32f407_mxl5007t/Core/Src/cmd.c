@@ -17,6 +17,28 @@
 #include "MxL_User_Define.h"
 #include "MY_CS43L22.h"
 #include "led.h"
+#include "scanner.h"
+#include "mem_bank.h"
+#include "settings.h"
+#include "perf.h"
+#include "audio_i2s.h"
+#include "wfm.h"
+#include "rds.h"
+#include "ssb.h"
+#include "cw.h"
+#include "sam.h"
+#include "nbfm.h"
+#include "data_demod.h"
+#include "nb.h"
+#include "iq_corr.h"
+#include "lms.h"
+#include "agc.h"
+#include "nfloor.h"
+#include "enob.h"
+#include "chan.h"
+#include "freq_plan.h"
+#include "dsp_mag.h"
+#include "dsp_tables.h"
 
 #define MxL5007_regs_num 218 //it looks like that MxL5007 has 218 registers
 #define MAX_ARGS 5
@@ -46,18 +68,55 @@ const char *cmd_commands[] =
 	"write",
 	"rssi",
 	"test",
+	"scan_cfg",
+	"mem",
+	"settings",
+	"cal",
+	"perf",
+	"fm_discr",
+	"wfm",
+	"rds",
+	"cw",
+	"mag",
+	"nbfm",
+	"data",
+	"nb",
+	"plan",
+	"bw",
+	"iq",
+	"lms",
+	"agc",
+	"snr",
+	"enob",
+	"chan",
 	NULL
 };
 
-const char *demod_type_param[] = {"AM", "FM", "IQ", "CW", NULL};
+const char *demod_type_param[] = {"AM", "FM", "IQ", "CW", "WFM", "USB", "LSB", "SAM", "NBFM", NULL};
+
+const char *fm_discr_param[] = {"noga", "atan2", NULL}; //the same order like FM_Discr_enum
+
+const char *mem_param[] = {"list", "store", "recall", "clear", "scan", NULL};
+
+const char *cal_param[] = {"if_gain", "atten", "a_agc", "b_agc", "k_corr", NULL};
 
 static uint8_t reg_prev[MxL5007_regs_num];
 
 extern Output_demod_type_enum Demod_Type;
-extern uint16_t CW_trig_upper_level;
-extern uint8_t CW_trig_lower_level;
-extern float b[];
-extern float a[];
+extern volatile FM_Discr_enum FM_Discr;
+extern const float* volatile IQ_IIR_next;
+
+IQ_Filter_enum IQ_Filter = IQ_FILTER_105kHz; //currently selected IQ filter
+
+//IQ channel filters bank - cut-off (half of channel bandwidth), the same order like IQ_Filter_enum. 105 kHz has no biquads,
+//it's the half band decimation filters only (-0.5 dB at 75 kHz, -3 dB at 95 kHz)
+const char *iq_filter_name[IQ_FILTERS] = {"105", "15", "3", "6", "10", "30", "60"}; //kHz
+const float IQ_Filter_bw_Hz[IQ_FILTERS] = {105000.0, 15000.0, 3000.0, 6000.0, 10000.0, 30000.0, 60000.0};
+static const float* const IQ_IIR[IQ_FILTERS] = {NULL, IQ_IIR_15k, IQ_IIR_3k, IQ_IIR_6k, IQ_IIR_10k, IQ_IIR_30k, IQ_IIR_60k};
+static const IQ_Filter_enum iq_filter_order[IQ_FILTERS] = {IQ_FILTER_3kHz, IQ_FILTER_6kHz, IQ_FILTER_10kHz, IQ_FILTER_15kHz,
+		IQ_FILTER_30kHz, IQ_FILTER_60kHz, IQ_FILTER_105kHz}; //by bandwidth for printing
+float Total_Gain_curr = SET_DEFAULT_GAIN; //currently set total gain [dB]
+uint8_t Volume_curr = CS43_default_vol; //currently set CS43L22 volume
 
 /* reset buffer & display the prompt */
 void cmd_prompt(void)
@@ -69,58 +128,55 @@ void cmd_prompt(void)
 	UART_printf("\r\nCommand>");
 }
 
-static char wait_for_char_SCAN(double* step)
+//only the coefficients pointer is written - ADC callback switches to the new filter at block boundary
+void set_IQ_filter(IQ_Filter_enum filter)
 {
-	char rxchar_loc;
-	UART_printf(" -> u/d - up/down ; s - stop\r\n\r\n");
-	while ( ((rxchar_loc = usart_getc()) == EOF) || ((rxchar_loc != 'u') && (rxchar_loc != 'd') && (rxchar_loc != 's')) );
-	if (rxchar_loc == 'u') *step = fabs(*step);
-	if (rxchar_loc == 'd') *step *= -1;
-	usart_flush_RX_buffer();
-	return rxchar_loc;
+	if (filter >= IQ_FILTERS) filter = IQ_FILTER_15kHz;
+	IQ_Filter = filter;
+	IQ_IIR_next = IQ_IIR[filter];
 }
 
-void set_IQ_filters_coeff(float* b, float* a, Output_demod_type_enum Demod_Type)
+void set_IQ_filters_coeff(Output_demod_type_enum Demod_Type)
 {
-	if (Demod_Type == DEMOD_FM)
-	{
-		//set coefficients for FM and fc=105 kHz
-		b[0] = b0__105kHz;
-		b[1] = b1__105kHz;
-		b[2] = b2__105kHz;
-		b[3] = b3__105kHz;
-		b[4] = b4__105kHz;
-		b[5] = b5__105kHz;
-		a[0] = a0__105kHz;
-		a[1] = a1__105kHz;
-		a[2] = a2__105kHz;
-		a[3] = a3__105kHz;
-		a[4] = a4__105kHz;
-	}
+	if ( ((Demod_Type == DEMOD_FM) || (Demod_Type == DEMOD_WFM) || ((Demod_Type == DEMOD_NBFM) && Chan_Config.on)) && FP_Plan.wide )
+		set_IQ_filter(IQ_FILTER_105kHz); //FM, WFM or NBFM channelizer - if frequency plan has room for it
 	else
-	{
-		//set coefficients for AM, IQ or CW and fc=15 kHz
-		b[0] = b0__15kHz;
-		b[1] = b1__15kHz;
-		b[2] = b2__15kHz;
-		b[3] = b3__15kHz;
-		b[4] = b4__15kHz;
-		b[5] = b5__15kHz;
-		a[0] = a0__15kHz;
-		a[1] = a1__15kHz;
-		a[2] = a2__15kHz;
-		a[3] = a3__15kHz;
-		a[4] = a4__15kHz;
-	}
+		set_IQ_filter(IQ_FILTER_15kHz); //AM, SAM, IQ, CW, USB or LSB
+}
+
+static void bw_print(void)
+{
+	uint8_t k;
+
+	UART_printf("IQ filter: %s kHz ; bank [kHz]:", iq_filter_name[IQ_Filter]);
+	for (k = 0; k < IQ_FILTERS; k++)
+		UART_printf(" %s%s", iq_filter_name[iq_filter_order[k]], fp_fits(IQ_Filter_bw_Hz[iq_filter_order[k]]) ? "" : "(x)");
+	UART_printf(" ; (x) - doesn't fit frequency plan, alias margin %.0f kHz, guard %.0f kHz\r\n", FP_Plan.margin_Hz/1.0e3, FP_GUARD_Hz/1.0e3);
+}
+
+//total gain = MxL5007T gain + IF amplifier gain + attenuation - returns MxL5007T gain
+float set_total_gain(float Total_Gain)
+{
+	float Gain_offset = Calibration.IF_gain + Calibration.attenuation;
+
+	if (Total_Gain < Gain_offset) Total_Gain = Gain_offset;
+	if (Total_Gain > MxL_max_Gain + Gain_offset) Total_Gain = MxL_max_Gain + Gain_offset;
+
+	float MxL_gain = Total_Gain - Gain_offset;
+	MxL_SetGain(MxL_gain);
+	Total_Gain_curr = Total_Gain;
+	return MxL_gain;
 }
 
 static float calculate_mean_module()
 {
 	float module = 0;
 	uint8_t i;
+	nf_reset(); //SNR of this frequency is estimated at the same time
 	for (i = 0; i < 120; i++) //calculating mean module value for scan and tune commands
 	{
-		module += sqrtf(I*I + Q*Q); //it's poor solution but that's not enough computing power for doing it real time in ADC's callbacks
+		module += mag_calc(I, Q, Mag_Mode[MAG_USER_LEVEL]); //it's poor solution but that's not enough computing power for doing it real time in ADC's callbacks
+		nf_task();
 		HAL_Delay(1);
 	}
 	return 20.0*log10f(module/120.0);
@@ -172,19 +228,47 @@ void cmd_proc(void)
 					UART_printf("help - this message\r\n");
 					UART_printf("freq <frequency> - Set freq in MHz\r\n");
 					UART_printf("set_gain <gain> - Set gain VGA [1 - 49.3 dB]\r\n");
-                    UART_printf("init - default SDR state\r\n");
+                    UART_printf("init - default SDR state (saved after a few seconds like any other change)\r\n");
                     UART_printf("volume <vol> - audio volume for CS43L22 [0 - 100]\r\n");
                     UART_printf("mute - muting of CS43L22\r\n");
                     UART_printf("unmute - unmuting of CS43L22\r\n");
-                    UART_printf("demod_type <type> <CW upper lvl> <CW hyst> - Set demodulator type [AM/FM/IQ/CW]\r\n");
+                    UART_printf("demod_type <type> - Set demodulator type [AM/FM/IQ/CW/WFM/USB/LSB/SAM/NBFM]\r\n");
+                    UART_printf("demod_type SAM [DSB/USB/LSB] - synchronous AM with both or one sideband, carrier PLL status\r\n");
+                    UART_printf("demod_type CW [bw] [pitch] - CW with filter bandwidth [200/300/500 Hz] and BFO beat note [%d - %d Hz]\r\n", CW_PITCH_MIN_Hz, CW_PITCH_MAX_Hz);
+                    UART_printf("demod_type <USB/LSB> [bw] [bfo] - SSB with audio bandwidth [2.4/2.7/3.0 kHz] and BFO offset [Hz]\r\n");
+                    UART_printf("demod_type NBFM [12.5/25] - narrowband FM voice with channel spacing [kHz], squelch by nbfm command\r\n");
                     UART_printf("tune <start_freq> <step> - Manual tune from start_freq [MHz] with step [MHz]\r\n");
-                    UART_printf("scan <start_freq> <step> <mod_thres> <Mute> - Scan from start_freq [MHz] with step [MHz], mod_thres [dB] and Mute [0/1]\r\n");
+                    UART_printf("scan <start_freq> <step> <mod_thres> <hyst> - Scan from start_freq [MHz] with step [MHz], squelch mod_thres [dB] (level or SNR - scan_cfg) and hyst [dB]\r\n");
                     UART_printf("dump - dump MxL5007's all registers\r\n");
 					UART_printf("reg_diff - print registers differences between reg_diff's calls\r\n");
 					UART_printf("read - reading particular register\r\n");
 					UART_printf("write - write particular register\r\n");
 					UART_printf("rssi - get RSSI value (experimental - most probably worthless)");
 					UART_printf("test - specific MxL5007 registers monitoring\r\n");
+					UART_printf("scan_cfg <settle> <dwell> <hang> <resume> [level/snr] - scanner timing [ms], resume=0 - stay until carrier drops, squelch thresholds are level or SNR [dB]\r\n");
+					UART_printf("mem list - list memory channels\r\n");
+					UART_printf("mem store <n> <mod_thres> - store current freq/demod/filter/gain in channel n [0 - %d] with squelch mod_thres [dB]\r\n", MEM_CHANNELS-1);
+					UART_printf("mem recall <n> / mem clear <n> - recall/clear memory channel n\r\n");
+					UART_printf("mem scan <hyst> [prio] [N] - scan memory channels with squelch hyst [dB], priority channel checked every N steps\r\n");
+					UART_printf("settings [save] - print saved settings and calibration / save them now\r\n");
+					UART_printf("cal <param> <value> - set calibration [if_gain/atten/a_agc/b_agc/k_corr]\r\n");
+					UART_printf("perf [reset] - DSP stage cycle counts, CPU load and overruns / reset statistics\r\n");
+					UART_printf("fm_discr [noga/atan2] - FM discriminator: division+asin LUT / polar atan2\r\n");
+					UART_printf("wfm [50/75/0] [stereo/mono] - WFM de-emphasis [us] and stereo decoding, pilot and I2S status\r\n");
+					UART_printf("rds [on/off] [print/quiet] - RDS decoder in WFM mode, printing of PI/PS/RT changes, decoder status\r\n");
+					UART_printf("cw [on/off] - Morse decoder in CW mode, speed and signal/noise levels\r\n");
+					UART_printf("nbfm [sq <dB>] [ctcss <Hz>] [dcs <octal code>] [tone off] - NBFM squelch (0 - off), tone squelch, received tone and code\r\n");
+					UART_printf("mag [am/sam/cw/level] [ambm/rsqrt/exact] / mag bench - magnitude accuracy per user / cycles and errors of all modes\r\n");
+					UART_printf("data [off/afsk/pocsag512/pocsag1200/pocsag2400] [text/kiss] - AX.25 or POCSAG decoder on FM/AM/NBFM output, frames as text or KISS\r\n");
+					UART_printf("nb [off/blank/limit] [thr <x>] [hang <samples>] - noise blanker on ADC samples, pulse threshold x average magnitude\r\n");
+					UART_printf("plan [n] - frequency plans (tuner IF, IF alias at fixed FS_ADC, mixer table, alias margin) / select plan n\r\n");
+					UART_printf("bw [kHz] - IQ channel filter bank / select filter cut-off (until demod_type change)\r\n");
+					UART_printf("iq [dc on/off] [corr on/off] [reset] - ADC DC offset removal, I/Q gain/phase imbalance estimate and correction\r\n");
+					UART_printf("lms [notch/nr on/off] [notch/nr taps <n>] / lms bench - LMS auto-notch and noise reduction (SSB, CW, SAM, NBFM) / cycles per tap count\r\n");
+					UART_printf("agc [on/off] [level <dBFS>] [attack <ms>] [decay <ms>] - audio AGC with look-ahead and soft limiter (all modes, decay per 20 dB)\r\n");
+					UART_printf("snr - noise floor (median of FFT bins), channel power and SNR in IQ filter bandwidth\r\n");
+					UART_printf("enob - SINAD, SFDR and effective bits of a tone at ADC, CIC decimators (R=2, 4) and IQ filters output\r\n");
+					UART_printf("chan [on/off] [<offset kHz, +/-25> ...] [route <n>/auto] [sq <dB>] - channelizer: up to 4 NBFM 12.5 kHz channels at once in NBFM mode, SNR squelch, audio route, CPU load\r\n");
                     break;
 	
                 case 1:     /* freq */
@@ -212,15 +296,8 @@ void cmd_proc(void)
 						UART_printf("set_gain - missing arg(s)\r\n");
 					else
 					{
-						float Total_Gain = atof(argv[1]);
-
-						if (Total_Gain < IF_Gain + Attenuation) Total_Gain = IF_Gain + Attenuation;
-						if (Total_Gain > Total_Gain_max) Total_Gain = Total_Gain_max;
-
-						float MxL_gain = Total_Gain - (IF_Gain + Attenuation);
-
-						MxL_SetGain(MxL_gain);
-						UART_printf("set_gain:  MxL->%.2f dB  Total->%.2f dB\r\n", MxL_gain, Total_Gain);
+						float MxL_gain = set_total_gain(atof(argv[1]));
+						UART_printf("set_gain:  MxL->%.2f dB  Total->%.2f dB\r\n", MxL_gain, Total_Gain_curr);
 					}
                     break;
 
@@ -229,7 +306,7 @@ void cmd_proc(void)
                     MxL_ERR_MSG MxL_Status = MxL_Tuner_Init(&myTuner);
 					if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
 
-					MxL_Status = MxL_Tuner_RFTune(&myTuner, 100*MHz, MxL_BW_6MHz);
+					MxL_Status = MxL_Tuner_RFTune(&myTuner, SET_DEFAULT_FREQ_Hz, MxL_BW_6MHz);
 					if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
 
 					//Check Lock Status
@@ -242,11 +319,19 @@ void cmd_proc(void)
 
 					UART_printf("rfLock=%d   refLock=%d\r\n", RFSynthLock, RFSynthLock);
 
-					MxL_SetGain(75.0 - (IF_Gain + Attenuation)); //total gain 75 dB
+					set_total_gain(SET_DEFAULT_GAIN);
 
-                    Demod_Type = DEMOD_FM;
+                    Demod_Type = SET_DEFAULT_DEMOD;
+                    set_IQ_filters_coeff(Demod_Type);
+                    cw_set_filter(SET_DEFAULT_CW_FILTER);
+                    cw_set_pitch(SET_DEFAULT_CW_PITCH);
+                    FM_Discr = SET_DEFAULT_FM_DISCR;
+                    settings_wfm_decode(0);
+                    wfm_set_deemph(WFM_Config.deemph_us);
+                    audio_route(Demod_Type);
 
 					CS43_SetVolume(CS43_default_vol);
+					Volume_curr = CS43_default_vol;
 					CS43_Unmute();
                     break;
 
@@ -258,6 +343,7 @@ void cmd_proc(void)
 						data = (int)strtoul(argv[1], NULL, 0);
 						if (data > 100) data = 100;
 						CS43_SetVolume(data);
+						Volume_curr = data;
 						UART_printf("volume:  %ld\r\n", data);
 					}
 					break;
@@ -291,38 +377,105 @@ void cmd_proc(void)
 							{
 								case 0: //AM
 									Demod_Type = DEMOD_AM;
-									set_IQ_filters_coeff(b, a, Demod_Type);
+									set_IQ_filters_coeff(Demod_Type);
 									UART_printf("demod_type: AM\r\n");
 								break;
 
 								case 1: //FM
 									Demod_Type = DEMOD_FM;
-									set_IQ_filters_coeff(b, a, Demod_Type);
+									set_IQ_filters_coeff(Demod_Type);
 									UART_printf("demod_type: FM\r\n");
 								break;
 
 								case 2: //IQ
 									Demod_Type = OUT_IQ;
-									set_IQ_filters_coeff(b, a, Demod_Type);
+									set_IQ_filters_coeff(Demod_Type);
 									UART_printf("demod_type: IQ\r\n");
 								break;
 
 								case 3: //CW
-									if(argc < 4)
-										UART_printf("demod_type CW - missing arg(s)\r\n");
-									else
+									if (argc > 2)
+									{
+										uint8_t filter = 0;
+										while ( (filter < CW_FILTERS) && (strcmp(argv[2], cw_filter_name[filter]) != 0) ) filter++;
+										if (filter < CW_FILTERS)
+											cw_set_filter(filter);
+										else
+											UART_printf("demod_type - CW bandwidth has to be 200, 300 or 500 Hz\r\n");
+									}
+									if (argc > 3) cw_set_pitch((int)strtoul(argv[3], NULL, 0));
+
+									if (Demod_Type != DEMOD_CW) cw_init();
+									Demod_Type = DEMOD_CW;
+									set_IQ_filters_coeff(Demod_Type);
+									UART_printf("demod_type: CW %s %d\r\n", cw_filter_name[CW_Config.filter], CW_Config.pitch_Hz);
+								break;
+
+								case 4: //WFM
+									if (Demod_Type != DEMOD_WFM) wfm_init();
+									Demod_Type = DEMOD_WFM;
+									set_IQ_filters_coeff(Demod_Type);
+									UART_printf("demod_type: WFM\r\n");
+								break;
+
+								case 5: //USB
+								case 6: //LSB
+									if (argc > 2)
 									{
-										CW_trig_lower_level = (int)strtoul(argv[2], NULL, 0) & 0xFF; //trigger lower level
-										CW_trig_upper_level = CW_trig_lower_level + ((int)strtoul(argv[3], NULL, 0) & 0xFF); //trigger lower level + hyst
-										Demod_Type = DEMOD_CW;
-										set_IQ_filters_coeff(b, a, Demod_Type);
-										UART_printf("demod_type: CW %d %d\r\n", CW_trig_lower_level, CW_trig_upper_level-CW_trig_lower_level);
+										uint8_t filter = 0;
+										while ( (filter < SSB_FILTERS) && (strcmp(argv[2], ssb_filter_name[filter]) != 0) ) filter++;
+										if (filter < SSB_FILTERS)
+											ssb_set_filter(filter);
+										else
+											UART_printf("demod_type - SSB bandwidth has to be 2.4, 2.7 or 3.0 kHz\r\n");
 									}
+									if (argc > 3) ssb_set_bfo((int16_t)strtol(argv[3], NULL, 0));
+
+									if ( (Demod_Type != DEMOD_USB) && (Demod_Type != DEMOD_LSB) ) ssb_init();
+									Demod_Type = (type == 5) ? DEMOD_USB : DEMOD_LSB;
+									set_IQ_filters_coeff(Demod_Type);
+									UART_printf("demod_type: %s %s %d\r\n", demod_type_param[type], ssb_filter_name[SSB_Config.filter], SSB_Config.bfo_Hz);
+								break;
+
+								case 7: //SAM
+									if (argc > 2)
+									{
+										uint8_t sb = 0;
+										while ( (sb < SAM_SIDEBANDS) && (strcmp(argv[2], sam_sideband_name[sb]) != 0) ) sb++;
+										if (sb < SAM_SIDEBANDS)
+											SAM_Config.sideband = sb;
+										else
+											UART_printf("demod_type - SAM sideband has to be DSB, USB or LSB\r\n");
+									}
+
+									if (Demod_Type != DEMOD_SAM) sam_init();
+									Demod_Type = DEMOD_SAM;
+									set_IQ_filters_coeff(Demod_Type);
+									UART_printf("demod_type: SAM\r\n");
+									sam_print();
+								break;
+
+								case 8: //NBFM
+									if (argc > 2)
+									{
+										uint8_t channel = 0;
+										while ( (channel < NBFM_CHANNELS) && (strcmp(argv[2], nbfm_channel_name[channel]) != 0) ) channel++;
+										if (channel < NBFM_CHANNELS)
+											nbfm_set_channel(channel);
+										else
+											UART_printf("demod_type - NBFM channel has to be 12.5 or 25 kHz\r\n");
+									}
+
+									if (Demod_Type != DEMOD_NBFM) nbfm_init();
+									Demod_Type = DEMOD_NBFM;
+									set_IQ_filters_coeff(Demod_Type);
+									UART_printf("demod_type: NBFM %s\r\n", nbfm_channel_name[NBFM_Config.channel]);
 								break;
 
 								default:
 								break;
 							}
+							audio_route(Demod_Type);
 						}
 						else
 							UART_printf("demod_type - unknown type param\r\n");
@@ -358,7 +511,8 @@ void cmd_proc(void)
 								break;
 							}
 
-							UART_printf(" ; Mod: %.2f -> n/p - next/prev step ; s - stop\r\n", calculate_mean_module());
+							UART_printf(" ; Mod: %.2f", calculate_mean_module());
+							UART_printf(" ; SNR: %.1f dB -> n/p - next/prev step ; s - stop\r\n", nf_snr_dB());
 
 							while ( ((rxchar_loc = usart_getc()) == EOF) || ((rxchar_loc != 'n') && (rxchar_loc != 'p') && (rxchar_loc != 's')) );
 							usart_flush_RX_buffer();
@@ -379,65 +533,15 @@ void cmd_proc(void)
 						double frequency = atof(argv[1]);
 						double step = fabs(atof(argv[2]));
 						float module_threshold = atof(argv[3]);
-						uint8_t Mute_Dis_Ena = atof(argv[4]);
-
-						char rxchar_loc;
-						UART_printf("start_freq: %.6f MHz ; step: %.6f MHz ; Mod_thresh: %.2f ; s - stop ; p - pause\r\n\r\n", frequency, step, module_threshold);
-
-						if (Mute_Dis_Ena == 1) CS43_Mute();
-						while(1)
-						{
-							MxL_Status = MxL_Tuner_RFTune(&myTuner, (uint32_t) (frequency*1.0E6), MxL_BW_6MHz);
-							if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-							UART_printf("SCANNING: %.6f MHz", frequency);
-
-							MxL_Status = MxL_RFSynth_Lock_Status(&myTuner, &RFSynthLock);
-							if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-							MxL_Status = MxL_REFSynth_Lock_Status(&myTuner, &REFSynthLock);
-							if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-							MxL_Status = MxL_REFSynth_Lock_Status(&myTuner, &REFSynthLock);
-							if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-							if ( (RFSynthLock == false) || (REFSynthLock == false) )
-							{
-								UART_printf("\r\nrfLock=%d   refLock=%d\r\n", RFSynthLock, REFSynthLock);
-								break;
-							}
-
-							HAL_Delay(200);
-							float module = calculate_mean_module();
-							UART_printf(" ; Mod: %.2f\r\n", module);
-							led_toggle(LED1);
+						float module_hyst = atof(argv[4]);
 
-							if((rxchar_loc = usart_getc())!= EOF)
-							{
-								if (rxchar_loc == 's') break;
-								if (rxchar_loc == 'p')
-								{
-									if (Mute_Dis_Ena == 1) CS43_Unmute();
-									UART_printf("***SCANNING PAUSED***");
-									if (wait_for_char_SCAN(&step) == 's') break;
-								}
-							}
+						UART_printf("start_freq: %.6f MHz ; step: %.6f MHz ; Mod_thresh: %.2f ; hyst: %.2f ; s - stop ; p - pause ; n - next ; u/d - up/down\r\n\r\n",
+								frequency, step, module_threshold, module_hyst);
 
-							if (module > module_threshold)
-							{
-								if (Mute_Dis_Ena == 1) CS43_Unmute();
-								UART_printf("***SCANNING HAS STOPPED***");
-								if (wait_for_char_SCAN(&step) == 's') break;
-							}
-
-							if (Mute_Dis_Ena == 1) CS43_Mute();
-
-							frequency += step;
-							if (frequency < 30.0) frequency = 30.0;
-
-						}
+						scanner_start(frequency, step, module_threshold, module_hyst);
+						while (scanner_task(usart_getc()));
+						usart_flush_RX_buffer();
 					}
-
-					CS43_Unmute();
 					break;
 
 				case 10:    /* dump */
@@ -514,6 +618,453 @@ void cmd_proc(void)
 					}
 					break;
 
+				case 16: /* scan_cfg */
+					if( (argc > 1) && (strcmp(argv[argc-1], "level") == 0 || strcmp(argv[argc-1], "snr") == 0) )
+					{
+						Scan_Config.snr = strcmp(argv[argc-1], "snr") == 0;
+						argc--;
+					}
+					if(argc >= 5)
+					{
+						Scan_Config.settle_ms = strtoul(argv[1], NULL, 0);
+						Scan_Config.dwell_ms = strtoul(argv[2], NULL, 0);
+						Scan_Config.hang_ms = strtoul(argv[3], NULL, 0);
+						Scan_Config.resume_ms = strtoul(argv[4], NULL, 0);
+					}
+					else if(argc > 1)
+						UART_printf("scan_cfg - missing arg(s)\r\n");
+
+					UART_printf("scan_cfg: settle %ld ms ; dwell %ld ms ; hang %ld ms ; resume %ld ms ; squelch %s\r\n",
+							Scan_Config.settle_ms, Scan_Config.dwell_ms, Scan_Config.hang_ms, Scan_Config.resume_ms,
+							Scan_Config.snr ? "SNR" : "level");
+					break;
+
+				case 17: /* mem */
+					if(argc < 2)
+					{
+						mem_list();
+						break;
+					}
+					else
+					{
+						uint8_t param = 0;
+						while(mem_param[param] != NULL)
+						{
+							if(strcmp(argv[1], mem_param[param])==0)
+								break;
+							param++;
+						}
+
+						uint8_t n = (argc > 2) ? strtoul(argv[2], NULL, 0) : 0;
+
+						switch(param)
+						{
+							case 0: //list
+								mem_list();
+							break;
+
+							case 1: //store
+								if(argc < 4)
+									UART_printf("mem store - missing arg(s)\r\n");
+								else if (mem_store(n, atof(argv[3])))
+									UART_printf("mem store: M%02d %.6f MHz\r\n", n, myTuner.RF_Freq_Hz/1.0E6);
+								else
+									UART_printf("mem store - failed\r\n");
+							break;
+
+							case 2: //recall
+								if(argc < 3)
+									UART_printf("mem recall - missing arg(s)\r\n");
+								else if (mem_recall(n))
+									UART_printf("mem recall: M%02d %.6f MHz\r\n", n, myTuner.RF_Freq_Hz/1.0E6);
+								else
+									UART_printf("mem recall - empty channel\r\n");
+							break;
+
+							case 3: //clear
+								if(argc < 3)
+									UART_printf("mem clear - missing arg(s)\r\n");
+								else if (mem_clear(n))
+									UART_printf("mem clear: M%02d\r\n", n);
+								else
+									UART_printf("mem clear - failed\r\n");
+							break;
+
+							case 4: //scan
+								if(argc < 3)
+									UART_printf("mem scan - missing arg(s)\r\n");
+								else
+								{
+									float module_hyst = atof(argv[2]);
+									int16_t prio = (argc > 3) ? (int16_t) strtol(argv[3], NULL, 0) : -1;
+									uint8_t prio_every = (argc > 4) ? strtoul(argv[4], NULL, 0) : 1;
+
+									UART_printf("mem scan: hyst: %.2f ; prio: %d ; every: %d ; s - stop ; p - pause ; n - next\r\n\r\n", module_hyst, prio, prio_every);
+
+									scanner_start_mem(module_hyst, prio, prio_every);
+									while (scanner_task(usart_getc()));
+									usart_flush_RX_buffer();
+								}
+							break;
+
+							default:
+								UART_printf("mem - unknown param\r\n");
+							break;
+						}
+					}
+					break;
+
+				case 18: /* settings */
+					if( (argc > 1) && (strcmp(argv[1], "save") == 0) )
+					{
+						if (settings_save())
+							UART_printf("settings saved\r\n");
+						else
+							UART_printf("settings - flash write failed\r\n");
+					}
+					settings_print();
+					break;
+
+				case 19: /* cal */
+					if(argc < 3)
+						UART_printf("cal - missing arg(s)\r\n");
+					else
+					{
+						uint8_t param = 0;
+						while(cal_param[param] != NULL)
+						{
+							if(strcmp(argv[1], cal_param[param])==0)
+								break;
+							param++;
+						}
+
+						float value = atof(argv[2]);
+						switch(param)
+						{
+							case 0: Calibration.IF_gain = value; break;
+							case 1: Calibration.attenuation = value; break;
+							case 2: Calibration.A_V_if_agc = value; break;
+							case 3: Calibration.B_V_if_agc = value; break;
+							case 4: Calibration.K_corr = value; break;
+							default:
+								UART_printf("cal - unknown param\r\n");
+							break;
+						}
+
+						if (cal_param[param] != NULL)
+						{
+							set_total_gain(Total_Gain_curr); //gain is recalculated with new calibration
+							UART_printf("cal: %s %.4e\r\n", cal_param[param], value);
+						}
+					}
+					break;
+
+				case 20: /* perf */
+					if( (argc > 1) && (strcmp(argv[1], "reset") == 0) )
+					{
+						perf_reset();
+						UART_printf("perf statistics reset\r\n");
+					}
+					else
+						perf_print();
+					break;
+
+				case 21: /* fm_discr */
+					if(argc > 1)
+					{
+						uint8_t discr = 0;
+						while(fm_discr_param[discr] != NULL)
+						{
+							if(strcmp(argv[1], fm_discr_param[discr])==0)
+								break;
+							discr++;
+						}
+
+						if (fm_discr_param[discr] != NULL)
+							FM_Discr = discr;
+						else
+							UART_printf("fm_discr - unknown discriminator\r\n");
+					}
+					UART_printf("fm_discr: %s\r\n", fm_discr_param[FM_Discr]);
+					break;
+
+				case 22: /* wfm */
+					for (i = 1; i < argc; i++)
+					{
+						if (strcmp(argv[i], "stereo") == 0)
+							WFM_Config.stereo = true;
+						else if (strcmp(argv[i], "mono") == 0)
+							WFM_Config.stereo = false;
+						else
+						{
+							uint8_t deemph = (int)strtoul(argv[i], NULL, 0);
+							if ( (deemph == 0) || (deemph == 50) || (deemph == 75) )
+								wfm_set_deemph(deemph);
+							else
+								UART_printf("wfm - de-emphasis has to be 0, 50 or 75 us\r\n");
+						}
+					}
+					wfm_print();
+					break;
+
+				case 23: /* rds */
+					for (i = 1; i < argc; i++)
+					{
+						if (strcmp(argv[i], "on") == 0)
+							RDS_Config.enabled = true;
+						else if (strcmp(argv[i], "off") == 0)
+							RDS_Config.enabled = false;
+						else if (strcmp(argv[i], "print") == 0)
+							RDS_Config.print = true;
+						else if (strcmp(argv[i], "quiet") == 0)
+							RDS_Config.print = false;
+						else
+							UART_printf("rds - unknown param %s\r\n", argv[i]);
+					}
+					rds_print();
+					break;
+
+				case 24: /* cw */
+					if(argc > 1)
+					{
+						if (strcmp(argv[1], "on") == 0)
+							CW_Config.decode = true;
+						else if (strcmp(argv[1], "off") == 0)
+							CW_Config.decode = false;
+						else
+							UART_printf("cw - unknown param %s\r\n", argv[1]);
+					}
+					cw_print();
+					break;
+
+				case 25: /* mag */
+					if(argc > 1 && strcmp(argv[1], "bench") == 0)
+					{
+						mag_bench();
+						break;
+					}
+					if(argc > 2)
+					{
+						uint8_t user = 0, mode = 0;
+						while(user < MAG_USERS && strcmp(argv[1], mag_user_name[user]) != 0)
+							user++;
+						while(mode < MAG_MODES && strcmp(argv[2], mag_mode_name[mode]) != 0)
+							mode++;
+
+						if (user < MAG_USERS && mode < MAG_MODES)
+							mag_set(user, mode);
+						else
+							UART_printf("mag - unknown user or mode\r\n");
+					}
+					else if(argc > 1)
+						UART_printf("mag - missing mode\r\n");
+					mag_print();
+					break;
+
+				case 26: /* nbfm */
+					for (i = 1; i + 1 < argc; i += 2)
+					{
+						if (strcmp(argv[i], "sq") == 0)
+							nbfm_set_squelch((int8_t)strtol(argv[i+1], NULL, 0));
+						else if (strcmp(argv[i], "ctcss") == 0)
+						{
+							if (!nbfm_set_ctcss(atof(argv[i+1])))
+								UART_printf("nbfm - %s Hz isn't CTCSS tone\r\n", argv[i+1]);
+						}
+						else if (strcmp(argv[i], "dcs") == 0)
+							nbfm_set_dcs((uint16_t)strtoul(argv[i+1], NULL, 8));
+						else if ( (strcmp(argv[i], "tone") == 0) && (strcmp(argv[i+1], "off") == 0) )
+							nbfm_tone_off();
+						else
+							UART_printf("nbfm - unknown param %s %s\r\n", argv[i], argv[i+1]);
+					}
+					if (i < argc)
+						UART_printf("nbfm - missing value of %s\r\n", argv[i]);
+					nbfm_print();
+					break;
+
+				case 27: /* data */
+					for (i = 1; i < argc; i++)
+					{
+						uint8_t mode = 0;
+						while(mode < DATA_MODES && strcmp(argv[i], data_mode_name[mode]) != 0)
+							mode++;
+
+						if (mode < DATA_MODES)
+							data_set_mode(mode);
+						else if (strcmp(argv[i], "text") == 0)
+							Data_Config.output = DATA_OUT_TEXT;
+						else if (strcmp(argv[i], "kiss") == 0)
+							Data_Config.output = DATA_OUT_KISS;
+						else
+							UART_printf("data - unknown param %s\r\n", argv[i]);
+					}
+					data_print();
+					break;
+
+				case 28: /* nb */
+					for (i = 1; i < argc; i++)
+					{
+						uint8_t mode = 0;
+						while(mode < NB_MODES && strcmp(argv[i], nb_mode_name[mode]) != 0)
+							mode++;
+
+						if (mode < NB_MODES)
+							nb_set_mode(mode);
+						else if ( (strcmp(argv[i], "thr") == 0) && (i + 1 < argc) )
+							nb_set_threshold(atof(argv[++i]));
+						else if ( (strcmp(argv[i], "hang") == 0) && (i + 1 < argc) )
+							nb_set_hang((uint8_t)strtoul(argv[++i], NULL, 0));
+						else
+							UART_printf("nb - unknown param %s\r\n", argv[i]);
+					}
+					nb_print();
+					break;
+
+				case 29: /* plan */
+					if (argc > 1)
+					{
+						uint8_t plan = (uint8_t)strtoul(argv[1], NULL, 0);
+						if (plan >= FP_PLANS)
+							UART_printf("plan - index has to be 0...%d\r\n", FP_PLANS - 1);
+						else
+							fp_select(plan);
+					}
+					fp_print();
+					break;
+
+				case 30: /* bw */
+					if (argc > 1)
+					{
+						uint8_t filter = 0;
+						while(filter < IQ_FILTERS && strcmp(argv[1], iq_filter_name[filter]) != 0)
+							filter++;
+
+						if (filter >= IQ_FILTERS)
+							UART_printf("bw - unknown filter %s kHz\r\n", argv[1]);
+						else if (!fp_fits(IQ_Filter_bw_Hz[filter]))
+							UART_printf("bw - %s kHz doesn't fit frequency plan\r\n", argv[1]);
+						else
+							set_IQ_filter(filter);
+					}
+					bw_print();
+					break;
+
+				case 31: /* iq */
+					for (i = 1; i < argc; i++)
+					{
+						if (strcmp(argv[i], "reset") == 0)
+							iqc_reset();
+						else if ( (strcmp(argv[i], "dc") == 0 || strcmp(argv[i], "corr") == 0) && (i + 1 < argc)
+								&& (strcmp(argv[i+1], "on") == 0 || strcmp(argv[i+1], "off") == 0) )
+						{
+							bool on = strcmp(argv[i+1], "on") == 0;
+							if (strcmp(argv[i], "dc") == 0)
+								iqc_set_dc_block(on);
+							else
+								iqc_set_corr(on);
+							i++;
+						}
+						else
+							UART_printf("iq - unknown param %s\r\n", argv[i]);
+					}
+					iqc_print();
+					break;
+
+				case 32: /* lms */
+					if(argc > 1 && strcmp(argv[1], "bench") == 0)
+					{
+						lms_bench();
+						break;
+					}
+					for (i = 1; i < argc; i++)
+					{
+						uint8_t filter = 0;
+						while(filter < LMS_FILTERS && strcmp(argv[i], lms_filter_name[filter]) != 0)
+							filter++;
+
+						if ( (filter < LMS_FILTERS) && (i + 1 < argc) && (strcmp(argv[i+1], "on") == 0 || strcmp(argv[i+1], "off") == 0) )
+							lms_set_on(filter, strcmp(argv[++i], "on") == 0);
+						else if ( (filter < LMS_FILTERS) && (i + 2 < argc) && (strcmp(argv[i+1], "taps") == 0) )
+						{
+							lms_set_taps(filter, (uint8_t)strtoul(argv[i+2], NULL, 0));
+							i += 2;
+						}
+						else
+							UART_printf("lms - unknown param %s\r\n", argv[i]);
+					}
+					lms_print();
+					break;
+
+				case 33: /* agc */
+					{
+						bool on = AGC_Config.on;
+						float level = AGC_Config.level_dB, attack = AGC_Config.attack_ms, decay = AGC_Config.decay_ms;
+
+						for (i = 1; i < argc; i++)
+						{
+							if (strcmp(argv[i], "on") == 0 || strcmp(argv[i], "off") == 0)
+								on = strcmp(argv[i], "on") == 0;
+							else if ( (strcmp(argv[i], "level") == 0) && (i + 1 < argc) )
+								level = atof(argv[++i]);
+							else if ( (strcmp(argv[i], "attack") == 0) && (i + 1 < argc) )
+								attack = atof(argv[++i]);
+							else if ( (strcmp(argv[i], "decay") == 0) && (i + 1 < argc) )
+								decay = atof(argv[++i]);
+							else
+								UART_printf("agc - unknown param %s\r\n", argv[i]);
+						}
+						agc_set(on, level, attack, decay);
+					}
+					agc_print();
+					break;
+
+				case 34: /* snr */
+					nf_print();
+					break;
+
+				case 35: /* enob */
+					enob_measure();
+					break;
+
+				case 36: /* chan */
+					{
+						bool on = Chan_Config.on;
+						float offset_Hz[CHAN_MAX];
+						uint8_t channels = 0;
+						char* end;
+
+						for (i = 1; i < argc; i++)
+						{
+							if (strcmp(argv[i], "on") == 0 || strcmp(argv[i], "off") == 0)
+								on = strcmp(argv[i], "on") == 0;
+							else if ( (strcmp(argv[i], "route") == 0) && (i + 1 < argc) )
+							{
+								i++;
+								chan_set_route(strcmp(argv[i], "auto") == 0 ? CHAN_ROUTE_AUTO : (uint8_t)strtoul(argv[i], NULL, 0));
+							}
+							else if ( (strcmp(argv[i], "sq") == 0) && (i + 1 < argc) )
+								chan_set_squelch((int8_t)atoi(argv[++i]));
+							else
+							{
+								float f = strtof(argv[i], &end);
+
+								if ( (end != argv[i]) && (*end == 0) && (channels < CHAN_MAX) )
+									offset_Hz[channels++] = f*1.0e3;
+								else
+									UART_printf("chan - unknown param %s\r\n", argv[i]);
+							}
+						}
+						if (channels) chan_set_offsets(offset_Hz, channels);
+						if (on != Chan_Config.on)
+						{
+							chan_set_on(on);
+							set_IQ_filters_coeff(Demod_Type);
+						}
+					}
+					chan_print();
+					break;
+
 				default:	/* shouldn't get here */
 					break;
 			}
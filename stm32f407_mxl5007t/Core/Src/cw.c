@@ -0,0 +1,281 @@
+/*
+ * cw.c - CW receiver with BFO product detector and Morse decoder
+ *
+ * I/Q is decimated to CW_FS_Hz in two FIR stages (8x, 8x), so the narrow filter (Chebyshev IIR on I and Q, half of
+ * the bandwidth) runs on one sample per two blocks. Filtered I/Q is linearly interpolated back to AUDIO_FS_Hz and
+ * multiplied by BFO - real part of the product is the beat note at pitch + carrier offset, so the tone keeps
+ * signal's strength, fading and noise. Envelope of the narrow filter output is compared with adaptive threshold
+ * between tracked signal and noise levels - mark/space lengths go by ring buffer to cw_task() in main loop, where
+ * dot length is estimated and Morse code is decoded.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include "main.h"
+#include "cw.h"
+#include "audio_i2s.h"
+#include "dsp_math.h"
+#include "dsp_mag.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "printf.h"
+
+#define HZ_TO_PHASE (4294967296.0/AUDIO_FS_Hz)
+
+CW_Config_TypeDef CW_Config =
+{
+	.filter = CW_FILTER_500,
+	.pitch_Hz = CW_DEFAULT_PITCH,
+	.decode = true
+};
+
+const char *cw_filter_name[CW_FILTERS] = {"200", "300", "500"}; //Hz - the same order like CW_Filter_enum
+
+static const float* const CW_IIR[CW_FILTERS] = {CW_IIR_200, CW_IIR_300, CW_IIR_500};
+
+//Morse code with leading 1 as start marker (dot - 0, dash - 1), '*' - unknown
+static const char CW_morse[128] =
+	"**ETIANMSURWDKGOHVF*L*PJBXCYZQ**"
+	"54*3***2&*+****16=/***(*7***8*90"
+	"************?*****\"**.****@***'*"
+	"*-*********!*)*****,****:*******";
+
+//I/Q decimation - the 1st stage is the same like in SSB demodulator
+static float FIR1_I_delay[2*SSB_FIR1_TAPS], FIR1_Q_delay[2*SSB_FIR1_TAPS];
+static FIR_Decim_TypeDef FIR1_I = {SSB_FIR1, SSB_FIR1_TAPS, CW_DECIM1, 0, 0, FIR1_I_delay};
+static FIR_Decim_TypeDef FIR1_Q = {SSB_FIR1, SSB_FIR1_TAPS, CW_DECIM1, 0, 0, FIR1_Q_delay};
+static float FIR2_I_delay[2*CW_FIR2_TAPS], FIR2_Q_delay[2*CW_FIR2_TAPS];
+static FIR_Decim_TypeDef FIR2_I = {CW_FIR2, CW_FIR2_TAPS, CW_DECIM2, 0, 0, FIR2_I_delay};
+static FIR_Decim_TypeDef FIR2_Q = {CW_FIR2, CW_FIR2_TAPS, CW_DECIM2, 0, 0, FIR2_Q_delay};
+static float Dec1_I[BB_BLOCK/CW_DECIM1], Dec1_Q[BB_BLOCK/CW_DECIM1];
+static float Dec2_I[BB_BLOCK/CW_DECIM1], Dec2_Q[BB_BLOCK/CW_DECIM1];
+
+//narrow filters - coefficients are switched by pointer (single word write, so it's safe during ADC callbacks)
+static const float* volatile IIR_coeff = CW_IIR_500;
+static float Z_I[CW_IIR_SECTIONS][2], Z_Q[CW_IIR_SECTIONS][2];
+
+//interpolation to AUDIO_FS_Hz and BFO
+static float Nar_I, Nar_Q, Nar_prev_I, Nar_prev_Q;
+static uint8_t Interp_cnt;
+static uint32_t BFO_phase;
+static volatile uint32_t BFO_step;
+
+//keying
+static float Env_smooth, Sig_level, Noise_level;
+static volatile bool Key_down;
+static volatile uint16_t Run_len; //CW_FS_Hz samples since the last key change
+
+//mark (positive) and space (negative) lengths to main loop
+static volatile int32_t CW_events[CW_EVENTS_RING];
+static volatile uint16_t CW_events_head; //written in ADC callback
+static uint16_t CW_events_tail;
+static uint32_t CW_events_lost;
+
+//decoder
+static float Dot_len;       //CW_FS_Hz samples
+static uint8_t Code;        //elements of current character with start marker
+static bool Word_printed;
+
+//has to be called before Demod_Type is switched to DEMOD_CW (it's not synchronized with ADC callbacks)
+void cw_init(void)
+{
+	uint8_t k;
+
+	fir_reset(&FIR1_I);
+	fir_reset(&FIR1_Q);
+	fir_reset(&FIR2_I);
+	fir_reset(&FIR2_Q);
+	for (k = 0; k < CW_IIR_SECTIONS; k++)
+		Z_I[k][0] = Z_I[k][1] = Z_Q[k][0] = Z_Q[k][1] = 0;
+	Nar_I = Nar_Q = Nar_prev_I = Nar_prev_Q = 0;
+	Interp_cnt = 0;
+	BFO_phase = 0;
+
+	Env_smooth = Sig_level = Noise_level = 0;
+	Key_down = false;
+	Run_len = 0;
+
+	CW_events_head = CW_events_tail = 0;
+	CW_events_lost = 0;
+	Dot_len = CW_FS_Hz*1.2/20.0; //20 WPM until the first dashes come
+	Code = 1;
+	Word_printed = true;
+
+	cw_set_filter(CW_Config.filter);
+	cw_set_pitch(CW_Config.pitch_Hz);
+}
+
+void cw_set_filter(CW_Filter_enum filter)
+{
+	if (filter >= CW_FILTERS) filter = CW_FILTER_500;
+	CW_Config.filter = filter;
+	IIR_coeff = CW_IIR[filter];
+}
+
+void cw_set_pitch(uint16_t pitch_Hz)
+{
+	if ( (pitch_Hz < CW_PITCH_MIN_Hz) || (pitch_Hz > CW_PITCH_MAX_Hz) ) pitch_Hz = CW_DEFAULT_PITCH;
+	CW_Config.pitch_Hz = pitch_Hz;
+	BFO_step = (uint32_t) (pitch_Hz*HZ_TO_PHASE);
+}
+
+//envelope at CW_FS_Hz - keying with hysteresis between signal peak level and average noise level
+static void cw_key(float env)
+{
+	float span;
+	bool key;
+
+	Env_smooth += (env - Env_smooth)*CW_ENV_SMOOTH;
+	if (Env_smooth > Sig_level) Sig_level += (Env_smooth - Sig_level)*CW_LEVEL_ATTACK;
+	else Sig_level += (Env_smooth - Sig_level)*CW_LEVEL_DECAY;
+	if (!Key_down || (Run_len > CW_MARK_MAX_ms*CW_FS_Hz/1000)) //too long mark is a carrier or noise, not keying
+		Noise_level += (Env_smooth - Noise_level)*CW_NOISE_AVG;
+
+	span = Sig_level - Noise_level;
+	if (Sig_level <= CW_SNR_MIN*Noise_level) key = false;
+	else if (Key_down) key = Env_smooth > Noise_level + CW_KEY_OFF*span;
+	else key = Env_smooth > Noise_level + CW_KEY_ON*span;
+
+	if (key != Key_down)
+	{
+		CW_events[CW_events_head & (CW_EVENTS_RING-1)] = Key_down ? Run_len : -(int32_t) Run_len;
+		CW_events_head++;
+		Key_down = key;
+		Run_len = 0;
+	}
+	if (Run_len < UINT16_MAX) Run_len++;
+}
+
+//returns number of audio samples in out (n/CW_DECIM1)
+uint16_t cw_process(const float* I, const float* Q, uint16_t n, float* out)
+{
+	const float* c = IIR_coeff;
+	Mag_Mode_enum mag_mode = Mag_Mode[MAG_USER_CW];
+	uint16_t k, m, l;
+	uint8_t j;
+	float i, q, s, co, t, env;
+
+	m = fir_decim(&FIR1_I, I, Dec1_I, n);
+	fir_decim(&FIR1_Q, Q, Dec1_Q, n);
+	l = fir_decim(&FIR2_I, Dec1_I, Dec2_I, m);
+	fir_decim(&FIR2_Q, Dec1_Q, Dec2_Q, m);
+
+	//narrow filters, envelope and keying at CW_FS_Hz
+	for (k = 0; k < l; k++)
+	{
+		i = Dec2_I[k];
+		q = Dec2_Q[k];
+		for (j = 0; j < CW_IIR_SECTIONS; j++)
+		{
+			const float* bq = &c[5*j];
+
+			t = i - (Z_I[j][0]*bq[3] + Z_I[j][1]*bq[4]);
+			i = t*bq[0] + Z_I[j][0]*bq[1] + Z_I[j][1]*bq[2];
+			Z_I[j][1] = Z_I[j][0];
+			Z_I[j][0] = t;
+
+			t = q - (Z_Q[j][0]*bq[3] + Z_Q[j][1]*bq[4]);
+			q = t*bq[0] + Z_Q[j][0]*bq[1] + Z_Q[j][1]*bq[2];
+			Z_Q[j][1] = Z_Q[j][0];
+			Z_Q[j][0] = t;
+		}
+		Nar_prev_I = Nar_I;
+		Nar_prev_Q = Nar_Q;
+		Nar_I = i;
+		Nar_Q = q;
+		Interp_cnt = 0;
+
+		env = mag_calc(i, q, mag_mode);
+		cw_key(env);
+	}
+
+	//product detector at AUDIO_FS_Hz: Re{(I + jQ)*exp(j*phase)} with I/Q interpolated between the last two narrow samples
+	for (k = 0; k < m; k++)
+	{
+		t = Interp_cnt*(1.0f/CW_DECIM2);
+		if (Interp_cnt < CW_DECIM2-1) Interp_cnt++;
+		i = Nar_prev_I + (Nar_I - Nar_prev_I)*t;
+		q = Nar_prev_Q + (Nar_Q - Nar_prev_Q)*t;
+
+		fast_sincos_phase(BFO_phase, &s, &co);
+		BFO_phase += BFO_step;
+		out[k] = i*co - q*s; //level is set by audio AGC (agc.c)
+	}
+
+	return m;
+}
+
+static void cw_char(void)
+{
+	if (Code > 1)
+	{
+		if (CW_Config.decode) UART_printf("%c", CW_morse[Code & 0x7F]);
+		Code = 1;
+	}
+}
+
+//Morse decoding in main loop - dot length follows marks: dot = mark, dash = 3 dots
+void cw_task(void)
+{
+	int32_t e;
+	float len;
+
+	if ((uint16_t) (CW_events_head - CW_events_tail) > CW_EVENTS_RING)
+	{
+		CW_events_lost += (uint16_t) (CW_events_head - CW_events_tail) - CW_EVENTS_RING;
+		CW_events_tail = CW_events_head - CW_EVENTS_RING;
+	}
+
+	while (CW_events_tail != CW_events_head)
+	{
+		e = CW_events[CW_events_tail & (CW_EVENTS_RING-1)];
+		CW_events_tail++;
+
+		if (e > 0) //mark
+		{
+			len = e;
+			if (len < 2.0f*Dot_len)
+			{
+				Code = Code << 1;
+				Dot_len += (len - Dot_len)*0.25f;
+			}
+			else
+			{
+				Code = (Code << 1) | 1;
+				Dot_len += (len/3.0f - Dot_len)*0.25f;
+			}
+			if (Dot_len < CW_FS_Hz*1.2/CW_WPM_MAX) Dot_len = CW_FS_Hz*1.2/CW_WPM_MAX;
+			if (Dot_len > CW_FS_Hz*1.2/CW_WPM_MIN) Dot_len = CW_FS_Hz*1.2/CW_WPM_MIN;
+			if (Code >= 0x80) Code = 0x7F; //too long - unknown
+			Word_printed = false;
+		}
+		else //space
+		{
+			len = -e;
+			if (len > 2.0f*Dot_len) cw_char();
+			if ( (len > 5.0f*Dot_len) && !Word_printed )
+			{
+				if (CW_Config.decode) UART_printf(" ");
+				Word_printed = true;
+			}
+		}
+	}
+
+	//the last character and word gap are printed without waiting for the next mark
+	if (!Key_down)
+	{
+		len = Run_len;
+		if (len > 2.0f*Dot_len) cw_char();
+		if ( (len > 5.0f*Dot_len) && !Word_printed )
+		{
+			if (CW_Config.decode) UART_printf(" ");
+			Word_printed = true;
+		}
+	}
+}
+
+void cw_print(void)
+{
+	UART_printf("cw: filter %s Hz ; pitch %d Hz ; decoder %s ; %.1f WPM ; signal %.2e noise %.2e ; events lost %lu\r\n",
+			cw_filter_name[CW_Config.filter], CW_Config.pitch_Hz, CW_Config.decode ? "on" : "off",
+			CW_FS_Hz*1.2/Dot_len, Sig_level, Noise_level, CW_events_lost);
+}
@@ -0,0 +1,231 @@
+/*
+ * data_demod.c - data demodulators (AFSK 1200 for AX.25, FSK for POCSAG) on FM/AM/NBFM demodulator output
+ *
+ * Demodulator output block is decimated to DATA_FS_Hz (FM/AM audio at FS_BB_Hz by SSB_FIR1 and DATA_FIR2, NBFM
+ * discriminator at AUDIO_FS_Hz only by DATA_FIR2) and then:
+ * - AFSK: mark and space energy - correlation with 1200 and 2200 Hz over one bit, the bigger one is the level,
+ * - FSK: DC (frequency offset) removal and moving average over one bit, the sign is the level.
+ * Bit clock is recovered from level transitions (phase accumulator pulled towards transitions) and levels sampled
+ * in the middle of bits are passed by ring buffer to data_task() in main loop - HDLC/AX.25 (ax25.c) or POCSAG
+ * (pocsag.c) decoding and printing is done there, so ADC callback costs about 2 decimated samples per block.
+ */
+#include <string.h>
+#include <stdbool.h>
+#include "main.h"
+#include "data_demod.h"
+#include "ax25.h"
+#include "pocsag.h"
+#include "dsp_math.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "printf.h"
+
+#define HZ_TO_PHASE (4294967296.0/DATA_FS_Hz)
+
+extern Output_demod_type_enum Demod_Type;
+
+Data_Config_TypeDef Data_Config =
+{
+	.mode = DATA_OFF,
+	.output = DATA_OUT_TEXT
+};
+
+const char *data_mode_name[DATA_MODES] = {"off", "afsk", "pocsag512", "pocsag1200", "pocsag2400"}; //the same order like Data_Mode_enum
+static const uint16_t data_baud[DATA_MODES] = {0, 1200, 512, 1200, 2400};
+
+//decimation to DATA_FS_Hz
+static float FIR1_delay[2*SSB_FIR1_TAPS], FIR2_delay[2*DATA_FIR2_TAPS];
+static FIR_Decim_TypeDef FIR1 = {SSB_FIR1, SSB_FIR1_TAPS, DATA_DECIM1, 0, 0, FIR1_delay};
+static FIR_Decim_TypeDef FIR2 = {DATA_FIR2, DATA_FIR2_TAPS, DATA_DECIM2, 0, 0, FIR2_delay};
+static float Dec1[BB_BLOCK/DATA_DECIM1], Dec2[BB_BLOCK/(DATA_DECIM1*DATA_DECIM2)];
+
+//AFSK mark/space correlators - I/Q products of the last bit
+static uint32_t Mark_phase, Space_phase, Mark_step, Space_step;
+static float Corr_MI[DATA_AFSK_CORR], Corr_MQ[DATA_AFSK_CORR], Corr_SI[DATA_AFSK_CORR], Corr_SQ[DATA_AFSK_CORR];
+static uint8_t Corr_idx;
+
+//FSK slicer
+static float FSK_DC, FSK_sum;
+static float FSK_delay[DATA_FSK_MA_MAX];
+static uint8_t FSK_len, FSK_idx;
+
+//bit clock
+static uint32_t Clk_phase, Clk_step;
+static bool Clk_level;
+
+//levels from ADC callback to data_task()
+static volatile uint8_t Data_bits[DATA_BITS_RING];
+static volatile uint16_t Data_bits_head; //written in ADC callback
+static uint16_t Data_bits_tail;
+static uint32_t Data_bits_lost, Data_bits_total;
+
+void data_init(void)
+{
+	data_set_mode(DATA_OFF);
+}
+
+//can be called at any time - demodulator is stopped while its state is reset
+void data_set_mode(Data_Mode_enum mode)
+{
+	if (mode >= DATA_MODES) mode = DATA_OFF;
+	Data_Config.mode = DATA_OFF;
+
+	fir_reset(&FIR1);
+	fir_reset(&FIR2);
+
+	Mark_phase = Space_phase = 0;
+	Mark_step = (uint32_t) (DATA_AFSK_MARK_Hz*HZ_TO_PHASE);
+	Space_step = (uint32_t) (DATA_AFSK_SPACE_Hz*HZ_TO_PHASE);
+	memset(Corr_MI, 0, sizeof(Corr_MI));
+	memset(Corr_MQ, 0, sizeof(Corr_MQ));
+	memset(Corr_SI, 0, sizeof(Corr_SI));
+	memset(Corr_SQ, 0, sizeof(Corr_SQ));
+	Corr_idx = 0;
+
+	FSK_DC = FSK_sum = 0;
+	memset(FSK_delay, 0, sizeof(FSK_delay));
+	FSK_idx = 0;
+	FSK_len = 1;
+	if (mode != DATA_OFF)
+	{
+		FSK_len = (uint8_t) (DATA_FS_Hz/data_baud[mode] + 0.5);
+		if (FSK_len > DATA_FSK_MA_MAX) FSK_len = DATA_FSK_MA_MAX;
+		Clk_step = (uint32_t) (data_baud[mode]*HZ_TO_PHASE);
+	}
+	Clk_phase = 0;
+	Clk_level = false;
+
+	Data_bits_head = Data_bits_tail = 0;
+	Data_bits_lost = Data_bits_total = 0;
+	ax25_reset();
+	pocsag_reset(data_baud[mode]);
+
+	Data_Config.mode = mode;
+}
+
+//phase accumulator is pulled to 0 at level transitions - returns true in the middle of bit
+static inline bool data_clock(bool level)
+{
+	int32_t prev;
+
+	if (level != Clk_level)
+	{
+		Clk_level = level;
+		Clk_phase -= ((int32_t) Clk_phase) >> DATA_CLOCK_GAIN;
+	}
+	prev = (int32_t) Clk_phase;
+	Clk_phase += Clk_step;
+	return (prev >= 0) && ((int32_t) Clk_phase < 0);
+}
+
+static inline bool data_afsk(float x)
+{
+	float s, c, mi = 0, mq = 0, si = 0, sq = 0;
+	uint8_t j;
+
+	fast_sincos_phase(Mark_phase, &s, &c);
+	Mark_phase += Mark_step;
+	Corr_MI[Corr_idx] = x*c;
+	Corr_MQ[Corr_idx] = x*s;
+	fast_sincos_phase(Space_phase, &s, &c);
+	Space_phase += Space_step;
+	Corr_SI[Corr_idx] = x*c;
+	Corr_SQ[Corr_idx] = x*s;
+	if (++Corr_idx == DATA_AFSK_CORR) Corr_idx = 0;
+
+	for (j = 0; j < DATA_AFSK_CORR; j++)
+	{
+		mi += Corr_MI[j];
+		mq += Corr_MQ[j];
+		si += Corr_SI[j];
+		sq += Corr_SQ[j];
+	}
+	return mi*mi + mq*mq > si*si + sq*sq; //mark is 1
+}
+
+static inline bool data_fsk(float x)
+{
+	uint8_t j;
+
+	FSK_DC += (x - FSK_DC)*DATA_FSK_DC_AVG;
+	x -= FSK_DC;
+
+	FSK_sum += x - FSK_delay[FSK_idx];
+	FSK_delay[FSK_idx] = x;
+	if (++FSK_idx == FSK_len)
+	{
+		//running sum is computed again once per bit, so rounding errors don't accumulate
+		FSK_idx = 0;
+		FSK_sum = 0;
+		for (j = 0; j < FSK_len; j++) FSK_sum += FSK_delay[j];
+	}
+	return FSK_sum > 0; //higher frequency is 1 - polarity is found by POCSAG sync word
+}
+
+void data_process(const float* x, uint16_t n, Data_Source_enum src)
+{
+	Data_Mode_enum mode = Data_Config.mode;
+	uint16_t k, m;
+	bool level;
+
+	if (mode == DATA_OFF) return;
+
+	if (src == DATA_SRC_BB)
+	{
+		m = fir_decim(&FIR1, x, Dec1, n);
+		m = fir_decim(&FIR2, Dec1, Dec2, m);
+	}
+	else
+		m = fir_decim(&FIR2, x, Dec2, n);
+
+	for (k = 0; k < m; k++)
+	{
+		if (mode == DATA_AFSK1200) level = data_afsk(Dec2[k]);
+		else level = data_fsk(Dec2[k]);
+
+		if (data_clock(level))
+		{
+			Data_bits[Data_bits_head & (DATA_BITS_RING-1)] = level;
+			Data_bits_head++;
+		}
+	}
+}
+
+//called from main loop - frame decoding and printing
+void data_task(void)
+{
+	Data_Mode_enum mode = Data_Config.mode;
+	bool kiss = Data_Config.output == DATA_OUT_KISS;
+	uint8_t level;
+
+	if ((uint16_t) (Data_bits_head - Data_bits_tail) > DATA_BITS_RING)
+	{
+		Data_bits_lost += (uint16_t) (Data_bits_head - Data_bits_tail) - DATA_BITS_RING;
+		Data_bits_tail = Data_bits_head - DATA_BITS_RING;
+	}
+
+	while (Data_bits_tail != Data_bits_head)
+	{
+		level = Data_bits[Data_bits_tail & (DATA_BITS_RING-1)];
+		Data_bits_tail++;
+		Data_bits_total++;
+
+		if (mode == DATA_AFSK1200) ax25_bit(level, kiss);
+		else if (mode != DATA_OFF) pocsag_bit(level);
+	}
+}
+
+void data_print(void)
+{
+	UART_printf("data: %s ; output %s ; source ", data_mode_name[Data_Config.mode], (Data_Config.output == DATA_OUT_KISS) ? "kiss" : "text");
+	if (Demod_Type == DEMOD_NBFM) UART_printf("NBFM discriminator");
+	else if ( (Demod_Type == DEMOD_FM) || (Demod_Type == DEMOD_AM) ) UART_printf("%s audio", (Demod_Type == DEMOD_FM) ? "FM" : "AM");
+	else UART_printf("none (FM, AM or NBFM is needed)");
+	UART_printf(" ; bits %lu (lost %lu)\r\n", Data_bits_total, Data_bits_lost);
+
+	if (Data_Config.mode == DATA_AFSK1200)
+		UART_printf("AX.25: frames %lu ; FCS errors %lu ; aborts %lu\r\n", AX25_Stat.frames, AX25_Stat.fcs_errors, AX25_Stat.aborts);
+	else if (Data_Config.mode != DATA_OFF)
+		UART_printf("POCSAG: batches %lu ; messages %lu ; codewords corrected %lu ; errors %lu\r\n", POCSAG_Stat.batches,
+				POCSAG_Stat.messages, POCSAG_Stat.corrected, POCSAG_Stat.errors);
+}
@@ -0,0 +1,56 @@
+/*
+ * dsp_fft.c - radix-2 complex FFT for measurements in the main loop
+ *
+ * In place decimation in time for any power of 2 length up to FFT_LEN_MAX. One sine table of 3/4 period is shared
+ * by all lengths (cosine is the sine a quarter period later) - it's computed by fft_init() with sinf(), so the
+ * spurs of the transform stay far below 12-bit ADC quantization (table in flash would be the same size).
+ */
+#include <math.h>
+#include "dsp_fft.h"
+
+static float Fft_sin[FFT_LEN_MAX*3/4]; //sin(2*pi*k/FFT_LEN_MAX)
+
+void fft_init(void)
+{
+	uint16_t k;
+
+	for (k = 0; k < FFT_LEN_MAX*3/4; k++) Fft_sin[k] = sinf(2.0*M_PI*k/FFT_LEN_MAX);
+}
+
+//len is power of 2 and <= FFT_LEN_MAX - X[k] = sum(x[n]*exp(-j*2*pi*k*n/len))
+void fft_cplx(float* re, float* im, uint16_t len)
+{
+	uint16_t i, j = 0, k, a, b, size, half, step, bit;
+	float tr, ti, wr, wi;
+
+	for (i = 1; i < len; i++) //bit reversed order
+	{
+		for (bit = len >> 1; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j)
+		{
+			tr = re[i]; re[i] = re[j]; re[j] = tr;
+			ti = im[i]; im[i] = im[j]; im[j] = ti;
+		}
+	}
+
+	for (size = 2; size <= len; size <<= 1)
+	{
+		half = size >> 1;
+		step = FFT_LEN_MAX/size;
+		for (i = 0; i < len; i += size)
+			for (k = 0; k < half; k++)
+			{
+				wr = Fft_sin[k*step + FFT_LEN_MAX/4];
+				wi = -Fft_sin[k*step];
+				a = i + k;
+				b = a + half;
+				tr = re[b]*wr - im[b]*wi;
+				ti = re[b]*wi + im[b]*wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+	}
+}
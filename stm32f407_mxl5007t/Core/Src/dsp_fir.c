@@ -0,0 +1,110 @@
+/*
+ * dsp_fir.c - decimating FIR filters for block processing
+ *
+ * Output is computed only for every decim-th input sample, so the cost is taps/decim multiplications per input sample.
+ * Linear phase filters can use fir_decim_sym() - samples with the same coefficient are added first and two accumulators
+ * hide VFMA latency, so it needs about half of the loads and multiplications. Half band filters (decimation by 2) can use
+ * fir_decim_hb() - every other coefficient is zero, so it's about a quarter of them.
+ */
+#include <string.h>
+#include "dsp_fir.h"
+
+void fir_reset(FIR_Decim_TypeDef* f)
+{
+	memset(f->delay, 0, 2*f->taps*sizeof(float));
+	f->idx = 0;
+	f->phase = 0;
+}
+
+//returns number of output samples
+uint16_t fir_decim(FIR_Decim_TypeDef* f, const float* in, float* out, uint16_t n)
+{
+	uint16_t i, k, m = 0;
+	const float* h;
+	const float* x;
+	float acc;
+
+	for (i = 0; i < n; i++)
+	{
+		if (f->idx == 0) f->idx = f->taps;
+		f->idx--;
+		f->delay[f->idx] = in[i];
+		f->delay[f->idx + f->taps] = in[i];
+
+		if (++f->phase == f->decim)
+		{
+			f->phase = 0;
+			h = f->coeff;
+			x = &f->delay[f->idx]; //x[0] is the newest sample
+			acc = 0;
+			for (k = 0; k < f->taps; k++) acc += h[k]*x[k];
+			out[m++] = acc;
+		}
+	}
+	return m;
+}
+
+//the same for symmetric coefficients (h[k] == h[taps-1-k]) and taps multiple of 4
+uint16_t fir_decim_sym(FIR_Decim_TypeDef* f, const float* in, float* out, uint16_t n)
+{
+	uint16_t i, k, m = 0;
+	const float* h;
+	const float* x;
+	const float* y;
+	float acc0, acc1;
+
+	for (i = 0; i < n; i++)
+	{
+		if (f->idx == 0) f->idx = f->taps;
+		f->idx--;
+		f->delay[f->idx] = in[i];
+		f->delay[f->idx + f->taps] = in[i];
+
+		if (++f->phase == f->decim)
+		{
+			f->phase = 0;
+			h = f->coeff;
+			x = &f->delay[f->idx]; //x[0] is the newest sample
+			y = &x[f->taps - 1];   //y[0] is the oldest one
+			acc0 = acc1 = 0;
+			for (k = 0; k < f->taps/2; k += 2)
+			{
+				acc0 += h[k]*(x[k] + y[-k]);
+				acc1 += h[k+1]*(x[k+1] + y[-k-1]);
+			}
+			out[m++] = acc0 + acc1;
+		}
+	}
+	return m;
+}
+
+//the same for symmetric half band coefficients (taps = 4*k + 3, h[k] == 0 for odd k except the middle one) and decim 2
+uint16_t fir_decim_hb(FIR_Decim_TypeDef* f, const float* in, float* out, uint16_t n)
+{
+	uint16_t i, k, m = 0;
+	uint16_t mid = f->taps/2;
+	const float* h;
+	const float* x;
+	const float* y;
+	float acc;
+
+	for (i = 0; i < n; i++)
+	{
+		if (f->idx == 0) f->idx = f->taps;
+		f->idx--;
+		f->delay[f->idx] = in[i];
+		f->delay[f->idx + f->taps] = in[i];
+
+		if (++f->phase == f->decim)
+		{
+			f->phase = 0;
+			h = f->coeff;
+			x = &f->delay[f->idx]; //x[0] is the newest sample
+			y = &x[f->taps - 1];   //y[0] is the oldest one
+			acc = h[mid]*x[mid];
+			for (k = 0; k < mid; k += 2) acc += h[k]*(x[k] + y[-k]);
+			out[m++] = acc;
+		}
+	}
+	return m;
+}
@@ -0,0 +1,110 @@
+/*
+ * dsp_mag.c - magnitude |I + jQ| for envelope detectors and level measurement
+ *
+ * The same kernel with three accuracy levels is used by all envelope users (AM, SAM, CW, level measurement), each
+ * one with its own mode. Block version has a separate loop per mode, so there's no branch inside.
+ * mag bench measures cycles per sample of every mode by DWT counter and max/rms relative error against double
+ * precision sqrt on a test vector with amplitudes from -60 dB to 0 dB and all phases.
+ */
+#include <math.h>
+#include "main.h"
+#include "dsp_mag.h"
+#include "perf.h"
+#include "printf.h"
+
+volatile Mag_Mode_enum Mag_Mode[MAG_USERS] =
+{
+	[MAG_USER_AM] = MAG_AMBM,     //audio after envelope is filtered and scaled - 4% error is only small distortion
+	[MAG_USER_SAM] = MAG_RSQRT,   //unlocked envelope is audio too, carrier level sets the volume
+	[MAG_USER_CW] = MAG_RSQRT,    //keying thresholds between noise and signal levels
+	[MAG_USER_LEVEL] = MAG_EXACT  //dB readout and scanner thresholds
+};
+
+const char *mag_mode_name[MAG_MODES] = {"ambm", "rsqrt", "exact"}; //the same order like Mag_Mode_enum
+const char *mag_user_name[MAG_USERS] = {"am", "sam", "cw", "level"}; //the same order like Mag_User_enum
+
+void mag_block(const float* I, const float* Q, float* out, uint16_t n, Mag_Mode_enum mode)
+{
+	uint16_t k;
+
+	switch (mode)
+	{
+	case MAG_AMBM:
+		for (k = 0; k < n; k++)
+			out[k] = mag_calc(I[k], Q[k], MAG_AMBM);
+		break;
+
+	case MAG_RSQRT:
+		for (k = 0; k < n; k++)
+			out[k] = mag_calc(I[k], Q[k], MAG_RSQRT);
+		break;
+
+	default:
+		for (k = 0; k < n; k++)
+			out[k] = mag_calc(I[k], Q[k], MAG_EXACT);
+		break;
+	}
+}
+
+void mag_set(Mag_User_enum user, Mag_Mode_enum mode)
+{
+	if (user >= MAG_USERS) return;
+	if (mode >= MAG_MODES) mode = MAG_EXACT;
+	Mag_Mode[user] = mode;
+}
+
+void mag_bench(void)
+{
+	static float I_test[MAG_BENCH_LEN], Q_test[MAG_BENCH_LEN], out[MAG_BENCH_LEN];
+	uint32_t t, cycles, cycles_min, phase = 0;
+	uint16_t k, run;
+	Mag_Mode_enum mode;
+	float s, c, a;
+	double ref, err, err_max, err_sum;
+
+	//amplitude steps through 60 dB, phase through 5.6 turns - irrational ratio covers all octants
+	for (k = 0; k < MAG_BENCH_LEN; k++)
+	{
+		a = powf(10.0f, -3.0f*k/(MAG_BENCH_LEN-1));
+		fast_sincos_phase(phase, &s, &c);
+		phase += 377000000;
+		I_test[k] = a*c;
+		Q_test[k] = a*s;
+	}
+
+	UART_printf("mode    cycles/sample  max err [%%]  rms err [%%]\r\n");
+	for (mode = 0; mode < MAG_MODES; mode++)
+	{
+		//the fastest run - ADC interrupts can preempt the loop
+		cycles_min = 0xFFFFFFFF;
+		for (run = 0; run < 16; run++)
+		{
+			t = perf_start();
+			mag_block(I_test, Q_test, out, MAG_BENCH_LEN, mode);
+			cycles = perf_start() - t;
+			if (cycles < cycles_min) cycles_min = cycles;
+		}
+
+		err_max = err_sum = 0;
+		for (k = 0; k < MAG_BENCH_LEN; k++)
+		{
+			ref = sqrt((double) I_test[k]*I_test[k] + (double) Q_test[k]*Q_test[k]);
+			err = fabs(out[k] - ref)/ref;
+			if (err > err_max) err_max = err;
+			err_sum += err*err;
+		}
+
+		UART_printf("%-7s %13.1f %13.4f %12.4f\r\n", mag_mode_name[mode], (float) cycles_min/MAG_BENCH_LEN,
+				100.0*err_max, 100.0*sqrt(err_sum/MAG_BENCH_LEN));
+	}
+}
+
+void mag_print(void)
+{
+	uint8_t k;
+
+	UART_printf("mag:");
+	for (k = 0; k < MAG_USERS; k++)
+		UART_printf(" %s %s%s", mag_user_name[k], mag_mode_name[Mag_Mode[k]], k < MAG_USERS-1 ? " ;" : "");
+	UART_printf("\r\n");
+}
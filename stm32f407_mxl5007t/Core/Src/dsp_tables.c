@@ -0,0 +1,413 @@
+/*
+ * dsp_tables.c - arcsine look-up table and FIR filters coefficients
+ *
+ * Generated by Matlab/lut_gen.m - don't edit. Tables are const so they're placed in flash
+ * and there's no asinf computing at startup (mixer table is set by frequency plan - freq_plan.c).
+ */
+#include "main.h"
+#include "dsp_tables.h"
+
+//arcsine for x = 2*i/N_asin - 1 (needed for FM)
+const float asin_arr[N_asin] =
+{
+	-1.570796371e+00, -1.407315135e+00, -1.339339972e+00, -1.287002087e+00,
+	-1.242728472e+00, -1.203588367e+00, -1.168080568e+00, -1.135313869e+00,
+	-1.104708672e+00, -1.075862169e+00, -1.048481464e+00, -1.022345781e+00,
+	-9.972832799e-01, -9.731577039e-01, -9.498587251e-01, -9.272952676e-01,
+	-9.053910375e-01, -8.840820193e-01, -8.633130789e-01, -8.430368304e-01,
+	-8.232120275e-01, -8.038023710e-01, -7.847759128e-01, -7.661044598e-01,
+	-7.477626204e-01, -7.297276258e-01, -7.119790316e-01, -6.944982409e-01,
+	-6.772683859e-01, -6.602740884e-01, -6.435011625e-01, -6.269365549e-01,
+	-6.105684638e-01, -5.943858027e-01, -5.783782005e-01, -5.625361800e-01,
+	-5.468509197e-01, -5.313140154e-01, -5.159177184e-01, -5.006546378e-01,
+	-4.855180979e-01, -4.705014527e-01, -4.555986822e-01, -4.408039153e-01,
+	-4.261116683e-01, -4.115168154e-01, -3.970143497e-01, -3.825995624e-01,
+	-3.682679236e-01, -3.540150225e-01, -3.398368955e-01, -3.257294893e-01,
+	-3.116889894e-01, -2.977116406e-01, -2.837940753e-01, -2.699327767e-01,
+	-2.561244369e-01, -2.423658669e-01, -2.286538631e-01, -2.149855494e-01,
+	-2.013579160e-01, -1.877680719e-01, -1.742131859e-01, -1.606906205e-01,
+	-1.471976340e-01, -1.337315887e-01, -1.202898845e-01, -1.068699360e-01,
+	-9.346934408e-02, -8.008556068e-02, -6.671614200e-02, -5.335859954e-02,
+	-4.001063481e-02, -2.666980214e-02, -1.333371550e-02, 0.000000000e+00,
+	1.333371550e-02, 2.666980214e-02, 4.001075402e-02, 5.335871875e-02,
+	6.671620160e-02, 8.008562028e-02, 9.346940368e-02, 1.068699956e-01,
+	1.202898845e-01, 1.337315887e-01, 1.471976340e-01, 1.606907398e-01,
+	1.742133051e-01, 1.877681315e-01, 2.013579756e-01, 2.149856091e-01,
+	2.286539227e-01, 2.423658669e-01, 2.561244369e-01, 2.699327767e-01,
+	2.837940753e-01, 2.977117896e-01, 3.116890490e-01, 3.257295489e-01,
+	3.398369551e-01, 3.540150821e-01, 3.682679236e-01, 3.825995624e-01,
+	3.970143497e-01, 4.115168154e-01, 4.261117876e-01, 4.408039749e-01,
+	4.555987418e-01, 4.705015421e-01, 4.855181575e-01, 5.006547570e-01,
+	5.159177184e-01, 5.313140154e-01, 5.468509197e-01, 5.625363588e-01,
+	5.783783197e-01, 5.943858624e-01, 6.105685830e-01, 6.269366145e-01,
+	6.435011625e-01, 6.602740884e-01, 6.772683859e-01, 6.944982409e-01,
+	7.119791508e-01, 7.297277451e-01, 7.477627397e-01, 7.661045790e-01,
+	7.847759724e-01, 8.038023710e-01, 8.232120275e-01, 8.430368304e-01,
+	8.633130789e-01, 8.840821981e-01, 9.053912163e-01, 9.272953272e-01,
+	9.498588443e-01, 9.731578231e-01, 9.972832799e-01, 1.022345781e+00,
+	1.048481464e+00, 1.075862169e+00, 1.104708910e+00, 1.135314226e+00,
+	1.168080688e+00, 1.203588486e+00, 1.242728591e+00, 1.287002325e+00,
+	1.339339972e+00, 1.407315135e+00
+};
+
+//IQ decimation 1st stage 848.5 -> 424.2 kHz - half band, Kaiser window 60 dB (pass 105 kHz, every other tap is zero)
+const float IQ_HB1[IQ_HB1_TAPS] =
+{
+	-9.680890944e-04, 1.848879777e-18, 1.432811376e-02, -7.919379208e-18,
+	-6.515222788e-02, 1.577072943e-17, 3.019629419e-01, 4.996585250e-01,
+	3.019629419e-01, 1.577072943e-17, -6.515222788e-02, -7.919379208e-18,
+	1.432811376e-02, 1.848879777e-18, -9.680890944e-04
+};
+
+//IQ decimation 2nd stage 424.2 -> 212.1 kHz - half band, Kaiser window 50 dB (pass 75 kHz, every other tap is zero)
+const float IQ_HB2[IQ_HB2_TAPS] =
+{
+	-2.523012692e-03, 3.140978287e-18, 1.985105127e-02, -9.616065611e-18,
+	-7.230213284e-02, 1.649259506e-17, 3.052282631e-01, 4.994916618e-01,
+	3.052282631e-01, 1.649259506e-17, -7.230213284e-02, -9.616065611e-18,
+	1.985105127e-02, 3.140978287e-18, -2.523012692e-03
+};
+
+//IQ channel filter low pass 3 kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (6 kHz channel)
+const float IQ_IIR_3k[IQ_IIR_COEFFS] =
+{
+	2.855338098e-04, 5.710676196e-04, 2.855338098e-04, -1.948562741e+00,
+	9.497724771e-01, 1.143384492e-03, 2.286768984e-03, 1.143384492e-03,
+	-1.958439350e+00, 9.630128741e-01, 2.004340524e-03, 4.008681048e-03,
+	2.004340524e-03, -1.978295445e+00, 9.863128066e-01
+};
+
+//IQ channel filter low pass 6 kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (12 kHz channel)
+const float IQ_IIR_6k[IQ_IIR_COEFFS] =
+{
+	1.117469743e-03, 2.234939486e-03, 1.117469743e-03, -1.897174001e+00,
+	9.019086957e-01, 4.492763896e-03, 8.985527791e-03, 4.492763896e-03,
+	-1.909504771e+00, 9.274758697e-01, 7.946518250e-03, 1.589303650e-02,
+	7.946518250e-03, -1.941135049e+00, 9.729210734e-01
+};
+
+//IQ channel filter low pass 10 kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (20 kHz channel)
+const float IQ_IIR_10k[IQ_IIR_COEFFS] =
+{
+	3.026872640e-03, 6.053745281e-03, 3.026872640e-03, -1.828505516e+00,
+	8.413304687e-01, 1.220074855e-02, 2.440149710e-02, 1.220074855e-02,
+	-1.833582640e+00, 8.823856711e-01, 2.177171595e-02, 4.354343191e-02,
+	2.177171595e-02, -1.868608236e+00, 9.556950927e-01
+};
+
+//IQ channel filter low pass 15 kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (30 kHz channel)
+const float IQ_IIR_15k[IQ_IIR_COEFFS] =
+{
+	6.639961153e-03, 1.327992231e-02, 6.639961153e-03, -1.741967201e+00,
+	7.701008320e-01, 2.673700266e-02, 5.347400531e-02, 2.673700266e-02,
+	-1.722813010e+00, 8.297610879e-01, 4.800813645e-02, 9.601627290e-02,
+	4.800813645e-02, -1.743439794e+00, 9.354722500e-01
+};
+
+//IQ channel filter low pass 30 kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (60 kHz channel)
+const float IQ_IIR_30k[IQ_IIR_COEFFS] =
+{
+	2.561203390e-02, 5.122406781e-02, 2.561203390e-02, -1.470714688e+00,
+	5.792332292e-01, 1.001082063e-01, 2.002164125e-01, 1.001082063e-01,
+	-1.297125697e+00, 6.975585818e-01, 1.775555760e-01, 3.551111519e-01,
+	1.775555760e-01, -1.176539898e+00, 8.867622614e-01
+};
+
+//IQ channel filter low pass 60 kHz at 212.1 kHz - 6th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (120 kHz channel)
+const float IQ_IIR_60k[IQ_IIR_COEFFS] =
+{
+	1.151141673e-01, 2.302283347e-01, 1.151141673e-01, -7.809808254e-01,
+	2.687212527e-01, 3.700475991e-01, 7.400951982e-01, 3.700475991e-01,
+	-8.750880510e-02, 5.676992536e-01, 5.655370355e-01, 1.131074071e+00,
+	5.655370355e-01, 4.016162753e-01, 8.605319262e-01
+};
+
+//WFM audio decimation 1st stage 212.1 -> 53.0 kHz - Kaiser window, fc=22 kHz
+const float WFM_FIR1[WFM_FIR1_TAPS] =
+{
+	7.695899112e-04, 2.547628013e-03, 4.308650270e-03, 3.866697196e-03,
+	-1.005716156e-03, -1.059987675e-02, -2.154496685e-02, -2.672218718e-02,
+	-1.758354157e-02, 1.171010546e-02, 6.024702638e-02, 1.187543198e-01,
+	1.718205959e-01, 2.034316808e-01, 2.034316808e-01, 1.718205959e-01,
+	1.187543198e-01, 6.024702638e-02, 1.171010546e-02, -1.758354157e-02,
+	-2.672218718e-02, -2.154496685e-02, -1.059987675e-02, -1.005716156e-03,
+	3.866697196e-03, 4.308650270e-03, 2.547628013e-03, 7.695899112e-04
+};
+
+//WFM audio decimation 2nd stage 53.0 -> 26.5 kHz - Kaiser window, fc=13.25 kHz (pass 11.5 kHz, stop 15 kHz)
+const float WFM_FIR2[WFM_FIR2_TAPS] =
+{
+	-5.434800987e-04, -8.039705572e-04, 1.203732332e-03, 1.593692112e-03,
+	-2.197356196e-03, -2.754702698e-03, 3.618446179e-03, 4.393264186e-03,
+	-5.587190855e-03, -6.651105359e-03, 8.271479048e-03, 9.737087414e-03,
+	-1.193401217e-02, -1.399814151e-02, 1.704198867e-02, 2.009344287e-02,
+	-2.455499023e-02, -2.949282341e-02, 3.684274852e-02, 4.630553722e-02,
+	-6.174865738e-02, -8.788460493e-02, 1.491512805e-01, 4.498983324e-01,
+	4.498983324e-01, 1.491512805e-01, -8.788460493e-02, -6.174865738e-02,
+	4.630553722e-02, 3.684274852e-02, -2.949282341e-02, -2.455499023e-02,
+	2.009344287e-02, 1.704198867e-02, -1.399814151e-02, -1.193401217e-02,
+	9.737087414e-03, 8.271479048e-03, -6.651105359e-03, -5.587190855e-03,
+	4.393264186e-03, 3.618446179e-03, -2.754702698e-03, -2.197356196e-03,
+	1.593692112e-03, 1.203732332e-03, -8.039705572e-04, -5.434800987e-04
+};
+
+//RDS 57 kHz band pass decimation 212.1 -> 26.5 kHz (real part) - Kaiser window low pass fc=12 kHz shifted to 57 kHz
+const float RDS_FIR1_I[RDS_FIR1_TAPS] =
+{
+	-7.925271639e-04, 2.252906415e-04, 3.384148004e-03, -1.772155287e-03,
+	-5.570550915e-03, 3.322817851e-03, 2.595559927e-03, 1.718419604e-03,
+	6.950632669e-03, -2.174963988e-02, -1.584869996e-02, 5.696063116e-02,
+	1.229221560e-02, -9.318190813e-02, 7.928465493e-03, 1.096040308e-01,
+	-3.412858024e-02, -9.575331956e-02, 4.840917513e-02, 6.088018045e-02,
+	-4.168935120e-02, -2.565362304e-02, 2.121414989e-02, 4.993731156e-03,
+	-2.224914730e-03, 6.839035195e-04, -5.969665479e-03, 2.075021330e-04,
+	5.071254913e-03, -9.227794362e-04, -1.779123559e-03, 3.824261075e-04
+};
+
+//RDS 57 kHz band pass decimation 212.1 -> 26.5 kHz (imaginary part)
+const float RDS_FIR1_Q[RDS_FIR1_TAPS] =
+{
+	-0.000000000e+00, -1.907137339e-03, 8.108558832e-04, 4.813614301e-03,
+	-2.832042053e-03, -4.985047504e-03, 2.210780745e-03, -1.593503868e-03,
+	9.530697949e-03, 1.223815139e-02, -3.802060336e-02, -1.621645130e-02,
+	7.628000528e-02, 3.933408298e-03, -1.049551964e-01, 2.141832933e-02,
+	1.063345149e-01, -4.370075092e-02, -7.971757650e-02, 4.757458717e-02,
+	4.206524417e-02, -3.222792596e-02, -1.314454433e-02, 1.068682130e-02,
+	7.361894823e-04, 3.340173280e-03, 5.048844614e-04, -6.245674100e-03,
+	7.705769385e-04, 3.355357330e-03, -7.229439798e-04, -6.941538886e-04
+};
+
+//RDS decimation 2nd stage 26.5 -> 13.3 kHz - Kaiser window, fc=3.7 kHz (pass 2.4 kHz, stop 5 kHz)
+const float RDS_FIR2[RDS_FIR2_TAPS] =
+{
+	9.756239597e-04, 3.130877158e-04, -2.346174093e-03, -5.356749054e-03,
+	-4.746687133e-03, 2.350725699e-03, 1.310527883e-02, 1.811065897e-02,
+	7.484055124e-03, -1.876767911e-02, -4.448574781e-02, -4.297494516e-02,
+	5.984189454e-03, 9.842793643e-02, 2.018217444e-01, 2.701046765e-01,
+	2.701046765e-01, 2.018217444e-01, 9.842793643e-02, 5.984189454e-03,
+	-4.297494516e-02, -4.448574781e-02, -1.876767911e-02, 7.484055124e-03,
+	1.811065897e-02, 1.310527883e-02, 2.350725699e-03, -4.746687133e-03,
+	-5.356749054e-03, -2.346174093e-03, 3.130877158e-04, 9.756239597e-04
+};
+
+//RDS biphase symbol matched filter at 13.3 kHz - one period of sine per bit (11.16 samples)
+const float RDS_MF[RDS_MF_TAPS] =
+{
+	-5.122410133e-02, -1.374090165e-01, -1.799675375e-01, -1.653876305e-01,
+	-9.829833359e-02, 1.030098009e-16, 9.829833359e-02, 1.653876305e-01,
+	1.799675375e-01, 1.374090165e-01, 5.122410133e-02
+};
+
+//SSB I/Q decimation 212.1 -> 26.5 kHz - Kaiser window, fc=12 kHz (pass 3.5 kHz, stop 22.5 kHz)
+const float SSB_FIR1[SSB_FIR1_TAPS] =
+{
+	-7.925271639e-04, -1.920398092e-03, -3.479934530e-03, -5.129465368e-03,
+	-6.249119993e-03, -5.990977865e-03, -3.409469500e-03, 2.343548695e-03,
+	1.179599483e-02, 2.495634556e-02, 4.119159654e-02, 5.922403932e-02,
+	7.726407796e-02, 9.326489270e-02, 1.052542329e-01, 1.116771623e-01,
+	1.116771623e-01, 1.052542329e-01, 9.326489270e-02, 7.726407796e-02,
+	5.922403932e-02, 4.119159654e-02, 2.495634556e-02, 1.179599483e-02,
+	2.343548695e-03, -3.409469500e-03, -5.990977865e-03, -6.249119993e-03,
+	-5.129465368e-03, -3.479934530e-03, -1.920398092e-03, -7.925271639e-04
+};
+
+//SSB Weaver low pass 1.20 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (2.4 kHz audio bandwidth)
+const float SSB_IIR_2k4[SSB_IIR_COEFFS] =
+{
+	1.599981100e-03, 3.199962201e-03, 1.599981100e-03, -1.875275373e+00,
+	8.820545077e-01, 6.929238793e-03, 1.385847759e-02, 6.929238793e-03,
+	-1.871915340e+00, 8.996322751e-01, 1.445665117e-02, 2.891330235e-02,
+	1.445665117e-02, -1.874483109e+00, 9.323097467e-01, 2.006835490e-02,
+	4.013670981e-02, 2.006835490e-02, -1.895553589e+00, 9.758270383e-01
+};
+
+//SSB Weaver low pass 1.35 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (2.7 kHz audio bandwidth)
+const float SSB_IIR_2k7[SSB_IIR_COEFFS] =
+{
+	2.016287530e-03, 4.032575060e-03, 2.016287530e-03, -1.859576464e+00,
+	8.681194782e-01, 8.729609661e-03, 1.745921932e-02, 8.729609661e-03,
+	-1.852888703e+00, 8.878071904e-01, 1.821356267e-02, 3.642712533e-02,
+	1.821356267e-02, -1.851477265e+00, 9.243314862e-01, 2.531493641e-02,
+	5.062987283e-02, 2.531493641e-02, -1.871684670e+00, 9.729444385e-01
+};
+
+//SSB Weaver low pass 1.50 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (3.0 kHz audio bandwidth)
+const float SSB_IIR_3k0[SSB_IIR_COEFFS] =
+{
+	2.479553688e-03, 4.959107377e-03, 2.479553688e-03, -1.843826294e+00,
+	8.543321490e-01, 1.073040348e-02, 2.146080695e-02, 1.073040348e-02,
+	-1.833213449e+00, 8.761351109e-01, 2.238356322e-02, 4.476712644e-02,
+	2.238356322e-02, -1.826941729e+00, 9.164759517e-01, 3.114334680e-02,
+	6.228669360e-02, 3.114334680e-02, -1.845530987e+00, 9.701044559e-01
+};
+
+//CW I/Q decimation 26.5 -> 3.3 kHz - Kaiser window, fc=1 kHz (pass 250 Hz, stop 2.5 kHz)
+const float CW_FIR2[CW_FIR2_TAPS] =
+{
+	-6.167128449e-04, -6.614756421e-04, -2.152114321e-04, 1.019636518e-03,
+	3.344725817e-03, 7.018596400e-03, 1.220615860e-02, 1.893304288e-02,
+	2.705322951e-02, 3.623709083e-02, 4.598429054e-02, 5.566225573e-02,
+	6.456680596e-02, 7.199764997e-02, 7.733861357e-02, 8.013129979e-02,
+	8.013129979e-02, 7.733861357e-02, 7.199764997e-02, 6.456680596e-02,
+	5.566225573e-02, 4.598429054e-02, 3.623709083e-02, 2.705322951e-02,
+	1.893304288e-02, 1.220615860e-02, 7.018596400e-03, 3.344725817e-03,
+	1.019636518e-03, -2.152114321e-04, -6.614756421e-04, -6.167128449e-04
+};
+
+//CW low pass 100 Hz at 3.3 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (200 Hz bandwidth)
+const float CW_IIR_200[CW_IIR_COEFFS] =
+{
+	2.806304256e-03, 5.612608511e-03, 2.806304256e-03, -1.839556217e+00,
+	8.514466286e-01, 9.216751903e-03, 1.843350381e-02, 9.216751903e-03,
+	-1.899195313e+00, 9.360622764e-01
+};
+
+//CW low pass 150 Hz at 3.3 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (300 Hz bandwidth)
+const float CW_IIR_300[CW_IIR_COEFFS] =
+{
+	6.109486334e-03, 1.221897267e-02, 6.109486334e-03, -1.759318948e+00,
+	7.852049470e-01, 2.032859437e-02, 4.065718874e-02, 2.032859437e-02,
+	-1.825024724e+00, 9.063391089e-01
+};
+
+//CW low pass 250 Hz at 3.3 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (500 Hz bandwidth)
+const float CW_IIR_500[CW_IIR_COEFFS] =
+{
+	1.601653732e-02, 3.203307465e-02, 1.601653732e-02, -1.598371267e+00,
+	6.662335992e-01, 5.409182608e-02, 1.081836522e-01, 5.409182608e-02,
+	-1.635913491e+00, 8.522807956e-01
+};
+
+//synchronous AM sideband low pass 2.5 kHz at 26.5 kHz - 8th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (5 kHz audio bandwidth)
+const float SAM_IIR[SAM_IIR_COEFFS] =
+{
+	6.779273041e-03, 1.355854608e-02, 6.779273041e-03, -1.736873269e+00,
+	7.655971050e-01, 2.912610210e-02, 5.825220421e-02, 2.912610210e-02,
+	-1.685614467e+00, 8.021189570e-01, 6.030964106e-02, 1.206192821e-01,
+	6.030964106e-02, -1.626309395e+00, 8.675479293e-01, 8.408572525e-02,
+	1.681714505e-01, 8.408572525e-02, -1.616150498e+00, 9.524934292e-01
+};
+
+//NBFM I/Q decimation 212.1 -> 53.0 kHz - Kaiser window, fc=26 kHz (pass 12.5 kHz, stop 39.5 kHz)
+const float NBFM_FIR1[NBFM_FIR1_TAPS] =
+{
+	8.278832538e-04, 3.370794002e-03, 5.488949362e-03, 2.758735325e-03,
+	-8.016344160e-03, -2.355633304e-02, -3.179130331e-02, -1.642317511e-02,
+	3.251247108e-02, 1.086287275e-01, 1.877820790e-01, 2.384175211e-01,
+	2.384175211e-01, 1.877820790e-01, 1.086287275e-01, 3.251247108e-02,
+	-1.642317511e-02, -3.179130331e-02, -2.355633304e-02, -8.016344160e-03,
+	2.758735325e-03, 5.488949362e-03, 3.370794002e-03, 8.278832538e-04
+};
+
+//NBFM channel filter and decimation 53.0 -> 26.5 kHz - Kaiser window, fc=6.5 kHz (pass 5.3 kHz, stop 7.7 kHz) for 12.5 kHz channels
+const float NBFM_FIR2_12k5[NBFM_FIR2_TAPS] =
+{
+	-4.304829636e-04, -7.796920836e-04, -6.938030710e-04, 5.689248428e-05,
+	1.237594173e-03, 2.115429379e-03, 1.835272531e-03, 5.885604332e-05,
+	-2.546798671e-03, -4.413492512e-03, -3.902110970e-03, -4.840054607e-04,
+	4.484760575e-03, 8.091609925e-03, 7.406532764e-03, 1.511152484e-03,
+	-7.250471506e-03, -1.387959998e-02, -1.329524629e-02, -3.689820878e-03,
+	1.132902503e-02, 2.351367660e-02, 2.392597124e-02, 8.403826505e-03,
+	-1.839279756e-02, -4.304970801e-02, -4.839985445e-02, -2.163293213e-02,
+	3.830702230e-02, 1.179908663e-01, 1.933986396e-01, 2.391736954e-01,
+	2.391736954e-01, 1.933986396e-01, 1.179908663e-01, 3.830702230e-02,
+	-2.163293213e-02, -4.839985445e-02, -4.304970801e-02, -1.839279756e-02,
+	8.403826505e-03, 2.392597124e-02, 2.351367660e-02, 1.132902503e-02,
+	-3.689820878e-03, -1.329524629e-02, -1.387959998e-02, -7.250471506e-03,
+	1.511152484e-03, 7.406532764e-03, 8.091609925e-03, 4.484760575e-03,
+	-4.840054607e-04, -3.902110970e-03, -4.413492512e-03, -2.546798671e-03,
+	5.885604332e-05, 1.835272531e-03, 2.115429379e-03, 1.237594173e-03,
+	5.689248428e-05, -6.938030710e-04, -7.796920836e-04, -4.304829636e-04
+};
+
+//NBFM channel filter and decimation 53.0 -> 26.5 kHz - Kaiser window, fc=10.5 kHz (pass 9.3 kHz, stop 11.7 kHz) for 25 kHz channels
+const float NBFM_FIR2_25k[NBFM_FIR2_TAPS] =
+{
+	5.592531525e-04, 1.894839661e-04, -8.761322242e-04, -1.054481138e-03,
+	5.770093994e-04, 2.113304101e-03, 7.830077666e-04, -2.512399340e-03,
+	-3.056606511e-03, 1.231723581e-03, 5.184164736e-03, 2.195281908e-03,
+	-5.393886007e-03, -6.948597729e-03, 2.042939188e-03, 1.068794169e-02,
+	5.170832854e-03, -1.019840129e-02, -1.423466485e-02, 2.875019331e-03,
+	2.073300071e-02, 1.149738301e-02, -1.892399043e-02, -2.947683260e-02,
+	3.560697660e-03, 4.372405261e-02, 2.887144126e-02, -4.294106737e-02,
+	-8.307757229e-02, 3.948448692e-03, 2.020607442e-01, 3.706888855e-01,
+	3.706888855e-01, 2.020607442e-01, 3.948448692e-03, -8.307757229e-02,
+	-4.294106737e-02, 2.887144126e-02, 4.372405261e-02, 3.560697660e-03,
+	-2.947683260e-02, -1.892399043e-02, 1.149738301e-02, 2.073300071e-02,
+	2.875019331e-03, -1.423466485e-02, -1.019840129e-02, 5.170832854e-03,
+	1.068794169e-02, 2.042939188e-03, -6.948597729e-03, -5.393886007e-03,
+	2.195281908e-03, 5.184164736e-03, 1.231723581e-03, -3.056606511e-03,
+	-2.512399340e-03, 7.830077666e-04, 2.113304101e-03, 5.770093994e-04,
+	-1.054481138e-03, -8.761322242e-04, 1.894839661e-04, 5.592531525e-04
+};
+
+//NBFM voice band pass 300 - 3000 Hz at 26.5 kHz - 6th order Chebyshev 0.5 dB high pass (CTCSS/DCS removal) and 4th order low pass, biquads {b0, b1, b2, a1, a2}
+const float NBFM_AUDIO_IIR[NBFM_AUDIO_COEFFS] =
+{
+	8.286100030e-01, -1.657220006e+00, 8.286100030e-01, -1.741277814e+00,
+	7.695550919e-01, 9.730324149e-01, -1.946064830e+00, 9.730324149e-01,
+	-1.941894054e+00, 9.502356052e-01, 9.934095144e-01, -1.986819029e+00,
+	9.934095144e-01, -1.984363198e+00, 9.892747998e-01, 3.400766104e-02,
+	6.801532209e-02, 3.400766104e-02, -1.394859672e+00, 5.389506817e-01,
+	1.147875190e-01, 2.295750380e-01, 1.147875190e-01, -1.336912632e+00,
+	7.960627079e-01
+};
+
+//NBFM noise squelch high pass 4.5 kHz at 26.5 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (discriminator noise above voice band)
+const float NBFM_NOISE_IIR[NBFM_NOISE_COEFFS] =
+{
+	2.793634534e-01, -5.587269068e-01, 2.793634534e-01, -1.343474351e-02,
+	1.702323854e-01, 6.569706202e-01, -1.313941240e+00, 6.569706202e-01,
+	-8.836021423e-01, 7.442802787e-01
+};
+
+//NBFM sub-audio low pass 270 Hz at 26.5 kHz - 4th order Chebyshev 0.5 dB, biquads {b0, b1, b2, a1, a2} (CTCSS/DCS before decimation to 1.66 kHz)
+const float NBFM_TONE_IIR[NBFM_TONE_COEFFS] =
+{
+	3.353688517e-04, 6.707377033e-04, 3.353688517e-04, -1.945837617e+00,
+	9.472585917e-01, 1.075885491e-03, 2.151770983e-03, 1.075885491e-03,
+	-1.973523378e+00, 9.778268933e-01
+};
+
+//data demodulators decimation 26.5 -> 13.3 kHz - Kaiser window, fc=6.5 kHz (pass 4.8 kHz, stop 8.2 kHz)
+const float DATA_FIR2[DATA_FIR2_TAPS] =
+{
+	-1.395280473e-03, -1.552817295e-03, 5.620744545e-03, 5.326474551e-03,
+	-1.401137840e-02, -1.362727676e-02, 2.916357480e-02, 3.112951480e-02,
+	-5.864711106e-02, -7.540703565e-02, 1.515892446e-01, 4.418113530e-01,
+	4.418113530e-01, 1.515892446e-01, -7.540703565e-02, -5.864711106e-02,
+	3.112951480e-02, 2.916357480e-02, -1.362727676e-02, -1.401137840e-02,
+	5.326474551e-03, 5.620744545e-03, -1.552817295e-03, -1.395280473e-03
+};
+
+//channelizer decimation 212.1 -> 106.1 kHz (all channels) and 53.0 -> 26.5 kHz - half band, Kaiser window 60 dB (pass 31.25 and 7.7 kHz, every other tap is zero)
+const float CHAN_HB[CHAN_HB_TAPS] =
+{
+	7.537779748e-04, -1.439561445e-18, -7.289176807e-03, 5.475920352e-18,
+	2.732196823e-02, -1.152757826e-17, -7.947602123e-02, 1.717746917e-17,
+	3.085881770e-01, 5.002025366e-01, 3.085881770e-01, 1.717746917e-17,
+	-7.947602123e-02, -1.152757826e-17, 2.732196823e-02, 5.475920352e-18,
+	-7.289176807e-03, -1.439561445e-18, 7.537779748e-04
+};
+
+//channelizer decimation 106.1 -> 53.0 kHz - half band, Kaiser window 60 dB (pass 7.7 kHz, stop 45.3 kHz, every other tap is zero)
+const float CHAN_HB_SHORT[CHAN_HB_SHORT_TAPS] =
+{
+	1.357025001e-03, -2.732834551e-18, -3.897801042e-02, 1.279185269e-17,
+	2.874782979e-01, 5.002853870e-01, 2.874782979e-01, 1.279185269e-17,
+	-3.897801042e-02, -2.732834551e-18, 1.357025001e-03
+};
+
+//channelizer channel filter at 26.5 kHz - Kaiser window, fc=6.5 kHz (pass 5.3 kHz, stop 7.7 kHz) for 12.5 kHz channels
+const float CHAN_FIR[CHAN_FIR_TAPS] =
+{
+	9.779332904e-04, 4.935507313e-04, -2.662376035e-03, -1.387897064e-03,
+	5.420462694e-03, 3.122170456e-03, -9.593087249e-03, -6.196136586e-03,
+	1.567010395e-02, 1.142297592e-02, -2.456770279e-02, -2.040217444e-02,
+	3.854572028e-02, 3.732258826e-02, -6.527791917e-02, -7.953540236e-02,
+	1.543861032e-01, 4.422610998e-01, 4.422610998e-01, 1.543861032e-01,
+	-7.953540236e-02, -6.527791917e-02, 3.732258826e-02, 3.854572028e-02,
+	-2.040217444e-02, -2.456770279e-02, 1.142297592e-02, 1.567010395e-02,
+	-6.196136586e-03, -9.593087249e-03, 3.122170456e-03, 5.420462694e-03,
+	-1.387897064e-03, -2.662376035e-03, 4.935507313e-04, 9.779332904e-04
+};
@@ -0,0 +1,219 @@
+/*
+ * enob.c - effective number of bits, SINAD and SFDR of a captured tone at ADC, CIC decimator and IQ filter outputs
+ *
+ * ADC callback copies raw ADC codes and I/Q after IQ filters once per enob command, the analysis runs in the console.
+ * Every path is windowed by 4-term Blackman-Harris (side lobes -92 dB), tone is the largest bin out of DC and its
+ * main lobe is the signal, the rest of the band is noise and distortion - ENOB = (SINAD + tone below full scale -
+ * 1.76)/6.02. Paths with narrower band show processing gain of oversampling: 0.5 bit per halving of the noise band.
+ * CIC paths decimate the captured ADC codes like a front-end at FS_ADC_Hz would do it - integer mixer with the NCO
+ * table of the frequency plan and N=3 CIC in wrap-around 32-bit accumulators (Q of NCO is lowered by CIC bit growth),
+ * so they show what integer decimation keeps compared to the float IQ filters of the DSP chain.
+ * Both CIC paths use +/-fs/16 band - the sum image of the mixer (twice IF alias) isn't rejected by short CIC and for
+ * R=2 it can alias close to +/-fs/8. The tone has to be off 0 Hz of the channel (more than ENOB_LOBE_BINS bins) and inside the bands of all paths.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "enob.h"
+#include "freq_plan.h"
+#include "cmd.h"
+#include "printf.h"
+
+extern IQ_Filter_enum IQ_Filter;
+
+#define ENOB_ADC_MID   2048 //mid scale code
+#define ENOB_ADC_BITS  11   //magnitude bits of ADC code without mid scale
+
+static const char *enob_path_name[ENOB_PATHS] = {"adc", "cic2", "cic4", "iir"}; //the same order like ENOB_Path_enum
+
+static int16_t Cap_adc[ENOB_WARMUP + ENOB_LEN];
+static float Re[ENOB_LEN], Im[ENOB_LEN]; //I/Q capture, then FFT of every path
+static volatile uint16_t Adc_fill = ENOB_WARMUP + ENOB_LEN, Bb_fill = ENOB_LEN; //full - no capture
+static ENOB_Result_TypeDef ENOB_Result[ENOB_PATHS];
+
+//ADC callback - raw ADC block
+void enob_capture_adc(const int16_t* samples, uint16_t n)
+{
+	uint16_t fill = Adc_fill;
+
+	if (fill >= ENOB_WARMUP + ENOB_LEN) return;
+	if (n > ENOB_WARMUP + ENOB_LEN - fill) n = ENOB_WARMUP + ENOB_LEN - fill;
+	memcpy(&Cap_adc[fill], samples, n*sizeof(int16_t));
+	Adc_fill = fill + n;
+}
+
+//ADC callback - I/Q block after IQ filters
+void enob_capture_bb(const float* I, const float* Q, uint16_t n)
+{
+	uint16_t fill = Bb_fill;
+
+	if (fill >= ENOB_LEN) return;
+	if (n > ENOB_LEN - fill) n = ENOB_LEN - fill;
+	memcpy(&Re[fill], I, n*sizeof(float));
+	memcpy(&Im[fill], Q, n*sizeof(float));
+	Bb_fill = fill + n;
+}
+
+//window, FFT and tone statistics in band - real input uses only 0...len/2 bins, fs_power is power of full scale sine
+static void enob_analyze(float* re, float* im, uint16_t len, bool real, float fs_Hz, float band_Hz, float fs_power,
+		ENOB_Result_TypeDef* r)
+{
+	const float bh[4] = {0.35875f, 0.48829f, 0.14128f, 0.01168f};
+	float w, x, w_pow = 0, scale, s = 0, nd = 0, peak = 0, spur = 0;
+	int16_t d, kb, peak_d = ENOB_LOBE_BINS + 1, bins = 0, nd_bins = 0;
+	uint16_t k;
+
+	for (k = 0; k < len; k++)
+	{
+		x = 2.0*M_PI*k/len;
+		w = bh[0] - bh[1]*cosf(x) + bh[2]*cosf(2*x) - bh[3]*cosf(3*x);
+		re[k] *= w;
+		im[k] *= w;
+		w_pow += w*w;
+	}
+	fft_cplx(re, im, len);
+
+	//bin powers - they sum to mean power of samples
+	scale = 1.0f/(len*w_pow);
+	for (k = 0; k < len; k++) re[k] = (re[k]*re[k] + im[k]*im[k])*scale;
+	if (real)
+		for (k = 1; k < len/2; k++) re[k] *= 2; //negative frequencies are the same
+
+	kb = (int16_t) (band_Hz*len/fs_Hz);
+	if (kb > (int16_t) len/2 - 1) kb = len/2 - 1;
+
+	for (d = real ? 0 : -kb; d <= kb; d++)
+	{
+		if (abs(d) <= ENOB_LOBE_BINS) continue; //DC offset and LO leakage
+		if (re[(uint16_t) d & (len - 1)] > peak)
+		{
+			peak = re[(uint16_t) d & (len - 1)];
+			peak_d = d;
+		}
+	}
+	for (d = real ? 0 : -kb; d <= kb; d++)
+	{
+		x = re[(uint16_t) d & (len - 1)];
+		bins++;
+		if (abs(d) <= ENOB_LOBE_BINS) continue;
+		if (abs(d - peak_d) <= ENOB_LOBE_BINS) s += x;
+		else
+		{
+			nd += x;
+			nd_bins++;
+			if (x > spur) spur = x;
+		}
+	}
+	s += 1.0e-30f;
+	nd = nd*bins/(nd_bins + 1.0e-30f) + 1.0e-30f; //noise under DC and tone lobes is the average of the other bins
+
+	r->fs_Hz = fs_Hz;
+	r->band_Hz = (float) kb*fs_Hz/len;
+	r->tone_Hz = (float) peak_d*fs_Hz/len;
+	r->tone_dBFS = 10*log10f(s/fs_power);
+	r->sinad_dB = 10*log10f(s/nd);
+	r->sfdr_dB = 10*log10f(peak/(spur + 1.0e-30f));
+	r->enob = (r->sinad_dB - r->tone_dBFS - 1.76f)/6.02f;
+}
+
+//integer mixer and CIC decimator by r (power of 2) of captured ADC codes - output is scaled like I/Q of DSP chain
+static uint16_t enob_cic(uint8_t r, float* re, float* im)
+{
+	uint32_t acc_i[ENOB_CIC_N] = {0}, acc_q[ENOB_CIC_N] = {0}, dly_i[ENOB_CIC_N] = {0}, dly_q[ENOB_CIC_N] = {0};
+	uint32_t y_i, y_q, t;
+	int32_t nco_cos[FP_NCO_MAX], nco_sin[FP_NCO_MAX], x;
+	uint8_t log2r = 0, q, j, s, nco_len = NCO_len;
+	uint16_t k, m = 0;
+	float out_scale;
+
+	while ((1 << log2r) < r) log2r++;
+	q = ENOB_CIC_BITS - ENOB_ADC_BITS - ENOB_CIC_N*log2r; //NCO fraction bits - CIC output fits in ENOB_CIC_BITS
+	out_scale = 1.0f/((float) (1UL << (q + ENOB_CIC_N*log2r))*2047.5f);
+	for (j = 0; j < nco_len; j++)
+	{
+		nco_cos[j] = lrintf(NCO_cos[j]*(1UL << q));
+		nco_sin[j] = lrintf(NCO_sin[j]*(1UL << q));
+	}
+
+	j = 0;
+	for (k = 0; k < ENOB_WARMUP + ENOB_LEN; k++)
+	{
+		x = Cap_adc[k] - ENOB_ADC_MID;
+		acc_i[0] += (uint32_t) (x*nco_cos[j]);
+		acc_q[0] += (uint32_t) (x*nco_sin[j]);
+		if (++j >= nco_len) j = 0;
+		for (s = 1; s < ENOB_CIC_N; s++)
+		{
+			acc_i[s] += acc_i[s-1];
+			acc_q[s] += acc_q[s-1];
+		}
+		if ((k & (r - 1)) != r - 1) continue;
+
+		y_i = acc_i[ENOB_CIC_N-1];
+		y_q = acc_q[ENOB_CIC_N-1];
+		for (s = 0; s < ENOB_CIC_N; s++)
+		{
+			t = y_i; y_i -= dly_i[s]; dly_i[s] = t;
+			t = y_q; y_q -= dly_q[s]; dly_q[s] = t;
+		}
+		if (k >= ENOB_WARMUP)
+		{
+			re[m] = (int32_t) y_i*out_scale;
+			im[m] = (int32_t) y_q*out_scale;
+			m++;
+		}
+	}
+	return m;
+}
+
+void enob_measure(void)
+{
+	uint32_t tick;
+	uint16_t k, m;
+	uint8_t p;
+	float band;
+
+	Adc_fill = 0;
+	Bb_fill = 0;
+	tick = HAL_GetTick();
+	while ( (Adc_fill < ENOB_WARMUP + ENOB_LEN) || (Bb_fill < ENOB_LEN) )
+	{
+		if (HAL_GetTick() - tick > ENOB_TIMEOUT_ms)
+		{
+			Adc_fill = ENOB_WARMUP + ENOB_LEN;
+			Bb_fill = ENOB_LEN;
+			UART_printf("enob - capture timeout\r\n");
+			return;
+		}
+	}
+
+	//DSP chain I/Q first - Re and Im are its capture buffer
+	band = fminf(IQ_Filter_bw_Hz[IQ_Filter], 0.45f*FS_BB_Hz);
+	enob_analyze(Re, Im, ENOB_LEN, false, FS_BB_Hz, band, 0.25f, &ENOB_Result[ENOB_IIR]);
+
+	for (k = 0; k < ENOB_LEN; k++)
+	{
+		Re[k] = (Cap_adc[ENOB_WARMUP + k] - 2047.5f)*(1.0f/2047.5f);
+		Im[k] = 0;
+	}
+	enob_analyze(Re, Im, ENOB_LEN, true, FS_ADC_Hz, FS_ADC_Hz/2, 0.5f, &ENOB_Result[ENOB_ADC]);
+
+	m = enob_cic(2, Re, Im);
+	enob_analyze(Re, Im, m, false, FS_ADC_Hz/2, FS_ADC_Hz/16, 0.25f, &ENOB_Result[ENOB_CIC2]);
+
+	m = enob_cic(4, Re, Im);
+	enob_analyze(Re, Im, m, false, FS_ADC_Hz/4, FS_ADC_Hz/16, 0.25f, &ENOB_Result[ENOB_CIC4]);
+
+	UART_printf("path  fs [kHz]  band [kHz]  tone [kHz]  tone [dBFS]  SINAD [dB]  SFDR [dBc]   ENOB  gain (ideal) [bits]\r\n");
+	for (p = 0; p < ENOB_PATHS; p++)
+	{
+		ENOB_Result_TypeDef* r = &ENOB_Result[p];
+		//ideal gain - white noise in 0...fs/2 of ADC and in +/-band of I/Q paths
+		float ideal = (p == ENOB_ADC) ? 0 : 0.5f*log2f(ENOB_Result[ENOB_ADC].band_Hz/(2*r->band_Hz));
+
+		UART_printf("%-5s %8.1f %s%9.1f %11.2f %12.1f %11.1f %11.1f %6.2f %5.2f (%.2f)\r\n", enob_path_name[p],
+				r->fs_Hz/1.0e3, (p == ENOB_ADC) ? "   " : "+/-", r->band_Hz/1.0e3, r->tone_Hz/1.0e3, r->tone_dBFS,
+				r->sinad_dB, r->sfdr_dB, r->enob, r->enob - ENOB_Result[ENOB_ADC].enob, ideal);
+	}
+}
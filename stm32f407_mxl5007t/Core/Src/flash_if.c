@@ -0,0 +1,58 @@
+/*
+ * flash_if.c - internal flash erase/program routines for data stored in reserved sectors
+ *
+ * Note that CPU is stalled during sector erase if code is fetched from the same flash bank
+ * (up to 2 s for 128K sector) so ADC callbacks are also stalled and audio is interrupted - the ADC blocks
+ * overwritten during the stall are added to ADC overruns here, so every caller's dropout is visible in perf.
+ */
+#include <string.h>
+#include "flash_if.h"
+
+uint32_t Flash_erase_ms; //duration of the last sector erase
+
+bool flash_erase_sector(uint32_t sector)
+{
+	FLASH_EraseInitTypeDef EraseInit;
+	uint32_t SectorError;
+	HAL_StatusTypeDef status;
+	uint32_t tick;
+
+	EraseInit.TypeErase = FLASH_TYPEERASE_SECTORS;
+	EraseInit.Banks = FLASH_BANK_1;
+	EraseInit.Sector = sector;
+	EraseInit.NbSectors = 1;
+	EraseInit.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+	tick = HAL_GetTick();
+	HAL_FLASH_Unlock();
+	status = HAL_FLASHEx_Erase(&EraseInit, &SectorError);
+	HAL_FLASH_Lock();
+	Flash_erase_ms = HAL_GetTick() - tick;
+
+	__disable_irq();
+	ADC_overruns += (uint32_t) (Flash_erase_ms*(FS_ADC_Hz/1000.0)/ADC_BLOCK); //blocks overwritten during the stall
+	__enable_irq();
+
+	return status == HAL_OK;
+}
+
+//addr and len have to be multiple of 4
+bool flash_program(uint32_t addr, const void* data, uint32_t len)
+{
+	const uint8_t* src = data;
+	uint32_t word;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	HAL_FLASH_Unlock();
+	while ( (len >= 4) && (status == HAL_OK) )
+	{
+		memcpy(&word, src, 4);
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, word);
+		addr += 4;
+		src += 4;
+		len -= 4;
+	}
+	HAL_FLASH_Lock();
+
+	return status == HAL_OK;
+}
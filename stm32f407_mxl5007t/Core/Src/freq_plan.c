@@ -0,0 +1,182 @@
+/*
+ * freq_plan.c - IF plan: tuner IF selection, IF after band pass sampling, mixer NCO table and validation
+ *
+ * Tuner IF is band pass sampled by ADC: IF/fs = zone + frac, the IF is seen at frac*fs (even zone pair half) or
+ * (1 - frac)*fs with inverted spectrum - then the tuner inverts its IF spectrum, so the DSP chain is the same.
+ * The channel has to stay clear of 0 Hz and fs/2 (its own image and the next zone) by IQ filter bandwidth and guard.
+ * Mixer table has nco_len samples with nco_step periods of the IF - the shortest table within FP_NCO_ERR_Hz is taken
+ * (4.5 MHz at 848.5 kHz gives 257.6 kHz and 33/10 table, 459 Hz low).
+ * This is an IF selector only - the sample rate is fixed at FS_ADC_Hz (TIM3 reload from .ioc), because decimation
+ * filters and DSP tables are generated for it and ADC_BLOCK/ADC_DECIM are compile time constants.
+ */
+#include <math.h>
+#include "freq_plan.h"
+#include "MxL5007_API.h"
+#include "MxL_User_Define.h"
+#include "cmd.h"
+#include "printf.h"
+
+extern MxL5007_TunerConfigS myTuner;
+extern volatile bool DSP_Mute;
+extern float Total_Gain_curr;
+extern Output_demod_type_enum Demod_Type;
+
+const FP_Spec_TypeDef fp_specs[FP_PLANS] =
+{
+	{"4.5",      MxL_IF_4_5_MHZ}, //default - the first one, so settings without plan read it
+	{"4",        MxL_IF_4_MHZ},
+	{"5.38",     MxL_IF_5_38_MHZ},
+	{"9.19",     MxL_IF_9_1915_MHZ},
+	{"6",        MxL_IF_6_MHZ},   //narrow modes only
+	{"36.15",    MxL_IF_36_15_MHZ}
+};
+
+static const char *fp_error_name[FP_ERRORS] = {"ok", "IF too high", "alias", "NCO error"};
+
+FP_Plan_TypeDef FP_Plan;
+static uint8_t FP_Active;
+
+//two buffers - the new table is written to the one ADC callback doesn't use
+static float NCO_table[2][2][FP_NCO_MAX];
+static uint8_t NCO_buf;
+const float *NCO_sin = NCO_table[0][0], *NCO_cos = NCO_table[0][1];
+uint8_t NCO_len = 1;
+
+void fp_compute(const FP_Spec_TypeDef* spec, FP_Plan_TypeDef* p)
+{
+	double frac, err;
+	uint8_t n, step;
+
+	p->fs_Hz = FS_ADC_Hz;
+	frac = spec->if_Hz/p->fs_Hz;
+	frac -= floor(frac);
+	p->inverted = frac > 0.5;
+	p->alias_Hz = (p->inverted ? 1.0 - frac : frac)*p->fs_Hz;
+	p->margin_Hz = fmin(p->alias_Hz, p->fs_Hz/2 - p->alias_Hz);
+	p->fs_bb_Hz = p->fs_Hz/ADC_DECIM;
+	p->zones = (uint8_t) ceil(FP_IF_BW_Hz/(p->fs_Hz/2));
+	p->wide = p->margin_Hz >= FP_WIDE_Hz + FP_GUARD_Hz;
+
+	//the shortest table within FP_NCO_ERR_Hz, otherwise the most accurate one
+	p->nco_len = 1;
+	p->nco_step = 0;
+	p->nco_err_Hz = -p->alias_Hz;
+	for (n = 2; n <= FP_NCO_MAX; n++)
+	{
+		step = (uint8_t) (p->alias_Hz/p->fs_Hz*n + 0.5);
+		err = p->fs_Hz*step/n - p->alias_Hz;
+		if (fabs(err) < fabs(p->nco_err_Hz))
+		{
+			p->nco_len = n;
+			p->nco_step = step;
+			p->nco_err_Hz = err;
+			if (fabs(err) <= FP_NCO_ERR_Hz) break;
+		}
+	}
+
+	if (spec->if_Hz > FP_IF_MAX_Hz) p->error = FP_ERR_IF;
+	else if (p->margin_Hz < FP_NARROW_Hz + FP_GUARD_Hz) p->error = FP_ERR_ALIAS;
+	else if (fabs(p->nco_err_Hz) > FP_NCO_ERR_Hz) p->error = FP_ERR_NCO;
+	else p->error = FP_OK;
+}
+
+//table is computed in unused buffer and switched with interrupts disabled - ADC callback takes it at block start
+static void fp_set_nco(const FP_Plan_TypeDef* p)
+{
+	uint8_t k, buf = NCO_buf ^ 1;
+	float w = 2*M_PI*p->nco_step/p->nco_len;
+
+	for (k = 0; k < p->nco_len; k++)
+	{
+		NCO_table[buf][0][k] = sinf(w*k);
+		NCO_table[buf][1][k] = cosf(w*k);
+	}
+
+	__disable_irq();
+	NCO_sin = NCO_table[buf][0];
+	NCO_cos = NCO_table[buf][1];
+	NCO_len = p->nco_len;
+	NCO_buf = buf;
+	__enable_irq();
+}
+
+static void fp_set_tuner_if(const FP_Spec_TypeDef* spec, const FP_Plan_TypeDef* p)
+{
+	myTuner.IF_Freq = spec->if_Hz;
+	myTuner.IF_Spectrum = p->inverted ? MxL_INVERT_IF : MxL_NORMAL_IF;
+}
+
+//at startup, before tuner initialization - invalid plan from settings falls back to the default one
+void fp_init(uint8_t plan)
+{
+	if (plan >= FP_PLANS) plan = 0;
+	fp_compute(&fp_specs[plan], &FP_Plan);
+	if (FP_Plan.error != FP_OK)
+	{
+		plan = 0;
+		fp_compute(&fp_specs[plan], &FP_Plan);
+	}
+	FP_Active = plan;
+	fp_set_tuner_if(&fp_specs[plan], &FP_Plan);
+	fp_set_nco(&FP_Plan);
+}
+
+//at run time - tuner is initialized again with the new IF and tuned to the same frequency
+bool fp_select(uint8_t plan)
+{
+	FP_Plan_TypeDef p;
+	MxL_ERR_MSG MxL_Status;
+	uint32_t freq_Hz = myTuner.RF_Freq_Hz;
+	bool mute = DSP_Mute;
+
+	if (plan >= FP_PLANS) return false;
+	fp_compute(&fp_specs[plan], &p);
+	if (p.error != FP_OK)
+	{
+		UART_printf("plan %s can't be used: %s\r\n", fp_specs[plan].name, fp_error_name[p.error]);
+		return false;
+	}
+
+	DSP_Mute = true;
+	fp_set_nco(&p);
+	FP_Plan = p;
+	FP_Active = plan;
+	fp_set_tuner_if(&fp_specs[plan], &p);
+
+	MxL_Status = MxL_Tuner_Init(&myTuner);
+	if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+	MxL_Status = MxL_Tuner_RFTune(&myTuner, freq_Hz, MxL_BW_6MHz);
+	if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+	set_total_gain(Total_Gain_curr);
+	set_IQ_filters_coeff(Demod_Type); //wide filter may not fit the new plan
+	DSP_Mute = mute;
+	return true;
+}
+
+uint8_t fp_active(void)
+{
+	return FP_Active;
+}
+
+//IQ filter with bw_Hz cut-off keeps the channel clear of 0 Hz and fs/2 in the active plan
+bool fp_fits(float bw_Hz)
+{
+	return FP_Plan.margin_Hz >= bw_Hz + FP_GUARD_Hz;
+}
+
+void fp_print(void)
+{
+	FP_Plan_TypeDef p;
+	uint8_t i;
+
+	UART_printf("   plan      IF[MHz] alias[kHz] inv NCO   err[Hz] margin[kHz] zones IQ   status\r\n");
+	for (i = 0; i < FP_PLANS; i++)
+	{
+		fp_compute(&fp_specs[i], &p);
+		UART_printf("%c%d %-9s %7.4f %10.2f %3s %2d/%-2d %7.0f %11.1f %5d %-4s %s\r\n", (i == FP_Active) ? '*' : ' ', i,
+				fp_specs[i].name, fp_specs[i].if_Hz/1.0e6, p.alias_Hz/1.0e3, p.inverted ? "yes" : "no",
+				p.nco_step, p.nco_len, p.nco_err_Hz, p.margin_Hz/1.0e3, p.zones, p.wide ? "wide" : "15k", fp_error_name[p.error]);
+	}
+	UART_printf("fs %.2f kHz (fixed) ; fs_bb %.2f kHz (ADC_DECIM %d) ; IQ filters: wide %.0f kHz (FM, WFM), narrow %.0f kHz ; guard %.0f kHz\r\n",
+			FP_Plan.fs_Hz/1.0e3, FP_Plan.fs_bb_Hz/1.0e3, ADC_DECIM, FP_WIDE_Hz/1.0e3, FP_NARROW_Hz/1.0e3, FP_GUARD_Hz/1.0e3);
+}
@@ -0,0 +1,109 @@
+/*
+ * iq_corr.c - ADC DC offset removal and I/Q gain/phase imbalance estimation and correction
+ *
+ * DC offset: mean of every scaled ADC block (it's summed in the scaling loop) is averaged and, when dc_block is on,
+ * subtracted by the scaling itself (B_ADC_scale - offset), so it costs one addition per sample. Without it the IF
+ * amplifier offset is a tone at the IF alias after mixing and it raises noise blanker average.
+ * I/Q imbalance: block powers and correlation of I and Q (without block mean - carrier at 0 Hz) are averaged, gain is
+ * sqrt(Pqq/Pii) and phase error asin(Piq/sqrt(Pii*Pqq)). Correction makes Q orthogonal to I and of the same power:
+ * Q' = c1*(Q + c2*I), c2 = -Piq/Pii, c1 = sqrt(Pii/(Pqq - Piq^2/Pii)). Mixer is digital, so the imbalance should be
+ * small - estimation assumes circular signal (noise, FM, SSB), AM carrier with fixed phase misleads it, so correction
+ * is off by default. Estimates aren't reset on retune or plan change - they belong to ADC and IF amplifier.
+ */
+#include <math.h>
+#include "iq_corr.h"
+#include "printf.h"
+
+IQC_Config_TypeDef IQC_Config =
+{
+	.dc_block = true,
+	.corr = false
+};
+
+float IQC_DC_applied;
+
+static float DC_est;            //ADC DC offset (scaled, full scale is +/-1.0)
+static float P_ii, P_qq, P_iq;  //averaged block powers and correlation
+static float C1 = 1.0f, C2;     //correction coefficients
+static uint32_t Blocks;
+
+void iqc_set_dc_block(bool on)
+{
+	IQC_Config.dc_block = on;
+	IQC_DC_applied = on ? DC_est : 0;
+}
+
+void iqc_set_corr(bool on)
+{
+	IQC_Config.corr = on;
+}
+
+void iqc_reset(void)
+{
+	DC_est = IQC_DC_applied = 0;
+	P_ii = P_qq = P_iq = 0;
+	C1 = 1.0f;
+	C2 = 0;
+	Blocks = 0;
+}
+
+//sum of n scaled samples with IQC_DC_applied already removed
+void iqc_dc_update(float sum, uint16_t n)
+{
+	DC_est += (sum/n + IQC_DC_applied - DC_est)*IQC_DC_COEFF;
+	if (IQC_Config.dc_block) IQC_DC_applied = DC_est;
+}
+
+//I/Q block after IQ filters - estimation and correction of Q in place
+void iqc_process(float* I, float* Q, uint16_t n)
+{
+	float si = 0, sq = 0, sii = 0, sqq = 0, siq = 0, i, q, r;
+	uint16_t k;
+
+	for (k = 0; k < n; k++)
+	{
+		i = I[k];
+		q = Q[k];
+		si += i;
+		sq += q;
+		sii += i*i;
+		sqq += q*q;
+		siq += i*q;
+	}
+	r = 1.0f/n;
+	P_ii += ((sii - si*si*r)*r - P_ii)*IQC_AVG_COEFF;
+	P_qq += ((sqq - sq*sq*r)*r - P_qq)*IQC_AVG_COEFF;
+	P_iq += ((siq - si*sq*r)*r - P_iq)*IQC_AVG_COEFF;
+	Blocks++;
+
+	if (P_ii > IQC_POWER_MIN)
+	{
+		r = P_qq - P_iq*P_iq/P_ii; //Q power without its part correlated with I
+		if (r > IQC_POWER_MIN)
+		{
+			C2 = -P_iq/P_ii;
+			C1 = sqrtf(P_ii/r);
+		}
+	}
+
+	if (!IQC_Config.corr) return;
+	for (k = 0; k < n; k++) Q[k] = C1*(Q[k] + C2*I[k]);
+}
+
+void iqc_print(void)
+{
+	float g = 1.0f, phase = 0, c, irr;
+
+	if ( (P_ii > IQC_POWER_MIN) && (P_qq > IQC_POWER_MIN) )
+	{
+		g = sqrtf(P_qq/P_ii);
+		phase = asinf(fmaxf(-1.0f, fminf(1.0f, P_iq/sqrtf(P_ii*P_qq))));
+	}
+	c = 2*g*cosf(phase);
+	irr = (1 + c + g*g)/fmaxf(1 + g*g - c, 1.0e-12f);
+
+	UART_printf("iq: dc_block %s ; DC offset %.2f LSB (%.2e) ; correction %s\r\n", IQC_Config.dc_block ? "on" : "off",
+			DC_est*(4095.0/2.0), DC_est, IQC_Config.corr ? "on" : "off");
+	UART_printf("I/Q imbalance: gain %.3f dB ; phase %.2f deg ; image rejection %.1f dB ; c1 %.4f c2 %.4f ; blocks %lu\r\n",
+			20*log10f(g), phase*(180.0/M_PI), 10*log10f(irr), C1, C2, Blocks);
+}
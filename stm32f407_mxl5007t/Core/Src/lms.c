@@ -0,0 +1,154 @@
+/*
+ * lms.c - LMS adaptive auto-notch and noise reduction on mono audio at AUDIO_FS_Hz
+ *
+ * Both filters are normalized LMS linear predictors: taps weights w predict input x[n] from reference x[n-delay...],
+ * weights are updated by w = (1 - leak)*w + mu*e*ref/(taps*power) where e is prediction error and power is average
+ * input power. Auto-notch has long delay, so only steady tones (heterodynes) stay correlated - its output is e.
+ * Noise reduction has one sample delay, voice is predictable and noise isn't - its output is prediction.
+ * They run after demodulator on SSB, CW, SAM and NBFM audio (AM envelope audio isn't decimated - SAM is the decimated
+ * AM path), notch first. Cost is about 3 operations per tap and sample - lms bench measures it by DWT counter.
+ */
+#include <string.h>
+#include <math.h>
+#include "lms.h"
+#include "audio_i2s.h"
+#include "perf.h"
+#include "printf.h"
+
+LMS_TypeDef LMS[LMS_FILTERS];
+
+const char *lms_filter_name[LMS_FILTERS] = {"notch", "nr"}; //the same order like LMS_Filter_enum
+
+static const uint8_t lms_bench_taps[] = {16, 32, 64, 128};
+
+static void lms_reset(LMS_TypeDef* f)
+{
+	memset(f->w, 0, sizeof(f->w));
+	memset(f->buf, 0, sizeof(f->buf));
+	f->idx = 0;
+	f->power = 0;
+}
+
+static void lms_config(LMS_TypeDef* f, uint8_t taps, uint8_t delay, float mu, float leak)
+{
+	f->on = false;
+	f->taps = taps;
+	f->delay = delay;
+	f->mu = mu;
+	f->leak = leak;
+	lms_reset(f);
+}
+
+void lms_init(void)
+{
+	lms_config(&LMS[LMS_NOTCH], LMS_NOTCH_TAPS, LMS_NOTCH_DELAY, LMS_NOTCH_MU, LMS_NOTCH_LEAK);
+	lms_config(&LMS[LMS_NR], LMS_NR_TAPS, LMS_NR_DELAY, LMS_NR_MU, LMS_NR_LEAK);
+}
+
+//filter is stopped while its state is reset, so it can be called at any time
+void lms_set_on(LMS_Filter_enum filter, bool on)
+{
+	if (filter >= LMS_FILTERS) return;
+	LMS[filter].on = false;
+	lms_reset(&LMS[filter]);
+	LMS[filter].on = on;
+}
+
+void lms_set_taps(LMS_Filter_enum filter, uint8_t taps)
+{
+	bool on;
+
+	if (filter >= LMS_FILTERS) return;
+	if (taps < LMS_TAPS_MIN) taps = LMS_TAPS_MIN;
+	if (taps > LMS_TAPS_MAX) taps = LMS_TAPS_MAX;
+	on = LMS[filter].on;
+	LMS[filter].on = false;
+	LMS[filter].taps = taps;
+	lms_reset(&LMS[filter]);
+	LMS[filter].on = on;
+}
+
+//demodulators with mono audio at AUDIO_FS_Hz
+bool lms_active(Output_demod_type_enum demod)
+{
+	if ( !LMS[LMS_NOTCH].on && !LMS[LMS_NR].on ) return false;
+	return (demod == DEMOD_USB) || (demod == DEMOD_LSB) || (demod == DEMOD_CW) || (demod == DEMOD_SAM) || (demod == DEMOD_NBFM);
+}
+
+//returns prediction error (notch) or prediction (noise reduction)
+static inline float lms_sample(LMS_TypeDef* f, float x, bool notch)
+{
+	uint16_t len = f->taps + f->delay;
+	uint8_t k;
+	const float* r;
+	float y = 0, e, ge, lc = 1.0f - f->leak;
+
+	if (f->idx == 0) f->idx = len;
+	f->idx--;
+	f->buf[f->idx] = x;
+	f->buf[f->idx + len] = x;
+	r = &f->buf[f->idx + f->delay]; //r[0] is the newest reference sample
+
+	for (k = 0; k < f->taps; k++) y += f->w[k]*r[k];
+	e = x - y;
+
+	f->power += (x*x - f->power)*LMS_POWER_AVG;
+	ge = f->mu*e/(f->taps*f->power + 1.0e-20f);
+	for (k = 0; k < f->taps; k++) f->w[k] = f->w[k]*lc + ge*r[k];
+
+	return notch ? e : y;
+}
+
+void lms_process(float* x, uint16_t n)
+{
+	uint16_t k;
+
+	if (LMS[LMS_NOTCH].on)
+		for (k = 0; k < n; k++) x[k] = lms_sample(&LMS[LMS_NOTCH], x[k], true);
+	if (LMS[LMS_NR].on)
+		for (k = 0; k < n; k++) x[k] = lms_sample(&LMS[LMS_NR], x[k], false);
+}
+
+//cycles per sample for every tap count - separate filter, so running ones aren't disturbed
+void lms_bench(void)
+{
+	static LMS_TypeDef f;
+	static float x[LMS_BENCH_LEN];
+	uint32_t t, cycles, cycles_min, seed = 1;
+	uint16_t k, run;
+	uint8_t j;
+	float cps;
+
+	UART_printf("taps  cycles/sample  CPU at %.1f kHz [%%]\r\n", AUDIO_FS_Hz/1.0e3);
+	for (j = 0; j < sizeof(lms_bench_taps); j++)
+	{
+		lms_config(&f, lms_bench_taps[j], LMS_NOTCH_DELAY, LMS_NOTCH_MU, LMS_NOTCH_LEAK);
+
+		//the fastest run - ADC interrupts can preempt the loop
+		cycles_min = 0xFFFFFFFF;
+		for (run = 0; run < 16; run++)
+		{
+			//tone and noise, so the weights aren't all zero
+			for (k = 0; k < LMS_BENCH_LEN; k++)
+			{
+				seed = seed*1664525 + 1013904223;
+				x[k] = 0.5f*sinf(0.237f*k) + (int32_t) seed*(0.1f/2147483648.0f);
+			}
+			t = perf_start();
+			for (k = 0; k < LMS_BENCH_LEN; k++) x[k] = lms_sample(&f, x[k], true);
+			cycles = perf_start() - t;
+			if (cycles < cycles_min) cycles_min = cycles;
+		}
+		cps = (float) cycles_min/LMS_BENCH_LEN;
+		UART_printf("%4d %14.1f %20.2f\r\n", lms_bench_taps[j], cps, 100.0*cps*AUDIO_FS_Hz/SystemCoreClock);
+	}
+}
+
+void lms_print(void)
+{
+	uint8_t k;
+
+	for (k = 0; k < LMS_FILTERS; k++)
+		UART_printf("%s: %s ; taps %d ; delay %d ; mu %.4f ; leak %.1e ; input power %.2e\r\n", lms_filter_name[k],
+				LMS[k].on ? "on" : "off", LMS[k].taps, LMS[k].delay, LMS[k].mu, LMS[k].leak, LMS[k].power);
+}
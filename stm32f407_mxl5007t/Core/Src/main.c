@@ -39,6 +39,24 @@
 #include "MxL5007_Common.h"
 #include "MxL5007_API.h"
 #include "MxL_User_Define.h"
+#include "mem_bank.h"
+#include "settings.h"
+#include "bringup.h"
+#include "perf.h"
+#include "audio_i2s.h"
+#include "wfm.h"
+#include "ssb.h"
+#include "cw.h"
+#include "sam.h"
+#include "nbfm.h"
+#include "data_demod.h"
+#include "lms.h"
+#include "agc.h"
+#include "nfloor.h"
+#include "dsp_fft.h"
+#include "chan.h"
+#include "freq_plan.h"
+#include "rds.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -61,6 +79,7 @@ ADC_HandleTypeDef hadc1;
 DMA_HandleTypeDef hdma_adc1;
 
 DAC_HandleTypeDef hdac;
+DMA_HandleTypeDef hdma_dac2;
 
 I2C_HandleTypeDef hi2c1;
 I2C_HandleTypeDef hi2c3;
@@ -70,24 +89,20 @@ DMA_HandleTypeDef hdma_spi3_tx;
 
 TIM_HandleTypeDef htim3;
 TIM_HandleTypeDef htim4;
+TIM_HandleTypeDef htim6;
 
 UART_HandleTypeDef huart5;
 
 /* USER CODE BEGIN PV */
 extern uint8_t rxchar;
-int16_t dataI2S[4]; //dummy array for I2S
-uint32_t v_in_samples[8]; //IF samples array for ADC
-
-//sine, cosine and arsine look-up tables
-float sine_arr[N_cos_sin];
-float cosine_arr[N_cos_sin];
-float asin_arr[N_asin];
+int16_t v_in_samples[2*ADC_BLOCK] __attribute__((aligned(4))); //IF samples array for ADC (halfword DMA) - two halves of ADC_BLOCK samples
+uint32_t DAC_out[2*BB_BLOCK]; //DAC samples (DHR12RD format) - two halves of BB_BLOCK samples
 
 MxL5007_TunerConfigS myTuner; //structure config for MxL5007T
 
 extern Output_demod_type_enum Demod_Type;
-extern float b[];
-extern float a[];
+extern volatile FM_Discr_enum FM_Discr;
+extern volatile bool DSP_Mute;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -102,6 +117,7 @@ static void MX_I2C3_Init(void);
 static void MX_DAC_Init(void);
 static void MX_UART5_Init(void);
 static void MX_TIM4_Init(void);
+static void MX_TIM6_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -121,6 +137,7 @@ int main(void)
 	//uint8_t regs[32], reg;
 	int rxchar_loc;
 	uint32_t tick;
+	bool ready = false;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -150,6 +167,7 @@ int main(void)
   MX_DAC_Init();
   MX_UART5_Init();
   MX_TIM4_Init();
+  MX_TIM6_Init();
   /* USER CODE BEGIN 2 */
 
   usart_init(&huart5);
@@ -162,76 +180,64 @@ int main(void)
   UART_printf("| based on the STM32F407 and MxL5007T. |\r\n");
   UART_printf("+--------------------------------------+\r\n");
 
+  //last receiver state and calibration from flash
+  settings_init();
+
   //init MXL5007T
   myTuner.I2C_Addr = MxL_I2C_ADDR_96; //Set Tuner's I2C Address
   myTuner.Mode = MxL_MODE_DVBT;
   //myTuner.IF_Diff_Out_Level = -8; //Setting for Cable mode only
   myTuner.Xtal_Freq = MxL_XTAL_24_MHZ; //Set Tuner's XTAL freq
-  myTuner.IF_Freq = MxL_IF_4_5_MHZ; //Set Tuner's IF Freq
+  fp_init(Settings.plan); //Set Tuner's IF Freq and spectrum, mixer table for its alias
   myTuner.ClkOut_Setting = MxL_CLKOUT_DISABLE; //Set Tuner's Clock out setting
   myTuner.ClkOut_Amp = MxL_CLKOUT_AMP_0;
 
-  HAL_Delay(300); //Without delay after power up MxL5007 doesn't give ACK.
-  MxL5007_ChipVersion MxL_ChipVersion = MxL_Check_ChipVersion(&myTuner);
-  MxL_Print_ChipVersion(MxL_ChipVersion);
-  if (MxL_ChipVersion == MxL_UNKNOWN_ID) MxL_TIMEOUT_UserCallback();
-
-  MxL_ERR_MSG MxL_Status = MxL_Tuner_Init(&myTuner);
-  if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-  MxL_Status = MxL_Tuner_RFTune(&myTuner, 100*MHz, MxL_BW_6MHz);
-  if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-  //Check Lock Status
-  bool RFSynthLock, REFSynthLock;
-  MxL_Status = MxL_RFSynth_Lock_Status(&myTuner, &RFSynthLock);
-  if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-  MxL_Status = MxL_REFSynth_Lock_Status(&myTuner, &REFSynthLock);
-  if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
-
-  UART_printf("rfLock=%d   refLock=%d\r\n", RFSynthLock, RFSynthLock);
-  UART_printf("MxL5007T initialized.\r\n");
-
-  HAL_TIM_PWM_Start(&htim4, TIM_CHANNEL_2); //starting PWM for IF_AGC pin voltage settings
-  MxL_SetGain(75.0 - (IF_Gain + Attenuation)); //total gain 75 dB
-
-  //init CS43L22
-  CS43_Init(hi2c1, MODE_ANALOG_);
-  CS43_SetVolume(CS43_default_vol); //maximum value without distortion for 3.00 Vpp from DAC is CS43_default_vol=48 for DISCOVERY BOARD
-  CS43_Enable_RightLeft(CS43_RIGHT_LEFT);
-  CS43_Start();
-  UART_printf("CS43L22 initialized.\r\n");
-
-  //TIM3_clk=84 MHz; ARR=98 -> FS_uint_kHz=ceil(TIM3_clk*1000/ARR)=858 kHz
-  //F_IF=260 kHz after band pass sampling
-  //FS_uint_kHz/F_IF=858/260=33/10 so Step_cos_sin=10 is step and after that is adding modulo N_cos_sin=33 k=mod(k+Step_cos_sin, N_cos_sin)
-  float dx = 2.0*M_PI / N_cos_sin; //N_cos_sin=33 samples per sine/cosine period is enough
-  uint8_t k = 0;
-  for (uint8_t i=0; i<N_cos_sin; i++)
-  {
-	  sine_arr[i] = sinf(dx*k); //calculating look-up tables with reordering
-	  cosine_arr[i] = cosf(dx*k);
-	  k = (k + Step_cos_sin) % N_cos_sin; //adding modulo N_cos_sin=33 - unnecessary during real time computing so it can be replace just by counter increment
-  }
-
-  dx = 2.0 / N_asin; //step 1-(-1) / N_asin
-  for (uint8_t i=0; i<N_asin; i++) asin_arr[i] = asinf(dx*i - 1.0); //calculating look-up table for arsine (needed for FM)
-
-  set_IQ_filters_coeff(b, a, Demod_Type);
-
+  mem_init(); //loading memory channels bank from flash
+
+  //look-up tables are const (dsp_tables.c generated by Matlab/lut_gen.m) so DSP chain can be started right away
+  //TIM3_clk=84 MHz; ARR=98 -> FS_ADC_Hz=848.5 kHz ; IF after band pass sampling and mixer table are set by fp_init()
+  //(freq_plan.c) - 4.5 MHz gives 257.6 kHz and 33 samples with 10 periods by default
+  Demod_Type = (Settings.demod <= DEMOD_NBFM) ? Settings.demod : SET_DEFAULT_DEMOD;
+  FM_Discr = (Settings.fm_discr < FM_DISCR_NUM) ? Settings.fm_discr : SET_DEFAULT_FM_DISCR;
+  settings_wfm_decode(Settings.wfm);
+  wfm_init();
+  SSB_Config.filter = Settings.ssb;
+  ssb_init();
+  CW_Config.filter = Settings.CW_filter;
+  CW_Config.pitch_Hz = Settings.CW_pitch;
+  cw_init(); //filter and pitch are checked there
+  sam_init();
+  NBFM_Config.channel = Settings.nbfm;
+  nbfm_init(); //channel is checked there
+  data_init();
+  lms_init();
+  agc_set(true, AGC_LEVEL_DEFAULT, AGC_ATTACK_DEFAULT, AGC_DECAY_DEFAULT);
+  fft_init();
+  nf_init();
+  chan_init();
+  set_IQ_filters_coeff(Demod_Type);
+
+  DSP_Mute = true; //until tuner and codec are ready
+  audio_i2s_start(); //I2S ring is sent all the time - MCLK for CS43L22 and WFM audio
+
+  //DAC channels are triggered by TIM6 at FS_BB_Hz, both are written by one DMA request to DHR12RD
   HAL_DAC_Start(&hdac, DAC_CHANNEL_1);
   HAL_DAC_Start(&hdac, DAC_CHANNEL_2);
-  HAL_I2S_Transmit_DMA(&hi2s3, (uint16_t *)dataI2S, 4); //starting I2S 16-bits dummy words sending with circular buffer just for MCLK clock for CS43L22
+  HAL_DMA_Start(&hdma_dac2, (uint32_t) DAC_out, (uint32_t) &DAC->DHR12RD, 2*BB_BLOCK);
+  DAC->CR |= DAC_CR_DMAEN2;
 
+  perf_init(); //DWT cycle counter for DSP profiling - deadline is taken from TIM3 settings
+  HAL_ADC_Start_DMA(&hadc1, (uint32_t*) v_in_samples, 2*ADC_BLOCK); //starting DMA for ADC with circular buffer
+  //TIM6 period is ADC_DECIM periods of TIM3 - both are started together so DAC is sampled in the middle of the block
+  HAL_TIM_Base_Start(&htim6);
   HAL_TIM_Base_Start(&htim3); //starting timer for ADC triggering
-  HAL_ADC_Start_DMA(&hadc1, v_in_samples, 8); //starting DMA for ADC with circular buffer
+
+  //MxL5007T and CS43L22 are brought up in main loop by bringup_task()
 
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  init_cmd();
   tick = HAL_GetTick() + 100;
   while (1)
   {
@@ -239,8 +245,14 @@ int main(void)
 
     /* USER CODE BEGIN 3 */
 
+	/* tuner and codec initialization - console is started when they're ready */
+	if (!ready)
+	{
+		ready = bringup_task();
+		if (ready) init_cmd();
+	}
 	/* UART command processing */
-	if((rxchar_loc = usart_getc())!= EOF)
+	else if((rxchar_loc = usart_getc())!= EOF)
 	{
 		/* Parse commands */
 		cmd_parse(rxchar_loc);
@@ -253,6 +265,24 @@ int main(void)
 		  tick = HAL_GetTick() + 100;
 	}
 
+	/* saving changed settings in flash */
+	if (ready) settings_task();
+
+	/* RDS block synchronization and group decoding */
+	if (ready) rds_task();
+
+	/* Morse decoding */
+	if (ready) cw_task();
+
+	/* AX.25 and POCSAG decoding */
+	if (ready) data_task();
+
+	/* noise floor and SNR estimation */
+	if (ready) nf_task();
+
+	/* channelizer squelch thresholds */
+	if (ready) chan_task();
+
   }
   /* USER CODE END 3 */
 }
@@ -382,7 +412,7 @@ static void MX_DAC_Init(void)
 
   /** DAC channel OUT1 config
   */
-  sConfig.DAC_Trigger = DAC_TRIGGER_NONE;
+  sConfig.DAC_Trigger = DAC_TRIGGER_T6_TRGO;
   sConfig.DAC_OutputBuffer = DAC_OUTPUTBUFFER_ENABLE;
   if (HAL_DAC_ConfigChannel(&hdac, &sConfig, DAC_CHANNEL_1) != HAL_OK)
   {
@@ -498,7 +528,8 @@ static void MX_I2S3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN I2S3_Init 2 */
-
+  //Fs=I2SCLK/(256*(2*DIV+ODD))=74.667 MHz/2816=FS_BB_Hz/AUDIO_DECIM exactly (PLLI2S N=112, R=3) - HAL can't compute it from AudioFreq
+  hi2s3.Instance->I2SPR = SPI_I2SPR_MCKOE | (AUDIO_I2S_ODD ? SPI_I2SPR_ODD : 0) | AUDIO_I2S_DIV;
   /* USER CODE END I2S3_Init 2 */
 
 }
@@ -607,6 +638,44 @@ static void MX_TIM4_Init(void)
 
 }
 
+/**
+  * @brief TIM6 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM6_Init(void)
+{
+
+  /* USER CODE BEGIN TIM6_Init 0 */
+
+  /* USER CODE END TIM6_Init 0 */
+
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM6_Init 1 */
+
+  /* USER CODE END TIM6_Init 1 */
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = 0;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = 395;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM6_Init 2 */
+
+  /* USER CODE END TIM6_Init 2 */
+
+}
+
 /**
   * @brief UART5 Initialization Function
   * @param None
@@ -654,6 +723,9 @@ static void MX_DMA_Init(void)
   /* DMA1_Stream5_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
   /* DMA2_Stream0_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
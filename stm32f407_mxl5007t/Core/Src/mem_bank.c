@@ -0,0 +1,210 @@
+/*
+ * mem_bank.c - memory channels bank stored in internal flash
+ *
+ * Every channel keeps precomputed MxL5007T RFTune payload and IQ filter selection,
+ * so recall is just one I2C burst and filter coefficients pointer switch without any recomputation.
+ * The bank is kept in RAM and every change is appended as one channel record to the reserved flash sector, so storing
+ * a channel doesn't erase the sector (1 - 2 s stall of code fetch and ADC callbacks). The sector is erased only when
+ * it is full (2048 records) and the bank is written back to it compacted - flash_erase_sector() adds the lost ADC blocks
+ * to ADC overruns and the stall is printed. There is no second sector, so power loss during the compaction loses the bank.
+ */
+#include <string.h>
+#include <stdbool.h>
+#include "main.h"
+#include "mem_bank.h"
+#include "flash_if.h"
+#include "cmd.h"
+#include "printf.h"
+#include "audio_i2s.h"
+#include "wfm.h"
+#include "ssb.h"
+#include "cw.h"
+#include "sam.h"
+#include "nbfm.h"
+#include "MxL5007_Common.h"
+#include "MxL5007_API.h"
+#include "MxL_User_Define.h"
+
+extern MxL5007_TunerConfigS myTuner;
+extern Output_demod_type_enum Demod_Type;
+extern IQ_Filter_enum IQ_Filter;
+extern float Total_Gain_curr;
+
+static Mem_Bank_TypeDef Mem_Bank;
+static uint32_t Mem_wr_addr; //next free record
+
+static const char *mem_demod_name[] = {"FM", "AM", "IQ", "CW", "WFM", "USB", "LSB", "SAM", "NBFM"};
+
+static uint32_t mem_checksum(const Mem_Record_TypeDef* rec)
+{
+	const uint32_t* p = (const uint32_t*) rec;
+	uint32_t i, sum = 0x5A5A5A5A;
+	for (i = 0; i < sizeof(Mem_Record_TypeDef)/4 - 1; i++) sum = ((sum << 5) | (sum >> 27)) ^ p[i];
+	return sum;
+}
+
+static bool mem_slot_erased(uint32_t addr)
+{
+	const uint32_t* p = (const uint32_t*) addr;
+	uint32_t i;
+	for (i = 0; i < MEM_RECORD_SIZE/4; i++) if (p[i] != 0xFFFFFFFF) return false;
+	return true;
+}
+
+//replaying the records - the sector written by older firmware holds one bank image, it is loaded and the sector
+//is marked as full, so the first store compacts it to records
+void mem_init(void)
+{
+	const Mem_Bank_TypeDef* flash_bank = (const Mem_Bank_TypeDef*) MEM_FLASH_ADDR;
+	const Mem_Record_TypeDef* rec;
+	uint32_t addr;
+
+	memset(&Mem_Bank, 0, sizeof(Mem_Bank));
+	Mem_Bank.magic = MEM_MAGIC;
+
+	if (flash_bank->magic == MEM_MAGIC_IMAGE)
+	{
+		memcpy(Mem_Bank.ch, flash_bank->ch, sizeof(Mem_Bank.ch));
+		Mem_wr_addr = MEM_FLASH_ADDR + MEM_FLASH_SIZE;
+		return;
+	}
+
+	Mem_wr_addr = MEM_FLASH_ADDR + MEM_FLASH_SIZE; //sector full unless free slot is found
+	for (addr = MEM_FLASH_ADDR; addr < MEM_FLASH_ADDR + MEM_FLASH_SIZE; addr += MEM_RECORD_SIZE)
+	{
+		if (mem_slot_erased(addr))
+		{
+			Mem_wr_addr = addr;
+			break;
+		}
+		rec = (const Mem_Record_TypeDef*) addr;
+		if ( (rec->magic == MEM_MAGIC) && (rec->n < MEM_CHANNELS) && (rec->checksum == mem_checksum(rec)) )
+			Mem_Bank.ch[rec->n] = rec->ch;
+	}
+}
+
+//magic is written last
+static bool mem_write_record(uint8_t n)
+{
+	Mem_Record_TypeDef rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = MEM_MAGIC;
+	rec.n = n;
+	rec.ch = Mem_Bank.ch[n];
+	rec.checksum = mem_checksum(&rec);
+
+	bool status = flash_program(Mem_wr_addr + 4, (uint8_t*) &rec + 4, sizeof(rec) - 4);
+	if (status) status = flash_program(Mem_wr_addr, &rec.magic, 4);
+	Mem_wr_addr += MEM_RECORD_SIZE; //failed slot is skipped too
+
+	return status;
+}
+
+//appending the record of channel n - full sector is erased and the stored channels are written back first
+static bool mem_save(uint8_t n)
+{
+	uint8_t k;
+
+	if (Mem_wr_addr + MEM_RECORD_SIZE > MEM_FLASH_ADDR + MEM_FLASH_SIZE)
+	{
+		bool erased = flash_erase_sector(MEM_FLASH_SECTOR);
+
+		UART_printf("mem: sector erase - ADC processing stalled %lu ms\r\n", Flash_erase_ms);
+		if (!erased) return false;
+		Mem_wr_addr = MEM_FLASH_ADDR;
+		for (k = 0; k < MEM_CHANNELS; k++)
+			if ( (k != n) && (Mem_Bank.ch[k].valid == MEM_VALID) && !mem_write_record(k) ) return false;
+	}
+
+	return mem_write_record(n);
+}
+
+//store current receiver state in channel n
+bool mem_store(uint8_t n, float squelch)
+{
+	uint8_t pArray[MAX_ARRAY_SIZE];
+	uint32_t Array_Size;
+
+	if (n >= MEM_CHANNELS) return false;
+
+	MxL_Tuner_RFTune_Calc(pArray, &Array_Size, myTuner.RF_Freq_Hz, MxL_BW_6MHz);
+	if (Array_Size > MEM_TUNE_PAYLOAD) return false;
+
+	Mem_Channel_TypeDef* ch = &Mem_Bank.ch[n];
+	ch->freq_Hz = myTuner.RF_Freq_Hz;
+	ch->demod = Demod_Type;
+	ch->filter = IQ_Filter;
+	ch->gain = Total_Gain_curr;
+	ch->squelch = squelch;
+	ch->tune_len = Array_Size;
+	memcpy(ch->tune_regs, pArray, Array_Size);
+	ch->valid = MEM_VALID;
+
+	return mem_save(n);
+}
+
+bool mem_clear(uint8_t n)
+{
+	if (n >= MEM_CHANNELS) return false;
+	memset(&Mem_Bank.ch[n], 0, sizeof(Mem_Channel_TypeDef));
+	return mem_save(n);
+}
+
+bool mem_valid(uint8_t n)
+{
+	return (n < MEM_CHANNELS) && (Mem_Bank.ch[n].valid == MEM_VALID);
+}
+
+const Mem_Channel_TypeDef* mem_get(uint8_t n)
+{
+	if (!mem_valid(n)) return NULL;
+	return &Mem_Bank.ch[n];
+}
+
+//next valid channel after n (with wrap around) or -1 if the bank is empty
+int16_t mem_next(uint8_t n)
+{
+	uint8_t i, k = n;
+	for (i = 0; i < MEM_CHANNELS; i++)
+	{
+		if (++k >= MEM_CHANNELS) k = 0;
+		if (Mem_Bank.ch[k].valid == MEM_VALID) return k;
+	}
+	return -1;
+}
+
+bool mem_recall(uint8_t n)
+{
+	if (!mem_valid(n)) return false;
+	Mem_Channel_TypeDef* ch = &Mem_Bank.ch[n];
+
+	MxL_ERR_MSG MxL_Status = MxL_Tuner_RFTune_Cached(&myTuner, ch->freq_Hz, MxL_BW_6MHz, ch->tune_regs, ch->tune_len);
+	if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+
+	if ( (ch->demod == DEMOD_WFM) && (Demod_Type != DEMOD_WFM) ) wfm_init();
+	if ( (ch->demod == DEMOD_CW) && (Demod_Type != DEMOD_CW) ) cw_init();
+	if ( (ch->demod == DEMOD_SAM) && (Demod_Type != DEMOD_SAM) ) sam_init();
+	if ( (ch->demod == DEMOD_NBFM) && (Demod_Type != DEMOD_NBFM) ) nbfm_init();
+	if ( ((ch->demod == DEMOD_USB) || (ch->demod == DEMOD_LSB)) && (Demod_Type != DEMOD_USB) && (Demod_Type != DEMOD_LSB) ) ssb_init();
+	Demod_Type = ch->demod;
+	set_IQ_filter(ch->filter);
+	audio_route(Demod_Type);
+
+	set_total_gain(ch->gain);
+
+	return true;
+}
+
+void mem_list(void)
+{
+	uint8_t n;
+	for (n = 0; n < MEM_CHANNELS; n++)
+	{
+		if (Mem_Bank.ch[n].valid != MEM_VALID) continue;
+		Mem_Channel_TypeDef* ch = &Mem_Bank.ch[n];
+		UART_printf("M%02d: %.6f MHz ; %s ; filter %s kHz ; gain %.2f dB ; squelch %.2f dB\r\n", n, ch->freq_Hz/1.0E6,
+				(ch->demod <= DEMOD_NBFM) ? mem_demod_name[ch->demod] : "?",
+				(ch->filter < IQ_FILTERS) ? iq_filter_name[ch->filter] : "?", ch->gain, ch->squelch);
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ * nb.c - noise blanker and impulse limiter on scaled ADC block (before mixer and IQ filters)
+ *
+ * Impulses are detected on the tuner IF samples, where they are still short - after 5th order IQ filter every pulse
+ * rings for many output samples. Sample magnitude is compared with threshold x average magnitude; average is updated
+ * with magnitudes limited to the threshold, so pulses don't raise it, but step of signal level is followed.
+ * Blank mode zeroes pulse samples, NB_PRE samples before and NB_Config.hang samples after them, limit mode clips
+ * samples at the threshold. When off, the ADC callback only tests the mode.
+ */
+#include <math.h>
+#include "nb.h"
+#include "printf.h"
+
+NB_Config_TypeDef NB_Config =
+{
+	.mode = NB_OFF,
+	.threshold = NB_THRESHOLD_DEFAULT,
+	.hang = NB_HANG_DEFAULT
+};
+
+const char *nb_mode_name[NB_MODES] = {"off", "blank", "limit"}; //the same order like NB_Mode_enum
+
+static float Avg = NB_AVG_INIT;
+static uint8_t Hang_cnt;
+static bool In_pulse;
+static uint32_t Pulses, Blanked, Samples;
+
+void nb_set_mode(NB_Mode_enum mode)
+{
+	if (mode >= NB_MODES) mode = NB_OFF;
+	NB_Config.mode = NB_OFF;
+	Avg = NB_AVG_INIT;
+	Hang_cnt = 0;
+	In_pulse = false;
+	Pulses = Blanked = Samples = 0;
+	NB_Config.mode = mode;
+}
+
+void nb_set_threshold(float threshold)
+{
+	if (threshold < NB_THRESHOLD_MIN) threshold = NB_THRESHOLD_MIN;
+	if (threshold > NB_THRESHOLD_MAX) threshold = NB_THRESHOLD_MAX;
+	NB_Config.threshold = threshold;
+}
+
+void nb_set_hang(uint8_t hang)
+{
+	if (hang > NB_HANG_MAX) hang = NB_HANG_MAX;
+	NB_Config.hang = hang;
+}
+
+void nb_process(float* x, uint16_t n)
+{
+	float thr = NB_Config.threshold*Avg; //average changes slowly - one threshold per block
+	float mag;
+	uint16_t k, j;
+	bool blank = NB_Config.mode == NB_BLANK;
+
+	for (k = 0; k < n; k++)
+	{
+		mag = fabsf(x[k]);
+		if (mag > thr)
+		{
+			if (!In_pulse && !Hang_cnt) Pulses++;
+			In_pulse = true;
+			if (blank)
+			{
+				for (j = (k > NB_PRE) ? k - NB_PRE : 0; j < k; j++) x[j] = 0;
+				Hang_cnt = NB_Config.hang + 1; //this sample too
+			}
+			else
+			{
+				x[k] = copysignf(thr, x[k]);
+				Blanked++;
+			}
+			mag = thr;
+		}
+		else In_pulse = false;
+		Avg += (mag - Avg)*NB_AVG_COEFF;
+
+		if (Hang_cnt)
+		{
+			Hang_cnt--;
+			x[k] = 0;
+			Blanked++;
+		}
+	}
+	Samples += n;
+}
+
+void nb_print(void)
+{
+	UART_printf("nb: %s ; threshold %.1f (%.1f dB) ; hang %d samples ; average %.2e ; pulses %lu ; %s %.3f %%\r\n",
+			nb_mode_name[NB_Config.mode], NB_Config.threshold, 20*log10f(NB_Config.threshold), NB_Config.hang, Avg,
+			Pulses, (NB_Config.mode == NB_LIMIT) ? "clipped" : "blanked", Samples ? 100.0*Blanked/Samples : 0.0);
+}
@@ -0,0 +1,423 @@
+/*
+ * nbfm.c - narrowband FM voice receiver with noise squelch and CTCSS/DCS tone squelch
+ *
+ * I/Q is decimated to 53 kHz and then to AUDIO_FS_Hz by the channel filter (12.5 or 25 kHz channel spacing, swapped
+ * by coefficients pointer). Polar discriminator output is split into three paths at AUDIO_FS_Hz:
+ * - voice: 750 us de-emphasis and 300 - 3000 Hz band pass (high pass removes CTCSS/DCS from the audio),
+ * - noise squelch: power above 4.5 kHz - there's no modulation there, so it's discriminator noise which drops
+ *   when the signal quiets the receiver,
+ * - sub-audio: low pass 270 Hz decimated to NBFM_TONE_FS_Hz, so CTCSS Goertzel bank (all 50 tones, the strongest one
+ *   is reported) and DCS bit slicer cost only a few cycles per audio sample.
+ * Audio is gated by the noise squelch and by the selected tone or code.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include "main.h"
+#include "nbfm.h"
+#include "audio_i2s.h"
+#include "dsp_math.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "printf.h"
+
+#define DCS_GOLAY_POLY 0xC75 //x^11 + x^10 + x^6 + x^5 + x^4 + x^2 + 1
+#define DCS_MASK       ((1UL << NBFM_DCS_BITS) - 1)
+
+NBFM_Config_TypeDef NBFM_Config =
+{
+	.channel = NBFM_CHANNEL_12k5,
+	.squelch_dB = NBFM_SQ_DEFAULT_dB,
+	.tone = NBFM_TONE_OFF,
+	.ctcss = 0,
+	.dcs = 023
+};
+
+const char *nbfm_channel_name[NBFM_CHANNELS] = {"12.5", "25"}; //kHz - the same order like NBFM_Channel_enum
+
+//EIA/TIA-603 CTCSS tones [0.1 Hz]
+const uint16_t nbfm_ctcss_dHz[NBFM_CTCSS_TONES] =
+{
+	 670,  693,  719,  744,  770,  797,  825,  854,  885,  915,  948,  974, 1000, 1035, 1072, 1109, 1148,
+	1188, 1230, 1273, 1318, 1365, 1413, 1462, 1514, 1567, 1598, 1622, 1655, 1679, 1713, 1738, 1773, 1799,
+	1835, 1862, 1899, 1928, 1966, 1995, 2035, 2065, 2107, 2181, 2257, 2291, 2336, 2418, 2503, 2541
+};
+
+static const float* const NBFM_FIR2[NBFM_CHANNELS] = {NBFM_FIR2_12k5, NBFM_FIR2_25k};
+static const float NBFM_dev_Hz[NBFM_CHANNELS] = {2500.0, 5000.0};
+
+//discriminator output power above voice band without signal - squelch levels are relative to it
+static const float NBFM_noise_ref[NBFM_CHANNELS] = {0.61f, 1.48f};
+
+//I/Q decimation and channel filter
+static float FIR1_I_delay[2*NBFM_FIR1_TAPS], FIR1_Q_delay[2*NBFM_FIR1_TAPS];
+static float FIR2_I_delay[2*NBFM_FIR2_TAPS], FIR2_Q_delay[2*NBFM_FIR2_TAPS];
+static FIR_Decim_TypeDef FIR1_I = {NBFM_FIR1, NBFM_FIR1_TAPS, NBFM_DECIM1, 0, 0, FIR1_I_delay};
+static FIR_Decim_TypeDef FIR1_Q = {NBFM_FIR1, NBFM_FIR1_TAPS, NBFM_DECIM1, 0, 0, FIR1_Q_delay};
+static FIR_Decim_TypeDef FIR2_I = {NBFM_FIR2_12k5, NBFM_FIR2_TAPS, NBFM_DECIM2, 0, 0, FIR2_I_delay};
+static FIR_Decim_TypeDef FIR2_Q = {NBFM_FIR2_12k5, NBFM_FIR2_TAPS, NBFM_DECIM2, 0, 0, FIR2_Q_delay};
+static float Dec1_I[BB_BLOCK/NBFM_DECIM1], Dec1_Q[BB_BLOCK/NBFM_DECIM1];
+static float Dec2_I[BB_BLOCK/(NBFM_DECIM1*NBFM_DECIM2)], Dec2_Q[BB_BLOCK/(NBFM_DECIM1*NBFM_DECIM2)];
+static float Prev_I, Prev_Q;
+float NBFM_Discr[BB_BLOCK/(NBFM_DECIM1*NBFM_DECIM2)]; //discriminator output for data demodulators
+
+//voice
+static float Deemph, Deemph_coeff;
+static float Z_audio[NBFM_AUDIO_SECTIONS][2];
+static volatile float Audio_scale;
+
+//noise squelch - levels are switched by channel and squelch setting
+static float Z_noise[NBFM_NOISE_SECTIONS][2];
+static float Noise_pow;
+static volatile float Sq_open_pow, Sq_close_pow;
+static bool Sq_open;
+static float Gate;
+
+//sub-audio decimation and CTCSS Goertzel bank
+static float Z_tone[NBFM_TONE_SECTIONS][2];
+static uint8_t Tone_cnt;
+static float Tone_DC;
+static float G_coeff[NBFM_CTCSS_TONES], G_s1[NBFM_CTCSS_TONES], G_s2[NBFM_CTCSS_TONES];
+static float Tone_energy;
+static uint16_t Tone_n;
+static volatile uint8_t Ctcss_detected;
+static volatile float Ctcss_ratio;
+
+//DCS bit slicer and word detection
+static uint32_t Dcs_phase, Dcs_step;
+static bool Dcs_level;
+static uint32_t Dcs_reg;
+static uint16_t Dcs_slot[NBFM_DCS_BITS]; //decoded word at every bit position of the last word period
+static uint8_t Dcs_pos;
+static volatile uint16_t Dcs_detected;
+static volatile bool Dcs_inverted;
+static volatile uint8_t Dcs_hold, Dcs_seen; //bits until configured code / any code is forgotten
+
+//biquads {b0, b1, b2, a1, a2} in direct form II
+static inline float nbfm_biquads(const float* c, float (*z)[2], uint8_t sections, float x)
+{
+	uint8_t j;
+	float t;
+
+	for (j = 0; j < sections; j++)
+	{
+		const float* bq = &c[5*j];
+
+		t = x - (z[j][0]*bq[3] + z[j][1]*bq[4]);
+		x = t*bq[0] + z[j][0]*bq[1] + z[j][1]*bq[2];
+		z[j][1] = z[j][0];
+		z[j][0] = t;
+	}
+	return x;
+}
+
+//23 bit DCS word of 9 bit code - bit 0 is sent first, polynomial degree 22 is bit 0
+static uint32_t nbfm_dcs_word(uint16_t code)
+{
+	uint32_t data = (code & 0x1FF) | 0x800; //code, then "100"
+	uint32_t rem = 0, word, fb;
+	uint8_t k;
+
+	//remainder of data*x^11 divided by Golay polynomial (LFSR) - data bits from the highest degree
+	for (k = 0; k < 12; k++)
+	{
+		fb = ((data >> k) ^ (rem >> 10)) & 1;
+		rem = (rem << 1) & 0x7FF;
+		if (fb) rem ^= DCS_GOLAY_POLY & 0x7FF;
+	}
+
+	//parity from degree 10 down to 0 follows data
+	word = data;
+	for (k = 0; k < 11; k++)
+		word |= ((rem >> (10 - k)) & 1) << (12 + k);
+	return word;
+}
+
+//code of valid DCS word or NBFM_DCS_NONE
+static uint16_t nbfm_dcs_decode(uint32_t word)
+{
+	if ( ((word >> 9) & 0x7) != 0x4 ) return NBFM_DCS_NONE;
+	if (nbfm_dcs_word(word & 0x1FF) != word) return NBFM_DCS_NONE;
+	return word & 0x1FF;
+}
+
+//squelch levels and audio scaling for current channel - can be called while NBFM is running
+static void nbfm_set_levels(void)
+{
+	float ref = NBFM_noise_ref[NBFM_Config.channel];
+
+	if (NBFM_Config.squelch_dB == 0)
+	{
+		Sq_open_pow = 1.0e30f;
+		Sq_close_pow = 1.0e30f;
+	}
+	else
+	{
+		Sq_open_pow = ref*powf(10.0f, NBFM_Config.squelch_dB/10.0f);
+		Sq_close_pow = ref*powf(10.0f, (NBFM_Config.squelch_dB + NBFM_SQ_HYST_dB)/10.0f);
+	}
+
+	//discriminator gives 2*pi*f/AUDIO_FS_Hz, de-emphasis gain at 1 kHz is 1/sqrt(1 + (2*pi*1kHz*tau)^2)
+	float wt = 2.0*M_PI*1000.0*NBFM_DEEMPH_us*1.0e-6;
+	Audio_scale = NBFM_AUDIO_LEVEL*AUDIO_FS_Hz*sqrtf(1.0f + wt*wt)/(2.0*M_PI*NBFM_dev_Hz[NBFM_Config.channel]);
+}
+
+//has to be called before Demod_Type is switched to DEMOD_NBFM (it's not synchronized with ADC callbacks)
+void nbfm_init(void)
+{
+	uint8_t k;
+
+	fir_reset(&FIR1_I);
+	fir_reset(&FIR1_Q);
+	fir_reset(&FIR2_I);
+	fir_reset(&FIR2_Q);
+	Prev_I = Prev_Q = 0;
+
+	Deemph = 0;
+	Deemph_coeff = 1.0 - exp(-1.0/(AUDIO_FS_Hz*NBFM_DEEMPH_us*1.0e-6));
+	for (k = 0; k < NBFM_AUDIO_SECTIONS; k++)
+		Z_audio[k][0] = Z_audio[k][1] = 0;
+	for (k = 0; k < NBFM_NOISE_SECTIONS; k++)
+		Z_noise[k][0] = Z_noise[k][1] = 0;
+	for (k = 0; k < NBFM_TONE_SECTIONS; k++)
+		Z_tone[k][0] = Z_tone[k][1] = 0;
+
+	Noise_pow = NBFM_noise_ref[NBFM_Config.channel];
+	Sq_open = false;
+	Gate = 0;
+
+	Tone_cnt = 0;
+	Tone_DC = 0;
+	for (k = 0; k < NBFM_CTCSS_TONES; k++)
+	{
+		G_coeff[k] = 2.0f*cosf(2.0*M_PI*nbfm_ctcss_dHz[k]/(10.0*NBFM_TONE_FS_Hz));
+		G_s1[k] = G_s2[k] = 0;
+	}
+	Tone_energy = 0;
+	Tone_n = 0;
+	Ctcss_detected = NBFM_CTCSS_NONE;
+	Ctcss_ratio = 0;
+
+	Dcs_phase = 0;
+	Dcs_step = (uint32_t) (NBFM_DCS_BAUD*4294967296.0/NBFM_TONE_FS_Hz);
+	Dcs_level = false;
+	Dcs_reg = 0;
+	for (k = 0; k < NBFM_DCS_BITS; k++)
+		Dcs_slot[k] = NBFM_DCS_NONE;
+	Dcs_pos = 0;
+	Dcs_detected = NBFM_DCS_NONE;
+	Dcs_hold = Dcs_seen = 0;
+
+	nbfm_set_channel(NBFM_Config.channel);
+}
+
+void nbfm_set_channel(NBFM_Channel_enum channel)
+{
+	if (channel >= NBFM_CHANNELS) channel = NBFM_CHANNEL_12k5;
+	NBFM_Config.channel = channel;
+	FIR2_I.coeff = NBFM_FIR2[channel]; //single word writes - the same number of taps
+	FIR2_Q.coeff = NBFM_FIR2[channel];
+	nbfm_set_levels();
+}
+
+void nbfm_set_squelch(int8_t squelch_dB)
+{
+	if (squelch_dB > 0) squelch_dB = 0;
+	NBFM_Config.squelch_dB = squelch_dB;
+	nbfm_set_levels();
+}
+
+//the nearest standard tone within 1 Hz - returns false if there's no such tone
+bool nbfm_set_ctcss(float freq_Hz)
+{
+	uint8_t k;
+
+	for (k = 0; k < NBFM_CTCSS_TONES; k++)
+		if (fabsf(nbfm_ctcss_dHz[k] - 10.0f*freq_Hz) <= 10.0f) break;
+	if (k == NBFM_CTCSS_TONES) return false;
+
+	NBFM_Config.ctcss = k;
+	NBFM_Config.tone = NBFM_TONE_CTCSS;
+	return true;
+}
+
+void nbfm_set_dcs(uint16_t code)
+{
+	NBFM_Config.dcs = code & 0x1FF;
+	NBFM_Config.tone = NBFM_TONE_DCS;
+}
+
+void nbfm_tone_off(void)
+{
+	NBFM_Config.tone = NBFM_TONE_OFF;
+}
+
+//DCS NRZ bit slicer - bit clock phase is pulled to level transitions and bits are sampled in the middle
+static void nbfm_dcs(float x)
+{
+	bool level = x > 0;
+	int32_t prev;
+	uint16_t code;
+
+	if (level != Dcs_level)
+	{
+		Dcs_level = level;
+		Dcs_phase -= ((int32_t) Dcs_phase) >> 2; //transition is expected at phase 0
+	}
+	prev = (int32_t) Dcs_phase;
+	Dcs_phase += Dcs_step;
+	if ( !((prev >= 0) && ((int32_t) Dcs_phase < 0)) ) return;
+
+	Dcs_reg = (Dcs_reg >> 1) | ((uint32_t) level << (NBFM_DCS_BITS - 1));
+	if (++Dcs_pos == NBFM_DCS_BITS) Dcs_pos = 0;
+	if (Dcs_hold > 0) Dcs_hold--;
+	if (Dcs_seen > 0) Dcs_seen--;
+
+	//polarity depends on transmitter's and receiver's mixing, so both are accepted (bit 15 is inversion)
+	code = nbfm_dcs_decode(Dcs_reg);
+	if (code == NBFM_DCS_NONE)
+	{
+		code = nbfm_dcs_decode(~Dcs_reg & DCS_MASK);
+		if (code != NBFM_DCS_NONE) code |= 0x8000;
+	}
+
+	//random bits make valid words quite often - the same word has to repeat after one word period
+	//(other rotations of the word can be valid codes too, so every bit position is checked on its own
+	//and the configured code is reported instead of its rotations while it's received)
+	if ( (code != NBFM_DCS_NONE) && (code == Dcs_slot[Dcs_pos]) )
+	{
+		if ((code & 0x1FF) == NBFM_Config.dcs) Dcs_hold = NBFM_DCS_HOLD;
+		if ( ((code & 0x1FF) == NBFM_Config.dcs) || (Dcs_hold == 0) )
+		{
+			Dcs_detected = code & 0x1FF;
+			Dcs_inverted = (code & 0x8000) != 0;
+		}
+		Dcs_seen = NBFM_DCS_HOLD;
+	}
+	Dcs_slot[Dcs_pos] = code;
+}
+
+//sub-audio sample at NBFM_TONE_FS_Hz
+static void nbfm_tone(float x)
+{
+	uint8_t k, best = 0;
+	float s, p, p_best = 0;
+
+	Tone_DC += (x - Tone_DC)*NBFM_TONE_DC_AVG;
+	x -= Tone_DC;
+
+	Tone_energy += x*x;
+	for (k = 0; k < NBFM_CTCSS_TONES; k++)
+	{
+		s = x + G_coeff[k]*G_s1[k] - G_s2[k];
+		G_s2[k] = G_s1[k];
+		G_s1[k] = s;
+	}
+
+	if (++Tone_n == NBFM_CTCSS_N)
+	{
+		//pure tone gives 2*|X|^2/N = energy, so the ratio is power fraction of the tone
+		for (k = 0; k < NBFM_CTCSS_TONES; k++)
+		{
+			p = G_s1[k]*G_s1[k] + G_s2[k]*G_s2[k] - G_coeff[k]*G_s1[k]*G_s2[k];
+			if (p > p_best)
+			{
+				p_best = p;
+				best = k;
+			}
+			G_s1[k] = G_s2[k] = 0;
+		}
+		Ctcss_ratio = 2.0f*p_best*fast_recipf(NBFM_CTCSS_N*Tone_energy + 1.0e-30f);
+		Ctcss_detected = (Ctcss_ratio > NBFM_CTCSS_RATIO) ? best : NBFM_CTCSS_NONE;
+		Tone_energy = 0;
+		Tone_n = 0;
+	}
+
+	nbfm_dcs(x);
+}
+
+//returns number of audio samples in out (n/(NBFM_DECIM1*NBFM_DECIM2))
+uint16_t nbfm_process(const float* I, const float* Q, uint16_t n, float* out)
+{
+	float open_pow = Sq_open_pow, close_pow = Sq_close_pow, scale = Audio_scale;
+	uint16_t k, l, m;
+	float i, q, d, x, y;
+	bool tone_ok;
+
+	l = fir_decim(&FIR1_I, I, Dec1_I, n);
+	fir_decim(&FIR1_Q, Q, Dec1_Q, n);
+	m = fir_decim(&FIR2_I, Dec1_I, Dec2_I, l);
+	fir_decim(&FIR2_Q, Dec1_Q, Dec2_Q, l);
+
+	switch (NBFM_Config.tone)
+	{
+	case NBFM_TONE_CTCSS:
+		tone_ok = Ctcss_detected == NBFM_Config.ctcss;
+		break;
+
+	case NBFM_TONE_DCS:
+		tone_ok = Dcs_hold > 0;
+		break;
+
+	default:
+		tone_ok = true;
+		break;
+	}
+
+	for (k = 0; k < m; k++)
+	{
+		//polar discriminator: arg(z*conj(z_prev))
+		i = Dec2_I[k];
+		q = Dec2_Q[k];
+		d = fast_atan2f(q*Prev_I - i*Prev_Q, i*Prev_I + q*Prev_Q);
+		Prev_I = i;
+		Prev_Q = q;
+		NBFM_Discr[k] = d;
+
+		//noise squelch with hysteresis
+		x = nbfm_biquads(NBFM_NOISE_IIR, Z_noise, NBFM_NOISE_SECTIONS, d);
+		Noise_pow += (x*x - Noise_pow)*NBFM_NOISE_AVG;
+		if (Sq_open) Sq_open = Noise_pow < close_pow;
+		else Sq_open = Noise_pow < open_pow;
+
+		//sub-audio
+		x = nbfm_biquads(NBFM_TONE_IIR, Z_tone, NBFM_TONE_SECTIONS, d);
+		if (++Tone_cnt == NBFM_TONE_DECIM)
+		{
+			Tone_cnt = 0;
+			nbfm_tone(x);
+		}
+
+		//voice
+		Deemph += (d - Deemph)*Deemph_coeff;
+		y = nbfm_biquads(NBFM_AUDIO_IIR, Z_audio, NBFM_AUDIO_SECTIONS, Deemph);
+
+		Gate += ((Sq_open && tone_ok ? 1.0f : 0.0f) - Gate)*NBFM_GATE_RAMP;
+		out[k] = y*scale*Gate;
+	}
+
+	return m;
+}
+
+void nbfm_print(void)
+{
+	uint8_t ctcss = Ctcss_detected;
+	uint16_t dcs = Dcs_detected;
+
+	UART_printf("nbfm: channel %s kHz ; noise %.1f dB ; squelch ", nbfm_channel_name[NBFM_Config.channel],
+			10.0*log10f(Noise_pow/NBFM_noise_ref[NBFM_Config.channel] + 1.0e-30f));
+	if (NBFM_Config.squelch_dB == 0) UART_printf("off");
+	else UART_printf("%d dB (%s)", NBFM_Config.squelch_dB, Sq_open ? "open" : "closed");
+
+	if (NBFM_Config.tone == NBFM_TONE_CTCSS)
+		UART_printf(" ; CTCSS %.1f Hz", nbfm_ctcss_dHz[NBFM_Config.ctcss]/10.0);
+	else if (NBFM_Config.tone == NBFM_TONE_DCS)
+		UART_printf(" ; DCS %03o", NBFM_Config.dcs);
+	else
+		UART_printf(" ; tone off");
+
+	UART_printf("\r\nreceived: CTCSS ");
+	if (ctcss != NBFM_CTCSS_NONE) UART_printf("%.1f Hz (%.2f)", nbfm_ctcss_dHz[ctcss]/10.0, Ctcss_ratio);
+	else UART_printf("none (%.2f)", Ctcss_ratio);
+	if ( (dcs != NBFM_DCS_NONE) && (Dcs_seen > 0) ) UART_printf(" ; DCS %03o%c\r\n", dcs, Dcs_inverted ? 'I' : 'N');
+	else UART_printf(" ; DCS none\r\n");
+}
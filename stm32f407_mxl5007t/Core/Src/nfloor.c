@@ -0,0 +1,160 @@
+/*
+ * nfloor.c - noise floor estimator (median of averaged FFT bins of mixer output) and channel SNR
+ *
+ * ADC callback only copies NF_FFT_LEN mixer output samples (complex baseband at FS_ADC_Hz, before IQ filters) when
+ * the capture buffer is free - Hann window, FFT (dsp_fft.c) and statistics run in nf_task() from the main loop (and
+ * from scanner loop). NF_AVG power spectra are averaged, bins of the channel (|f| <= IQ filter cut-off and 2 bins of window
+ * leakage) are summed as signal + noise and the median of the rest (most of 848 kHz band is empty) is the noise
+ * per bin. A carrier doesn't raise the median as it raises mean or minimum of block powers, and both powers come from
+ * the same samples, so SNR doesn't depend on tuner gain. New estimate every NF_AVG*NF_FFT_LEN samples (2.4 ms) plus
+ * FFT time, so the scanner gets several of them in one dwell.
+ */
+#include <string.h>
+#include <math.h>
+#include "nfloor.h"
+#include "dsp_fft.h"
+#include "cmd.h"
+#include "printf.h"
+
+extern IQ_Filter_enum IQ_Filter;
+
+NF_Result_TypeDef NF_Result;
+
+static float Cap_I[NF_FFT_LEN], Cap_Q[NF_FFT_LEN]; //written by ADC callback until full
+static volatile uint16_t Fill;
+static float Re[NF_FFT_LEN], Im[NF_FFT_LEN], Acc[NF_FFT_LEN], Work[NF_FFT_LEN];
+static float Window[NF_FFT_LEN];
+static float Window_pow; //sum of squared window
+static uint8_t Frames;
+
+void nf_init(void)
+{
+	uint16_t k;
+
+	Window_pow = 0;
+	for (k = 0; k < NF_FFT_LEN; k++)
+	{
+		Window[k] = 0.5f - 0.5f*cosf(2.0*M_PI*k/NF_FFT_LEN);
+		Window_pow += Window[k]*Window[k];
+	}
+	nf_reset();
+}
+
+//after retune or filter change - samples in the capture buffer can be older, so they're dropped
+void nf_reset(void)
+{
+	memset(Acc, 0, sizeof(Acc));
+	Frames = 0;
+	NF_Result.count = 0;
+	Fill = 0;
+}
+
+//ADC callback - mixer output block
+void nf_capture(const float* I, const float* Q, uint16_t n)
+{
+	uint16_t fill = Fill;
+
+	if (fill >= NF_FFT_LEN) return; //waiting for nf_task()
+	if (n > NF_FFT_LEN - fill) n = NF_FFT_LEN - fill;
+	memcpy(&Cap_I[fill], I, n*sizeof(float));
+	memcpy(&Cap_Q[fill], Q, n*sizeof(float));
+	Fill = fill + n;
+}
+
+//k-th smallest of x[0...n-1] - x is reordered
+static float nf_select(float* x, uint16_t n, uint16_t k)
+{
+	uint16_t lo = 0, hi = n - 1, i, j;
+	float p, tmp;
+
+	while (lo < hi)
+	{
+		p = x[(lo + hi)/2];
+		i = lo;
+		j = hi;
+		while (i <= j)
+		{
+			while (x[i] < p) i++;
+			while (x[j] > p) j--;
+			if (i <= j)
+			{
+				tmp = x[i]; x[i] = x[j]; x[j] = tmp;
+				i++;
+				if (j == 0) break;
+				j--;
+			}
+		}
+		if (k <= j) hi = j;
+		else if (k >= i) lo = i;
+		else break;
+	}
+	return x[k];
+}
+
+static void nf_estimate(void)
+{
+	const float bin_Hz = FS_ADC_Hz/NF_FFT_LEN;
+	float scale = 1.0f/(NF_AVG*NF_FFT_LEN*Window_pow); //bin powers sum to mean power of samples
+	float p_ch = 0, noise_bin, n_ch, snr;
+	uint16_t ch, k, m = 0;
+
+	ch = (uint16_t) (IQ_Filter_bw_Hz[IQ_Filter]/bin_Hz + 0.5f);
+	if (ch > NF_FFT_LEN/4) ch = NF_FFT_LEN/4;
+
+	p_ch = Acc[0];
+	for (k = 1; k <= ch; k++) p_ch += Acc[k] + Acc[NF_FFT_LEN - k];
+	for (k = ch + 3; k <= NF_FFT_LEN - ch - 3; k++) Work[m++] = Acc[k]; //without channel and leakage bins
+
+	noise_bin = nf_select(Work, m, m/2)*scale/NF_MEDIAN_BIAS;
+	n_ch = noise_bin*(2*ch + 1) + 1.0e-30f;
+	p_ch = p_ch*scale + 1.0e-30f;
+
+	snr = 10*log10f(fmaxf(p_ch - n_ch, 0)/n_ch + 1.0e-30f);
+	NF_Result.noise_dB = 10*log10f(n_ch);
+	NF_Result.channel_dB = 10*log10f(p_ch);
+	NF_Result.snr_dB = fmaxf(snr, NF_SNR_MIN_dB);
+	NF_Result.density_dB = 10*log10f(noise_bin/bin_Hz + 1.0e-30f);
+	NF_Result.count++;
+}
+
+//main loop - one FFT per call when the capture buffer is full
+void nf_task(void)
+{
+	uint16_t k;
+
+	if (Fill < NF_FFT_LEN) return;
+	for (k = 0; k < NF_FFT_LEN; k++)
+	{
+		Re[k] = Cap_I[k]*Window[k];
+		Im[k] = Cap_Q[k]*Window[k];
+	}
+	Fill = 0; //next capture runs during FFT
+
+	fft_cplx(Re, Im, NF_FFT_LEN);
+	for (k = 0; k < NF_FFT_LEN; k++) Acc[k] += Re[k]*Re[k] + Im[k]*Im[k];
+
+	if (++Frames < NF_AVG) return;
+	nf_estimate();
+	memset(Acc, 0, sizeof(Acc));
+	Frames = 0;
+}
+
+//the latest SNR since nf_reset() - -200 dB if there isn't any yet
+float nf_snr_dB(void)
+{
+	if (NF_Result.count == 0) return -200.0;
+	return NF_Result.snr_dB;
+}
+
+void nf_print(void)
+{
+	if (NF_Result.count == 0)
+	{
+		UART_printf("snr: no estimate yet\r\n");
+		return;
+	}
+	UART_printf("snr: %.1f dB ; channel %.1f dB ; noise %.1f dB in +/-%.1f kHz ; noise density %.1f dBFS/Hz\r\n",
+			NF_Result.snr_dB, NF_Result.channel_dB, NF_Result.noise_dB, IQ_Filter_bw_Hz[IQ_Filter]/1.0e3, NF_Result.density_dB);
+	UART_printf("FFT %d bins of %.2f kHz, %d averaged ; estimates %lu\r\n", NF_FFT_LEN, FS_ADC_Hz/NF_FFT_LEN/1.0e3,
+			NF_AVG, NF_Result.count);
+}
@@ -0,0 +1,73 @@
+/*
+ * perf.c - DSP profiling with DWT cycle counter
+ *
+ * Probes are placed around every stage of the ADC block processing, min/avg/max cycles are collected in interrupt
+ * and printed by perf command. CPU load is average DMA interrupt time related to the time between interrupts.
+ */
+#include <string.h>
+#include "main.h"
+#include "perf.h"
+#include "printf.h"
+
+extern TIM_HandleTypeDef htim3;
+
+Perf_Stat_TypeDef Perf_Stat[PERF_PROBES];
+uint32_t Perf_deadline; //CPU cycles between ADC DMA interrupts
+uint32_t Perf_overruns;
+
+static const char *perf_names[PERF_PROBES] = {"scale", "nb", "mixer", "iir", "iq", "demod", "lms", "agc", "output", "wfm_mpx", "wfm_pilot", "wfm_audio", "rds", "data", "callback", "isr"};
+
+void perf_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	//TIM3 clock is 2*PCLK1 because APB1 prescaler isn't 1
+	uint32_t TIM3_clk = 2*HAL_RCC_GetPCLK1Freq();
+	Perf_deadline = ADC_BLOCK * (__HAL_TIM_GET_AUTORELOAD(&htim3) + 1) * (SystemCoreClock / TIM3_clk);
+
+	perf_reset();
+}
+
+void perf_reset(void)
+{
+	uint8_t i;
+
+	__disable_irq();
+	for (i = 0; i < PERF_PROBES; i++)
+	{
+		memset(&Perf_Stat[i], 0, sizeof(Perf_Stat_TypeDef));
+		Perf_Stat[i].min = 0xFFFFFFFF;
+	}
+	Perf_overruns = 0;
+	ADC_overruns = 0;
+	__enable_irq();
+}
+
+void perf_print(void)
+{
+	Perf_Stat_TypeDef s[PERF_PROBES];
+	uint32_t overruns, adc_overruns;
+	uint8_t i;
+
+	__disable_irq();
+	memcpy(s, Perf_Stat, sizeof(s));
+	overruns = Perf_overruns;
+	adc_overruns = ADC_overruns;
+	__enable_irq();
+
+	UART_printf("stage       min    avg    max [cycles]\r\n");
+	for (i = 0; i < PERF_PROBES; i++)
+	{
+		if (s[i].cnt == 0)
+			UART_printf("%-9s      -      -      -\r\n", perf_names[i]);
+		else
+			UART_printf("%-9s %6ld %6ld %6ld\r\n", perf_names[i], s[i].min, (uint32_t) (s[i].sum/s[i].cnt), s[i].max);
+	}
+
+	if (s[PERF_ISR].cnt != 0)
+		UART_printf("deadline: %ld cycles ; CPU load: %.1f %% ; overruns: %ld\r\n", Perf_deadline,
+				100.0*s[PERF_ISR].sum/s[PERF_ISR].cnt/Perf_deadline, overruns);
+	UART_printf("ADC buffer overruns: %ld\r\n", adc_overruns);
+}
@@ -0,0 +1,178 @@
+/*
+ * pocsag.c - POCSAG pager batch synchronization, BCH(31,21) correction and message decoding
+ *
+ * Sync word (either polarity - it tells FSK polarity) starts a batch of 8 frames of 2 codewords. Codeword is
+ * 21 bits (flag, 20 bits of address or message), BCH(31,21) check bits and even parity - one bit error is corrected.
+ * Address codeword gives 18 upper bits of address (frame number gives 3 lower ones) and function, message codewords
+ * give 20 bits of numeric (4 bit BCD) or alphanumeric (7 bit ASCII, LSB first) message. Message is printed when
+ * address, idle codeword or loss of sync ends it.
+ */
+#include <string.h>
+#include "pocsag.h"
+#include "printf.h"
+
+#define POCSAG_BCH_POLY  0x769 //x^10+x^9+x^8+x^6+x^5+x^3+1
+
+POCSAG_Stat_TypeDef POCSAG_Stat;
+
+static const char pocsag_numeric[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '*', 'U', ' ', '-', ')', '('};
+
+static uint16_t Baud;
+static uint32_t Reg;        //last 32 bits
+static bool Synced, Inverted;
+static uint8_t Bit_cnt, Cw_idx;
+
+static bool Msg_active;
+static uint32_t Msg_address;
+static uint8_t Msg_function;
+static char Msg_numeric[POCSAG_MSG_MAX + 1], Msg_alpha[POCSAG_MSG_MAX + 1];
+static uint8_t Numeric_len, Alpha_len, Numeric_bits, Alpha_bits, Numeric_chr, Alpha_chr;
+static bool Msg_error;
+
+void pocsag_reset(uint16_t baud)
+{
+	memset(&POCSAG_Stat, 0, sizeof(POCSAG_Stat));
+	Baud = baud;
+	Reg = 0;
+	Synced = Inverted = false;
+	Bit_cnt = Cw_idx = 0;
+	Msg_active = false;
+}
+
+static bool pocsag_valid(uint32_t cw)
+{
+	uint32_t r = cw >> 1;
+	int8_t j;
+
+	if (__builtin_parity(cw)) return false;
+	for (j = 30; j >= 10; j--)
+		if (r & (1UL << j)) r ^= (uint32_t) POCSAG_BCH_POLY << (j - 10);
+	return r == 0;
+}
+
+//false if the codeword can't be corrected
+static bool pocsag_correct(uint32_t* cw)
+{
+	uint8_t j;
+
+	if (pocsag_valid(*cw)) return true;
+	for (j = 0; j < 32; j++)
+		if (pocsag_valid(*cw ^ (1UL << j)))
+		{
+			*cw ^= 1UL << j;
+			POCSAG_Stat.corrected++;
+			return true;
+		}
+	return false;
+}
+
+static void pocsag_flush(void)
+{
+	char* text;
+	int16_t len;
+
+	if (!Msg_active) return;
+	Msg_active = false;
+	POCSAG_Stat.messages++;
+
+	if (Msg_function == 0) //numeric pagers
+	{
+		text = Msg_numeric;
+		len = Numeric_len;
+		while ((len > 0) && (text[len - 1] == ' ')) len--; //padding
+	}
+	else
+	{
+		text = Msg_alpha;
+		len = Alpha_len;
+	}
+	text[len] = 0;
+	UART_printf("POCSAG%u: %7lu/%u%s: %s\r\n", Baud, Msg_address, Msg_function, Msg_error ? " (errors)" : "", text);
+}
+
+static void pocsag_codeword(uint32_t cw, uint8_t frame)
+{
+	int8_t j;
+	uint8_t bit;
+
+	if (!pocsag_correct(&cw))
+	{
+		POCSAG_Stat.errors++;
+		if (Msg_active) Msg_error = true;
+		return;
+	}
+	if (cw == POCSAG_IDLE)
+	{
+		pocsag_flush();
+		return;
+	}
+	if (!(cw & 0x80000000)) //address
+	{
+		pocsag_flush();
+		Msg_active = true;
+		Msg_address = (((cw >> 13) & 0x3FFFF) << 3) | frame;
+		Msg_function = (cw >> 11) & 3;
+		Msg_error = false;
+		Numeric_len = Alpha_len = Numeric_bits = Alpha_bits = Numeric_chr = Alpha_chr = 0;
+		return;
+	}
+	if (!Msg_active) return;
+
+	//both decodings are collected, function tells which one is printed
+	for (j = 30; j >= 11; j--)
+	{
+		bit = (cw >> j) & 1;
+		Numeric_chr |= bit << Numeric_bits;
+		if (++Numeric_bits == 4)
+		{
+			if (Numeric_len < POCSAG_MSG_MAX) Msg_numeric[Numeric_len++] = pocsag_numeric[Numeric_chr];
+			Numeric_bits = Numeric_chr = 0;
+		}
+		Alpha_chr |= bit << Alpha_bits;
+		if (++Alpha_bits == 7)
+		{
+			if ( (Alpha_len < POCSAG_MSG_MAX) && (Alpha_chr >= ' ') && (Alpha_chr < 0x7F) ) Msg_alpha[Alpha_len++] = Alpha_chr;
+			Alpha_bits = Alpha_chr = 0;
+		}
+	}
+}
+
+void pocsag_bit(uint8_t bit)
+{
+	uint32_t cw;
+
+	Reg = (Reg << 1) | (bit & 1);
+
+	if (!Synced)
+	{
+		if ( (Reg == POCSAG_SYNC) || (Reg == (uint32_t) ~POCSAG_SYNC) )
+		{
+			Synced = true;
+			Inverted = Reg != POCSAG_SYNC;
+			Bit_cnt = Cw_idx = 0;
+			POCSAG_Stat.batches++;
+		}
+		return;
+	}
+
+	if (++Bit_cnt < 32) return;
+	Bit_cnt = 0;
+	cw = Inverted ? ~Reg : Reg;
+
+	if (Cw_idx == POCSAG_BATCH) //sync word of the next batch expected
+	{
+		if (__builtin_popcount(cw ^ POCSAG_SYNC) <= POCSAG_SYNC_ERR)
+		{
+			Cw_idx = 0;
+			POCSAG_Stat.batches++;
+		}
+		else
+		{
+			pocsag_flush();
+			Synced = false;
+		}
+		return;
+	}
+	pocsag_codeword(cw, Cw_idx/2);
+	Cw_idx++;
+}
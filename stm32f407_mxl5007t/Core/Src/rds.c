@@ -0,0 +1,442 @@
+/*
+ * rds.c - RDS/RBDS decoder from WFM multiplex signal
+ *
+ * Demodulator runs in ADC callback on MPX block from wfm_process():
+ * 57 kHz band pass FIR with decimation by 8 (complex coefficients - mixing is done after decimation, so there's no
+ * multiplication by sine/cosine at 212 kHz), Costas loop with NCO at 26.5 kHz, low pass FIR with decimation by 2,
+ * biphase matched filter and Gardner symbol clock recovery at 13.3 kHz. Differentially decoded bits are passed
+ * by ring buffer to rds_task() in main loop, where block synchronization, error correction and group decoding is done.
+ */
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+#include "main.h"
+#include "rds.h"
+#include "dsp_math.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "printf.h"
+
+#define RAD_TO_PHASE 683565275.6f //2^32/(2*pi)
+
+#define RDS_POLY 0x5B9 //g(x)=x^10+x^8+x^7+x^5+x^4+x^3+1
+
+//offset words of blocks A, B, C, C' and D
+enum { RDS_BLK_A = 0, RDS_BLK_B, RDS_BLK_C, RDS_BLK_C2, RDS_BLK_D, RDS_BLK_NUM };
+static const uint16_t rds_offset[RDS_BLK_NUM] = {0x0FC, 0x198, 0x168, 0x350, 0x1B4};
+static const uint8_t rds_blk_pos[RDS_BLK_NUM] = {0, 1, 2, 2, 3}; //position in group
+
+RDS_Config_TypeDef RDS_Config =
+{
+	.enabled = true,
+	.print = true
+};
+
+//band pass decimation - the same input for real and imaginary part
+static float FIR1_I_delay[2*RDS_FIR1_TAPS], FIR1_Q_delay[2*RDS_FIR1_TAPS];
+static FIR_Decim_TypeDef FIR1_I = {RDS_FIR1_I, RDS_FIR1_TAPS, RDS_DECIM1, 0, 0, FIR1_I_delay};
+static FIR_Decim_TypeDef FIR1_Q = {RDS_FIR1_Q, RDS_FIR1_TAPS, RDS_DECIM1, 0, 0, FIR1_Q_delay};
+
+//low pass decimation
+static float FIR2_I_delay[2*RDS_FIR2_TAPS], FIR2_Q_delay[2*RDS_FIR2_TAPS];
+static FIR_Decim_TypeDef FIR2_I = {RDS_FIR2, RDS_FIR2_TAPS, RDS_DECIM2, 0, 0, FIR2_I_delay};
+static FIR_Decim_TypeDef FIR2_Q = {RDS_FIR2, RDS_FIR2_TAPS, RDS_DECIM2, 0, 0, FIR2_Q_delay};
+
+//matched filter
+static float MF_delay[2*RDS_MF_TAPS];
+static FIR_Decim_TypeDef MF = {RDS_MF, RDS_MF_TAPS, 1, 0, 0, MF_delay};
+
+//block buffers
+static float S1_I[BB_BLOCK/RDS_DECIM1], S1_Q[BB_BLOCK/RDS_DECIM1];
+static float S2_I[BB_BLOCK/RDS_DECIM1], S2_Q[BB_BLOCK/RDS_DECIM1];
+static float Sym[BB_BLOCK/RDS_DECIM1];
+
+//Costas loop - NCO at FS_BB_Hz/RDS_DECIM1
+static uint32_t NCO_phase, NCO_step;
+static float Costas_int, Costas_freq, Costas_Kp, Costas_Ki, Costas_int_max;
+
+//symbol clock - phase accumulator overflows in the middle of the bit
+static uint32_t Clk_phase, Clk_step;
+static int32_t Clk_adj; //correction added to the next step, so the accumulator never goes backwards
+static float Clk_y_prev, Clk_y_mid;
+static uint8_t Clk_sym_prev;
+
+//bits to main loop
+static volatile uint8_t RDS_bits[RDS_BITS_RING];
+static volatile uint16_t RDS_bits_head; //written in ADC callback
+static uint16_t RDS_bits_tail;
+static uint32_t RDS_bits_lost;
+
+//block synchronization
+static uint32_t Blk_reg;            //the last 26 bits
+static uint32_t Bit_cnt;            //bits since decoder reset
+static uint32_t Blk_found_bit;      //bit number of the last block found during acquisition
+static uint8_t Blk_found_pos;
+static bool Synced;
+static uint8_t Blk_pos;             //expected block position in group
+static uint8_t Blk_bits;            //bits of current block
+static uint8_t Blk_bad_run;         //consecutive uncorrectable blocks
+static uint32_t Blk_ok, Blk_corrected, Blk_errors;
+
+//group
+static uint16_t Group[4];
+static uint8_t Group_valid;         //bit per block
+
+//decoded data
+static uint16_t PI_code, PI_candidate;
+static uint8_t PTY;
+static char PS[9], PS_shown[9];
+static uint8_t PS_seg;
+static char RT[65], RT_shown[65];
+static uint32_t RT_seg;
+static int8_t RT_ab;
+static bool RT_ver_B;
+
+static void rds_data_reset(void)
+{
+	memset(PS, ' ', 8);
+	PS[8] = 0;
+	memset(RT, ' ', 64);
+	RT[64] = 0;
+	PS_shown[0] = 0;
+	RT_shown[0] = 0;
+	PS_seg = 0;
+	RT_seg = 0;
+	RT_ab = -1;
+	PTY = 0;
+}
+
+//has to be called when rds_process() isn't running (it's called by wfm_init())
+void rds_init(void)
+{
+	//2nd order loop: Kp=2*zeta*wn*T ; Ki=(wn*T)^2 ; phase detector gain is 1 (normalized I*Q)
+	float wnT = 2.0*M_PI*RDS_COSTAS_BW_Hz/RDS_FS_Hz;
+	Costas_Kp = 2.0*RDS_COSTAS_ZETA*wnT;
+	Costas_Ki = wnT*wnT;
+	Costas_int_max = 2.0*M_PI*RDS_COSTAS_RANGE_Hz/RDS_FS_Hz;
+	Costas_int = Costas_freq = 0;
+	NCO_phase = 0;
+	NCO_step = (uint32_t) fmod(RDS_CARRIER_Hz*RDS_DECIM1/FS_BB_Hz*4294967296.0, 4294967296.0);
+
+	Clk_phase = 0;
+	Clk_step = (uint32_t) (RDS_BITRATE_Hz/RDS_FS_Hz*4294967296.0);
+	Clk_adj = 0;
+	Clk_y_prev = Clk_y_mid = 0;
+	Clk_sym_prev = 0;
+
+	fir_reset(&FIR1_I);
+	fir_reset(&FIR1_Q);
+	fir_reset(&FIR2_I);
+	fir_reset(&FIR2_Q);
+	fir_reset(&MF);
+
+	RDS_bits_head = RDS_bits_tail = 0;
+	RDS_bits_lost = 0;
+
+	Blk_reg = 0;
+	Bit_cnt = 0;
+	Blk_found_bit = 0;
+	Blk_found_pos = 0xFF;
+	Synced = false;
+	Blk_ok = Blk_corrected = Blk_errors = 0;
+	Group_valid = 0;
+	PI_code = PI_candidate = 0;
+	rds_data_reset();
+}
+
+//MPX block at FS_BB_Hz - n has to be multiple of RDS_DECIM1
+void rds_process(const float* mpx, uint16_t n)
+{
+	uint16_t k, m;
+	uint32_t prev;
+	float s, c, re, im, err, y;
+	uint8_t sym;
+
+	//57 kHz band pass and decimation - output is at 57 kHz*RDS_DECIM1 modulo FS_BB_Hz, NCO moves it to 0 Hz
+	m = fir_decim(&FIR1_I, mpx, S1_I, n);
+	fir_decim(&FIR1_Q, mpx, S1_Q, n);
+
+	for (k = 0; k < m; k++)
+	{
+		fast_sincos_phase(NCO_phase, &s, &c);
+		re = S1_I[k]*c + S1_Q[k]*s;
+		im = S1_Q[k]*c - S1_I[k]*s;
+		S1_I[k] = re;
+		S1_Q[k] = im;
+		NCO_phase += NCO_step + (int32_t) (Costas_freq*RAD_TO_PHASE);
+	}
+
+	k = fir_decim(&FIR2_I, S1_I, S2_I, m);
+	fir_decim(&FIR2_Q, S1_Q, S2_Q, m);
+	m = k;
+
+	//Costas loop - BPSK data is in I, NCO is updated at twice the rate
+	for (k = 0; k < m; k++)
+	{
+		err = S2_I[k]*S2_Q[k]*fast_recipf(S2_I[k]*S2_I[k] + S2_Q[k]*S2_Q[k] + 1.0e-20f);
+		Costas_int += Costas_Ki*err;
+		if (Costas_int > Costas_int_max) Costas_int = Costas_int_max;
+		if (Costas_int < -Costas_int_max) Costas_int = -Costas_int_max;
+		Costas_freq = (Costas_int + Costas_Kp*err)*(1.0f/RDS_DECIM2);
+	}
+
+	fir_decim(&MF, S2_I, Sym, m);
+
+	//symbol clock - Gardner timing error from samples in the middle between bits
+	for (k = 0; k < m; k++)
+	{
+		y = Sym[k];
+		prev = Clk_phase;
+		Clk_phase += Clk_step + Clk_adj;
+		Clk_adj = 0;
+
+		if ( (prev < 0x80000000) && (Clk_phase >= 0x80000000) ) Clk_y_mid = y;
+
+		if (Clk_phase < prev)
+		{
+			//late sampling - middle sample has sign of the current bit, so the clock has to be advanced
+			err = Clk_y_mid*(y - Clk_y_prev)*fast_recipf(Clk_y_prev*Clk_y_prev + y*y + 1.0e-20f);
+			Clk_adj = (int32_t) (RDS_CLOCK_GAIN*err*4294967296.0);
+			Clk_y_prev = y;
+
+			//differential decoding - 180 degrees ambiguity of Costas loop doesn't matter
+			sym = (y > 0);
+			RDS_bits[RDS_bits_head & (RDS_BITS_RING-1)] = sym ^ Clk_sym_prev;
+			RDS_bits_head++;
+			Clk_sym_prev = sym;
+		}
+	}
+}
+
+//remainder of 26-bit block divided by g(x) - it's equal to the offset word for error free block
+static uint16_t rds_syndrome(uint32_t blk)
+{
+	int8_t i;
+	for (i = 25; i >= 10; i--)
+		if (blk & (1UL << i)) blk ^= (uint32_t) RDS_POLY << (i - 10);
+	return blk & 0x3FF;
+}
+
+//burst errors up to RDS_MAX_BURST bits - syndrome of e(x)=p(x)*x^i is searched by multiplication of p(x) by x modulo g(x)
+static bool rds_correct(uint32_t* blk, uint16_t syndrome)
+{
+	uint16_t p, r;
+	uint8_t i;
+
+	for (p = 1; p < (1 << RDS_MAX_BURST); p += 2)
+	{
+		r = p;
+		for (i = 0; ((uint32_t) p << i) < (1UL << 26); i++)
+		{
+			if (r == syndrome)
+			{
+				*blk ^= (uint32_t) p << i;
+				return true;
+			}
+			r <<= 1;
+			if (r & 0x400) r ^= RDS_POLY;
+		}
+	}
+	return false;
+}
+
+static char rds_char(uint8_t c)
+{
+	return ( (c >= 0x20) && (c < 0x7F) ) ? c : '.';
+}
+
+static void rds_group(void)
+{
+	uint16_t b = Group[1];
+	uint8_t type = b >> 12, ver_B = (b >> 11) & 1, addr;
+	uint16_t pi;
+	uint8_t i, n, segs;
+
+	//PI from block A (or C' in version B) - it has to be received twice before decoded data is cleared
+	if (Group_valid & 1) pi = Group[0];
+	else if ( ver_B && (Group_valid & 4) ) pi = Group[2];
+	else pi = 0;
+
+	if ( (pi != 0) && (pi != PI_code) )
+	{
+		if (pi == PI_candidate)
+		{
+			PI_code = pi;
+			rds_data_reset();
+			if (RDS_Config.print) UART_printf("RDS PI: %04X\r\n", PI_code);
+		}
+		PI_candidate = pi;
+	}
+	if ( !(Group_valid & 2) || (PI_code == 0) ) return;
+
+	PTY = (b >> 5) & 0x1F;
+
+	//0A/0B - program service name, 2 characters in block D
+	if ( (type == 0) && (Group_valid & 8) )
+	{
+		addr = b & 0x03;
+		PS[2*addr] = rds_char(Group[3] >> 8);
+		PS[2*addr + 1] = rds_char(Group[3]);
+		PS_seg |= 1 << addr;
+
+		if ( (PS_seg == 0x0F) && (strcmp(PS, PS_shown) != 0) )
+		{
+			strcpy(PS_shown, PS);
+			if (RDS_Config.print) UART_printf("RDS PS: '%s'\r\n", PS);
+		}
+	}
+
+	//2A/2B - radio text, 4 characters in blocks C and D or 2 characters in block D
+	if (type == 2)
+	{
+		addr = b & 0x0F;
+		if ( (((b >> 4) & 1) != RT_ab) || (ver_B != RT_ver_B) ) //A/B flag toggles for new text
+		{
+			memset(RT, ' ', 64);
+			RT_seg = 0;
+			RT_ab = (b >> 4) & 1;
+			RT_ver_B = ver_B;
+		}
+
+		if (!ver_B && (Group_valid & 0x0C) == 0x0C)
+		{
+			RT[4*addr] = Group[2] >> 8;
+			RT[4*addr + 1] = Group[2];
+			RT[4*addr + 2] = Group[3] >> 8;
+			RT[4*addr + 3] = Group[3];
+			RT_seg |= 1UL << addr;
+		}
+		else if (ver_B && (Group_valid & 8))
+		{
+			RT[2*addr] = Group[3] >> 8;
+			RT[2*addr + 1] = Group[3];
+			RT_seg |= 1UL << addr;
+		}
+
+		//text is complete when all segments up to carriage return (or the last one) are received
+		n = ver_B ? 32 : 64;
+		for (i = 0; i < n; i++) if (RT[i] == '\r') break;
+		n = i;
+		segs = ver_B ? (n + 1)/2 : (n + 3)/4;
+		if ( (RT_seg & ((1UL << segs) - 1)) == ((1UL << segs) - 1) )
+		{
+			char text[65];
+			for (i = 0; i < n; i++) text[i] = rds_char(RT[i]);
+			while ( (i > 0) && (text[i-1] == ' ') ) i--;
+			text[i] = 0;
+
+			if (strcmp(text, RT_shown) != 0)
+			{
+				strcpy(RT_shown, text);
+				if (RDS_Config.print) UART_printf("RDS RT: '%s'\r\n", text);
+			}
+		}
+	}
+}
+
+static void rds_block(void)
+{
+	uint16_t syndrome = rds_syndrome(Blk_reg);
+	uint8_t off = (Blk_pos == 2) ? RDS_BLK_C : (Blk_pos == 3) ? RDS_BLK_D : Blk_pos;
+	bool ok = false;
+
+	if (syndrome == rds_offset[off])
+		ok = true;
+	else if ( (Blk_pos == 2) && (syndrome == rds_offset[RDS_BLK_C2]) )
+		ok = true;
+	else if (rds_correct(&Blk_reg, syndrome ^ rds_offset[off]))
+	{
+		ok = true;
+		Blk_corrected++;
+	}
+	else if ( (Blk_pos == 2) && rds_correct(&Blk_reg, syndrome ^ rds_offset[RDS_BLK_C2]) )
+	{
+		ok = true;
+		Blk_corrected++;
+	}
+
+	if (Blk_pos == 0) Group_valid = 0;
+	if (ok)
+	{
+		Group[Blk_pos] = Blk_reg >> 10;
+		Group_valid |= 1 << Blk_pos;
+		Blk_ok++;
+		Blk_bad_run = 0;
+	}
+	else
+	{
+		Blk_errors++;
+		Blk_bad_run++;
+	}
+	if (Blk_pos == 3) rds_group();
+
+	Blk_pos = (Blk_pos + 1) & 3;
+	if (Blk_bad_run >= RDS_SYNC_LOSS)
+	{
+		Synced = false;
+		Blk_found_pos = 0xFF;
+	}
+}
+
+//block synchronization and group decoding in main loop
+void rds_task(void)
+{
+	uint16_t syndrome;
+	uint8_t i, pos;
+
+	if ((uint16_t) (RDS_bits_head - RDS_bits_tail) > RDS_BITS_RING)
+	{
+		RDS_bits_lost += (uint16_t) (RDS_bits_head - RDS_bits_tail) - RDS_BITS_RING;
+		RDS_bits_tail = RDS_bits_head - RDS_BITS_RING;
+	}
+
+	while (RDS_bits_tail != RDS_bits_head)
+	{
+		Blk_reg = ((Blk_reg << 1) | RDS_bits[RDS_bits_tail & (RDS_BITS_RING-1)]) & 0x3FFFFFF;
+		RDS_bits_tail++;
+		Bit_cnt++;
+
+		if (Synced)
+		{
+			if (++Blk_bits == 26)
+			{
+				Blk_bits = 0;
+				rds_block();
+			}
+			continue;
+		}
+
+		//acquisition - two error free blocks in right distance and order
+		syndrome = rds_syndrome(Blk_reg);
+		for (i = 0; i < RDS_BLK_NUM; i++)
+		{
+			if (syndrome != rds_offset[i]) continue;
+
+			pos = rds_blk_pos[i];
+			if ( (Blk_found_pos != 0xFF) && ((Bit_cnt - Blk_found_bit) % 26 == 0) && (Bit_cnt - Blk_found_bit <= 26*8) &&
+					(((Blk_found_pos + (Bit_cnt - Blk_found_bit)/26) & 3) == pos) )
+			{
+				Synced = true;
+				Blk_bits = 0;
+				Blk_bad_run = 0;
+				Group_valid = 0;
+				Blk_pos = pos;
+				rds_block(); //the block found is processed as the first one
+			}
+			else
+			{
+				Blk_found_bit = Bit_cnt;
+				Blk_found_pos = pos;
+			}
+			break;
+		}
+	}
+}
+
+void rds_print(void)
+{
+	UART_printf("rds: %s ; %s ; PI %04X ; PTY %d ; carrier offset %.2f Hz\r\n", RDS_Config.enabled ? "on" : "off",
+			Synced ? "synchronized" : "no sync", PI_code, PTY, Costas_int*RDS_FS_Hz/(2.0*M_PI));
+	UART_printf("PS: '%s' ; RT: '%s'\r\n", PS_shown, RT_shown);
+	UART_printf("blocks: ok %lu (corrected %lu) ; errors %lu ; bits lost %lu\r\n", Blk_ok, Blk_corrected, Blk_errors, RDS_bits_lost);
+}
@@ -0,0 +1,156 @@
+/*
+ * sam.c - synchronous AM detector with carrier tracking PLL
+ *
+ * I/Q is decimated to AUDIO_FS_Hz (the same FIR like in SSB demodulator) and rotated by PLL NCO, so the carrier
+ * stays on I axis - in-phase component is the audio with both sidebands added coherently, and selective fading
+ * of the carrier doesn't distort it like in envelope detector. One sideband can be selected by Weaver method
+ * (shift by SAM_SB_SHIFT_Hz, low pass I and Q, shift back), LSB is USB of conjugated I/Q.
+ * Audio level is set by the audio AGC (agc.c) like in the other modes. Without lock the output is
+ * envelope (dsp_mag kernel) until the carrier is caught.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include "main.h"
+#include "sam.h"
+#include "audio_i2s.h"
+#include "dsp_math.h"
+#include "dsp_mag.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "printf.h"
+
+#define RAD_TO_PHASE 683565275.6f //2^32/(2*pi)
+
+SAM_Config_TypeDef SAM_Config =
+{
+	.sideband = SAM_DSB
+};
+
+const char *sam_sideband_name[SAM_SIDEBANDS] = {"DSB", "USB", "LSB"}; //the same order like SAM_Sideband_enum
+
+//I/Q decimation
+static float FIR_I_delay[2*SSB_FIR1_TAPS], FIR_Q_delay[2*SSB_FIR1_TAPS];
+static FIR_Decim_TypeDef FIR_I = {SSB_FIR1, SSB_FIR1_TAPS, SAM_DECIM, 0, 0, FIR_I_delay};
+static FIR_Decim_TypeDef FIR_Q = {SSB_FIR1, SSB_FIR1_TAPS, SAM_DECIM, 0, 0, FIR_Q_delay};
+static float Dec_I[BB_BLOCK/SAM_DECIM], Dec_Q[BB_BLOCK/SAM_DECIM];
+
+//carrier PLL
+static uint32_t PLL_phase;
+static float PLL_int, PLL_int_max;
+static float PLL_Kp[2], PLL_Ki[2]; //[0] - acquisition, [1] - locked
+static float Lock_I, Lock_Q; //carrier level in phase and in quadrature
+static bool PLL_locked;
+
+//sideband selection
+static float Z_I[SAM_IIR_SECTIONS][2], Z_Q[SAM_IIR_SECTIONS][2];
+static uint32_t SB_phase, SB_step;
+
+//scaling and DC removal
+static float Carrier, DC;
+
+//has to be called before Demod_Type is switched to DEMOD_SAM (it's not synchronized with ADC callbacks)
+void sam_init(void)
+{
+	uint8_t k;
+
+	//2nd order PLL: Kp=2*zeta*wn*T ; Ki=(wn*T)^2 ; phase detector is atan2 so Kd=1
+	float wnT = 2.0*M_PI*SAM_PLL_ACQ_Hz/AUDIO_FS_Hz;
+	PLL_Kp[0] = 2.0*SAM_PLL_ZETA*wnT;
+	PLL_Ki[0] = wnT*wnT;
+	wnT = 2.0*M_PI*SAM_PLL_BW_Hz/AUDIO_FS_Hz;
+	PLL_Kp[1] = 2.0*SAM_PLL_ZETA*wnT;
+	PLL_Ki[1] = wnT*wnT;
+	PLL_int_max = 2.0*M_PI*SAM_PLL_RANGE_Hz/AUDIO_FS_Hz;
+	PLL_int = 0;
+	PLL_phase = 0;
+	Lock_I = Lock_Q = 0;
+	PLL_locked = false;
+
+	fir_reset(&FIR_I);
+	fir_reset(&FIR_Q);
+	for (k = 0; k < SAM_IIR_SECTIONS; k++)
+		Z_I[k][0] = Z_I[k][1] = Z_Q[k][0] = Z_Q[k][1] = 0;
+	SB_phase = 0;
+	SB_step = (uint32_t) (SAM_SB_SHIFT_Hz*4294967296.0/AUDIO_FS_Hz);
+
+	Carrier = DC = 0;
+}
+
+//returns number of audio samples in out (n/SAM_DECIM)
+uint16_t sam_process(const float* I, const float* Q, uint16_t n, float* out)
+{
+	SAM_Sideband_enum sb = SAM_Config.sideband;
+	Mag_Mode_enum mag_mode = Mag_Mode[MAG_USER_SAM];
+	uint16_t k, m;
+	uint8_t j;
+	float i, q, s, c, err, env, y, ti, tq;
+
+	m = fir_decim(&FIR_I, I, Dec_I, n);
+	fir_decim(&FIR_Q, Q, Dec_Q, n);
+
+	for (k = 0; k < m; k++)
+	{
+		//carrier to I axis: (I + jQ)*exp(-j*phase)
+		fast_sincos_phase(PLL_phase, &s, &c);
+		i = Dec_I[k]*c + Dec_Q[k]*s;
+		q = Dec_Q[k]*c - Dec_I[k]*s;
+
+		err = fast_atan2f(q, i);
+		PLL_int += PLL_Ki[PLL_locked]*err;
+		if (PLL_int > PLL_int_max) PLL_int = PLL_int_max;
+		if (PLL_int < -PLL_int_max) PLL_int = -PLL_int_max;
+		PLL_phase += (int32_t) ((PLL_int + PLL_Kp[PLL_locked]*err)*RAD_TO_PHASE);
+
+		//carrier level is DC of envelope - audio is scaled by it
+		env = mag_calc(i, q, mag_mode);
+		Carrier += (env - Carrier)*SAM_AVG;
+
+		//lock detector with hysteresis - sidebands average out, so only the carrier is left
+		Lock_I += (i - Lock_I)*(1.0f/1024.0f);
+		Lock_Q += (q - Lock_Q)*(1.0f/1024.0f);
+		if (PLL_locked) PLL_locked = Lock_I > 0.5f*SAM_LOCK_RATIO*Carrier;
+		else PLL_locked = (Lock_I > SAM_LOCK_RATIO*Carrier) && (Lock_I > 4.0f*fabsf(Lock_Q));
+
+		if (!PLL_locked)
+			y = env;
+		else if (sb == SAM_DSB)
+			y = i;
+		else
+		{
+			//Weaver: one sideband is shifted to +/-SAM_SB_SHIFT_Hz band, the other is removed by low pass filters
+			if (sb == SAM_LSB) q = -q;
+			fast_sincos_phase(SB_phase, &s, &c);
+			ti = i*c + q*s;
+			tq = q*c - i*s;
+
+			for (j = 0; j < SAM_IIR_SECTIONS; j++)
+			{
+				const float* bq = &SAM_IIR[5*j];
+
+				i = ti - (Z_I[j][0]*bq[3] + Z_I[j][1]*bq[4]);
+				ti = i*bq[0] + Z_I[j][0]*bq[1] + Z_I[j][1]*bq[2];
+				Z_I[j][1] = Z_I[j][0];
+				Z_I[j][0] = i;
+
+				q = tq - (Z_Q[j][0]*bq[3] + Z_Q[j][1]*bq[4]);
+				tq = q*bq[0] + Z_Q[j][0]*bq[1] + Z_Q[j][1]*bq[2];
+				Z_Q[j][1] = Z_Q[j][0];
+				Z_Q[j][0] = q;
+			}
+
+			y = 2.0f*(ti*c - tq*s); //one sideband carries half of DSB audio
+		}
+		SB_phase += SB_step;
+
+		DC += (y - DC)*SAM_AVG;
+		out[k] = y - DC; //level is set by audio AGC (agc.c)
+	}
+
+	return m;
+}
+
+void sam_print(void)
+{
+	UART_printf("sam: %s ; carrier %s (offset %.1f Hz ; level %.2e ; I %.2e Q %.2e)\r\n", sam_sideband_name[SAM_Config.sideband],
+			PLL_locked ? "locked" : "not locked", PLL_int*AUDIO_FS_Hz/(2.0*M_PI), Carrier, Lock_I, Lock_Q);
+}
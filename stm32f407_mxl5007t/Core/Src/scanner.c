@@ -0,0 +1,346 @@
+/*
+ * scanner.c - squelch controlled frequency scanner
+ *
+ * Non-blocking state machine: tune -> settle -> dwell (level measurement) -> next channel.
+ * If the level is above squelch open threshold the scanner stops on the channel and unmutes the audio,
+ * when the level drops below (open threshold - hysteresis) the hang time starts and after that scanning resumes automatically.
+ * Audio is muted in the DSP path (DSP_Mute) so there are no CS43L22 I2C transfers for every step.
+ *
+ * With Scan_Config.snr the level is SNR from noise floor estimator (nfloor.c), so thresholds don't depend on tuner gain.
+ *
+ * Memory scan visits stored memory channels (mem_bank.c) with their own squelch thresholds and checks
+ * priority channel every N steps and periodically while another channel is held open.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <stdbool.h>
+#include "main.h"
+#include "scanner.h"
+#include "mem_bank.h"
+#include "printf.h"
+#include "dsp_mag.h"
+#include "nfloor.h"
+#include "led.h"
+#include "MxL5007_Common.h"
+#include "MxL5007_API.h"
+#include "MxL_User_Define.h"
+
+extern float I, Q;
+extern MxL5007_TunerConfigS myTuner;
+extern volatile bool DSP_Mute;
+
+Scan_Config_TypeDef Scan_Config =
+{
+	.settle_ms = 10,
+	.dwell_ms = 30,
+	.hang_ms = 2000,
+	.resume_ms = 0,
+	.snr = false
+};
+
+static Scan_State_enum Scan_State = SCAN_IDLE;
+static double Scan_freq, Scan_step;
+static float Scan_sq_open, Scan_sq_close, Scan_sq_hyst;
+static uint32_t Scan_state_tick, Scan_open_tick;
+
+//memory scan
+static bool Scan_mem_mode, Scan_on_prio;
+static int16_t Scan_mem_idx, Scan_prio_idx, Scan_resume_idx;
+static uint8_t Scan_prio_every, Scan_prio_cnt;
+static uint32_t Scan_prio_tick;
+static uint32_t Scan_resume_open_tick; //open tick of the held channel - kept over priority samples
+static bool Scan_prio_return;          //tuned back to the held channel after a priority sample
+
+//level measurement - module is sampled once per SysTick in the main loop so it doesn't cost anything in ADC's callbacks
+static float level_acc;
+static uint16_t level_cnt;
+static uint32_t level_tick, level_start_tick;
+
+static void scanner_level_reset(void)
+{
+	level_acc = 0;
+	level_cnt = 0;
+	level_tick = HAL_GetTick();
+	level_start_tick = level_tick;
+	nf_reset();
+}
+
+static void scanner_level_update(void)
+{
+	uint32_t tick = HAL_GetTick();
+
+	if (Scan_Config.snr) nf_task(); //main loop is blocked by scanning
+	if (tick != level_tick)
+	{
+		level_tick = tick;
+		level_acc += mag_calc(I, Q, Mag_Mode[MAG_USER_LEVEL]);
+		level_cnt++;
+	}
+}
+
+static float scanner_level_dB(void)
+{
+	if (Scan_Config.snr) return nf_snr_dB();
+	if (level_cnt == 0) return -200.0;
+	return 20.0*log10f(level_acc/level_cnt);
+}
+
+static void scanner_set_state(Scan_State_enum state)
+{
+	Scan_State = state;
+	Scan_state_tick = HAL_GetTick();
+	scanner_level_reset();
+}
+
+static bool scanner_tune(void)
+{
+	bool RFSynthLock, REFSynthLock;
+	MxL_ERR_MSG MxL_Status;
+
+	if (Scan_mem_mode)
+	{
+		int16_t idx = Scan_on_prio ? Scan_prio_idx : Scan_mem_idx;
+		const Mem_Channel_TypeDef* ch = mem_get(idx);
+		if ( (idx < 0) || (ch == NULL) )
+		{
+			UART_printf("memory bank is empty\r\n");
+			return false;
+		}
+
+		mem_recall(idx); //cached payload - one I2C burst
+		Scan_freq = ch->freq_Hz/1.0E6;
+		Scan_sq_open = ch->squelch;
+		Scan_sq_close = ch->squelch - Scan_sq_hyst;
+	}
+	else
+	{
+		MxL_Status = MxL_Tuner_RFTune(&myTuner, (uint32_t) (Scan_freq*1.0E6), MxL_BW_6MHz);
+		if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+	}
+
+	MxL_Status = MxL_RFSynth_Lock_Status(&myTuner, &RFSynthLock);
+	if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+
+	MxL_Status = MxL_REFSynth_Lock_Status(&myTuner, &REFSynthLock);
+	if (MxL_Status != MxL_OK) MxL_TIMEOUT_UserCallback();
+
+	if ( (RFSynthLock == false) || (REFSynthLock == false) )
+	{
+		UART_printf("\r\nrfLock=%d   refLock=%d\r\n", RFSynthLock, REFSynthLock);
+		return false;
+	}
+
+	scanner_set_state(SCAN_SETTLE);
+	return true;
+}
+
+static bool scanner_next(void)
+{
+	DSP_Mute = true;
+	led_toggle(LED1);
+
+	if (Scan_mem_mode)
+	{
+		if (Scan_on_prio && (Scan_resume_idx >= 0))
+		{
+			Scan_mem_idx = Scan_resume_idx; //priority channel is quiet - back to the channel that was held
+			Scan_resume_idx = -1;
+			Scan_on_prio = false;
+			Scan_prio_return = true;
+		}
+		else if ( (Scan_prio_idx >= 0) && !Scan_on_prio && (++Scan_prio_cnt >= Scan_prio_every) )
+		{
+			Scan_prio_cnt = 0;
+			Scan_on_prio = true;
+			Scan_prio_return = false;
+		}
+		else
+		{
+			Scan_on_prio = false;
+			Scan_prio_return = false;
+			Scan_mem_idx = mem_next(Scan_mem_idx);
+			if ( (Scan_mem_idx == Scan_prio_idx) && (mem_next(Scan_mem_idx) != Scan_mem_idx) )
+				Scan_mem_idx = mem_next(Scan_mem_idx); //priority channel is visited separately
+		}
+	}
+	else
+	{
+		Scan_freq += Scan_step;
+		if (Scan_freq < 30.0) Scan_freq = 30.0;
+	}
+
+	return scanner_tune();
+}
+
+void scanner_start(double start_freq, double step, float sq_open, float sq_hyst)
+{
+	Scan_mem_mode = false;
+	Scan_freq = start_freq;
+	Scan_step = step;
+	Scan_sq_hyst = fabsf(sq_hyst);
+	Scan_sq_open = sq_open;
+	Scan_sq_close = sq_open - Scan_sq_hyst;
+
+	DSP_Mute = true;
+	if (!scanner_tune()) scanner_stop();
+}
+
+//prio < 0 - no priority channel
+void scanner_start_mem(float sq_hyst, int16_t prio, uint8_t prio_every)
+{
+	Scan_mem_mode = true;
+	Scan_sq_hyst = fabsf(sq_hyst);
+	Scan_prio_idx = mem_valid(prio) ? prio : -1;
+	Scan_prio_every = (prio_every == 0) ? 1 : prio_every;
+	Scan_prio_cnt = 0;
+	Scan_resume_idx = -1;
+	Scan_on_prio = false;
+	Scan_prio_return = false;
+	Scan_mem_idx = mem_next(MEM_CHANNELS - 1);
+
+	DSP_Mute = true;
+	if (!scanner_tune()) scanner_stop();
+}
+
+void scanner_stop(void)
+{
+	Scan_State = SCAN_IDLE;
+	DSP_Mute = false;
+}
+
+Scan_State_enum scanner_state(void)
+{
+	return Scan_State;
+}
+
+//one step of scanner state machine - returns false when scanning is finished
+bool scanner_task(int key)
+{
+	float level;
+	uint32_t elapsed;
+
+	if (Scan_State == SCAN_IDLE) return false;
+
+	//console keys
+	if (key != EOF)
+	{
+		if (key == 's')
+		{
+			UART_printf("***SCANNING STOPPED*** %.6f MHz\r\n", Scan_freq);
+			scanner_stop();
+			return false;
+		}
+
+		if (key == 'u') Scan_step = fabs(Scan_step);
+		if (key == 'd') Scan_step = -fabs(Scan_step);
+
+		if (Scan_State == SCAN_PAUSED)
+		{
+			if ( (key == 'u') || (key == 'd') || (key == 'p') )
+			{
+				UART_printf("***SCANNING RESUMED***\r\n");
+				if (!scanner_next()) scanner_stop();
+			}
+			return Scan_State != SCAN_IDLE;
+		}
+
+		if (key == 'p')
+		{
+			DSP_Mute = false;
+			Scan_State = SCAN_PAUSED;
+			UART_printf("***SCANNING PAUSED*** %.6f MHz -> u/d/p - resume up/down ; s - stop\r\n", Scan_freq);
+			return true;
+		}
+
+		if (key == 'n')
+		{
+			if (!scanner_next()) scanner_stop();
+			return Scan_State != SCAN_IDLE;
+		}
+	}
+
+	elapsed = HAL_GetTick() - Scan_state_tick;
+
+	switch (Scan_State)
+	{
+		case SCAN_SETTLE:
+			if (elapsed >= Scan_Config.settle_ms) scanner_set_state(SCAN_DWELL);
+			break;
+
+		case SCAN_DWELL:
+			scanner_level_update();
+			if (elapsed >= Scan_Config.dwell_ms)
+			{
+				level = scanner_level_dB();
+				if (Scan_mem_mode)
+					UART_printf("SCANNING: %cM%02d %.6f MHz ; %s: %.2f\r\n", Scan_on_prio ? '*' : ' ',
+							Scan_on_prio ? Scan_prio_idx : Scan_mem_idx, Scan_freq, Scan_Config.snr ? "SNR" : "Mod", level);
+				else
+					UART_printf("SCANNING: %.6f MHz ; %s: %.2f\r\n", Scan_freq, Scan_Config.snr ? "SNR" : "Mod", level);
+
+				if (level > Scan_sq_open)
+				{
+					UART_printf("***SIGNAL*** %.6f MHz -> n - next ; p - pause ; s - stop\r\n", Scan_freq);
+					DSP_Mute = false;
+					scanner_set_state(SCAN_OPEN);
+					//resume time of the held channel runs on over priority samples, the next sample is
+					//SCAN_PRIO_SAMPLE_ms after every (re)opening
+					if (Scan_prio_return)
+						Scan_open_tick = Scan_resume_open_tick;
+					else
+						Scan_open_tick = Scan_state_tick;
+					Scan_prio_return = false;
+					Scan_prio_tick = Scan_state_tick;
+				}
+				else if (!scanner_next()) scanner_stop();
+			}
+			break;
+
+		case SCAN_OPEN:
+		case SCAN_HANG:
+			scanner_level_update();
+
+			if ( (Scan_Config.resume_ms != 0) && (HAL_GetTick() - Scan_open_tick >= Scan_Config.resume_ms) )
+			{
+				if (!scanner_next()) scanner_stop();
+				break;
+			}
+
+			if ( (Scan_State == SCAN_HANG) && (elapsed >= Scan_Config.hang_ms) )
+			{
+				if (!scanner_next()) scanner_stop();
+				break;
+			}
+
+			//priority channel sampling while another memory channel is held
+			if ( Scan_mem_mode && (Scan_prio_idx >= 0) && !Scan_on_prio && (HAL_GetTick() - Scan_prio_tick >= SCAN_PRIO_SAMPLE_ms) )
+			{
+				Scan_resume_idx = Scan_mem_idx;
+				Scan_resume_open_tick = Scan_open_tick;
+				Scan_on_prio = true;
+				DSP_Mute = true;
+				if (!scanner_tune()) scanner_stop();
+				break;
+			}
+
+			if (HAL_GetTick() - level_start_tick >= SCAN_SQ_WINDOW_ms)
+			{
+				level = scanner_level_dB();
+				scanner_level_reset();
+
+				if ( (Scan_State == SCAN_OPEN) && (level < Scan_sq_close) )
+				{
+					Scan_State = SCAN_HANG;
+					Scan_state_tick = HAL_GetTick();
+				}
+				else if ( (Scan_State == SCAN_HANG) && (level >= Scan_sq_close) )
+					Scan_State = SCAN_OPEN;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return Scan_State != SCAN_IDLE;
+}
@@ -0,0 +1,231 @@
+/*
+ * settings.c - persistent receiver settings and calibration stored in internal flash
+ *
+ * Log structured store: every change is appended as a new record in the active one of two reserved sectors and the
+ * latest valid record (the highest sequence number in both sectors) is loaded at startup. When the active sector is
+ * full (2048 records), the other one is erased and the new record is written to it right after the erase - the full
+ * sector is left as it is, so power loss during erase doesn't lose the latest settings and calibration. Erase stalls
+ * code fetch and so the ADC callbacks for 1 - 2 s - flash_erase_sector() adds the lost ADC blocks to ADC overruns and
+ * the stall is printed, so the audio dropout is visible in perf.
+ * Changes are detected by comparing current receiver state with last saved one and they're written after SET_SAVE_DELAY_ms
+ * of stability, so e.g. manual tuning doesn't produce a record for every step.
+ */
+#include <string.h>
+#include <stdbool.h>
+#include "main.h"
+#include "settings.h"
+#include "flash_if.h"
+#include "printf.h"
+#include "MY_CS43L22.h"
+#include "wfm.h"
+#include "ssb.h"
+#include "nbfm.h"
+#include "freq_plan.h"
+#include "MxL5007_Common.h"
+#include "MxL5007_API.h"
+#include "MxL_User_Define.h"
+
+extern MxL5007_TunerConfigS myTuner;
+extern Output_demod_type_enum Demod_Type;
+extern volatile FM_Discr_enum FM_Discr;
+extern float Total_Gain_curr;
+extern uint8_t Volume_curr;
+
+Settings_TypeDef Settings; //last saved settings
+
+Calibration_TypeDef Calibration =
+{
+	.IF_gain = IF_Gain,
+	.attenuation = Attenuation,
+	.A_V_if_agc = A_MxL_V_if_agc,
+	.B_V_if_agc = B_MxL_V_if_agc,
+	.K_corr = K_corr_coeff
+};
+
+static const uint32_t Set_sector[SET_FLASH_SECTORS] = {SET_FLASH_SECTOR_0, SET_FLASH_SECTOR_1};
+static const uint32_t Set_addr[SET_FLASH_SECTORS] = {SET_FLASH_ADDR_0, SET_FLASH_ADDR_1};
+static uint8_t Set_active; //sector with the latest record
+static uint32_t Set_wr_addr; //next free record in the active sector
+static uint32_t Set_seq;
+static Settings_TypeDef Set_pending;
+static uint32_t Set_change_tick, Set_check_tick;
+
+static uint32_t settings_checksum(const Settings_Record_TypeDef* rec)
+{
+	const uint32_t* p = (const uint32_t*) rec;
+	uint32_t i, sum = 0x5A5A5A5A;
+	for (i = 0; i < sizeof(Settings_Record_TypeDef)/4 - 1; i++) sum = ((sum << 5) | (sum >> 27)) ^ p[i];
+	return sum;
+}
+
+static bool settings_slot_erased(uint32_t addr)
+{
+	const uint32_t* p = (const uint32_t*) addr;
+	uint32_t i;
+	for (i = 0; i < SET_RECORD_SIZE/4; i++) if (p[i] != 0xFFFFFFFF) return false;
+	return true;
+}
+
+void settings_defaults(Settings_TypeDef* s)
+{
+	memset(s, 0, sizeof(Settings_TypeDef));
+	s->freq_Hz = SET_DEFAULT_FREQ_Hz;
+	s->gain = SET_DEFAULT_GAIN;
+	s->demod = SET_DEFAULT_DEMOD;
+	s->volume = CS43_default_vol;
+	s->CW_pitch = SET_DEFAULT_CW_PITCH;
+	s->CW_filter = SET_DEFAULT_CW_FILTER;
+	s->fm_discr = SET_DEFAULT_FM_DISCR;
+	s->cal = Calibration;
+}
+
+//current receiver state
+void settings_capture(Settings_TypeDef* s)
+{
+	memset(s, 0, sizeof(Settings_TypeDef));
+	s->freq_Hz = myTuner.RF_Freq_Hz;
+	s->gain = Total_Gain_curr;
+	s->demod = Demod_Type;
+	s->volume = Volume_curr;
+	s->CW_pitch = CW_Config.pitch_Hz;
+	s->CW_filter = CW_Config.filter;
+	s->fm_discr = FM_Discr;
+	s->wfm = settings_wfm_encode();
+	s->ssb = SSB_Config.filter;
+	s->cal = Calibration;
+	s->nbfm = NBFM_Config.channel;
+	s->plan = fp_active();
+}
+
+//loading the latest valid record - receiver state is applied by the caller
+void settings_init(void)
+{
+	const Settings_Record_TypeDef* rec;
+	const Settings_Record_TypeDef* latest = NULL;
+	uint32_t addr, free_addr[SET_FLASH_SECTORS];
+	uint8_t k;
+
+	Set_active = 0;
+	for (k = 0; k < SET_FLASH_SECTORS; k++)
+	{
+		free_addr[k] = Set_addr[k] + SET_FLASH_SIZE; //sector full unless free slot is found
+		for (addr = Set_addr[k]; addr < Set_addr[k] + SET_FLASH_SIZE; addr += SET_RECORD_SIZE)
+		{
+			rec = (const Settings_Record_TypeDef*) addr;
+			if (settings_slot_erased(addr))
+			{
+				free_addr[k] = addr;
+				break;
+			}
+			if ( (rec->magic == SET_MAGIC) && (rec->checksum == settings_checksum(rec)) )
+				if ( (latest == NULL) || (rec->seq > latest->seq) )
+				{
+					latest = rec;
+					Set_active = k;
+				}
+		}
+	}
+	Set_wr_addr = free_addr[Set_active];
+
+	if (latest != NULL)
+	{
+		Settings = latest->s;
+		Set_seq = latest->seq;
+		Calibration = Settings.cal;
+	}
+	else
+	{
+		settings_defaults(&Settings);
+		Set_seq = 0;
+	}
+
+	Set_pending = Settings;
+	Set_change_tick = HAL_GetTick();
+	Set_check_tick = Set_change_tick;
+}
+
+bool settings_save(void)
+{
+	Settings_Record_TypeDef rec;
+
+	settings_capture(&Settings);
+	Set_pending = Settings;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = SET_MAGIC;
+	rec.seq = ++Set_seq;
+	rec.s = Settings;
+	rec.checksum = settings_checksum(&rec);
+
+	//active sector is full - the other one is erased and gets the record, the full one keeps the previous record
+	if (Set_wr_addr + SET_RECORD_SIZE > Set_addr[Set_active] + SET_FLASH_SIZE)
+	{
+		uint8_t next = (Set_active + 1) % SET_FLASH_SECTORS;
+		bool erased = flash_erase_sector(Set_sector[next]);
+
+		UART_printf("settings: sector erase - ADC processing stalled %lu ms\r\n", Flash_erase_ms);
+		if (!erased) return false;
+		Set_active = next;
+		Set_wr_addr = Set_addr[next];
+	}
+
+	//magic is written last
+	bool status = flash_program(Set_wr_addr + 4, (uint8_t*) &rec + 4, sizeof(rec) - 4);
+	if (status) status = flash_program(Set_wr_addr, &rec.magic, 4);
+	Set_wr_addr += SET_RECORD_SIZE; //failed slot is skipped too
+
+	return status;
+}
+
+//called from main loop - saves changed settings when they're stable
+void settings_task(void)
+{
+	Settings_TypeDef curr;
+	uint32_t tick = HAL_GetTick();
+
+	if (tick - Set_check_tick < SET_CHECK_PERIOD_ms) return;
+	Set_check_tick = tick;
+
+	settings_capture(&curr);
+	if (memcmp(&curr, &Set_pending, sizeof(curr)) != 0)
+	{
+		Set_pending = curr;
+		Set_change_tick = tick;
+	}
+	else if ( (memcmp(&curr, &Settings, sizeof(curr)) != 0) && (tick - Set_change_tick >= SET_SAVE_DELAY_ms) )
+		settings_save();
+}
+
+void settings_print(void)
+{
+	UART_printf("freq: %.6f MHz ; gain: %.2f dB ; demod: %d ; volume: %d ; CW: filter %d pitch %d Hz ; fm_discr: %d ; wfm: 0x%02X ; ssb: %d ; nbfm: %d ; plan: %d\r\n", Settings.freq_Hz/1.0E6, Settings.gain,
+			Settings.demod, Settings.volume, Settings.CW_filter, Settings.CW_pitch, Settings.fm_discr, Settings.wfm, Settings.ssb, Settings.nbfm, Settings.plan);
+	UART_printf("cal: IF_gain %.2f dB ; atten %.2f dB ; A %.4e ; B %.4e ; K_corr %.4f\r\n", Calibration.IF_gain, Calibration.attenuation,
+			Calibration.A_V_if_agc, Calibration.B_V_if_agc, Calibration.K_corr);
+	UART_printf("record: %ld ; sector: 0x%08lX ; used: %ld/%d\r\n", Set_seq, Set_addr[Set_active],
+			(Set_wr_addr - Set_addr[Set_active])/SET_RECORD_SIZE, SET_FLASH_SIZE/SET_RECORD_SIZE);
+}
+
+uint8_t settings_wfm_encode(void)
+{
+	uint8_t wfm;
+
+	if (WFM_Config.deemph_us == 75) wfm = 1;
+	else if (WFM_Config.deemph_us == 0) wfm = 2;
+	else wfm = 0;
+
+	if (!WFM_Config.stereo) wfm |= SET_WFM_MONO;
+	return wfm;
+}
+
+//WFM_Config is set and wfm_init() has to be called by the caller
+void settings_wfm_decode(uint8_t wfm)
+{
+	switch (wfm & SET_WFM_DEEMPH_MASK)
+	{
+		case 1: WFM_Config.deemph_us = 75; break;
+		case 2: WFM_Config.deemph_us = 0; break;
+		default: WFM_Config.deemph_us = 50; break;
+	}
+	WFM_Config.stereo = (wfm & SET_WFM_MONO) == 0;
+}
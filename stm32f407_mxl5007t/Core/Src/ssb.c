@@ -0,0 +1,139 @@
+/*
+ * ssb.c - SSB (USB/LSB) demodulator - Weaver method
+ *
+ * I/Q (already limited by 15 kHz IQ filter) is decimated to AUDIO_FS_Hz by one FIR stage, so everything else runs
+ * on 4 samples per block. The middle of audio pass band (SSB_LOW_CUT_Hz ... SSB_LOW_CUT_Hz + bandwidth) is shifted
+ * to 0 Hz by the first NCO, I and Q are low pass filtered with half of the bandwidth (8th order Chebyshev IIR) and
+ * the second NCO shifts the band back - real part of the result is the audio. The opposite sideband is rejected by
+ * the low pass filters, so there's no Hilbert transformer and no phase matching of two audio paths.
+ * LSB is USB of conjugated I/Q. BFO offset moves the first NCO, so the carrier doesn't have to be on the tuner's grid.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include "main.h"
+#include "ssb.h"
+#include "audio_i2s.h"
+#include "dsp_math.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "printf.h"
+
+#define HZ_TO_PHASE (4294967296.0/AUDIO_FS_Hz)
+
+SSB_Config_TypeDef SSB_Config =
+{
+	.filter = SSB_FILTER_2k7,
+	.bfo_Hz = 0
+};
+
+const char *ssb_filter_name[SSB_FILTERS] = {"2.7", "2.4", "3.0"}; //kHz - the same order like SSB_Filter_enum
+
+static const float* const SSB_IIR[SSB_FILTERS] = {SSB_IIR_2k7, SSB_IIR_2k4, SSB_IIR_3k0};
+static const float SSB_bw_Hz[SSB_FILTERS] = {2700.0, 2400.0, 3000.0};
+
+//I/Q decimation
+static float FIR_I_delay[2*SSB_FIR1_TAPS], FIR_Q_delay[2*SSB_FIR1_TAPS];
+static FIR_Decim_TypeDef FIR_I = {SSB_FIR1, SSB_FIR1_TAPS, SSB_DECIM, 0, 0, FIR_I_delay};
+static FIR_Decim_TypeDef FIR_Q = {SSB_FIR1, SSB_FIR1_TAPS, SSB_DECIM, 0, 0, FIR_Q_delay};
+static float Dec_I[BB_BLOCK/SSB_DECIM], Dec_Q[BB_BLOCK/SSB_DECIM];
+
+//Weaver low pass filters - coefficients are switched by pointer (single word write, so it's safe during ADC callbacks)
+static const float* volatile IIR_coeff = SSB_IIR_2k7;
+static float Z_I[SSB_IIR_SECTIONS][2], Z_Q[SSB_IIR_SECTIONS][2];
+
+//NCOs - the first one is different for USB and LSB because BFO offset changes its sign with conjugation
+static uint32_t NCO1_phase, NCO2_phase;
+static volatile uint32_t NCO1_step_usb, NCO1_step_lsb, NCO2_step;
+
+//NCO steps for current filter and BFO - can be called while SSB is running
+static void ssb_set_nco(void)
+{
+	float f0 = SSB_LOW_CUT_Hz + SSB_bw_Hz[SSB_Config.filter]/2.0;
+
+	NCO1_step_usb = (uint32_t) (int32_t) ((f0 + SSB_Config.bfo_Hz)*HZ_TO_PHASE);
+	NCO1_step_lsb = (uint32_t) (int32_t) ((f0 - SSB_Config.bfo_Hz)*HZ_TO_PHASE);
+	NCO2_step = (uint32_t) (int32_t) (f0*HZ_TO_PHASE);
+}
+
+//has to be called before Demod_Type is switched to DEMOD_USB/DEMOD_LSB (it's not synchronized with ADC callbacks)
+void ssb_init(void)
+{
+	uint8_t k;
+
+	fir_reset(&FIR_I);
+	fir_reset(&FIR_Q);
+	for (k = 0; k < SSB_IIR_SECTIONS; k++)
+		Z_I[k][0] = Z_I[k][1] = Z_Q[k][0] = Z_Q[k][1] = 0;
+	NCO1_phase = NCO2_phase = 0;
+
+	ssb_set_filter(SSB_Config.filter);
+}
+
+void ssb_set_filter(SSB_Filter_enum filter)
+{
+	if (filter >= SSB_FILTERS) filter = SSB_FILTER_2k7;
+	SSB_Config.filter = filter;
+	IIR_coeff = SSB_IIR[filter];
+	ssb_set_nco();
+}
+
+void ssb_set_bfo(int16_t bfo_Hz)
+{
+	if (bfo_Hz > SSB_BFO_MAX_Hz) bfo_Hz = SSB_BFO_MAX_Hz;
+	if (bfo_Hz < -SSB_BFO_MAX_Hz) bfo_Hz = -SSB_BFO_MAX_Hz;
+	SSB_Config.bfo_Hz = bfo_Hz;
+	ssb_set_nco();
+}
+
+//returns number of audio samples in out (n/SSB_DECIM)
+uint16_t ssb_process(const float* I, const float* Q, uint16_t n, bool lsb, float* out)
+{
+	const float* c = IIR_coeff;
+	uint32_t nco1_step = lsb ? NCO1_step_lsb : NCO1_step_usb;
+	uint16_t k, m;
+	uint8_t j;
+	float i, q, s, co, ti, tq;
+
+	m = fir_decim(&FIR_I, I, Dec_I, n);
+	fir_decim(&FIR_Q, Q, Dec_Q, n);
+
+	for (k = 0; k < m; k++)
+	{
+		//the middle of the band to 0 Hz: (I + jQ)*exp(-j*phase1) ; LSB: (I - jQ)*exp(-j*phase1)
+		i = Dec_I[k];
+		q = lsb ? -Dec_Q[k] : Dec_Q[k];
+		fast_sincos_phase(NCO1_phase, &s, &co);
+		NCO1_phase += nco1_step;
+		ti = i*co + q*s;
+		tq = q*co - i*s;
+
+		//low pass filters - biquads {b0, b1, b2, a1, a2} in direct form II
+		for (j = 0; j < SSB_IIR_SECTIONS; j++)
+		{
+			const float* bq = &c[5*j];
+
+			i = ti - (Z_I[j][0]*bq[3] + Z_I[j][1]*bq[4]);
+			ti = i*bq[0] + Z_I[j][0]*bq[1] + Z_I[j][1]*bq[2];
+			Z_I[j][1] = Z_I[j][0];
+			Z_I[j][0] = i;
+
+			q = tq - (Z_Q[j][0]*bq[3] + Z_Q[j][1]*bq[4]);
+			tq = q*bq[0] + Z_Q[j][0]*bq[1] + Z_Q[j][1]*bq[2];
+			Z_Q[j][1] = Z_Q[j][0];
+			Z_Q[j][0] = q;
+		}
+
+		//back to audio band: Re{(ti + j*tq)*exp(j*phase2)}
+		fast_sincos_phase(NCO2_phase, &s, &co);
+		NCO2_phase += NCO2_step;
+		out[k] = ti*co - tq*s; //level is set by audio AGC (agc.c)
+	}
+
+	return m;
+}
+
+void ssb_print(void)
+{
+	UART_printf("ssb: filter %s kHz (%.0f - %.0f Hz) ; BFO %d Hz\r\n", ssb_filter_name[SSB_Config.filter],
+			SSB_LOW_CUT_Hz, SSB_LOW_CUT_Hz + SSB_bw_Hz[SSB_Config.filter], SSB_Config.bfo_Hz);
+}
@@ -23,6 +23,25 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "usart.h"
+#include "dsp_tables.h"
+#include "perf.h"
+#include "dsp_math.h"
+#include "dsp_mag.h"
+#include "audio_i2s.h"
+#include "wfm.h"
+#include "ssb.h"
+#include "cw.h"
+#include "sam.h"
+#include "nbfm.h"
+#include "data_demod.h"
+#include "nb.h"
+#include "iq_corr.h"
+#include "lms.h"
+#include "agc.h"
+#include "nfloor.h"
+#include "enob.h"
+#include "chan.h"
+#include "freq_plan.h"
 #include <string.h>
 #include <math.h>
 #include <stdbool.h>
@@ -65,26 +84,29 @@ const float B_DAC_scale_AM = 2048.0;
 const float A_DAC_scale_FM = (4095.0/2.0)*M_2_PI;
 const float B_DAC_scale_FM = 4095.0/2.0;
 
-extern float sine_arr[];
-extern float cosine_arr[];
-extern float asin_arr[];
-uint8_t cnt; //look-up tables entry counter for sine_arr and cosine_arr
+//DAC and I2S scaling coefficients for WFM, SSB, CW and SAM - L and R are +/-1 rad for 75 kHz deviation, other audio peaks are 1.0
+const float A_DAC_scale_WFM = (4095.0/2.0)/1.2;
+const float B_DAC_scale_WFM = 4095.0/2.0;
+const float A_I2S_scale_WFM = 32767.0/1.2;
+
+uint8_t cnt; //mixer table entry counter for NCO_sin and NCO_cos
 
 const float A_asin_arr_scale = (N_asin - 1.0)/2.0;
 const float B_asin_arr_scale = (N_asin - 1.0)/2.0;
 
-//IIR filters were designed in Matlab's Filter Designer Tool. It's Chebyshev’s Type I filter and it was implemented with direct form II.
-//It would be much more better with high order FIR filters but it's impossible to implement it due to hardware limitation. Generally speaking IIR filter provides
-//non linear phase response and it tends to non constant group delay and obviously distortions.
+//IQ filters are two half band FIR filters (decimation 848.5 -> 424.2 -> 212.1 kHz, linear phase, every other tap is zero)
+//and Chebyshev's Type I low pass filters (6th order, 0.5 dB) at 212.1 kHz implemented as biquads in direct form II - direct form
+//of the whole filter isn't stable for narrow bandwidths with single precision coefficients. Narrow channel filters can't be FIR
+//due to hardware limitation, so IIR filter provides non linear phase response and it tends to non constant group delay.
 
-//fc=105 kHz for FM and fc=15 kHz for AM and CW
-//Numerator filter coefficients
-float b[6];
-float a[5];
+//channel filter from the bank in flash (dsp_tables.c) - set_IQ_filter() writes only the pointer (single word, so coefficients
+//are never torn) and ADC callback takes it at block boundary. NULL is 105 kHz channel - half band filters only
+const float* volatile IQ_IIR_next = NULL;
+static const float* IQ_IIR_coeff = NULL;
 
 //IIR filters delay registers for I and Q filters
-float Z_I[5];
-float Z_Q[5];
+float Z_I[IQ_IIR_SECTIONS][2];
+float Z_Q[IQ_IIR_SECTIONS][2];
 
 //It was hard to implement single section filter (with float computing instead of double) so it's two sections filter.
 //first AM audio filter section
@@ -109,37 +131,36 @@ const float b_FM[] = {1.80640220642089843750000000000000e-02, 3.6128044128417968
 const float a_FM[] = {-1.64560496807098388671875000000000e+00, 7.26677656173706054687500000000000e-01};
 
 
-//Numerator filter coefficients for CW audio filter fc=100 Hz - after decimation
-float b_CW[] = {4.93644665766623802483081817626953e-06, 9.87289331533247604966163635253906e-06, 4.93644665766623802483081817626953e-06};
+//IIR filters delay registers for audio filters AM (HPF and LPF) and FM
+float Z1_audio, Z2_audio, Z_audio;
 
-//Denominator filter coefficients for CW audio filter fc=100 Hz - after decimation
-const float a_CW[] = {-1.99434518814086914062500000000000e+00, 9.94365453720092773437500000000000e-01};
+//the newest I and Q values
+float I, Q;
 
+//I/Q block after IQ filters and decimation - two previous samples are kept at [0] and [1] for FM discriminators
+float I_bb[BB_BLOCK+2], Q_bb[BB_BLOCK+2];
 
-//IIR filters delay registers for audio filters AM (HPF and LPF), FM and CW
-float Z1_audio, Z2_audio, Z_audio;
+//mixer output and 1st half band output with previous samples for half band filters in front
+float I_mix[IQ_HB1_TAPS-1 + ADC_BLOCK], Q_mix[IQ_HB1_TAPS-1 + ADC_BLOCK];
+float I_hb[IQ_HB2_TAPS-1 + ADC_BLOCK/2], Q_hb[IQ_HB2_TAPS-1 + ADC_BLOCK/2];
 
-//current and previous I and Q values
-float I, Q, I_Z1, I_Z2, Q_Z1, Q_Z2;
+//demodulated audio blocks
+float Audio_L[BB_BLOCK], Audio_R[BB_BLOCK];
+int32_t DAC_value;
+volatile uint32_t ADC_overruns;
 
-extern uint32_t v_in_samples[];
+extern int16_t v_in_samples[];
+extern uint32_t DAC_out[];
 const float K = 0.5;
 
-//variables and constants for CW
-uint16_t CW_trig_upper_level = 32;
-uint8_t CW_trig_lower_level = 30; //0..255
-bool CW_triggered = false;
-uint8_t CW_decim_cnt;
-const float CW_A_COEFF = 500.0;
-
-//variables and constants for simple digital AGC for AM - it's more like automatic scaling rather than actual AGC
-float module, module_max_tmp, AM_AGC_sig;
-uint32_t AM_mod_max_cnt;
-
-#define AM_max_cnt_sample 60000
-const float AM_AGC_coeff = 0.7;
+float module;
 
 Output_demod_type_enum Demod_Type = DEMOD_FM; //demodulation type
+volatile FM_Discr_enum FM_Discr = FM_DISCR_NOGA; //FM discriminator - can be changed at run time
+
+//muting in DSP path - demodulator is skipped and DAC outputs are held at mid scale (used by scanner instead of CS43L22 I2C muting)
+volatile bool DSP_Mute = false;
+const uint16_t DAC_mid_scale = 2048;
 
 /* USER CODE END PV */
 
@@ -155,6 +176,7 @@ Output_demod_type_enum Demod_Type = DEMOD_FM; //demodulation type
 
 /* External variables --------------------------------------------------------*/
 extern DMA_HandleTypeDef hdma_adc1;
+extern DMA_HandleTypeDef hdma_dac2;
 extern DMA_HandleTypeDef hdma_spi3_tx;
 extern UART_HandleTypeDef huart5;
 /* USER CODE BEGIN EV */
@@ -316,6 +338,20 @@ void DMA1_Stream5_IRQHandler(void)
   /* USER CODE END DMA1_Stream5_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 stream6 global interrupt.
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream6_IRQn 0 */
+
+  /* USER CODE END DMA1_Stream6_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_dac2);
+  /* USER CODE BEGIN DMA1_Stream6_IRQn 1 */
+
+  /* USER CODE END DMA1_Stream6_IRQn 1 */
+}
+
 /**
   * @brief This function handles UART5 global interrupt.
   */
@@ -336,300 +372,380 @@ void UART5_IRQHandler(void)
 void DMA2_Stream0_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA2_Stream0_IRQn 0 */
-
+  uint32_t t_isr = perf_start();
   /* USER CODE END DMA2_Stream0_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_adc1);
   /* USER CODE BEGIN DMA2_Stream0_IRQn 1 */
-
+  perf_isr_end(t_isr);
   /* USER CODE END DMA2_Stream0_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
-void HAL_ADC_ConvHalfCpltCallback (ADC_HandleTypeDef * hadc)
+//half band filter output (IQ_HB1_TAPS = IQ_HB2_TAPS = 15) - taps are symmetric and every other one is zero except the middle
+//one, so 5 multiplications. x points to the oldest sample
+static inline float iq_half_band(const float* x, const float* h)
 {
-	GPIOD->BSRR = 1<<15; //calculation time measurement
-
-	uint8_t n, k;
-	float sig_in, tmp, I_tmp, Q_tmp;
-	for (n = 0;n < 4; n++) //processing first 4 samples from ADC
-	{
-		sig_in = A_ADC_scale*v_in_samples[n] + B_ADC_scale; //scaling from 0...4095 to +/-1.000
-		I_tmp = sig_in*cosine_arr[cnt]; //multiplication by sine and cosine before LPF
-		Q_tmp = sig_in*sine_arr[cnt];
-		if (++cnt == N_cos_sin) cnt = 0;
-
-		//I low pass filter
-		for (k = 0;k<5;k++) I_tmp -= Z_I[k]*a[k];
-		if (n == 3) //calculating filter's output - only in the final iteration because 4 samples from ADC gives 1 sample for detectors due to downsampling
-		{
-			I_Z2 = I_Z1;
-			I_Z1 = I;
-			I = I_tmp*b[0] + Z_I[0]*b[1] + Z_I[1]*b[2] + Z_I[2]*b[3] + Z_I[3]*b[4] + Z_I[4]*b[5];
-		}
-		Z_I[4] = Z_I[3];
-		Z_I[3] = Z_I[2];
-		Z_I[2] = Z_I[1];
-		Z_I[1] = Z_I[0];
-		Z_I[0] = I_tmp;
-
-		//Q low pass filter
-		for (k = 0;k<5;k++) Q_tmp -= Z_Q[k]*a[k];
-		if (n == 3) //calculating filter's output - only in the final iteration because 4 samples from ADC gives 1 sample for detectors due to downsampling
-		{
-			Q_Z2 = Q_Z1;
-			Q_Z1 = Q;
-			Q = Q_tmp*b[0] + Z_Q[0]*b[1] + Z_Q[1]*b[2] + Z_Q[2]*b[3] + Z_Q[3]*b[4] + Z_Q[4]*b[5];
-		}
-		Z_Q[4] = Z_Q[3];
-		Z_Q[3] = Z_Q[2];
-		Z_Q[2] = Z_Q[1];
-		Z_Q[1] = Z_Q[0];
-		Z_Q[0] = Q_tmp;
-	}
+	return h[0]*(x[0] + x[14]) + h[2]*(x[2] + x[12]) + h[4]*(x[4] + x[10]) + h[6]*(x[6] + x[8]) + h[7]*x[7];
+}
 
-	float phase;
-	int32_t DAC_value;
+//IQ filter switching - delay registers of direct form II are section input divided by A(z), so for in-band signal they're
+//about input/A(1). Every section has unity gain at DC, so A(1) = B(1) = 4*b0 and registers are rescaled by b0 ratio
+//to go on with the same signal in the new filter instead of its step response. Registers aren't updated while the biquads
+//are bypassed (105 kHz), so they're cleared when they're switched on again
+static void iq_iir_switch(const float* c_old, const float* c_new)
+{
+	uint8_t j;
+	float s;
 
-	switch(Demod_Type)
+	if (c_new == NULL) return;
+	for (j = 0; j < IQ_IIR_SECTIONS; j++)
 	{
+		s = (c_old != NULL) ? c_old[5*j]/c_new[5*j] : 0;
+		Z_I[j][0] *= s;
+		Z_I[j][1] *= s;
+		Z_Q[j][0] *= s;
+		Z_Q[j][1] *= s;
+	}
+}
 
-	//FM discriminator
-	case DEMOD_FM: //it's described in NUMERICAL FM DEMODULATION ENHANCEMENTS by Andrew J. Noga   https://apps.dtic.mil/sti/pdfs/ADA311269.pdf
-			phase = K*(I_Z1*(Q - Q_Z2) - (I - I_Z2)*Q_Z1) / (I_Z1*I_Z1 + Q_Z1*Q_Z1);
+//SDR processing of ADC_BLOCK samples from ADC (half of DMA buffer) - it gives BB_BLOCK I/Q samples for detectors due to downsampling
+//and BB_BLOCK DAC samples which are written by DMA (TIM6 trigger) one block later
+static void SDR_process(const int16_t* samples, uint32_t* dac)
+{
+	GPIOD->BSRR = 1<<15; //calculation time measurement
 
-			if (phase > 1.0) phase = 1.0;
-			if (phase < -1.0) phase = -1.0;
+	uint32_t t_start = perf_start();
+	uint32_t t = t_start;
 
-			phase = asin_arr[(uint16_t) (A_asin_arr_scale*phase + B_asin_arr_scale)];
+	uint16_t n, k, m = 0;
+	uint8_t j;
+	float tmp, phase, I_tmp, Q_tmp;
+	float i0, i1, i2, q0, q1, q2;
 
-			//audio low pass filter for FM
-			tmp = phase - (Z1_audio*a_FM[0] + Z2_audio*a_FM[1]);
-			phase = tmp*b_FM[0] + Z1_audio*b_FM[1] + Z2_audio*b_FM[2];
-			Z2_audio = Z1_audio;
-			Z1_audio = tmp;
+	float b_scale = B_ADC_scale - IQC_DC_applied; //DC offset estimate is removed by scaling
+	float dc_sum = 0;
 
-			DAC->DHR12R1 = A_DAC_scale_FM*phase + B_DAC_scale_FM; //scaling
-		break;
+	float* i_mix = &I_mix[IQ_HB1_TAPS-1]; //new samples after history of half band filter
+	float* q_mix = &Q_mix[IQ_HB1_TAPS-1];
+	enob_capture_adc(samples, ADC_BLOCK); //raw codes for enob command - only while it captures
+	for (n = 0;n < ADC_BLOCK; n++)
+	{
+		i_mix[n] = A_ADC_scale*samples[n] + b_scale; //scaling from 0...4095 to +/-1.000
+		dc_sum += i_mix[n];
+	}
+	iqc_dc_update(dc_sum, ADC_BLOCK);
+	t = perf_stamp(PERF_SCALE, t);
 
-	//AM detector
-	case DEMOD_AM: //simple AM detector based on module
-			module = sqrtf(I*I + Q*Q);
+	if (NB_Config.mode != NB_OFF)
+	{
+		nb_process(i_mix, ADC_BLOCK);
+		t = perf_stamp(PERF_NB, t);
+	}
 
-			//digital AGC - more likely automatic scaling
-			if (module > module_max_tmp) module_max_tmp = module;
-			AM_mod_max_cnt++;
-			if (AM_mod_max_cnt == AM_max_cnt_sample)
-			{
-				AM_mod_max_cnt = 0;
-				AM_AGC_sig = AM_AGC_coeff / module_max_tmp;
-				module_max_tmp = -1.0;
-			}
+	const float* nco_sin = NCO_sin; //frequency plan can switch the table - one per block
+	const float* nco_cos = NCO_cos;
+	uint8_t nco_len = NCO_len;
+	for (n = 0;n < ADC_BLOCK; n++)
+	{
+		q_mix[n] = i_mix[n]*nco_sin[cnt]; //multiplication by sine and cosine before LPF
+		i_mix[n] = i_mix[n]*nco_cos[cnt];
+		if (++cnt >= nco_len) cnt = 0;
+	}
+	nf_capture(i_mix, q_mix, ADC_BLOCK); //copy for noise floor FFT in main loop when it's free
+	t = perf_stamp(PERF_MIXER, t);
 
-			//first AM audio filter section
-			tmp = module - Z_audio*a_AM_HPF;
-			module = tmp*b_AM_HPF[0] + Z_audio*b_AM_HPF[1];
-			Z_audio = tmp;
-
-			//second AM audio filter section
-			tmp = module - (Z1_audio*a_AM_LPF[0] + Z2_audio*a_AM_LPF[1]);
-			module = tmp*b_AM_LPF[0] + Z1_audio*b_AM_LPF[1] + Z2_audio*b_AM_LPF[2];
-			Z2_audio = Z1_audio;
-			Z1_audio = tmp;
-
-
-			DAC_value = A_DAC_scale_AM*module*AM_AGC_sig + B_DAC_scale_AM;
-			//if (DAC_value > 4095) DAC_value = 4095; //it would be better with this limiter but it's not enough time to do that
-			if (DAC_value < 0) DAC_value = 0;
-			DAC->DHR12R1 = DAC_value;
-		break;
-
-	//IQ output - just for testing and educational purposes
-	case OUT_IQ:
-			DAC_value = A_DAC_scale_IQ*I + B_DAC_scale_IQ;
-			if (DAC_value > 4095) DAC_value = 4095;
-			if (DAC_value < 0) DAC_value = 0;
-			DAC->DHR12R1 = DAC_value;
-
-			DAC_value = A_DAC_scale_IQ*Q + B_DAC_scale_IQ;
-			if (DAC_value > 4095) DAC_value = 4095;
-			if (DAC_value < 0) DAC_value = 0;
-			DAC->DHR12R2 = DAC_value;
-		break;
-
-	//simple CW - based on comparator with hysteresis
-	case DEMOD_CW:
-		module = sqrtf(I*I + Q*Q);
-
-		tmp = module - (Z1_audio*a_CW[0] + Z2_audio*a_CW[1]);
-		module = (tmp*b_CW[0] + Z1_audio*b_CW[1] + Z2_audio*b_CW[2])*CW_A_COEFF;
-		Z2_audio = Z1_audio;
-		Z1_audio = tmp;
-
-		if ( (module > CW_trig_upper_level) && (!CW_triggered) )
-		{
-			CW_triggered = true;
-			DAC->DHR12R1 = 0;
-		}
+	//I and Q decimation by half band filters - output for every 2nd sample
+	for (n = 0; n < ADC_BLOCK/2; n++)
+	{
+		I_hb[IQ_HB2_TAPS-1 + n] = iq_half_band(&I_mix[2*n + 1], IQ_HB1);
+		Q_hb[IQ_HB2_TAPS-1 + n] = iq_half_band(&Q_mix[2*n + 1], IQ_HB1);
+	}
+	for (n = 0; n < BB_BLOCK; n++)
+	{
+		I_bb[2 + n] = iq_half_band(&I_hb[2*n + 1], IQ_HB2);
+		Q_bb[2 + n] = iq_half_band(&Q_hb[2*n + 1], IQ_HB2);
+	}
+	memcpy(I_mix, &I_mix[ADC_BLOCK], (IQ_HB1_TAPS-1)*sizeof(float)); //history for the next block
+	memcpy(Q_mix, &Q_mix[ADC_BLOCK], (IQ_HB1_TAPS-1)*sizeof(float));
+	memcpy(I_hb, &I_hb[ADC_BLOCK/2], (IQ_HB2_TAPS-1)*sizeof(float));
+	memcpy(Q_hb, &Q_hb[ADC_BLOCK/2], (IQ_HB2_TAPS-1)*sizeof(float));
 
-		if (CW_triggered)
+	const float* c = IQ_IIR_next; //the same coefficients for the whole block
+	if (c != IQ_IIR_coeff)
+	{
+		iq_iir_switch(IQ_IIR_coeff, c);
+		IQ_IIR_coeff = c;
+	}
+	if (c != NULL)
+	{
+		//I and Q channel low pass filters at FS_BB_Hz - biquads {b0, b1, b2, a1, a2} with both zeros at Nyquist (b1 = 2*b0,
+		//b2 = b0), so feed-forward part is b0*(w0 + 2*w1 + w2) - 3 multiplications per section
+		for (n = 0; n < BB_BLOCK; n++)
 		{
-			CW_decim_cnt++;
-			if (CW_decim_cnt == 107)
+			I_tmp = I_bb[2 + n];
+			Q_tmp = Q_bb[2 + n];
+			for (j = 0; j < IQ_IIR_SECTIONS; j++)
 			{
-				DAC->DHR12R1 ^= 0xFFF;
-				CW_decim_cnt = 0;
+				const float* bq = &c[5*j];
+
+				i0 = I_tmp - (Z_I[j][0]*bq[3] + Z_I[j][1]*bq[4]);
+				q0 = Q_tmp - (Z_Q[j][0]*bq[3] + Z_Q[j][1]*bq[4]);
+				I_tmp = bq[0]*(i0 + Z_I[j][0] + Z_I[j][0] + Z_I[j][1]);
+				Q_tmp = bq[0]*(q0 + Z_Q[j][0] + Z_Q[j][0] + Z_Q[j][1]);
+				Z_I[j][1] = Z_I[j][0];
+				Z_I[j][0] = i0;
+				Z_Q[j][1] = Z_Q[j][0];
+				Z_Q[j][0] = q0;
 			}
-
-			if (module < CW_trig_lower_level) CW_triggered = false;
+			I_bb[2 + n] = I_tmp;
+			Q_bb[2 + n] = Q_tmp;
 		}
-		break;
-
-	default:
-		break;
 	}
+	t = perf_stamp(PERF_IIR, t);
 
-	GPIOD->BSRR = 1<<31; //calculation time measurement
-}
-
-void HAL_ADC_ConvCpltCallback (ADC_HandleTypeDef * hadc)
-{
-	GPIOD->BSRR = 1<<15; //calculation time measurement
+	iqc_process(&I_bb[2], &Q_bb[2], BB_BLOCK);
+	enob_capture_bb(&I_bb[2], &Q_bb[2], BB_BLOCK);
+	I = I_bb[BB_BLOCK+1]; //the newest I/Q sample for scanner and console
+	Q = Q_bb[BB_BLOCK+1];
+	t = perf_stamp(PERF_IQ, t);
 
-	uint8_t n, k;
-	float sig_in, tmp, I_tmp, Q_tmp;
-	for (n = 4;n < 8; n++) //processing second 4 samples from ADC - the same principle of operation like in previous 4 samples
+	if (DSP_Mute)
 	{
-		sig_in = A_ADC_scale*v_in_samples[n] + B_ADC_scale;
-		I_tmp = sig_in*cosine_arr[cnt];
-		Q_tmp = sig_in*sine_arr[cnt];
-		if (++cnt == N_cos_sin) cnt = 0;
-
-		for (k = 0;k<5;k++) I_tmp -= Z_I[k]*a[k];
-		if (n == 7)
-		{
-			I_Z2 = I_Z1;
-			I_Z1 = I;
-			I = I_tmp*b[0] + Z_I[0]*b[1] + Z_I[1]*b[2] + Z_I[2]*b[3] + Z_I[3]*b[4] + Z_I[4]*b[5];
-		}
-		Z_I[4] = Z_I[3];
-		Z_I[3] = Z_I[2];
-		Z_I[2] = Z_I[1];
-		Z_I[1] = Z_I[0];
-		Z_I[0] = I_tmp;
-
-		for (k = 0;k<5;k++) Q_tmp -= Z_Q[k]*a[k];
-		if (n == 7)
+		for (k = 0; k < BB_BLOCK; k++) dac[k] = DAC_mid_scale | (DAC_mid_scale << 16);
+		if (audio_i2s_demod(Demod_Type))
 		{
-			Q_Z2 = Q_Z1;
-			Q_Z1 = Q;
-			Q = Q_tmp*b[0] + Z_Q[0]*b[1] + Z_Q[1]*b[2] + Z_Q[2]*b[3] + Z_Q[3]*b[4] + Z_Q[4]*b[5];
+			memset(Audio_L, 0, AUDIO_BLOCK*sizeof(float));
+			audio_i2s_write(Audio_L, Audio_L, AUDIO_BLOCK, 0);
 		}
-		Z_Q[4] = Z_Q[3];
-		Z_Q[3] = Z_Q[2];
-		Z_Q[2] = Z_Q[1];
-		Z_Q[1] = Z_Q[0];
-		Z_Q[0] = Q_tmp;
 	}
-
-	float phase;
-	int32_t DAC_value;
-
-	switch(Demod_Type)
+	else
 	{
-	case DEMOD_FM:
-			phase = K*(I_Z1*(Q - Q_Z2) - (I - I_Z2)*Q_Z1) / (I_Z1*I_Z1 + Q_Z1*Q_Z1);
-
-			if (phase > 1.0) phase = 1.0;
-			if (phase < -1.0) phase = -1.0;
-
-			phase = asin_arr[(uint16_t) (A_asin_arr_scale*phase + B_asin_arr_scale)];
+		switch(Demod_Type)
+		{
 
-			tmp = phase - (Z1_audio*a_FM[0] + Z2_audio*a_FM[1]);
-			phase = tmp*b_FM[0] + Z1_audio*b_FM[1] + Z2_audio*b_FM[2];
-			Z2_audio = Z1_audio;
-			Z1_audio = tmp;
+		//FM discriminator
+		case DEMOD_FM: //it's described in NUMERICAL FM DEMODULATION ENHANCEMENTS by Andrew J. Noga   https://apps.dtic.mil/sti/pdfs/ADA311269.pdf
+			for (k = 0; k < BB_BLOCK; k++)
+			{
+				i0 = I_bb[k+2]; i1 = I_bb[k+1]; i2 = I_bb[k];
+				q0 = Q_bb[k+2]; q1 = Q_bb[k+1]; q2 = Q_bb[k];
+
+				switch(FM_Discr)
+				{
+				//phase difference between current and previous sample: arg(z*conj(z_Z1)) - exact in whole +/-pi range
+				case FM_DISCR_ATAN2:
+					phase = fast_atan2f(i1*q0 - i0*q1, i0*i1 + q0*q1);
+					break;
+
+				default:
+					phase = K*(i1*(q0 - q2) - (i0 - i2)*q1) / (i1*i1 + q1*q1);
+
+					if (phase > 1.0f) phase = 1.0f;
+					if (phase < -1.0f) phase = -1.0f;
+
+					phase = asin_arr[(uint16_t) (A_asin_arr_scale*phase + B_asin_arr_scale)];
+					break;
+				}
+
+				//audio low pass filter for FM
+				tmp = phase - (Z1_audio*a_FM[0] + Z2_audio*a_FM[1]);
+				Audio_L[k] = tmp*b_FM[0] + Z1_audio*b_FM[1] + Z2_audio*b_FM[2];
+				Z2_audio = Z1_audio;
+				Z1_audio = tmp;
+			}
+			break;
 
-			DAC->DHR12R1 = A_DAC_scale_FM*phase + B_DAC_scale_FM;
-		break;
+		//AM detector
+		case DEMOD_AM: //simple AM envelope detector - whole block of magnitudes first, then filters in place (AGC is after them)
+			mag_block(&I_bb[2], &Q_bb[2], Audio_L, BB_BLOCK, Mag_Mode[MAG_USER_AM]);
+			for (k = 0; k < BB_BLOCK; k++)
+			{
+				module = Audio_L[k];
+
+				//first AM audio filter section
+				tmp = module - Z_audio*a_AM_HPF;
+				module = tmp*b_AM_HPF[0] + Z_audio*b_AM_HPF[1];
+				Z_audio = tmp;
+
+				//second AM audio filter section
+				tmp = module - (Z1_audio*a_AM_LPF[0] + Z2_audio*a_AM_LPF[1]);
+				Audio_L[k] = tmp*b_AM_LPF[0] + Z1_audio*b_AM_LPF[1] + Z2_audio*b_AM_LPF[2];
+				Z2_audio = Z1_audio;
+				Z1_audio = tmp;
+			}
+			break;
+
+		//broadcast FM - stereo audio at AUDIO_FS_Hz
+		case DEMOD_WFM:
+			m = wfm_process(&I_bb[2], &Q_bb[2], BB_BLOCK, Audio_L, Audio_R);
+			break;
+
+		//CW - BFO beat note at AUDIO_FS_Hz
+		case DEMOD_CW:
+			m = cw_process(&I_bb[2], &Q_bb[2], BB_BLOCK, Audio_L);
+			memcpy(Audio_R, Audio_L, m*sizeof(float));
+			break;
+
+		//synchronous AM - mono audio at AUDIO_FS_Hz
+		case DEMOD_SAM:
+			m = sam_process(&I_bb[2], &Q_bb[2], BB_BLOCK, Audio_L);
+			memcpy(Audio_R, Audio_L, m*sizeof(float));
+			break;
+
+		//narrowband FM - mono audio at AUDIO_FS_Hz gated by noise and tone squelch, or routed channel of channelizer
+		case DEMOD_NBFM:
+			if (Chan_Config.on) m = chan_process(&I_bb[2], &Q_bb[2], BB_BLOCK, Audio_L);
+			else m = nbfm_process(&I_bb[2], &Q_bb[2], BB_BLOCK, Audio_L);
+			memcpy(Audio_R, Audio_L, m*sizeof(float));
+			break;
+
+		//SSB - mono audio at AUDIO_FS_Hz
+		case DEMOD_USB:
+		case DEMOD_LSB:
+			m = ssb_process(&I_bb[2], &Q_bb[2], BB_BLOCK, Demod_Type == DEMOD_LSB, Audio_L);
+			memcpy(Audio_R, Audio_L, m*sizeof(float));
+			break;
+
+		default:
+			break;
+		}
+		t = perf_stamp(PERF_DEMOD, t);
 
-	case DEMOD_AM:
-		module = sqrtf(I*I + Q*Q);
+		//auto-notch and noise reduction on mono audio at AUDIO_FS_Hz
+		if (lms_active(Demod_Type))
+		{
+			lms_process(Audio_L, m);
+			memcpy(Audio_R, Audio_L, m*sizeof(float));
+			t = perf_stamp(PERF_LMS, t);
+		}
 
-		//digital AGC - more likely automatic scaling
-		if (module > module_max_tmp) module_max_tmp = module;
-		AM_mod_max_cnt++;
-		if (AM_mod_max_cnt == AM_max_cnt_sample)
+		//data demodulators on demodulator output - bits for data_task()
+		if (Data_Config.mode != DATA_OFF)
 		{
-			AM_mod_max_cnt = 0;
-			AM_AGC_sig = AM_AGC_coeff / module_max_tmp;
-			module_max_tmp = -1.0;
+			if (Demod_Type == DEMOD_NBFM) data_process(Chan_Config.on ? Chan_Discr : NBFM_Discr, m, DATA_SRC_AUDIO);
+			else if ( (Demod_Type == DEMOD_FM) || (Demod_Type == DEMOD_AM) ) data_process(Audio_L, BB_BLOCK, DATA_SRC_BB);
+			t = perf_stamp(PERF_DATA, t);
 		}
 
-		//first AM audio filter section
-		tmp = module - Z_audio*a_AM_HPF;
-		module = tmp*b_AM_HPF[0] + Z_audio*b_AM_HPF[1];
-		Z_audio = tmp;
-
-		//second AM audio filter section
-		tmp = module - (Z1_audio*a_AM_LPF[0] + Z2_audio*a_AM_LPF[1]);
-		module = tmp*b_AM_LPF[0] + Z1_audio*b_AM_LPF[1] + Z2_audio*b_AM_LPF[2];
-		Z2_audio = Z1_audio;
-		Z1_audio = tmp;
-
-
-		DAC_value = A_DAC_scale_AM*module*AM_AGC_sig + B_DAC_scale_AM;
-		//if (DAC_value > 4095) DAC_value = 4095; //it would be better with this limiter but it's not enough time to do that
-		if (DAC_value < 0) DAC_value = 0;
-		DAC->DHR12R1 = DAC_value;
-		break;
-
-	case OUT_IQ:
-			DAC_value = A_DAC_scale_IQ*I + B_DAC_scale_IQ;
-			if (DAC_value > 4095) DAC_value = 4095;
-			if (DAC_value < 0) DAC_value = 0;
-			DAC->DHR12R1 = DAC_value;
-
-			DAC_value = A_DAC_scale_IQ*Q + B_DAC_scale_IQ;
-			if (DAC_value > 4095) DAC_value = 4095;
-			if (DAC_value < 0) DAC_value = 0;
-			DAC->DHR12R2 = DAC_value;
-		break;
-
-	case DEMOD_CW:
-		module = sqrtf(I*I + Q*Q);
-
-		tmp = module - (Z1_audio*a_CW[0] + Z2_audio*a_CW[1]);
-		module = (tmp*b_CW[0] + Z1_audio*b_CW[1] + Z2_audio*b_CW[2])*CW_A_COEFF;
-		Z2_audio = Z1_audio;
-		Z1_audio = tmp;
-
-		if ( (module > CW_trig_upper_level) && (!CW_triggered) )
+		//audio AGC and limiter - output full scale of every mode, audio is delayed by look-ahead (attack time)
+		switch(Demod_Type)
 		{
-			CW_triggered = true;
-			DAC->DHR12R1 = 0;
+		case DEMOD_FM:
+			agc_process(Audio_L, NULL, BB_BLOCK, B_DAC_scale_FM/A_DAC_scale_FM, Demod_Type);
+			break;
+
+		case DEMOD_AM:
+			agc_process(Audio_L, NULL, BB_BLOCK, B_DAC_scale_AM/A_DAC_scale_AM, Demod_Type);
+			break;
+
+		case OUT_IQ:
+			break;
+
+		default:
+			agc_process(Audio_L, Audio_R, m, B_DAC_scale_WFM/A_DAC_scale_WFM, Demod_Type);
+			break;
 		}
+		t = perf_stamp(PERF_AGC, t);
 
-		if (CW_triggered)
+		switch(Demod_Type)
 		{
-			CW_decim_cnt++;
-			if (CW_decim_cnt == 107)
+		case DEMOD_FM:
+			for (k = 0; k < BB_BLOCK; k++)
 			{
-				DAC->DHR12R1 ^= 0xFFF;
-				CW_decim_cnt = 0;
+				DAC_value = A_DAC_scale_FM*Audio_L[k] + B_DAC_scale_FM; //scaling
+				if (DAC_value > 4095) DAC_value = 4095; //polar discriminator isn't limited to +/-pi/2
+				if (DAC_value < 0) DAC_value = 0;
+				dac[k] = DAC_value | (DAC_value << 16);
 			}
+			break;
 
-			if (module < CW_trig_lower_level) CW_triggered = false;
-		}
-		break;
+		case DEMOD_AM:
+			for (k = 0; k < BB_BLOCK; k++)
+			{
+				DAC_value = A_DAC_scale_AM*Audio_L[k] + B_DAC_scale_AM;
+				if (DAC_value > 4095) DAC_value = 4095; //both DAC channels are in one word, so overflow can't be left
+				if (DAC_value < 0) DAC_value = 0;
+				dac[k] = DAC_value | (DAC_value << 16);
+			}
+			break;
+
+		//IQ output - just for testing and educational purposes
+		case OUT_IQ:
+			for (k = 0; k < BB_BLOCK; k++)
+			{
+				DAC_value = A_DAC_scale_IQ*I_bb[k+2] + B_DAC_scale_IQ;
+				if (DAC_value > 4095) DAC_value = 4095;
+				if (DAC_value < 0) DAC_value = 0;
+				dac[k] = DAC_value;
+
+				DAC_value = A_DAC_scale_IQ*Q_bb[k+2] + B_DAC_scale_IQ;
+				if (DAC_value > 4095) DAC_value = 4095;
+				if (DAC_value < 0) DAC_value = 0;
+				dac[k] |= DAC_value << 16;
+			}
+			break;
+
+		//L and R to CS43L22 over I2S, DAC outputs L (PA4) and R (PA5) with sample and hold at AUDIO_FS_Hz
+		case DEMOD_WFM:
+		case DEMOD_USB:
+		case DEMOD_LSB:
+		case DEMOD_CW:
+		case DEMOD_SAM:
+		case DEMOD_NBFM:
+			audio_i2s_write(Audio_L, Audio_R, m, A_I2S_scale_WFM);
+			for (k = 0; k < BB_BLOCK; k++)
+			{
+				DAC_value = A_DAC_scale_WFM*Audio_L[k/AUDIO_DECIM] + B_DAC_scale_WFM;
+				if (DAC_value > 4095) DAC_value = 4095;
+				if (DAC_value < 0) DAC_value = 0;
+				dac[k] = DAC_value;
+
+				DAC_value = A_DAC_scale_WFM*Audio_R[k/AUDIO_DECIM] + B_DAC_scale_WFM;
+				if (DAC_value > 4095) DAC_value = 4095;
+				if (DAC_value < 0) DAC_value = 0;
+				dac[k] |= DAC_value << 16;
+			}
+			break;
 
-	default:
-		break;
+		default:
+			break;
+		}
+		perf_stamp(PERF_OUTPUT, t);
 	}
 
+	//two last I/Q samples are needed by FM discriminators in the next block
+	I_bb[0] = I_bb[BB_BLOCK];
+	I_bb[1] = I_bb[BB_BLOCK+1];
+	Q_bb[0] = Q_bb[BB_BLOCK];
+	Q_bb[1] = Q_bb[BB_BLOCK+1];
+
+	perf_stamp(PERF_CALLBACK, t_start);
+
 	GPIOD->BSRR = 1<<31; //calculation time measurement
 }
 
+//DMA must be in the other half of ADC buffer when processing of this half is finished - otherwise samples were
+//overwritten during processing (or the callback came too late)
+static inline void ADC_check_overrun(uint8_t half)
+{
+	uint16_t pos = 2*ADC_BLOCK - hdma_adc1.Instance->NDTR; //the next sample written by DMA
+
+	if (pos/ADC_BLOCK == half) ADC_overruns++;
+}
+
+void HAL_ADC_ConvHalfCpltCallback (ADC_HandleTypeDef * hadc)
+{
+	SDR_process(&v_in_samples[0], &DAC_out[0]); //processing first half of ADC buffer
+	ADC_check_overrun(0);
+}
+
+void HAL_ADC_ConvCpltCallback (ADC_HandleTypeDef * hadc)
+{
+	SDR_process(&v_in_samples[ADC_BLOCK], &DAC_out[BB_BLOCK]); //processing second half of ADC buffer - the same principle of operation like in the first half
+	ADC_check_overrun(1);
+}
+
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
 	uint8_t rxchar_tmp = rxchar;
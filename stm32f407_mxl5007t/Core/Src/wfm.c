@@ -0,0 +1,167 @@
+/*
+ * wfm.c - broadcast FM demodulator with stereo decoder
+ *
+ * Multiplex signal (MPX) comes from polar discriminator at FS_BB_Hz - 75 kHz deviation is about 2.2 rad per sample,
+ * so Noga's discriminator (+/-pi/2) can't be used here.
+ * 19 kHz pilot is tracked by PLL and 38 kHz subcarrier is the doubled PLL phase: L-R = MPX*2*sin(2*phase).
+ * L+R and L-R are decimated by AUDIO_DECIM in two FIR stages (4x, 2x) - outputs are computed only at decimated rate.
+ * After matrixing L/R are de-emphasised at AUDIO_FS_Hz. Without pilot lock the output is mono (L+R).
+ * MPX block is passed to RDS demodulator (rds.c).
+ */
+#include <math.h>
+#include <stdbool.h>
+#include "main.h"
+#include "wfm.h"
+#include "audio_i2s.h"
+#include "dsp_math.h"
+#include "dsp_fir.h"
+#include "dsp_tables.h"
+#include "rds.h"
+#include "perf.h"
+#include "printf.h"
+
+#define RAD_TO_PHASE 683565275.6f //2^32/(2*pi) as float - a double here pulls the soft-float library into the loop
+
+WFM_Config_TypeDef WFM_Config =
+{
+	.deemph_us = WFM_DEFAULT_DEEMPH,
+	.stereo = true
+};
+
+//pilot PLL
+static uint32_t PLL_phase;
+static float PLL_int, PLL_Kp, PLL_Ki, PLL_int_max, PLL_freq_nom;
+static float Pilot_I, Pilot_Q; //pilot level in phase and in quadrature
+static bool Pilot_locked;
+
+//de-emphasis
+static float Deemph_coeff, Deemph_L, Deemph_R;
+
+//decimation filters for L+R (M) and L-R (D)
+static float FIR_M1_delay[2*WFM_FIR1_TAPS], FIR_D1_delay[2*WFM_FIR1_TAPS];
+static float FIR_M2_delay[2*WFM_FIR2_TAPS], FIR_D2_delay[2*WFM_FIR2_TAPS];
+static FIR_Decim_TypeDef FIR_M1 = {WFM_FIR1, WFM_FIR1_TAPS, 4, 0, 0, FIR_M1_delay};
+static FIR_Decim_TypeDef FIR_D1 = {WFM_FIR1, WFM_FIR1_TAPS, 4, 0, 0, FIR_D1_delay};
+static FIR_Decim_TypeDef FIR_M2 = {WFM_FIR2, WFM_FIR2_TAPS, 2, 0, 0, FIR_M2_delay};
+static FIR_Decim_TypeDef FIR_D2 = {WFM_FIR2, WFM_FIR2_TAPS, 2, 0, 0, FIR_D2_delay};
+
+//block buffers
+static float MPX[BB_BLOCK], Diff[BB_BLOCK];
+static float M1[BB_BLOCK/4], D1[BB_BLOCK/4];
+
+//has to be called before Demod_Type is switched to DEMOD_WFM (it's not synchronized with ADC callbacks)
+void wfm_init(void)
+{
+	//2nd order PLL: Kp=2*zeta*wn*T/Kd ; Ki=(wn*T)^2/Kd ; Kd=pilot level
+	float wnT = 2.0*M_PI*WFM_PLL_BW_Hz/FS_BB_Hz;
+	PLL_Kp = 2.0*WFM_PLL_ZETA*wnT/WFM_PILOT_NOM;
+	PLL_Ki = wnT*wnT/WFM_PILOT_NOM;
+	PLL_int_max = 2.0*M_PI*WFM_PLL_RANGE_Hz/FS_BB_Hz;
+	PLL_freq_nom = 2.0*M_PI*WFM_PILOT_Hz/FS_BB_Hz;
+	PLL_int = 0;
+	PLL_phase = 0;
+	Pilot_I = Pilot_Q = 0;
+	Pilot_locked = false;
+
+	wfm_set_deemph(WFM_Config.deemph_us);
+	Deemph_L = Deemph_R = 0;
+
+	fir_reset(&FIR_M1);
+	fir_reset(&FIR_D1);
+	fir_reset(&FIR_M2);
+	fir_reset(&FIR_D2);
+
+	rds_init();
+}
+
+//0 - de-emphasis off ; it can be changed while WFM is running
+void wfm_set_deemph(uint8_t deemph_us)
+{
+	WFM_Config.deemph_us = deemph_us;
+	if (deemph_us == 0)
+		Deemph_coeff = 1.0;
+	else
+		Deemph_coeff = 1.0 - expf(-1.0E6/(AUDIO_FS_Hz*deemph_us));
+}
+
+//I[-1] and Q[-1] have to be the previous samples ; returns number of audio samples in L and R (n/AUDIO_DECIM)
+uint16_t wfm_process(const float* I, const float* Q, uint16_t n, float* L, float* R)
+{
+	uint16_t k, m;
+	float s, c, err, freq, l, r;
+	uint32_t t = perf_start();
+
+	//MPX - phase difference between current and previous sample
+	for (k = 0; k < n; k++)
+		MPX[k] = fast_atan2f(I[k-1]*Q[k] - I[k]*Q[k-1], I[k]*I[k-1] + Q[k]*Q[k-1]);
+	t = perf_stamp(PERF_WFM_MPX, t);
+
+	if (RDS_Config.enabled)
+	{
+		rds_process(MPX, n);
+		t = perf_stamp(PERF_RDS, t);
+	}
+
+	//pilot PLL - pilot is sin(phase) so its product with cos(phase) is phase error
+	for (k = 0; k < n; k++)
+	{
+		fast_sincos_phase(PLL_phase, &s, &c);
+		err = MPX[k]*c;
+
+		PLL_int += PLL_Ki*err;
+		if (PLL_int > PLL_int_max) PLL_int = PLL_int_max;
+		if (PLL_int < -PLL_int_max) PLL_int = -PLL_int_max;
+		freq = PLL_freq_nom + PLL_int + PLL_Kp*err;
+		PLL_phase += (int32_t) (freq*RAD_TO_PHASE);
+
+		Pilot_I += (MPX[k]*s - Pilot_I)*(1.0f/1024.0f);
+		Pilot_Q += (err - Pilot_Q)*(1.0f/1024.0f);
+
+		Diff[k] = MPX[k]*4.0f*s*c; //2*sin(2*phase)=4*sin(phase)*cos(phase)
+	}
+
+	//lock detector with hysteresis
+	if (Pilot_locked)
+		Pilot_locked = (Pilot_I > 0.7*WFM_PILOT_LOCK) && (Pilot_I > fabsf(Pilot_Q));
+	else
+		Pilot_locked = (Pilot_I > WFM_PILOT_LOCK) && (Pilot_I > 2.0*fabsf(Pilot_Q));
+	t = perf_stamp(PERF_WFM_PILOT, t);
+
+	//decimation of L+R and L-R
+	k = fir_decim(&FIR_M1, MPX, M1, n);
+	fir_decim(&FIR_D1, Diff, D1, n);
+	m = fir_decim(&FIR_M2, M1, L, k);
+	fir_decim(&FIR_D2, D1, R, k);
+
+	//matrix and de-emphasis - L+R is in L and L-R is in R
+	for (k = 0; k < m; k++)
+	{
+		if (Pilot_locked && WFM_Config.stereo)
+		{
+			l = 0.5f*(L[k] + R[k]);
+			r = 0.5f*(L[k] - R[k]);
+		}
+		else
+			l = r = 0.5f*L[k];
+
+		Deemph_L += (l - Deemph_L)*Deemph_coeff;
+		Deemph_R += (r - Deemph_R)*Deemph_coeff;
+		L[k] = Deemph_L;
+		R[k] = Deemph_R;
+	}
+	perf_stamp(PERF_WFM_AUDIO, t);
+
+	return m;
+}
+
+bool wfm_stereo(void)
+{
+	return Pilot_locked && WFM_Config.stereo;
+}
+
+void wfm_print(void)
+{
+	UART_printf("wfm: de-emphasis %d us ; stereo %s ; pilot %s (I %.3f Q %.3f rad ; offset %.1f Hz) ; I2S slips %ld\r\n",
+			WFM_Config.deemph_us, WFM_Config.stereo ? "on" : "off", Pilot_locked ? "locked" : "not locked",
+			Pilot_I, Pilot_Q, PLL_int*FS_BB_Hz/(2.0*M_PI), Audio_I2S_slips);
+}